@@ -30,10 +30,19 @@
 #define AUDIO_BUFFER_FREE_SAMPLES_COUNT (8 * 1024)
 #endif
 
+/* audio_driver_flush() pushes input through conversion, DSP
+ * and resampling this many frames at a time, so intermediate
+ * data stays in L1 instead of making full passes over memory. */
+#ifndef AUDIO_FLUSH_BLOCK_FRAMES
+#define AUDIO_FLUSH_BLOCK_FRAMES 128
+#endif
+
 typedef struct audio_driver_input_data
 {
-   float *data;
+   float block[AUDIO_FLUSH_BLOCK_FRAMES * 2];
 
+   /* Frames from audio_driver_sample() waiting for a full chunk. */
+   int16_t *sample_buf;
    size_t data_ptr;
    size_t chunk_size;
    size_t nonblock_chunk_size;
@@ -299,6 +308,8 @@ void uninit_audio(void)
 
    free(audio_data.conv_outsamples);
    audio_data.conv_outsamples = NULL;
+   free(audio_data.sample_buf);
+   audio_data.sample_buf      = NULL;
    audio_data.data_ptr        = 0;
 
    free(audio_data.rewind_buf);
@@ -313,9 +324,6 @@ void uninit_audio(void)
    rarch_resampler_freep(&driver->resampler,
          &driver->resampler_data);
 
-   free(audio_data.data);
-   audio_data.data = NULL;
-
    free(audio_data.outsamples);
    audio_data.outsamples = NULL;
 
@@ -347,6 +355,14 @@ void init_audio(void)
    if (!audio_data.conv_outsamples)
       goto error;
 
+   rarch_assert(audio_data.sample_buf =
+         (int16_t*)malloc(max_bufsamples * sizeof(int16_t)));
+
+   if (!audio_data.sample_buf)
+      goto error;
+
+   audio_data.data_ptr = 0;
+
    audio_data.block_chunk_size    = AUDIO_CHUNK_SIZE_BLOCKING;
    audio_data.nonblock_chunk_size = AUDIO_CHUNK_SIZE_NONBLOCKING;
    audio_data.chunk_size          = audio_data.block_chunk_size;
@@ -418,21 +434,14 @@ void init_audio(void)
 
    if (!rarch_resampler_realloc(&driver->resampler_data,
             &driver->resampler,
-         settings->audio.resampler, audio_data.orig_src_ratio))
+         settings->audio.resampler, audio_data.orig_src_ratio,
+         (enum resampler_quality)settings->audio.resampler_quality))
    {
       RARCH_ERR("Failed to initialize resampler \"%s\".\n",
             settings->audio.resampler);
       driver->audio_active = false;
    }
 
-   rarch_assert(audio_data.data = (float*)
-         malloc(max_bufsamples * sizeof(float)));
-
-   if (!audio_data.data)
-      goto error;
-
-   audio_data.data_ptr = 0;
-
    rarch_assert(settings->audio.out_rate <
          audio_data.in_rate * AUDIO_MAX_RATIO);
    rarch_assert(audio_data.outsamples = (float*)
@@ -474,9 +483,9 @@ error:
    if (audio_data.conv_outsamples)
       free(audio_data.conv_outsamples);
    audio_data.conv_outsamples = NULL;
-   if (audio_data.data)
-      free(audio_data.data);
-   audio_data.data = NULL;
+   if (audio_data.sample_buf)
+      free(audio_data.sample_buf);
+   audio_data.sample_buf = NULL;
    if (audio_data.rewind_buf)
       free(audio_data.rewind_buf);
    audio_data.rewind_buf = NULL;
@@ -604,16 +613,20 @@ ssize_t audio_driver_write(const void *buf, size_t size)
  * Writes audio samples to audio driver. Will first
  * perform DSP processing (if enabled) and resampling.
  *
+ * The input is streamed through every stage in blocks of
+ * AUDIO_FLUSH_BLOCK_FRAMES frames, and the volume gain is
+ * applied by the resampler.
+ *
  * Returns: true (1) if audio samples were written to the audio
  * driver, false (0) in case of an error.
  **/
 bool audio_driver_flush(const int16_t *data, size_t samples)
 {
+   size_t   frames;
    const void *output_data        = NULL;
    unsigned output_frames         = 0;
    size_t   output_size           = sizeof(float);
    struct resampler_data src_data = {0};
-   struct rarch_dsp_data dsp_data = {0};
    runloop_t *runloop             = rarch_main_get_ptr();
    driver_t  *driver              = driver_get_ptr();
    settings_t *settings           = config_get_ptr();
@@ -630,61 +643,81 @@ bool audio_driver_flush(const int16_t *data, size_t samples)
 
    if (runloop->is_paused || settings->audio.mute_enable)
       return true;
-   if (!driver->audio_active || !audio_data.data)
+   if (!driver->audio_active || !audio_data.outsamples)
       return false;
 
-   RARCH_PERFORMANCE_INIT(audio_convert_s16);
-   RARCH_PERFORMANCE_START(audio_convert_s16);
-   audio_convert_s16_to_float(audio_data.data, data, samples,
-         audio_data.volume_gain);
-   RARCH_PERFORMANCE_STOP(audio_convert_s16);
+   if (audio_data.rate_control)
+      audio_driver_readjust_input_rate();
 
-   src_data.data_in               = audio_data.data;
-   src_data.input_frames          = samples >> 1;
+   src_data.ratio = audio_data.src_ratio;
+   if (runloop->is_slowmotion)
+      src_data.ratio *= settings->slowmotion_ratio;
+   src_data.gain  = audio_data.volume_gain;
 
-   dsp_data.input                 = audio_data.data;
-   dsp_data.input_frames          = samples >> 1;
+   RARCH_PERFORMANCE_INIT(audio_convert_s16);
+   RARCH_PERFORMANCE_INIT(audio_dsp);
+   RARCH_PERFORMANCE_INIT(resampler_proc);
+   RARCH_PERFORMANCE_INIT(audio_convert_float);
 
-   if (audio_data.dsp)
+   for (frames = samples >> 1; frames; )
    {
-      RARCH_PERFORMANCE_INIT(audio_dsp);
-      RARCH_PERFORMANCE_START(audio_dsp);
-      rarch_dsp_filter_process(audio_data.dsp, &dsp_data);
-      RARCH_PERFORMANCE_STOP(audio_dsp);
+      size_t block_frames = min(frames, AUDIO_FLUSH_BLOCK_FRAMES);
+      /* s16 output only needs the float block until it is
+       * converted, so keep reusing the start of the buffer. */
+      float *out          = audio_data.use_float ?
+         audio_data.outsamples + output_frames * 2 : audio_data.outsamples;
+
+      RARCH_PERFORMANCE_START(audio_convert_s16);
+      audio_convert_s16_to_float(audio_data.block, data,
+            block_frames * 2, 1.0f);
+      RARCH_PERFORMANCE_STOP(audio_convert_s16);
+
+      src_data.data_in      = audio_data.block;
+      src_data.input_frames = block_frames;
 
-      if (dsp_data.output)
+      if (audio_data.dsp)
       {
-         src_data.data_in      = dsp_data.output;
-         src_data.input_frames = dsp_data.output_frames;
+         struct rarch_dsp_data dsp_data = {0};
+
+         dsp_data.input        = audio_data.block;
+         dsp_data.input_frames = block_frames;
+
+         RARCH_PERFORMANCE_START(audio_dsp);
+         rarch_dsp_filter_process(audio_data.dsp, &dsp_data);
+         RARCH_PERFORMANCE_STOP(audio_dsp);
+
+         if (dsp_data.output)
+         {
+            src_data.data_in      = dsp_data.output;
+            src_data.input_frames = dsp_data.output_frames;
+         }
       }
-   }
 
-   src_data.data_out = audio_data.outsamples;
+      src_data.data_out = out;
 
-   if (audio_data.rate_control)
-      audio_driver_readjust_input_rate();
+      RARCH_PERFORMANCE_START(resampler_proc);
+      rarch_resampler_process(driver->resampler,
+            driver->resampler_data, &src_data);
+      RARCH_PERFORMANCE_STOP(resampler_proc);
 
-   src_data.ratio = audio_data.src_ratio;
-   if (runloop->is_slowmotion)
-      src_data.ratio *= settings->slowmotion_ratio;
+      if (!audio_data.use_float)
+      {
+         RARCH_PERFORMANCE_START(audio_convert_float);
+         audio_convert_float_to_s16(
+               audio_data.conv_outsamples + output_frames * 2,
+               out, src_data.output_frames * 2);
+         RARCH_PERFORMANCE_STOP(audio_convert_float);
+      }
 
-   RARCH_PERFORMANCE_INIT(resampler_proc);
-   RARCH_PERFORMANCE_START(resampler_proc);
-   rarch_resampler_process(driver->resampler,
-         driver->resampler_data, &src_data);
-   RARCH_PERFORMANCE_STOP(resampler_proc);
+      output_frames += src_data.output_frames;
+      data          += block_frames * 2;
+      frames        -= block_frames;
+   }
 
-   output_data   = audio_data.outsamples;
-   output_frames = src_data.output_frames;
+   output_data = audio_data.outsamples;
 
    if (!audio_data.use_float)
    {
-      RARCH_PERFORMANCE_INIT(audio_convert_float);
-      RARCH_PERFORMANCE_START(audio_convert_float);
-      audio_convert_float_to_s16(audio_data.conv_outsamples,
-            (const float*)output_data, output_frames * 2);
-      RARCH_PERFORMANCE_STOP(audio_convert_float);
-
       output_data = audio_data.conv_outsamples;
       output_size = sizeof(int16_t);
    }
@@ -707,13 +740,13 @@ bool audio_driver_flush(const int16_t *data, size_t samples)
  **/
 void audio_driver_sample(int16_t left, int16_t right)
 {
-   audio_data.conv_outsamples[audio_data.data_ptr++] = left;
-   audio_data.conv_outsamples[audio_data.data_ptr++] = right;
+   audio_data.sample_buf[audio_data.data_ptr++] = left;
+   audio_data.sample_buf[audio_data.data_ptr++] = right;
 
    if (audio_data.data_ptr < audio_data.chunk_size)
       return;
 
-   audio_driver_flush(audio_data.conv_outsamples, audio_data.data_ptr);
+   audio_driver_flush(audio_data.sample_buf, audio_data.data_ptr);
 
    audio_data.data_ptr = 0;
 }
@@ -803,10 +836,10 @@ void audio_driver_setup_rewind(void)
    for (i = 0; i < audio_data.data_ptr; i += 2)
    {
       audio_data.rewind_buf[--audio_data.rewind_ptr] =
-         audio_data.conv_outsamples[i + 1];
+         audio_data.sample_buf[i + 1];
 
       audio_data.rewind_buf[--audio_data.rewind_ptr] =
-         audio_data.conv_outsamples[i + 0];
+         audio_data.sample_buf[i + 0];
    }
 
    audio_data.data_ptr = 0;
@@ -31,6 +31,9 @@
 #include "audio_filters/dspfilter.h"
 #include "../file_ext.h"
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
 
 struct rarch_dsp_plug
 {
@@ -132,6 +135,8 @@ extern const struct dspfilter_implementation *phaser_dspfilter_get_implementatio
 extern const struct dspfilter_implementation *wahwah_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
 extern const struct dspfilter_implementation *eq_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
 extern const struct dspfilter_implementation *chorus_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *reverb_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *convolution_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
 
 static const dspfilter_get_implementation_t dsp_plugs_builtin[] = {
    panning_dspfilter_get_implementation,
@@ -141,6 +146,8 @@ static const dspfilter_get_implementation_t dsp_plugs_builtin[] = {
    wahwah_dspfilter_get_implementation,
    eq_dspfilter_get_implementation,
    chorus_dspfilter_get_implementation,
+   reverb_dspfilter_get_implementation,
+   convolution_dspfilter_get_implementation,
 };
 
 static bool append_plugs(rarch_dsp_filter_t *dsp, struct string_list *list)
@@ -299,6 +306,13 @@ void rarch_dsp_filter_process(rarch_dsp_filter_t *dsp,
    unsigned i;
    struct dspfilter_output output = {0};
    struct dspfilter_input input   = {0};
+#if defined(__SSE__)
+   /* The recursive filters decay into denormals once the input goes
+    * quiet, which costs an order of magnitude on x86. Flush them to
+    * zero for the whole chain, NEON already does. */
+   unsigned int csr = _mm_getcsr();
+   _mm_setcsr(csr | _MM_FLUSH_ZERO_ON);
+#endif
 
    output.samples = data->input;
    output.frames  = data->input_frames;
@@ -313,5 +327,9 @@ void rarch_dsp_filter_process(rarch_dsp_filter_t *dsp,
 
    data->output        = output.samples;
    data->output_frames = output.frames;
+
+#if defined(__SSE__)
+   _mm_setcsr(csr);
+#endif
 }
 
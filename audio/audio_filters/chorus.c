@@ -18,25 +18,31 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "stereo_simd.h"
+
 #ifndef M_PI
 #define M_PI 3.1415926535897932384626433832795
 #endif
 
 #define CHORUS_MAX_DELAY 4096
 #define CHORUS_DELAY_MASK (CHORUS_MAX_DELAY - 1)
+#define CHORUS_BLOCK 64
 
 struct chorus_data
 {
-   float old[2][CHORUS_MAX_DELAY];
+   /* Interleaved stereo history. */
+   float old[CHORUS_MAX_DELAY][2];
    unsigned old_ptr;
 
+   /* In frames. */
    float delay;
    float depth;
-   float input_rate;
    float mix_dry;
    float mix_wet;
    unsigned lfo_ptr;
    unsigned lfo_period;
+   /* Rotation of the LFO phasor per frame. */
+   double lfo_cos, lfo_sin;
 };
 
 static void chorus_free(void *data)
@@ -44,46 +50,71 @@ static void chorus_free(void *data)
    free(data);
 }
 
+/* Delay of the next @frames frames, from a phasor which is
+ * reset to the exact LFO phase at the start of every block. */
+static void chorus_lfo(struct chorus_data *ch, float *delay, unsigned frames)
+{
+   unsigned i;
+   double phase = (2.0 * M_PI * ch->lfo_ptr) / ch->lfo_period;
+   double s     = sin(phase);
+   double c     = cos(phase);
+
+   for (i = 0; i < frames; i++)
+   {
+      double next = s * ch->lfo_cos + c * ch->lfo_sin;
+      c           = c * ch->lfo_cos - s * ch->lfo_sin;
+      delay[i]    = ch->delay + ch->depth * (float)s;
+      s           = next;
+   }
+
+   ch->lfo_ptr = (ch->lfo_ptr + frames) % ch->lfo_period;
+}
+
 static void chorus_process(void *data, struct dspfilter_output *output,
       const struct dspfilter_input *input)
 {
    unsigned i;
+   float *out;
+   float delay[CHORUS_BLOCK];
+   unsigned frames        = input->frames;
    struct chorus_data *ch = (struct chorus_data*)data;
+   stereo_t mix_dry       = stereo_dup(ch->mix_dry);
+   stereo_t mix_wet       = stereo_dup(ch->mix_wet);
 
    output->samples = input->samples;
    output->frames  = input->frames;
-   float *out = output->samples;
+   out = output->samples;
 
-   for (i = 0; i < input->frames; i++, out += 2)
+   while (frames)
    {
-      float in[2] = { out[0], out[1] };
+      unsigned run = frames < CHORUS_BLOCK ? frames : CHORUS_BLOCK;
+
+      chorus_lfo(ch, delay, run);
 
-      float delay = ch->delay + ch->depth * sin((2.0 * M_PI * ch->lfo_ptr++) / ch->lfo_period);
-      delay *= ch->input_rate;
-      if (ch->lfo_ptr >= ch->lfo_period)
-         ch->lfo_ptr = 0;
+      for (i = 0; i < run; i++, out += 2)
+      {
+         stereo_t in, a, b, chorus;
+         float delay_frac;
+         unsigned delay_int = (unsigned)delay[i];
+         if (delay_int >= CHORUS_MAX_DELAY - 1)
+            delay_int = CHORUS_MAX_DELAY - 2;
+         delay_frac = delay[i] - delay_int;
 
-      unsigned delay_int = (unsigned)delay;
-      if (delay_int >= CHORUS_MAX_DELAY - 1)
-         delay_int = CHORUS_MAX_DELAY - 2;
-      float delay_frac = delay - delay_int;
+         in = stereo_load(out);
+         stereo_store(ch->old[ch->old_ptr], in);
 
-      ch->old[0][ch->old_ptr] = in[0];
-      ch->old[1][ch->old_ptr] = in[1];
+         a = stereo_load(ch->old[(ch->old_ptr - delay_int - 0) & CHORUS_DELAY_MASK]);
+         b = stereo_load(ch->old[(ch->old_ptr - delay_int - 1) & CHORUS_DELAY_MASK]);
 
-      float l_a = ch->old[0][(ch->old_ptr - delay_int - 0) & CHORUS_DELAY_MASK];
-      float l_b = ch->old[0][(ch->old_ptr - delay_int - 1) & CHORUS_DELAY_MASK];
-      float r_a = ch->old[1][(ch->old_ptr - delay_int - 0) & CHORUS_DELAY_MASK];
-      float r_b = ch->old[1][(ch->old_ptr - delay_int - 1) & CHORUS_DELAY_MASK];
+         /* Lerp introduces aliasing of the chorus component, but doing full polyphase here is probably overkill. */
+         chorus = stereo_mla(a, stereo_sub(b, a), stereo_dup(delay_frac));
 
-      // Lerp introduces aliasing of the chorus component, but doing full polyphase here is probably overkill.
-      float chorus_l = l_a * (1.0f - delay_frac) + l_b * delay_frac;
-      float chorus_r = r_a * (1.0f - delay_frac) + r_b * delay_frac;
+         stereo_store(out, stereo_mla(stereo_mul(mix_dry, in), mix_wet, chorus));
 
-      out[0] = ch->mix_dry * in[0] + ch->mix_wet * chorus_l;
-      out[1] = ch->mix_dry * in[1] + ch->mix_wet * chorus_r;
+         ch->old_ptr = (ch->old_ptr + 1) & CHORUS_DELAY_MASK;
+      }
 
-      ch->old_ptr = (ch->old_ptr + 1) & CHORUS_DELAY_MASK;
+      frames -= run;
    }
 }
 
@@ -114,12 +145,13 @@ static void *chorus_init(const struct dspfilter_info *info,
    ch->mix_dry = 1.0f - 0.5f * drywet;
    ch->mix_wet = 0.5f * drywet;
 
-   ch->delay = delay;
-   ch->depth = depth;
+   ch->delay = delay * info->input_rate;
+   ch->depth = depth * info->input_rate;
    ch->lfo_period = (1.0f / lfo_freq) * info->input_rate;
-   ch->input_rate = info->input_rate;
    if (!ch->lfo_period)
       ch->lfo_period = 1;
+   ch->lfo_cos = cos(2.0 * M_PI / ch->lfo_period);
+   ch->lfo_sin = sin(2.0 * M_PI / ch->lfo_period);
    return ch;
 }
 
@@ -0,0 +1,383 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dspfilter.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <boolean.h>
+
+#include "fft/convolver.c"
+
+struct convolution_data
+{
+   fft_convolver_t *conv;
+};
+
+/* An impulse response, one array per channel.
+ * right == left for mono responses. */
+struct convolution_ir
+{
+   float *left;
+   float *right;
+   unsigned frames;
+   unsigned rate;
+};
+
+static void convolution_ir_free(struct convolution_ir *ir)
+{
+   if (ir->right != ir->left)
+      free(ir->right);
+   free(ir->left);
+   ir->left   = NULL;
+   ir->right  = NULL;
+   ir->frames = 0;
+}
+
+static uint32_t convolution_read_le16(const uint8_t *p)
+{
+   return p[0] | (p[1] << 8);
+}
+
+static uint32_t convolution_read_le32(const uint8_t *p)
+{
+   return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Decodes one sample of a PCM or IEEE float WAV to [-1, 1]. */
+static float convolution_read_sample(const uint8_t *p,
+      unsigned bits, bool is_float)
+{
+   switch (bits)
+   {
+      case 8:
+         return (p[0] - 128) / 128.0f;
+      case 16:
+         return (int16_t)convolution_read_le16(p) / 32768.0f;
+      case 24:
+         return (int32_t)((p[0] << 8) | (p[1] << 16) | ((uint32_t)p[2] << 24))
+            / 2147483648.0f;
+      case 32:
+         if (is_float)
+         {
+            float f;
+            uint32_t u = convolution_read_le32(p);
+            memcpy(&f, &u, sizeof(f));
+            return f;
+         }
+         return (int32_t)convolution_read_le32(p) / 2147483648.0f;
+   }
+
+   return 0.0f;
+}
+
+static bool convolution_parse_wav(struct convolution_ir *ir,
+      const uint8_t *buf, size_t size)
+{
+   unsigned i;
+   size_t pos           = 12;
+   const uint8_t *data  = NULL;
+   size_t data_size     = 0;
+   unsigned format      = 0;
+   unsigned channels    = 0;
+   unsigned bits        = 0;
+   unsigned block_align = 0;
+
+   if (size < 12 || memcmp(buf, "RIFF", 4) || memcmp(buf + 8, "WAVE", 4))
+      return false;
+
+   while (pos + 8 <= size)
+   {
+      const uint8_t *chunk = buf + pos + 8;
+      size_t chunk_size    = convolution_read_le32(buf + pos + 4);
+
+      if (chunk_size > size - pos - 8)
+         chunk_size = size - pos - 8;
+
+      if (!memcmp(buf + pos, "fmt ", 4) && chunk_size >= 16)
+      {
+         format      = convolution_read_le16(chunk + 0);
+         channels    = convolution_read_le16(chunk + 2);
+         ir->rate    = convolution_read_le32(chunk + 4);
+         block_align = convolution_read_le16(chunk + 12);
+         bits        = convolution_read_le16(chunk + 14);
+
+         /* WAVE_FORMAT_EXTENSIBLE, the real format
+          * starts the sub-format GUID. */
+         if (format == 0xfffe && chunk_size >= 26)
+            format = convolution_read_le16(chunk + 24);
+      }
+      else if (!memcmp(buf + pos, "data", 4))
+      {
+         data      = chunk;
+         data_size = chunk_size;
+      }
+
+      pos += 8 + chunk_size + (chunk_size & 1);
+   }
+
+   if (!data || !channels || !ir->rate
+         || block_align < channels * (bits / 8))
+      return false;
+   if (!(format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32))
+         && !(format == 3 && bits == 32))
+      return false;
+
+   ir->frames = data_size / block_align;
+   if (!ir->frames)
+      return false;
+
+   ir->left  = (float*)malloc(ir->frames * sizeof(float));
+   ir->right = ir->left;
+   if (channels > 1)
+      ir->right = (float*)malloc(ir->frames * sizeof(float));
+   if (!ir->left || !ir->right)
+      return false;
+
+   /* Only the first two channels are used. */
+   for (i = 0; i < ir->frames; i++)
+   {
+      const uint8_t *frame = data + i * block_align;
+
+      ir->left[i] = convolution_read_sample(frame, bits, format == 3);
+      if (channels > 1)
+         ir->right[i] = convolution_read_sample(frame + bits / 8,
+               bits, format == 3);
+   }
+
+   return true;
+}
+
+static bool convolution_load_wav(struct convolution_ir *ir, const char *path)
+{
+   long size;
+   bool ret     = false;
+   uint8_t *buf = NULL;
+   FILE *file   = fopen(path, "rb");
+
+   if (!file)
+      return false;
+
+   if (fseek(file, 0, SEEK_END) || (size = ftell(file)) <= 0
+         || fseek(file, 0, SEEK_SET))
+      goto end;
+
+   buf = (uint8_t*)malloc(size);
+   if (!buf || fread(buf, 1, size, file) != (size_t)size)
+      goto end;
+
+   ret = convolution_parse_wav(ir, buf, size);
+   if (!ret)
+      convolution_ir_free(ir);
+
+end:
+   free(buf);
+   fclose(file);
+   return ret;
+}
+
+/* Linear interpolation is enough here, the response is
+ * normalized afterwards anyway. */
+static float *convolution_resample_channel(const float *in,
+      unsigned in_frames, unsigned out_frames, double step)
+{
+   unsigned i;
+   float *out = (float*)malloc(out_frames * sizeof(float));
+   if (!out)
+      return NULL;
+
+   for (i = 0; i < out_frames; i++)
+   {
+      double pos     = i * step;
+      unsigned index = (unsigned)pos;
+      float frac     = pos - index;
+      float next     = index + 1 < in_frames ? in[index + 1] : 0.0f;
+
+      out[i] = in[index] + (next - in[index]) * frac;
+   }
+
+   return out;
+}
+
+static bool convolution_resample(struct convolution_ir *ir, float rate)
+{
+   struct convolution_ir out = {0};
+   double step               = ir->rate / rate;
+
+   if (ir->rate == (unsigned)rate)
+      return true;
+
+   out.frames = (unsigned)((ir->frames - 1) / step) + 1;
+   out.rate   = rate;
+   out.left   = convolution_resample_channel(ir->left,
+         ir->frames, out.frames, step);
+   out.right  = out.left;
+   if (ir->right != ir->left)
+      out.right = convolution_resample_channel(ir->right,
+            ir->frames, out.frames, step);
+
+   convolution_ir_free(ir);
+   *ir = out;
+   return ir->left && ir->right;
+}
+
+/* Scales the response to unit energy, then folds the dry
+ * signal into its first tap so one convolution does the mix. */
+static void convolution_mix(struct convolution_ir *ir, float dry, float wet)
+{
+   unsigned i;
+   double energy = 0.0;
+   float scale   = 0.0f;
+
+   for (i = 0; i < ir->frames; i++)
+      energy += ir->left[i] * ir->left[i] + ir->right[i] * ir->right[i];
+
+   /* Average of both channels keeps their balance. */
+   if (energy > 0.0)
+      scale = wet / sqrt(0.5 * energy);
+
+   for (i = 0; i < ir->frames; i++)
+      ir->left[i] *= scale;
+   ir->left[0] += dry;
+
+   if (ir->right == ir->left)
+      return;
+
+   for (i = 0; i < ir->frames; i++)
+      ir->right[i] *= scale;
+   ir->right[0] += dry;
+}
+
+static void convolution_free(void *data)
+{
+   struct convolution_data *conv = (struct convolution_data*)data;
+   if (!conv)
+      return;
+
+   fft_convolver_free(conv->conv);
+   free(conv);
+}
+
+static void convolution_process(void *data, struct dspfilter_output *output,
+      const struct dspfilter_input *input)
+{
+   struct convolution_data *conv = (struct convolution_data*)data;
+
+   output->samples = input->samples;
+   output->frames  = input->frames;
+
+   fft_convolver_process(conv->conv, output->samples, output->frames);
+}
+
+/* There is no preset, as there is no impulse response to ship with
+ * one. To use the filter, point a preset at a response of your own:
+ *
+ * filters = 1
+ * filter0 = convolution
+ *
+ * # PCM (8, 16, 24 or 32 bit) or 32-bit float WAV. Mono responses are
+ * # applied to both channels, otherwise the first two channels are
+ * # used. It is resampled to the audio rate and normalized to unit
+ * # energy.
+ * convolution_impulse_response = "/path/to/impulse.wav"
+ *
+ * # Gains of the unprocessed and the reverberated signal.
+ * convolution_dry = 1.0
+ * convolution_wet = 0.3
+ *
+ * # Partition size, which is also the latency of the filter. Smaller
+ * # partitions cost more, the more so the longer the response.
+ * convolution_partition_size_log2 = 10
+ */
+static void *convolution_init(const struct dspfilter_info *info,
+      const struct dspfilter_config *config, void *userdata)
+{
+   float dry, wet;
+   int partition_log2;
+   char *path                    = NULL;
+   struct convolution_ir ir      = {0};
+   struct convolution_data *conv = (struct convolution_data*)
+      calloc(1, sizeof(*conv));
+   if (!conv)
+      return NULL;
+
+   config->get_string(userdata, "impulse_response", &path, "");
+   config->get_int(userdata, "partition_size_log2", &partition_log2, 10);
+   config->get_float(userdata, "dry", &dry, 1.0f);
+   config->get_float(userdata, "wet", &wet, 0.3f);
+
+   if (partition_log2 < 4)
+      partition_log2 = 4;
+   if (partition_log2 > 14)
+      partition_log2 = 14;
+
+   if (!path || !*path)
+   {
+      fprintf(stderr, "[Convolution]: No impulse response given, "
+            "set convolution_impulse_response.\n");
+      goto error;
+   }
+
+   if (!convolution_load_wav(&ir, path))
+   {
+      fprintf(stderr, "[Convolution]: Failed to load impulse response \"%s\".\n",
+            path);
+      goto error;
+   }
+
+   if (!convolution_resample(&ir, info->input_rate))
+      goto error;
+
+   convolution_mix(&ir, dry, wet);
+
+   conv->conv = fft_convolver_new(partition_log2,
+         ir.left, ir.right, ir.frames);
+   if (!conv->conv)
+      goto error;
+
+   convolution_ir_free(&ir);
+   config->free(path);
+   return conv;
+
+error:
+   convolution_ir_free(&ir);
+   config->free(path);
+   convolution_free(conv);
+   return NULL;
+}
+
+static const struct dspfilter_implementation convolution_plug = {
+   convolution_init,
+   convolution_process,
+   convolution_free,
+
+   DSPFILTER_API_VERSION,
+   "Convolution Reverb",
+   "convolution",
+};
+
+#ifdef HAVE_FILTERS_BUILTIN
+#define dspfilter_get_implementation convolution_dspfilter_get_implementation
+#endif
+
+const struct dspfilter_implementation *dspfilter_get_implementation(dspfilter_simd_mask_t mask)
+{
+   (void)mask;
+   return &convolution_plug;
+}
+
+#undef dspfilter_get_implementation
@@ -17,10 +17,14 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include "stereo_simd.h"
+
 #ifndef min
 #define min(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
+#define ECHO_BLOCK 256
+
 struct echo_channel
 {
    float *buffer;
@@ -51,43 +55,62 @@ static void echo_process(void *data, struct dspfilter_output *output,
       const struct dspfilter_input *input)
 {
    unsigned i, c;
+   float *out;
+   float echo_buf[ECHO_BLOCK * 2];
+   unsigned frames        = input->frames;
    struct echo_data *echo = (struct echo_data*)data;
+   stereo_t amp           = stereo_dup(echo->amp);
 
    output->samples = input->samples;
    output->frames  = input->frames;
+   out = output->samples;
 
-   float *out = output->samples;
-
-   for (i = 0; i < input->frames; i++, out += 2)
+   while (frames)
    {
-      float echo_left  = 0.0f;
-      float echo_right = 0.0f;
+      unsigned run = min(frames, ECHO_BLOCK);
+
+      /* No delay line wraps within a run. As a run is never longer
+       * than the shortest delay, every tap read in it was written
+       * before it started, so each pass can go over the whole run. */
+      for (c = 0; c < echo->num_channels; c++)
+         run = min(run, echo->channels[c].frames - echo->channels[c].ptr);
+
+      for (i = 0; i < run * 2; i += 2)
+         stereo_store(echo_buf + i, stereo_dup(0.0f));
 
       for (c = 0; c < echo->num_channels; c++)
       {
-         echo_left  += echo->channels[c].buffer[(echo->channels[c].ptr << 1) + 0];
-         echo_right += echo->channels[c].buffer[(echo->channels[c].ptr << 1) + 1];
-      }
+         const float *tap = echo->channels[c].buffer + (echo->channels[c].ptr << 1);
 
-      echo_left  *= echo->amp;
-      echo_right *= echo->amp;
+         for (i = 0; i < run * 2; i += 2)
+            stereo_store(echo_buf + i,
+                  stereo_add(stereo_load(echo_buf + i), stereo_load(tap + i)));
+      }
 
-      float left  = out[0] + echo_left;
-      float right = out[1] + echo_right;
+      for (i = 0; i < run * 2; i += 2)
+         stereo_store(echo_buf + i, stereo_mul(amp, stereo_load(echo_buf + i)));
 
       for (c = 0; c < echo->num_channels; c++)
       {
-         float feedback_left  = out[0] + echo->channels[c].feedback * echo_left;
-         float feedback_right = out[1] + echo->channels[c].feedback * echo_right;
+         struct echo_channel *ch = &echo->channels[c];
+         float *tap              = ch->buffer + (ch->ptr << 1);
+         stereo_t feedback       = stereo_dup(ch->feedback);
 
-         echo->channels[c].buffer[(echo->channels[c].ptr << 1) + 0] = feedback_left;
-         echo->channels[c].buffer[(echo->channels[c].ptr << 1) + 1] = feedback_right;
+         for (i = 0; i < run * 2; i += 2)
+            stereo_store(tap + i, stereo_mla(stereo_load(out + i),
+                     feedback, stereo_load(echo_buf + i)));
 
-         echo->channels[c].ptr = (echo->channels[c].ptr + 1) % echo->channels[c].frames;
+         ch->ptr += run;
+         if (ch->ptr >= ch->frames)
+            ch->ptr = 0;
       }
 
-      out[0] = left;
-      out[1] = right;
+      for (i = 0; i < run * 2; i += 2)
+         stereo_store(out + i,
+               stereo_add(stereo_load(out + i), stereo_load(echo_buf + i)));
+
+      out    += run * 2;
+      frames -= run;
    }
 }
 
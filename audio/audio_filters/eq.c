@@ -19,7 +19,7 @@
 #include <stdio.h>
 #include <retro_inline.h>
 
-#include "fft/fft.c"
+#include "fft/convolver.c"
 
 #ifndef M_PI
 #define M_PI 3.1415926535897932384626433832795
@@ -31,15 +31,8 @@
 
 struct eq_data
 {
-   fft_t *fft;
-   float buffer[8 * 1024];
-
-   float *save;
-   float *block;
-   fft_complex_t *filter;
-   fft_complex_t *fftblock;
+   fft_convolver_t *conv;
    unsigned block_size;
-   unsigned block_ptr;
 };
 
 struct eq_gain
@@ -54,11 +47,7 @@ static void eq_free(void *data)
    if (!eq)
       return;
 
-   fft_free(eq->fft);
-   free(eq->save);
-   free(eq->block);
-   free(eq->fftblock);
-   free(eq->filter);
+   fft_convolver_free(eq->conv);
    free(eq);
 }
 
@@ -67,50 +56,12 @@ static void eq_process(void *data, struct dspfilter_output *output,
 {
    struct eq_data *eq = (struct eq_data*)data;
 
-   output->samples = eq->buffer;
-   output->frames  = 0;
-
-   float *out = eq->buffer;
-   const float *in = input->samples;
-   unsigned input_frames = input->frames;
-
-   while (input_frames)
-   {
-      unsigned write_avail = eq->block_size - eq->block_ptr;
-      if (input_frames < write_avail)
-         write_avail = input_frames;
-
-      memcpy(eq->block + eq->block_ptr * 2, in, write_avail * 2 * sizeof(float));
-
-      in += write_avail * 2;
-      input_frames -= write_avail;
-      eq->block_ptr += write_avail;
-
-      // Convolve a new block.
-      if (eq->block_ptr == eq->block_size)
-      {
-         unsigned i, c;
-
-         for (c = 0; c < 2; c++)
-         {
-            fft_process_forward(eq->fft, eq->fftblock, eq->block + c, 2);
-            for (i = 0; i < 2 * eq->block_size; i++)
-               eq->fftblock[i] = fft_complex_mul(eq->fftblock[i], eq->filter[i]);
-            fft_process_inverse(eq->fft, out + c, eq->fftblock, 2);
-         }
-
-         // Overlap add method, so add in saved block now.
-         for (i = 0; i < 2 * eq->block_size; i++)
-            out[i] += eq->save[i];
-
-         // Save block for later.
-         memcpy(eq->save, out + 2 * eq->block_size, 2 * eq->block_size * sizeof(float));
+   output->samples = input->samples;
+   output->frames  = input->frames;
 
-         out += eq->block_size * 2;
-         output->frames += eq->block_size;
-         eq->block_ptr = 0;
-      }
-   }
+   // Partitioned convolution, so latency is one partition
+   // no matter how long the filter is.
+   fft_convolver_process(eq->conv, output->samples, output->frames);
 }
 
 static int gains_cmp(const void *a_, const void *b_)
@@ -217,8 +168,9 @@ static INLINE double kaiser_window(double index, double beta)
    return kaiser_besseli0(beta * sqrt(1 - index * index));
 }
 
-static void create_filter(struct eq_data *eq, unsigned size_log2,
-      struct eq_gain *gains, unsigned num_gains, double beta, const char *filter_path)
+static bool create_filter(struct eq_data *eq, unsigned size_log2,
+      unsigned partition_log2, struct eq_gain *gains, unsigned num_gains,
+      double beta, const char *filter_path)
 {
    int i;
    int half_block_size = eq->block_size >> 1;
@@ -226,17 +178,18 @@ static void create_filter(struct eq_data *eq, unsigned size_log2,
 
    fft_t *fft = fft_new(size_log2);
    float *time_filter = (float*)calloc(eq->block_size * 2 + 1, sizeof(*time_filter));
-   if (!fft || !time_filter)
+   fft_complex_t *filter = (fft_complex_t*)calloc(2 * eq->block_size, sizeof(*filter));
+   if (!fft || !time_filter || !filter)
       goto end;
 
    // Make sure bands are in correct order.
    qsort(gains, num_gains, sizeof(*gains), gains_cmp);
 
    // Compute desired filter response.
-   generate_response(eq->filter, gains, num_gains, half_block_size);
+   generate_response(filter, gains, num_gains, half_block_size);
 
    // Get equivalent time-domain filter.
-   fft_process_inverse(fft, time_filter, eq->filter, 1);
+   fft_process_inverse(fft, time_filter, filter, 1);
 
    // ifftshift() to create the correct linear phase filter.
    // The filter response was designed with zero phase, which won't work unless we compensate
@@ -269,14 +222,16 @@ static void create_filter(struct eq_data *eq, unsigned size_log2,
       }
    }
 
-   // Padded FFT to create our FFT filter.
    // Make our even-length filter odd by discarding the first coefficient.
    // For some interesting reason, this allows us to design an odd-length linear phase filter.
-   fft_process_forward(eq->fft, eq->filter, time_filter + 1, 1);
+   eq->conv = fft_convolver_new(partition_log2,
+         time_filter + 1, time_filter + 1, eq->block_size - 1);
 
 end:
    fft_free(fft);
    free(time_filter);
+   free(filter);
+   return eq->conv != NULL;
 }
 
 static void *eq_init(const struct dspfilter_info *info,
@@ -297,6 +252,14 @@ static void *eq_init(const struct dspfilter_info *info,
    config->get_int(userdata, "block_size_log2", &size_log2, 8);
    unsigned size = 1 << size_log2;
 
+   // Convolution is done in partitions of this size.
+   int partition_log2;
+   config->get_int(userdata, "partition_size_log2", &partition_log2, 6);
+   if (partition_log2 > size_log2)
+      partition_log2 = size_log2;
+   if (partition_log2 < 2)
+      partition_log2 = 2;
+
    struct eq_gain *gains = NULL;
    float *frequencies, *gain;
    unsigned num_freq, num_gain;
@@ -326,19 +289,9 @@ static void *eq_init(const struct dspfilter_info *info,
 
    eq->block_size = size;
 
-   eq->save     = (float*)calloc(    size, 2 * sizeof(*eq->save));
-   eq->block    = (float*)calloc(2 * size, 2 * sizeof(*eq->block));
-   eq->fftblock = (fft_complex_t*)calloc(2 * size, sizeof(*eq->fftblock));
-   eq->filter   = (fft_complex_t*)calloc(2 * size, sizeof(*eq->filter));
-
-   // Use an FFT which is twice the block size with zero-padding
-   // to make circular convolution => proper convolution.
-   eq->fft = fft_new(size_log2 + 1);
-
-   if (!eq->fft || !eq->fftblock || !eq->save || !eq->block || !eq->filter)
+   if (!create_filter(eq, size_log2, partition_log2,
+            gains, num_gain, beta, filter_path))
       goto error;
-
-   create_filter(eq, size_log2, gains, num_gain, beta, filter_path);
    config->free(filter_path);
    filter_path = NULL;
 
@@ -346,6 +299,7 @@ static void *eq_init(const struct dspfilter_info *info,
    return eq;
 
 error:
+   config->free(filter_path);
    free(gains);
    eq_free(eq);
    return NULL;
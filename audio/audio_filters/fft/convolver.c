@@ -0,0 +1,304 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RARCH_FFT_CONVOLVER_C__
+#define RARCH_FFT_CONVOLVER_C__
+
+#include "convolver.h"
+#include "fft.c"
+#include <stdlib.h>
+#include <string.h>
+#include <boolean.h>
+
+/* An interleaved stereo frame is used as one complex sample,
+ * left in the real part and right in the imaginary part, so both
+ * channels share every transform.
+ *
+ * With X = L + iR, filtering left by HL and right by HR is
+ *    Y = X * (HL + HR) / 2 + conj(X[-k]) * (HL - HR) / 2
+ * and the second term is accumulated as conj(rev(sum(X * B'))),
+ * where B' = conj(rev((HL - HR) / 2)), so it reuses the same
+ * input spectra. It vanishes when both responses are equal.
+ *
+ * Spectra are stored planar, all real parts of a partition
+ * followed by all imaginary parts, so the multiply-accumulate
+ * needs no shuffles. */
+struct fft_convolver
+{
+   fft_t *fft;
+
+   unsigned block_size;
+   unsigned partitions;
+   unsigned fdl_ptr;
+   unsigned block_ptr;
+
+   float *filter;
+   float *filter_cross;
+   /* Frequency domain delay line, one input spectrum per partition. */
+   float *fdl;
+   float *accum;
+
+   /* The last two blocks of input. */
+   fft_complex_t *input;
+   fft_complex_t *spectrum;
+   /* Output of the last transform. Its second half is the
+    * block currently being played back. */
+   fft_complex_t *time;
+};
+
+/* acc += x * h for n bins of planar spectra. */
+static void fft_convolver_mac(float *acc, const float *x,
+      const float *h, unsigned n)
+{
+   unsigned i       = 0;
+   float *acc_re    = acc;
+   float *acc_im    = acc + n;
+   const float *xre = x;
+   const float *xim = x + n;
+   const float *hre = h;
+   const float *him = h + n;
+
+#if defined(FFT_HAVE_SSE)
+   for (; i + 4 <= n; i += 4)
+   {
+      __m128 xr = _mm_loadu_ps(xre + i);
+      __m128 xi = _mm_loadu_ps(xim + i);
+      __m128 hr = _mm_loadu_ps(hre + i);
+      __m128 hi = _mm_loadu_ps(him + i);
+
+      _mm_storeu_ps(acc_re + i, _mm_add_ps(_mm_loadu_ps(acc_re + i),
+               _mm_sub_ps(_mm_mul_ps(xr, hr), _mm_mul_ps(xi, hi))));
+      _mm_storeu_ps(acc_im + i, _mm_add_ps(_mm_loadu_ps(acc_im + i),
+               _mm_add_ps(_mm_mul_ps(xr, hi), _mm_mul_ps(xi, hr))));
+   }
+#elif defined(FFT_HAVE_NEON)
+   for (; i + 4 <= n; i += 4)
+   {
+      float32x4_t xr = vld1q_f32(xre + i);
+      float32x4_t xi = vld1q_f32(xim + i);
+      float32x4_t hr = vld1q_f32(hre + i);
+      float32x4_t hi = vld1q_f32(him + i);
+
+      vst1q_f32(acc_re + i,
+            vmlsq_f32(vmlaq_f32(vld1q_f32(acc_re + i), xr, hr), xi, hi));
+      vst1q_f32(acc_im + i,
+            vmlaq_f32(vmlaq_f32(vld1q_f32(acc_im + i), xr, hi), xi, hr));
+   }
+#endif
+
+   for (; i < n; i++)
+   {
+      acc_re[i] += xre[i] * hre[i] - xim[i] * him[i];
+      acc_im[i] += xre[i] * him[i] + xim[i] * hre[i];
+   }
+}
+
+static void fft_convolver_block(fft_convolver_t *conv)
+{
+   unsigned p, k;
+   unsigned size    = conv->block_size * 2;
+   unsigned mask    = size - 1;
+   float *x         = conv->fdl + conv->fdl_ptr * 2 * size;
+   float *acc       = conv->accum;
+   float *acc_cross = conv->accum + 2 * size;
+
+   fft_process_forward_complex(conv->fft, conv->spectrum, conv->input, 1);
+
+   for (k = 0; k < size; k++)
+   {
+      x[k]        = conv->spectrum[k].real;
+      x[size + k] = conv->spectrum[k].imag;
+   }
+
+   memset(acc, 0, (conv->filter_cross ? 4 : 2) * size * sizeof(float));
+
+   for (p = 0; p < conv->partitions; p++)
+   {
+      unsigned slot = (conv->fdl_ptr + conv->partitions - p) % conv->partitions;
+      const float *in = conv->fdl + slot * 2 * size;
+
+      fft_convolver_mac(acc, in, conv->filter + p * 2 * size, size);
+      if (conv->filter_cross)
+         fft_convolver_mac(acc_cross, in,
+               conv->filter_cross + p * 2 * size, size);
+   }
+
+   for (k = 0; k < size; k++)
+   {
+      conv->spectrum[k].real = acc[k];
+      conv->spectrum[k].imag = acc[size + k];
+   }
+
+   if (conv->filter_cross)
+   {
+      for (k = 0; k < size; k++)
+      {
+         unsigned j = (size - k) & mask;
+         conv->spectrum[k].real += acc_cross[j];
+         conv->spectrum[k].imag -= acc_cross[size + j];
+      }
+   }
+
+   fft_process_inverse_complex(conv->fft, conv->time, conv->spectrum, 1);
+
+   /* Overlap-save, the older input block slides out. */
+   memcpy(conv->input, conv->input + conv->block_size,
+         conv->block_size * sizeof(*conv->input));
+   conv->fdl_ptr = (conv->fdl_ptr + 1) % conv->partitions;
+}
+
+void fft_convolver_process(fft_convolver_t *conv,
+      float *samples, unsigned frames)
+{
+   while (frames)
+   {
+      unsigned i;
+      unsigned avail = conv->block_size - conv->block_ptr;
+      float *in      = (float*)(conv->input + conv->block_size + conv->block_ptr);
+      float *out     = (float*)(conv->time  + conv->block_size + conv->block_ptr);
+
+      if (avail > frames)
+         avail = frames;
+
+      for (i = 0; i < avail * 2; i++)
+      {
+         float sample = samples[i];
+         samples[i]   = out[i];
+         in[i]        = sample;
+      }
+
+      samples         += avail * 2;
+      frames          -= avail;
+      conv->block_ptr += avail;
+
+      if (conv->block_ptr == conv->block_size)
+      {
+         fft_convolver_block(conv);
+         conv->block_ptr = 0;
+      }
+   }
+}
+
+/* Zero-pads one partition of a response into @scratch
+ * and transforms it into @out. */
+static void fft_convolver_partition(fft_convolver_t *conv,
+      fft_complex_t *out, float *scratch,
+      const float *response, unsigned taps, unsigned partition)
+{
+   unsigned offset = partition * conv->block_size;
+   unsigned len    = taps - offset;
+
+   if (len > conv->block_size)
+      len = conv->block_size;
+
+   memset(scratch, 0, 2 * conv->block_size * sizeof(float));
+   memcpy(scratch, response + offset, len * sizeof(float));
+   fft_process_forward(conv->fft, out, scratch, 1);
+}
+
+fft_convolver_t *fft_convolver_new(unsigned block_size_log2,
+      const float *left, const float *right, unsigned taps)
+{
+   unsigned p, k, size, mask;
+   bool cross            = right && right != left &&
+      memcmp(left, right, taps * sizeof(float));
+   fft_convolver_t *conv = (fft_convolver_t*)calloc(1, sizeof(*conv));
+   if (!conv)
+      return NULL;
+
+   conv->block_size = 1 << block_size_log2;
+   conv->partitions = (taps + conv->block_size - 1) >> block_size_log2;
+   if (!conv->partitions)
+      conv->partitions = 1;
+
+   size = conv->block_size * 2;
+   mask = size - 1;
+
+   conv->fft      = fft_new(block_size_log2 + 1);
+   conv->filter   = (float*)calloc(conv->partitions * 2 * size, sizeof(float));
+   conv->fdl      = (float*)calloc(conv->partitions * 2 * size, sizeof(float));
+   conv->accum    = (float*)calloc(4 * size, sizeof(float));
+   conv->input    = (fft_complex_t*)calloc(size, sizeof(fft_complex_t));
+   conv->spectrum = (fft_complex_t*)calloc(size, sizeof(fft_complex_t));
+   conv->time     = (fft_complex_t*)calloc(size, sizeof(fft_complex_t));
+
+   if (cross)
+      conv->filter_cross = (float*)
+         calloc(conv->partitions * 2 * size, sizeof(float));
+
+   if (!conv->fft || !conv->filter || !conv->fdl || !conv->accum
+         || !conv->input || !conv->spectrum || !conv->time
+         || (cross && !conv->filter_cross))
+      goto error;
+
+   /* spectrum, time and accum are free to use as scratch here. */
+   for (p = 0; p < conv->partitions; p++)
+   {
+      fft_complex_t *hl = conv->spectrum;
+      fft_complex_t *hr = conv->time;
+      float *h          = conv->filter + p * 2 * size;
+
+      fft_convolver_partition(conv, hl, conv->accum, left, taps, p);
+
+      if (!cross)
+      {
+         for (k = 0; k < size; k++)
+         {
+            h[k]        = hl[k].real;
+            h[size + k] = hl[k].imag;
+         }
+         continue;
+      }
+
+      fft_convolver_partition(conv, hr, conv->accum, right, taps, p);
+
+      for (k = 0; k < size; k++)
+      {
+         unsigned j = (size - k) & mask;
+         float *c   = conv->filter_cross + p * 2 * size;
+
+         h[k]        =  0.5f * (hl[k].real + hr[k].real);
+         h[size + k] =  0.5f * (hl[k].imag + hr[k].imag);
+         c[k]        =  0.5f * (hl[j].real - hr[j].real);
+         c[size + k] = -0.5f * (hl[j].imag - hr[j].imag);
+      }
+   }
+
+   memset(conv->spectrum, 0, size * sizeof(fft_complex_t));
+   memset(conv->time,     0, size * sizeof(fft_complex_t));
+   return conv;
+
+error:
+   fft_convolver_free(conv);
+   return NULL;
+}
+
+void fft_convolver_free(fft_convolver_t *conv)
+{
+   if (!conv)
+      return;
+
+   fft_free(conv->fft);
+   free(conv->filter);
+   free(conv->filter_cross);
+   free(conv->fdl);
+   free(conv->accum);
+   free(conv->input);
+   free(conv->spectrum);
+   free(conv->time);
+   free(conv);
+}
+
+#endif
@@ -0,0 +1,40 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RARCH_FFT_CONVOLVER_H__
+#define RARCH_FFT_CONVOLVER_H__
+
+/* Uniformly partitioned overlap-save convolution of interleaved
+ * stereo audio.
+ *
+ * The impulse response is split into blocks of
+ * 1 << block_size_log2 frames. Latency is exactly one block,
+ * regardless of the length of the impulse response. */
+typedef struct fft_convolver fft_convolver_t;
+
+/* Creates a convolver for impulse responses of @taps samples.
+ * @left and @right are the responses for each channel; pass the
+ * same array twice to filter both channels identically, which
+ * halves the work. */
+fft_convolver_t *fft_convolver_new(unsigned block_size_log2,
+      const float *left, const float *right, unsigned taps);
+
+void fft_convolver_free(fft_convolver_t *conv);
+
+/* Filters @frames interleaved stereo frames in place. */
+void fft_convolver_process(fft_convolver_t *conv,
+      float *samples, unsigned frames);
+
+#endif
@@ -13,20 +13,45 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+/* This file is included directly by several DSP plugins, and
+ * griffin builds all of them in one translation unit. */
+#ifndef RARCH_FFT_C__
+#define RARCH_FFT_C__
+
 #include "fft.h"
 #include <math.h>
 #include <stdlib.h>
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define FFT_HAVE_SSE
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define FFT_HAVE_NEON
+#endif
+
 #ifndef M_PI
 #define M_PI 3.1415926535897932384626433832795
 #endif
 
+/* The transform is decimation in time on bit-reversed input.
+ * Two radix-2 stages are fused into one radix-4 pass, so every
+ * pass over the buffer does twice the work of the old
+ * implementation. An odd log2 size starts with one radix-2 pass.
+ *
+ * Twiddles for a pass with butterfly distance step are stored
+ * for pairs of k, so SIMD kernels can load them directly:
+ * { wr0, wr0, wr1, wr1, -wi0, wi0, -wi1, wi1 } for W^k, then the
+ * same for W^2k and W^3k, i.e. 12 * step floats per pass. */
+#define FFT_TWIDDLE_PAIR_FLOATS 24
+
 struct fft
 {
    fft_complex_t *interleave_buffer;
-   fft_complex_t *phase_lut;
+   float *twiddles;
    unsigned *bitinverse_buffer;
    unsigned size;
+   unsigned size_log2;
 };
 
 static unsigned bitswap(unsigned x, unsigned size_log2)
@@ -46,18 +71,47 @@ static void build_bitinverse(unsigned *bitinverse, unsigned size_log2)
       bitinverse[i] = bitswap(i, size_log2);
 }
 
-static fft_complex_t exp_imag(double phase)
+/* Butterfly distance of the first pass which needs twiddles. */
+static unsigned fft_first_twiddle_step(unsigned size_log2)
 {
-   fft_complex_t out = { cos(phase), sin(phase) };
-   return out;
+   return (size_log2 & 1) ? 2 : 4;
 }
 
-static void build_phase_lut(fft_complex_t *out, int size)
+static unsigned fft_twiddle_floats(unsigned size_log2)
 {
-   int i;
-   out += size;
-   for (i = -size; i <= size; i++)
-      out[i] = exp_imag((M_PI * i) / size);
+   unsigned step;
+   unsigned floats = 0;
+   unsigned size   = 1 << size_log2;
+
+   for (step = fft_first_twiddle_step(size_log2); step < size; step <<= 2)
+      floats += 12 * step;
+   return floats;
+}
+
+static void build_twiddles(float *out, unsigned size_log2)
+{
+   unsigned step, k, m;
+   unsigned size = 1 << size_log2;
+
+   for (step = fft_first_twiddle_step(size_log2); step < size; step <<= 2)
+   {
+      for (k = 0; k < step; k++)
+      {
+         float *pair = out + (k >> 1) * FFT_TWIDDLE_PAIR_FLOATS + (k & 1) * 2;
+
+         for (m = 0; m < 3; m++)
+         {
+            double phase = -2.0 * M_PI * (m + 1) * k / (4.0 * step);
+            float *t     = pair + m * 8;
+
+            t[0] = t[1] = cos(phase);
+            t[4]        = -sin(phase);
+            t[5]        = sin(phase);
+         }
+      }
+
+      out += 12 * step;
+   }
 }
 
 static void interleave_complex(const unsigned *bitinverse,
@@ -69,6 +123,16 @@ static void interleave_complex(const unsigned *bitinverse,
       out[bitinverse[i]] = *in;
 }
 
+/* The inverse transform is conj(FFT(conj(x))) / N. */
+static void interleave_complex_conj(const unsigned *bitinverse,
+      fft_complex_t *out, const fft_complex_t *in,
+      unsigned samples, unsigned step)
+{
+   unsigned i;
+   for (i = 0; i < samples; i++, in += step)
+      out[bitinverse[i]] = fft_complex_conj(*in);
+}
+
 static void interleave_float(const unsigned *bitinverse,
       fft_complex_t *out, const float *in,
       unsigned samples, unsigned step)
@@ -90,6 +154,17 @@ static void resolve_float(float *out, const fft_complex_t *in, unsigned samples,
       *out = gain * in->real;
 }
 
+static void resolve_complex_conj(fft_complex_t *buf, unsigned samples,
+      float gain)
+{
+   unsigned i;
+   for (i = 0; i < samples; i++)
+   {
+      buf[i].real =  gain * buf[i].real;
+      buf[i].imag = -gain * buf[i].imag;
+   }
+}
+
 fft_t *fft_new(unsigned block_size_log2)
 {
    fft_t *fft = (fft_t*)calloc(1, sizeof(*fft));
@@ -100,15 +175,17 @@ fft_t *fft_new(unsigned block_size_log2)
 
    fft->interleave_buffer = (fft_complex_t*)calloc(size, sizeof(*fft->interleave_buffer));
    fft->bitinverse_buffer = (unsigned*)calloc(size, sizeof(*fft->bitinverse_buffer));
-   fft->phase_lut         = (fft_complex_t*)calloc(2 * size + 1, sizeof(*fft->phase_lut));
+   fft->twiddles          = (float*)calloc(fft_twiddle_floats(block_size_log2) + 1,
+         sizeof(*fft->twiddles));
 
-   if (!fft->interleave_buffer || !fft->bitinverse_buffer || !fft->phase_lut)
+   if (!fft->interleave_buffer || !fft->bitinverse_buffer || !fft->twiddles)
       goto error;
 
-   fft->size = size;
+   fft->size      = size;
+   fft->size_log2 = block_size_log2;
 
    build_bitinverse(fft->bitinverse_buffer, block_size_log2);
-   build_phase_lut(fft->phase_lut, size);
+   build_twiddles(fft->twiddles, block_size_log2);
    return fft;
 
 error:
@@ -123,74 +200,237 @@ void fft_free(fft_t *fft)
 
    free(fft->interleave_buffer);
    free(fft->bitinverse_buffer);
-   free(fft->phase_lut);
+   free(fft->twiddles);
    free(fft);
 }
 
-static void butterfly(fft_complex_t *a, fft_complex_t *b, fft_complex_t mod)
+/* (-i) * a */
+static INLINE fft_complex_t fft_complex_mul_neg_i(fft_complex_t a)
 {
-   mod = fft_complex_mul(mod, *b);
-   *b = fft_complex_sub(*a, mod);
-   *a = fft_complex_add(*a, mod);
+   fft_complex_t out = {
+      a.imag, -a.real,
+   };
+
+   return out;
 }
 
-static void butterflies(fft_complex_t *butterfly_buf,
-      const fft_complex_t *phase_lut,
-      int phase_dir, unsigned step_size, unsigned samples)
+/* Multiplies by a twiddle in the pair layout, see build_twiddles(). */
+static INLINE fft_complex_t fft_twiddle(fft_complex_t a, const float *t)
 {
-   unsigned i, j;
-   for (i = 0; i < samples; i += step_size << 1)
+   fft_complex_t out = {
+      a.real * t[0] + a.imag * t[4],
+      a.imag * t[1] + a.real * t[5],
+   };
+
+   return out;
+}
+
+/* Radix-4 butterfly on twiddled inputs. The outputs are written
+ * back in natural order, matching two radix-2 stages. */
+static INLINE void fft_butterfly4(fft_complex_t *a0, fft_complex_t *a1,
+      fft_complex_t *a2, fft_complex_t *a3,
+      fft_complex_t b0, fft_complex_t b1, fft_complex_t b2, fft_complex_t b3)
+{
+   fft_complex_t sum0  = fft_complex_add(b0, b1);
+   fft_complex_t diff0 = fft_complex_sub(b0, b1);
+   fft_complex_t sum1  = fft_complex_add(b2, b3);
+   fft_complex_t diff1 = fft_complex_mul_neg_i(fft_complex_sub(b2, b3));
+
+   *a0 = fft_complex_add(sum0, sum1);
+   *a1 = fft_complex_add(diff0, diff1);
+   *a2 = fft_complex_sub(sum0, sum1);
+   *a3 = fft_complex_sub(diff0, diff1);
+}
+
+/* First pass of an odd log2 size. Twiddles are all 1. */
+static void fft_pass_radix2_first(fft_complex_t *buf, unsigned samples)
+{
+   unsigned i;
+   for (i = 0; i < samples; i += 2)
    {
-      int phase_step = (int)samples * phase_dir / (int)step_size;
-      for (j = i; j < i + step_size; j++)
-         butterfly(&butterfly_buf[j], &butterfly_buf[j + step_size], phase_lut[phase_step * (int)(j - i)]);
+      fft_complex_t a = buf[i];
+      fft_complex_t b = buf[i + 1];
+      buf[i]          = fft_complex_add(a, b);
+      buf[i + 1]      = fft_complex_sub(a, b);
    }
 }
 
-void fft_process_forward_complex(fft_t *fft,
-      fft_complex_t *out, const fft_complex_t *in, unsigned step)
+/* First pass of an even log2 size. Twiddles are all 1. */
+static void fft_pass_radix4_first(fft_complex_t *buf, unsigned samples)
 {
-   unsigned step_size;
-   unsigned samples = fft->size;
-   interleave_complex(fft->bitinverse_buffer, out, in, samples, step);
+   unsigned i;
+   for (i = 0; i < samples; i += 4)
+      fft_butterfly4(buf + i, buf + i + 1, buf + i + 2, buf + i + 3,
+            buf[i], buf[i + 1], buf[i + 2], buf[i + 3]);
+}
+
+#if defined(FFT_HAVE_SSE)
+/* Two complex numbers per vector. */
+static INLINE __m128 fft_twiddle_sse(__m128 a, const float *t)
+{
+   __m128 swapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+   return _mm_add_ps(_mm_mul_ps(a, _mm_loadu_ps(t)),
+         _mm_mul_ps(swapped, _mm_loadu_ps(t + 4)));
+}
 
-   for (step_size = 1; step_size < samples; step_size <<= 1)
+static void fft_pass_radix4(fft_complex_t *buf, const float *tw,
+      unsigned step, unsigned samples)
+{
+   unsigned i, k;
+   const __m128 neg_imag = _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+
+   for (i = 0; i < samples; i += step << 2)
    {
-      butterflies(out,
-            fft->phase_lut + samples,
-            -1, step_size, samples);
+      float *x0       = (float*)(buf + i);
+      float *x1       = x0 + 2 * step;
+      float *x2       = x1 + 2 * step;
+      float *x3       = x2 + 2 * step;
+      const float *t  = tw;
+
+      for (k = 0; k < 2 * step; k += 4, t += FFT_TWIDDLE_PAIR_FLOATS)
+      {
+         __m128 b0    = _mm_loadu_ps(x0 + k);
+         __m128 b1    = fft_twiddle_sse(_mm_loadu_ps(x1 + k), t + 8);
+         __m128 b2    = fft_twiddle_sse(_mm_loadu_ps(x2 + k), t);
+         __m128 b3    = fft_twiddle_sse(_mm_loadu_ps(x3 + k), t + 16);
+
+         __m128 sum0  = _mm_add_ps(b0, b1);
+         __m128 diff0 = _mm_sub_ps(b0, b1);
+         __m128 sum1  = _mm_add_ps(b2, b3);
+         __m128 diff1 = _mm_sub_ps(b2, b3);
+
+         /* diff1 *= -i */
+         diff1 = _mm_xor_ps(_mm_shuffle_ps(diff1, diff1,
+                  _MM_SHUFFLE(2, 3, 0, 1)), neg_imag);
+
+         _mm_storeu_ps(x0 + k, _mm_add_ps(sum0, sum1));
+         _mm_storeu_ps(x1 + k, _mm_add_ps(diff0, diff1));
+         _mm_storeu_ps(x2 + k, _mm_sub_ps(sum0, sum1));
+         _mm_storeu_ps(x3 + k, _mm_sub_ps(diff0, diff1));
+      }
    }
 }
+#elif defined(FFT_HAVE_NEON)
+/* Two complex numbers per vector. */
+static INLINE float32x4_t fft_twiddle_neon(float32x4_t a, const float *t)
+{
+   return vmlaq_f32(vmulq_f32(a, vld1q_f32(t)),
+         vrev64q_f32(a), vld1q_f32(t + 4));
+}
 
-void fft_process_forward(fft_t *fft,
-      fft_complex_t *out, const float *in, unsigned step)
+static void fft_pass_radix4(fft_complex_t *buf, const float *tw,
+      unsigned step, unsigned samples)
 {
-   unsigned step_size;
-   unsigned samples = fft->size;
-   interleave_float(fft->bitinverse_buffer, out, in, samples, step);
+   unsigned i, k;
+   static const float neg_imag_f[4] = { 1.0f, -1.0f, 1.0f, -1.0f };
+   const float32x4_t neg_imag       = vld1q_f32(neg_imag_f);
 
-   for (step_size = 1; step_size < fft->size; step_size <<= 1)
+   for (i = 0; i < samples; i += step << 2)
    {
-      butterflies(out,
-            fft->phase_lut + samples,
-            -1, step_size, samples);
+      float *x0       = (float*)(buf + i);
+      float *x1       = x0 + 2 * step;
+      float *x2       = x1 + 2 * step;
+      float *x3       = x2 + 2 * step;
+      const float *t  = tw;
+
+      for (k = 0; k < 2 * step; k += 4, t += FFT_TWIDDLE_PAIR_FLOATS)
+      {
+         float32x4_t b0    = vld1q_f32(x0 + k);
+         float32x4_t b1    = fft_twiddle_neon(vld1q_f32(x1 + k), t + 8);
+         float32x4_t b2    = fft_twiddle_neon(vld1q_f32(x2 + k), t);
+         float32x4_t b3    = fft_twiddle_neon(vld1q_f32(x3 + k), t + 16);
+
+         float32x4_t sum0  = vaddq_f32(b0, b1);
+         float32x4_t diff0 = vsubq_f32(b0, b1);
+         float32x4_t sum1  = vaddq_f32(b2, b3);
+         float32x4_t diff1 = vmulq_f32(vrev64q_f32(vsubq_f32(b2, b3)), neg_imag);
+
+         vst1q_f32(x0 + k, vaddq_f32(sum0, sum1));
+         vst1q_f32(x1 + k, vaddq_f32(diff0, diff1));
+         vst1q_f32(x2 + k, vsubq_f32(sum0, sum1));
+         vst1q_f32(x3 + k, vsubq_f32(diff0, diff1));
+      }
    }
 }
+#else
+static void fft_pass_radix4(fft_complex_t *buf, const float *tw,
+      unsigned step, unsigned samples)
+{
+   unsigned i, k;
 
-void fft_process_inverse(fft_t *fft,
-      float *out, const fft_complex_t *in, unsigned step)
+   for (i = 0; i < samples; i += step << 2)
+   {
+      fft_complex_t *x = buf + i;
+
+      for (k = 0; k < step; k++)
+      {
+         const float *t = tw + (k >> 1) * FFT_TWIDDLE_PAIR_FLOATS + (k & 1) * 2;
+
+         fft_butterfly4(x + k, x + k + step, x + k + 2 * step, x + k + 3 * step,
+               x[k],
+               fft_twiddle(x[k + step], t + 8),
+               fft_twiddle(x[k + 2 * step], t),
+               fft_twiddle(x[k + 3 * step], t + 16));
+      }
+   }
+}
+#endif
+
+static void fft_passes(const fft_t *fft, fft_complex_t *buf)
 {
-   unsigned step_size;
+   unsigned step;
    unsigned samples = fft->size;
-   interleave_complex(fft->bitinverse_buffer, fft->interleave_buffer, in, samples, 1);
+   const float *tw  = fft->twiddles;
 
-   for (step_size = 1; step_size < samples; step_size <<= 1)
+   if (samples < 2)
+      return;
+
+   if (fft->size_log2 & 1)
+      fft_pass_radix2_first(buf, samples);
+   else
+      fft_pass_radix4_first(buf, samples);
+
+   for (step = fft_first_twiddle_step(fft->size_log2);
+         step < samples; step <<= 2)
    {
-      butterflies(fft->interleave_buffer,
-            fft->phase_lut + samples,
-            1, step_size, samples);
+      fft_pass_radix4(buf, tw, step, samples);
+      tw += 12 * step;
    }
+}
+
+void fft_process_forward_complex(fft_t *fft,
+      fft_complex_t *out, const fft_complex_t *in, unsigned step)
+{
+   interleave_complex(fft->bitinverse_buffer, out, in, fft->size, step);
+   fft_passes(fft, out);
+}
+
+void fft_process_forward(fft_t *fft,
+      fft_complex_t *out, const float *in, unsigned step)
+{
+   interleave_float(fft->bitinverse_buffer, out, in, fft->size, step);
+   fft_passes(fft, out);
+}
+
+void fft_process_inverse(fft_t *fft,
+      float *out, const fft_complex_t *in, unsigned step)
+{
+   unsigned samples = fft->size;
+   interleave_complex_conj(fft->bitinverse_buffer,
+         fft->interleave_buffer, in, samples, 1);
+   fft_passes(fft, fft->interleave_buffer);
 
+   /* The real part is unaffected by the final conjugate. */
    resolve_float(out, fft->interleave_buffer, samples, 1.0f / samples, step);
 }
 
+void fft_process_inverse_complex(fft_t *fft,
+      fft_complex_t *out, const fft_complex_t *in, unsigned step)
+{
+   unsigned samples = fft->size;
+   interleave_complex_conj(fft->bitinverse_buffer, out, in, samples, step);
+   fft_passes(fft, out);
+   resolve_complex_conj(out, samples, 1.0f / samples);
+}
+
+#endif
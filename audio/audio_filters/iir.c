@@ -19,6 +19,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "stereo_simd.h"
+
 #ifndef M_PI
 #define M_PI		3.1415926535897932384626433832795
 #endif
@@ -43,14 +45,13 @@ enum IIRFilter
 
 struct iir_data
 {
+   /* Normalized by a0. */
    float b0, b1, b2;
-   float a0, a1, a2;
+   float a1, a2;
 
-   struct
-   {
-      float xn1, xn2;
-      float yn1, yn2;
-   } l, r;
+   /* Interleaved stereo history. */
+   float xn1[2], xn2[2];
+   float yn1[2], yn2[2];
 };
 
 static void iir_free(void *data)
@@ -62,61 +63,45 @@ static void iir_process(void *data, struct dspfilter_output *output,
       const struct dspfilter_input *input)
 {
    unsigned i;
+   float *out;
    struct iir_data *iir = (struct iir_data*)data;
+   stereo_t b0          = stereo_dup(iir->b0);
+   stereo_t b1          = stereo_dup(iir->b1);
+   stereo_t b2          = stereo_dup(iir->b2);
+   stereo_t a1          = stereo_dup(-iir->a1);
+   stereo_t a2          = stereo_dup(-iir->a2);
+   stereo_t xn1         = stereo_load(iir->xn1);
+   stereo_t xn2         = stereo_load(iir->xn2);
+   stereo_t yn1         = stereo_load(iir->yn1);
+   stereo_t yn2         = stereo_load(iir->yn2);
 
    output->samples = input->samples;
    output->frames  = input->frames;
 
-   float *out = output->samples;
-
-   float b0 = iir->b0;
-   float b1 = iir->b1;
-   float b2 = iir->b2;
-   float a0 = iir->a0;
-   float a1 = iir->a1;
-   float a2 = iir->a2;
-
-   float xn1_l = iir->l.xn1;
-   float xn2_l = iir->l.xn2;
-   float yn1_l = iir->l.yn1;
-   float yn2_l = iir->l.yn2;
-
-   float xn1_r = iir->r.xn1;
-   float xn2_r = iir->r.xn2;
-   float yn1_r = iir->r.yn1;
-   float yn2_r = iir->r.yn2;
+   out = output->samples;
 
    for (i = 0; i < input->frames; i++, out += 2)
    {
-      float in_l = out[0];
-      float in_r = out[1];
-
-      float l    = (b0 * in_l + b1 * xn1_l + b2 * xn2_l - a1 * yn1_l - a2 * yn2_l) / a0;
-      float r    = (b0 * in_r + b1 * xn1_r + b2 * xn2_r - a1 * yn1_r - a2 * yn2_r) / a0;
+      stereo_t in = stereo_load(out);
+      stereo_t y  = stereo_mul(b0, in);
 
-      xn2_l = xn1_l;
-      xn1_l = in_l;
-      yn2_l = yn1_l;
-      yn1_l = l;
+      y   = stereo_mla(y, b1, xn1);
+      y   = stereo_mla(y, b2, xn2);
+      y   = stereo_mla(y, a1, yn1);
+      y   = stereo_mla(y, a2, yn2);
 
-      xn2_r = xn1_r;
-      xn1_r = in_r;
-      yn2_r = yn1_r;
-      yn1_r = r;
+      xn2 = xn1;
+      xn1 = in;
+      yn2 = yn1;
+      yn1 = y;
 
-      out[0] = l;
-      out[1] = r;
+      stereo_store(out, y);
    }
 
-   iir->l.xn1 = xn1_l;
-   iir->l.xn2 = xn2_l;
-   iir->l.yn1 = yn1_l;
-   iir->l.yn2 = yn2_l;
-
-   iir->r.xn1 = xn1_r;
-   iir->r.xn2 = xn2_r;
-   iir->r.yn1 = yn1_r;
-   iir->r.yn2 = yn2_r;
+   stereo_store(iir->xn1, xn1);
+   stereo_store(iir->xn2, xn2);
+   stereo_store(iir->yn1, yn1);
+   stereo_store(iir->yn2, yn2);
 }
 
 #define CHECK(x) if (!strcmp(str, #x)) return x
@@ -308,12 +293,11 @@ static void iir_filter_init(struct iir_data *iir,
          break;
    }
 
-   iir->b0 = b0;
-   iir->b1 = b1;
-   iir->b2 = b2;
-   iir->a0 = a0;
-   iir->a1 = a1;
-   iir->a2 = a2;
+   iir->b0 = b0 / a0;
+   iir->b1 = b1 / a0;
+   iir->b2 = b2 / a0;
+   iir->a1 = a1 / a0;
+   iir->a2 = a2 / a0;
 }
 
 static void *iir_init(const struct dspfilter_info *info,
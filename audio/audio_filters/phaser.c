@@ -19,6 +19,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "stereo_simd.h"
+
 #define phaserlfoshape 4.0
 #define phaserlfoskipsamples 20
 
@@ -33,7 +35,8 @@ struct phaser_data
    float fb;
    float depth;
    float drywet;
-   float old[2][24];
+   /* Interleaved stereo state of each allpass stage. */
+   float old[24][2];
    float gain;
    float fbout[2];
    float lfoskip;
@@ -48,48 +51,72 @@ static void phaser_free(void *data)
    free(data);
 }
 
+/* The LFO moves the allpass stages once every phaserlfoskipsamples frames. */
+static void phaser_update(struct phaser_data *ph, unsigned long skipcount)
+{
+   ph->gain = 0.5 * (1.0 + cos(skipcount * ph->lfoskip + ph->phase));
+   ph->gain = (exp(ph->gain * phaserlfoshape) - 1.0) / (exp(phaserlfoshape) - 1);
+   ph->gain = 1.0 - ph->gain * ph->depth;
+}
+
 static void phaser_process(void *data, struct dspfilter_output *output,
       const struct dspfilter_input *input)
 {
-   unsigned i, c;
+   unsigned i;
    int s;
-   float m[2], tmp[2];
-   struct phaser_data *ph = (struct phaser_data*)data;
+   float *out;
+   unsigned frames         = input->frames;
+   struct phaser_data *ph  = (struct phaser_data*)data;
+   stereo_t fb             = stereo_dup(ph->fb * 0.01f);
+   stereo_t wet            = stereo_dup(ph->drywet);
+   stereo_t dry            = stereo_dup(1.0f - ph->drywet);
+   stereo_t fbout          = stereo_load(ph->fbout);
 
    output->samples = input->samples;
    output->frames  = input->frames;
-   float *out = output->samples;
+   out = output->samples;
 
-   for (i = 0; i < input->frames; i++, out += 2)
+   /* Runs of frames which share the same stage gain. */
+   while (frames)
    {
-      float in[2] = { out[0], out[1] };
+      stereo_t gain, neg_gain, gain_comp;
+      unsigned offset = ph->skipcount % phaserlfoskipsamples;
+      unsigned run    = phaserlfoskipsamples - offset;
 
-      for (c = 0; c < 2; c++)
-         m[c] = in[c] + ph->fbout[c] * ph->fb * 0.01f;
+      if (!offset)
+         phaser_update(ph, ph->skipcount + 1);
 
-      if ((ph->skipcount++ % phaserlfoskipsamples) == 0)
-      {
-         ph->gain = 0.5 * (1.0 + cos(ph->skipcount * ph->lfoskip + ph->phase));
-         ph->gain = (exp(ph->gain * phaserlfoshape) - 1.0) / (exp(phaserlfoshape) - 1);
-         ph->gain = 1.0 - ph->gain * ph->depth;
-      }
+      if (run > frames)
+         run = frames;
+
+      gain      = stereo_dup(ph->gain);
+      neg_gain  = stereo_dup(-ph->gain);
+      gain_comp = stereo_dup(1.0f - ph->gain * ph->gain);
 
-      for (s = 0; s < ph->stages; s++)
+      for (i = 0; i < run; i++, out += 2)
       {
-         for (c = 0; c < 2; c++)
+         stereo_t in = stereo_load(out);
+         stereo_t m  = stereo_mla(in, fbout, fb);
+
+         /* m = tmp - gain * (m + gain * tmp), rearranged so only
+          * one multiply-add per stage depends on the previous one. */
+         for (s = 0; s < ph->stages; s++)
          {
-            tmp[c] = ph->old[c][s];
-            ph->old[c][s] = ph->gain * tmp[c] + m[c];
-            m[c] = tmp[c] - ph->gain * ph->old[c][s];
+            stereo_t tmp = stereo_load(ph->old[s]);
+
+            stereo_store(ph->old[s], stereo_mla(m, gain, tmp));
+            m = stereo_mla(stereo_mul(gain_comp, tmp), neg_gain, m);
          }
-      }
 
-      for (c = 0; c < 2; c++)
-      {
-         ph->fbout[c] = m[c];
-         out[c] = m[c] * ph->drywet + in[c] * (1.0f - ph->drywet);
+         fbout = m;
+         stereo_store(out, stereo_mla(stereo_mul(m, wet), in, dry));
       }
+
+      ph->skipcount += run;
+      frames        -= run;
    }
+
+   stereo_store(ph->fbout, fbout);
 }
 
 static void *phaser_init(const struct dspfilter_info *info,
@@ -20,6 +20,15 @@
 #include <string.h>
 #include <retro_inline.h>
 
+#include "stereo_simd.h"
+
+#define REVERB_BLOCK 256
+
+#define numcombs 8
+#define numallpasses 4
+
+/* The delay lines hold interleaved stereo frames. Both channels
+ * share the same tuning, so they run in the two lanes of one vector. */
 struct comb
 {
    float *buffer;
@@ -27,7 +36,7 @@ struct comb
    unsigned bufidx;
 
    float feedback;
-   float filterstore;
+   float filterstore[2];
    float damp1, damp2;
 };
 
@@ -39,36 +48,99 @@ struct allpass
    unsigned bufidx;
 };
 
-static INLINE float comb_process(struct comb *c, float input)
+/* Runs @input through all @num combs and writes the sum of their
+ * outputs to @output. The combs are independent recursions, so
+ * stepping through all of them every frame keeps the pipeline busy.
+ * revmodel_update() gives every comb the same feedback and damping. */
+static void comb_process(struct comb *c, unsigned num, float *output,
+      const float *input, unsigned frames)
 {
-   float output = c->buffer[c->bufidx];
-   c->filterstore = (output * c->damp2) + (c->filterstore * c->damp1);
+   unsigned i, j;
+   stereo_t filterstore[numcombs];
+   stereo_t feedback = stereo_dup(c[0].feedback);
+   stereo_t damp1    = stereo_dup(c[0].damp1);
+   stereo_t damp2    = stereo_dup(c[0].damp2);
 
-   c->buffer[c->bufidx] = input + (c->filterstore * c->feedback);
+   for (i = 0; i < num; i++)
+      filterstore[i] = stereo_load(c[i].filterstore);
 
-   c->bufidx++;
-   if (c->bufidx >= c->bufsize)
-      c->bufidx = 0;
+   while (frames)
+   {
+      float *buf[numcombs];
+      unsigned run = frames;
+
+      /* No buffer wraps within a run. */
+      for (i = 0; i < num; i++)
+      {
+         if (run > c[i].bufsize - c[i].bufidx)
+            run = c[i].bufsize - c[i].bufidx;
+         buf[i] = c[i].buffer + c[i].bufidx * 2;
+      }
+
+      for (j = 0; j < run * 2; j += 2)
+      {
+         stereo_t in  = stereo_load(input + j);
+         stereo_t out = stereo_dup(0.0f);
+
+         for (i = 0; i < num; i++)
+         {
+            stereo_t bufout = stereo_load(buf[i] + j);
+            filterstore[i]  = stereo_mla(stereo_mul(bufout, damp2), filterstore[i], damp1);
+
+            stereo_store(buf[i] + j, stereo_mla(in, filterstore[i], feedback));
+            out = stereo_add(out, bufout);
+         }
+
+         stereo_store(output + j, out);
+      }
+
+      for (i = 0; i < num; i++)
+      {
+         c[i].bufidx += run;
+         if (c[i].bufidx >= c[i].bufsize)
+            c[i].bufidx = 0;
+      }
+
+      input  += run * 2;
+      output += run * 2;
+      frames -= run;
+   }
 
-   return output;
+   for (i = 0; i < num; i++)
+      stereo_store(c[i].filterstore, filterstore[i]);
 }
 
-
-static INLINE float allpass_process(struct allpass *a, float input)
+static void allpass_process(struct allpass *a, float *samples, unsigned frames)
 {
-   float bufout = a->buffer[a->bufidx];
-   float output = -input + bufout;
-   a->buffer[a->bufidx] = input + bufout * a->feedback;
+   unsigned i;
+   stereo_t feedback = stereo_dup(a->feedback);
+
+   while (frames)
+   {
+      unsigned run = a->bufsize - a->bufidx;
+      float *buf   = a->buffer + a->bufidx * 2;
 
-   a->bufidx++;
-   if (a->bufidx >= a->bufsize)
-      a->bufidx = 0;
+      if (run > frames)
+         run = frames;
 
-   return output;
+      for (i = 0; i < run * 2; i += 2)
+      {
+         stereo_t input  = stereo_load(samples + i);
+         stereo_t bufout = stereo_load(buf + i);
+
+         stereo_store(samples + i, stereo_sub(bufout, input));
+         stereo_store(buf + i, stereo_mla(input, bufout, feedback));
+      }
+
+      a->bufidx += run;
+      if (a->bufidx >= a->bufsize)
+         a->bufidx = 0;
+
+      samples += run * 2;
+      frames  -= run;
+   }
 }
 
-#define numcombs 8
-#define numallpasses 4
 static const float muted = 0;
 static const float fixedgain = 0.015f;
 static const float scalewet = 3;
@@ -102,19 +174,19 @@ struct revmodel
    struct comb combL[numcombs];
    struct allpass allpassL[numallpasses];
 
-   float bufcombL1[combtuningL1];
-   float bufcombL2[combtuningL2];
-   float bufcombL3[combtuningL3];
-   float bufcombL4[combtuningL4];
-   float bufcombL5[combtuningL5];
-   float bufcombL6[combtuningL6];
-   float bufcombL7[combtuningL7];
-   float bufcombL8[combtuningL8];
+   float bufcombL1[combtuningL1 * 2];
+   float bufcombL2[combtuningL2 * 2];
+   float bufcombL3[combtuningL3 * 2];
+   float bufcombL4[combtuningL4 * 2];
+   float bufcombL5[combtuningL5 * 2];
+   float bufcombL6[combtuningL6 * 2];
+   float bufcombL7[combtuningL7 * 2];
+   float bufcombL8[combtuningL8 * 2];
 
-   float bufallpassL1[allpasstuningL1];
-   float bufallpassL2[allpasstuningL2];
-   float bufallpassL3[allpasstuningL3];
-   float bufallpassL4[allpasstuningL4];
+   float bufallpassL1[allpasstuningL1 * 2];
+   float bufallpassL2[allpasstuningL2 * 2];
+   float bufallpassL3[allpasstuningL3 * 2];
+   float bufallpassL4[allpasstuningL4 * 2];
 
    float gain;
    float roomsize, roomsize1;
@@ -125,19 +197,30 @@ struct revmodel
    float mode;
 };
 
-static float revmodel_process(struct revmodel *rev, float in)
+/* Processes @frames interleaved stereo frames in place,
+ * at most REVERB_BLOCK at a time. */
+static void revmodel_process(struct revmodel *rev, float *samples, unsigned frames)
 {
    int i;
-   float mono_out = 0.0f;
-   float mono_in = in;
-   float input = mono_in * rev->gain;
-   for (i = 0; i < numcombs; i++)
-      mono_out += comb_process(&rev->combL[i], input);
+   unsigned j;
+   float input[REVERB_BLOCK * 2];
+   float wet[REVERB_BLOCK * 2];
+   stereo_t gain = stereo_dup(rev->gain);
+   stereo_t dry  = stereo_dup(rev->dry);
+   stereo_t wet1 = stereo_dup(rev->wet1);
+
+   for (j = 0; j < frames * 2; j += 2)
+      stereo_store(input + j, stereo_mul(stereo_load(samples + j), gain));
+
+   comb_process(rev->combL, numcombs, wet, input, frames);
 
    for (i = 0; i < numallpasses; i++)
-      mono_out = allpass_process(&rev->allpassL[i], mono_out);
+      allpass_process(&rev->allpassL[i], wet, frames);
 
-   return mono_in * rev->dry + mono_out * rev->wet1;
+   for (j = 0; j < frames * 2; j += 2)
+      stereo_store(samples + j, stereo_mla(
+               stereo_mul(stereo_load(samples + j), dry),
+               stereo_load(wet + j), wet1));
 }
 
 static void revmodel_update(struct revmodel *rev)
@@ -233,7 +316,7 @@ static void revmodel_init(struct revmodel *rev)
 
 struct reverb_data
 {
-   struct revmodel left, right;
+   struct revmodel rev;
 };
 
 static void reverb_free(void *data)
@@ -249,14 +332,14 @@ static void reverb_process(void *data, struct dspfilter_output *output,
 
    output->samples = input->samples;
    output->frames  = input->frames;
-   float *out = output->samples;
 
-   for (i = 0; i < input->frames; i++, out += 2)
+   for (i = 0; i < input->frames; i += REVERB_BLOCK)
    {
-      float in[2] = { out[0], out[1] };
+      unsigned frames = input->frames - i;
+      if (frames > REVERB_BLOCK)
+         frames = REVERB_BLOCK;
 
-      out[0] = revmodel_process(&rev->left, in[0]);
-      out[1] = revmodel_process(&rev->right, in[1]);
+      revmodel_process(&rev->rev, output->samples + i * 2, frames);
    }
 }
 
@@ -274,20 +357,13 @@ static void *reverb_init(const struct dspfilter_info *info,
    config->get_float(userdata, "roomwidth", &roomwidth, 0.56f);
    config->get_float(userdata, "roomsize", &roomsize, 0.56f);
 
-   revmodel_init(&rev->left);
-   revmodel_init(&rev->right);
-
-   revmodel_setdamp(&rev->left, damping);
-   revmodel_setdry(&rev->left, drytime);
-   revmodel_setwet(&rev->left, wettime);
-   revmodel_setwidth(&rev->left, roomwidth);
-   revmodel_setroomsize(&rev->left, roomsize);
+   revmodel_init(&rev->rev);
 
-   revmodel_setdamp(&rev->right, damping);
-   revmodel_setdry(&rev->right, drytime);
-   revmodel_setwet(&rev->right, wettime);
-   revmodel_setwidth(&rev->right, roomwidth);
-   revmodel_setroomsize(&rev->right, roomsize);
+   revmodel_setdamp(&rev->rev, damping);
+   revmodel_setdry(&rev->rev, drytime);
+   revmodel_setwet(&rev->rev, wettime);
+   revmodel_setwidth(&rev->rev, roomwidth);
+   revmodel_setroomsize(&rev->rev, roomsize);
 
    return rev;
 }
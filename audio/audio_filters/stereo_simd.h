@@ -0,0 +1,171 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DSPFILTER_STEREO_SIMD_H__
+#define DSPFILTER_STEREO_SIMD_H__
+
+#include <retro_inline.h>
+
+/* One interleaved stereo frame, left and right in two SIMD lanes.
+ *
+ * The plugins run both channels through the same recursion, so a
+ * frame maps onto one vector and the channel loop disappears.
+ * Loads and stores take a pointer to a left sample, which only
+ * needs float alignment. */
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+
+/* Only the two low lanes are used. */
+typedef __m128 stereo_t;
+
+static INLINE stereo_t stereo_load(const float *p)
+{
+   return _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)p);
+}
+
+static INLINE void stereo_store(float *p, stereo_t v)
+{
+   _mm_storel_pi((__m64*)p, v);
+}
+
+static INLINE stereo_t stereo_dup(float v)
+{
+   return _mm_set1_ps(v);
+}
+
+static INLINE stereo_t stereo_add(stereo_t a, stereo_t b)
+{
+   return _mm_add_ps(a, b);
+}
+
+static INLINE stereo_t stereo_sub(stereo_t a, stereo_t b)
+{
+   return _mm_sub_ps(a, b);
+}
+
+static INLINE stereo_t stereo_mul(stereo_t a, stereo_t b)
+{
+   return _mm_mul_ps(a, b);
+}
+
+/* a + b * c */
+static INLINE stereo_t stereo_mla(stereo_t a, stereo_t b, stereo_t c)
+{
+   return _mm_add_ps(a, _mm_mul_ps(b, c));
+}
+
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+
+typedef float32x2_t stereo_t;
+
+static INLINE stereo_t stereo_load(const float *p)
+{
+   return vld1_f32(p);
+}
+
+static INLINE void stereo_store(float *p, stereo_t v)
+{
+   vst1_f32(p, v);
+}
+
+static INLINE stereo_t stereo_dup(float v)
+{
+   return vdup_n_f32(v);
+}
+
+static INLINE stereo_t stereo_add(stereo_t a, stereo_t b)
+{
+   return vadd_f32(a, b);
+}
+
+static INLINE stereo_t stereo_sub(stereo_t a, stereo_t b)
+{
+   return vsub_f32(a, b);
+}
+
+static INLINE stereo_t stereo_mul(stereo_t a, stereo_t b)
+{
+   return vmul_f32(a, b);
+}
+
+/* a + b * c */
+static INLINE stereo_t stereo_mla(stereo_t a, stereo_t b, stereo_t c)
+{
+   return vmla_f32(a, b, c);
+}
+
+#else
+
+typedef struct
+{
+   float l, r;
+} stereo_t;
+
+static INLINE stereo_t stereo_load(const float *p)
+{
+   stereo_t v;
+   v.l = p[0];
+   v.r = p[1];
+   return v;
+}
+
+static INLINE void stereo_store(float *p, stereo_t v)
+{
+   p[0] = v.l;
+   p[1] = v.r;
+}
+
+static INLINE stereo_t stereo_dup(float f)
+{
+   stereo_t v;
+   v.l = f;
+   v.r = f;
+   return v;
+}
+
+static INLINE stereo_t stereo_add(stereo_t a, stereo_t b)
+{
+   a.l += b.l;
+   a.r += b.r;
+   return a;
+}
+
+static INLINE stereo_t stereo_sub(stereo_t a, stereo_t b)
+{
+   a.l -= b.l;
+   a.r -= b.r;
+   return a;
+}
+
+static INLINE stereo_t stereo_mul(stereo_t a, stereo_t b)
+{
+   a.l *= b.l;
+   a.r *= b.r;
+   return a;
+}
+
+/* a + b * c */
+static INLINE stereo_t stereo_mla(stereo_t a, stereo_t b, stereo_t c)
+{
+   a.l += b.l * c.l;
+   a.r += b.r * c.r;
+   return a;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,323 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks the FFT, the partitioned convolver and the WAV loader of the
+ * convolution plugin against naive references (-t), or measures how
+ * much of a core they take (default). */
+
+#define HAVE_FILTERS_BUILTIN
+#include "../convolution.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RATE 48000
+
+static unsigned failed;
+
+static void check(bool ok, const char *what, double err)
+{
+   printf("%-44s %10.2e  %s\n", what, err, ok ? "ok" : "FAIL");
+   if (!ok)
+      failed++;
+}
+
+static double now_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static float frand(unsigned *seed)
+{
+   *seed = *seed * 1103515245u + 12345u;
+   return ((*seed >> 8) & 0xffff) / 32768.0f - 1.0f;
+}
+
+static void test_fft(void)
+{
+   for (unsigned size_log2 = 0; size_log2 <= 11; size_log2++)
+   {
+      char what[64];
+      unsigned size = 1 << size_log2;
+      double err = 0.0, err_inv = 0.0;
+      fft_t *fft = fft_new(size_log2);
+      fft_complex_t *in = calloc(size, sizeof(*in));
+      fft_complex_t *out = calloc(size, sizeof(*out));
+      fft_complex_t *back = calloc(size, sizeof(*back));
+
+      for (unsigned i = 0; i < size; i++)
+      {
+         in[i].real = sin(i * 0.37) + 0.1 * (i % 7);
+         in[i].imag = cos(i * 1.3) - 0.05 * (i % 5);
+      }
+
+      fft_process_forward_complex(fft, out, in, 1);
+      fft_process_inverse_complex(fft, back, out, 1);
+
+      for (unsigned k = 0; k < size; k++)
+      {
+         double re = 0.0, im = 0.0;
+         for (unsigned i = 0; i < size; i++)
+         {
+            double phase = -2.0 * M_PI * i * k / size;
+            re += in[i].real * cos(phase) - in[i].imag * sin(phase);
+            im += in[i].real * sin(phase) + in[i].imag * cos(phase);
+         }
+         err = fmax(err, hypot(re - out[k].real, im - out[k].imag) / sqrt(size));
+         err_inv = fmax(err_inv, hypot(back[k].real - in[k].real,
+                  back[k].imag - in[k].imag));
+      }
+
+      snprintf(what, sizeof(what), "FFT %u vs DFT, round trip", size);
+      check(err < 1e-5 && err_inv < 1e-5, what, fmax(err, err_inv));
+
+      fft_free(fft);
+      free(in);
+      free(out);
+      free(back);
+   }
+}
+
+static void test_convolver(unsigned block_log2, unsigned taps, bool cross)
+{
+   char what[64];
+   unsigned seed = taps * 31 + block_log2;
+   unsigned block = 1 << block_log2;
+   unsigned frames = 4 * taps + 8 * block;
+   float *left = malloc(taps * sizeof(float));
+   float *right = malloc(taps * sizeof(float));
+   float *in = malloc(frames * 2 * sizeof(float));
+   float *out = malloc(frames * 2 * sizeof(float));
+   double err = 0.0, peak = 1.0;
+
+   for (unsigned i = 0; i < taps; i++)
+   {
+      left[i] = frand(&seed) * expf(-(float)i / taps);
+      right[i] = cross ? frand(&seed) : left[i];
+   }
+   for (unsigned i = 0; i < frames * 2; i++)
+      in[i] = out[i] = frand(&seed);
+
+   fft_convolver_t *conv = fft_convolver_new(block_log2,
+         left, cross ? right : left, taps);
+
+   /* Odd chunk sizes, so block boundaries fall anywhere. */
+   for (unsigned pos = 0; pos < frames; )
+   {
+      unsigned chunk = 1 + (frand(&seed) + 1.0f) * block;
+      if (chunk > frames - pos)
+         chunk = frames - pos;
+      fft_convolver_process(conv, out + pos * 2, chunk);
+      pos += chunk;
+   }
+
+   /* Output is delayed by exactly one block. */
+   for (unsigned i = block; i < frames; i++)
+   {
+      double l = 0.0, r = 0.0;
+      for (unsigned k = 0; k < taps && k <= i - block; k++)
+      {
+         l += left[k]  * in[(i - block - k) * 2 + 0];
+         r += right[k] * in[(i - block - k) * 2 + 1];
+      }
+      err = fmax(err, fmax(fabs(l - out[i * 2]), fabs(r - out[i * 2 + 1])));
+      peak = fmax(peak, fmax(fabs(l), fabs(r)));
+   }
+
+   snprintf(what, sizeof(what), "Convolver block %4u, %5u taps, %s",
+         block, taps, cross ? "stereo" : "mono");
+   check(err / peak < 1e-5, what, err / peak);
+
+   fft_convolver_free(conv);
+   free(left);
+   free(right);
+   free(in);
+   free(out);
+}
+
+static void put_le(uint8_t *p, uint32_t v, unsigned bytes)
+{
+   for (unsigned i = 0; i < bytes; i++)
+      p[i] = v >> (8 * i);
+}
+
+/* Builds a WAV in memory, with a chunk the parser has to skip. */
+static size_t make_wav(uint8_t *buf, unsigned format, unsigned channels,
+      unsigned bits, const int32_t *samples, unsigned frames)
+{
+   unsigned bytes = bits / 8;
+   size_t data_size = frames * channels * bytes;
+
+   memcpy(buf, "RIFF", 4);
+   put_le(buf + 4, 4 + 24 + 10 + 8 + data_size, 4);
+   memcpy(buf + 8, "WAVE", 4);
+
+   memcpy(buf + 12, "fmt ", 4);
+   put_le(buf + 16, 16, 4);
+   put_le(buf + 20, format, 2);
+   put_le(buf + 22, channels, 2);
+   put_le(buf + 24, RATE, 4);
+   put_le(buf + 28, RATE * channels * bytes, 4);
+   put_le(buf + 32, channels * bytes, 2);
+   put_le(buf + 34, bits, 2);
+
+   memcpy(buf + 36, "LIST", 4);
+   put_le(buf + 40, 1, 4);
+   buf[44] = buf[45] = 0;
+
+   memcpy(buf + 46, "data", 4);
+   put_le(buf + 50, data_size, 4);
+   for (unsigned i = 0; i < frames * channels; i++)
+      put_le(buf + 54 + i * bytes, samples[i], bytes);
+
+   return 54 + data_size;
+}
+
+static void test_wav(void)
+{
+   uint8_t buf[256];
+   struct convolution_ir ir = {0};
+   float half = 0.5f;
+   int32_t pcm16[] = { 0x4000, -0x8000, 0x2000, 0x7fff };
+   int32_t pcm24[] = { 0x400000, -0x200000 };
+   int32_t flt[2];
+   bool ok;
+   size_t size;
+
+   size = make_wav(buf, 1, 2, 16, pcm16, 2);
+   ok = convolution_parse_wav(&ir, buf, size) && ir.frames == 2
+      && ir.left != ir.right && ir.rate == RATE
+      && ir.left[0] == 0.5f && ir.right[0] == -1.0f
+      && ir.left[1] == 0.25f && fabsf(ir.right[1] - 1.0f) < 1e-4f;
+   check(ok, "WAV 16-bit stereo", 0.0);
+   convolution_ir_free(&ir);
+
+   size = make_wav(buf, 1, 1, 24, pcm24, 2);
+   ok = convolution_parse_wav(&ir, buf, size) && ir.frames == 2
+      && ir.left == ir.right
+      && ir.left[0] == 0.5f && ir.left[1] == -0.25f;
+   check(ok, "WAV 24-bit mono", 0.0);
+   convolution_ir_free(&ir);
+
+   memcpy(&flt[0], &half, sizeof(half));
+   flt[1] = 0;
+   size = make_wav(buf, 3, 1, 32, flt, 2);
+   ok = convolution_parse_wav(&ir, buf, size) && ir.frames == 2
+      && ir.left[0] == 0.5f && ir.left[1] == 0.0f;
+   check(ok, "WAV 32-bit float mono", 0.0);
+
+   /* Unit energy, then the dry signal on the first tap. */
+   convolution_mix(&ir, 1.0f, 0.5f);
+   check(fabsf(ir.left[0] - 1.5f) < 1e-6f, "WAV dry/wet mix", ir.left[0] - 1.5f);
+   convolution_ir_free(&ir);
+
+   memcpy(buf, "RIFX", 4);
+   check(!convolution_parse_wav(&ir, buf, size), "WAV rejects non-RIFF", 0.0);
+}
+
+/* Microseconds per 1024 frames of a @seconds long response. */
+static void bench_convolver(const char *name, unsigned block_log2,
+      double seconds, bool cross)
+{
+   unsigned seed = 1;
+   unsigned taps = seconds * RATE;
+   float *left = malloc(taps * sizeof(float));
+   float *right = malloc(taps * sizeof(float));
+   float buf[1024 * 2];
+   unsigned blocks = 0;
+   double start, elapsed, us;
+
+   for (unsigned i = 0; i < taps; i++)
+   {
+      left[i] = frand(&seed) * expf(-3.0f * i / taps);
+      right[i] = frand(&seed) * expf(-3.0f * i / taps);
+   }
+   for (unsigned i = 0; i < 1024 * 2; i++)
+      buf[i] = frand(&seed);
+
+   fft_convolver_t *conv = fft_convolver_new(block_log2,
+         left, cross ? right : left, taps);
+
+   start = now_ns();
+   do
+   {
+      fft_convolver_process(conv, buf, 1024);
+      blocks++;
+      elapsed = now_ns() - start;
+   } while (elapsed < 5e8);
+
+   us = elapsed / blocks / 1000.0;
+   printf("%-28s %6u %8u %10.1f %9.2f%%\n", name, 1 << block_log2, taps,
+         us, 100.0 * us * RATE / 1024.0 / 1e6);
+
+   fft_convolver_free(conv);
+   free(left);
+   free(right);
+}
+
+int main(int argc, char *argv[])
+{
+   bool test = false;
+   int opt;
+
+   while ((opt = getopt(argc, argv, "t")) != -1)
+   {
+      switch (opt)
+      {
+         case 't':
+            test = true;
+            break;
+         default:
+            fprintf(stderr, "Usage: %s [-t]\n"
+                  "  -t: check against naive references instead of benchmarking.\n",
+                  argv[0]);
+            return 1;
+      }
+   }
+
+   if (test)
+   {
+      test_fft();
+
+      for (unsigned b = 2; b <= 9; b += 7)
+         for (unsigned cross = 0; cross < 2; cross++)
+         {
+            test_convolver(b, 1, cross);
+            test_convolver(b, 100, cross);
+            test_convolver(b, 3001, cross);
+         }
+      test_convolver(6, 255, false);
+
+      test_wav();
+
+      printf("%u failed.\n", failed);
+      return failed ? 1 : 0;
+   }
+
+   printf("%-28s %6s %8s %10s %10s\n", "response", "block", "taps",
+         "us/1024", "of core");
+   bench_convolver("EQ, default", 6, 255.0 / RATE, false);
+   bench_convolver("3 s mono", 10, 3.0, false);
+   bench_convolver("3 s stereo", 10, 3.0, true);
+   bench_convolver("3 s stereo", 9, 3.0, true);
+   bench_convolver("3 s stereo", 11, 3.0, true);
+   return 0;
+}
@@ -0,0 +1,200 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Runs DSP presets through rarch_dsp_filter_new() the same way the
+ * frontend does, and reports how long the whole chain takes.
+ *
+ * Usage: dsp_chain [-r rate] [-n blocks] [preset.dsp ...]
+ *
+ * With no presets, every .dsp in the parent directory is run. Each
+ * preset processes blocks of 1024 stereo frames of a fixed signal.
+ * The report is the mean time per block in microseconds, and that as
+ * a share of one core at the given rate. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <file/dir_list.h>
+#include <file/file_path.h>
+#include <string/string_list.h>
+
+#include "audio_dsp_filter.h"
+
+#define CHAIN_FRAMES 1024
+
+/* The part of the frontend audio_dsp_filter.c depends on. */
+
+uint64_t rarch_get_cpu_features(void)
+{
+   return 0;
+}
+
+static double now_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* A few seconds of two detuned tones over quiet noise, with a short
+ * stretch of silence so the recursive filters decay as well. */
+static float *chain_signal(unsigned frames, float rate)
+{
+   unsigned i;
+   uint32_t state = 1;
+   float *buf     = (float*)malloc(frames * 2 * sizeof(float));
+
+   if (!buf)
+      return NULL;
+
+   for (i = 0; i < frames; i++)
+   {
+      float noise;
+
+      state = state * 1103515245u + 12345u;
+      noise = ((state >> 8) & 0xffff) / 32768.0f - 1.0f;
+
+      buf[2 * i + 0] = 0.4f * sin(2.0 * M_PI * 220.0 * i / rate) + 0.05f * noise;
+      buf[2 * i + 1] = 0.4f * sin(2.0 * M_PI * 331.0 * i / rate) - 0.05f * noise;
+
+      if (i % (frames / 4) >= frames / 4 - frames / 32)
+         buf[2 * i + 0] = buf[2 * i + 1] = 0.0f;
+   }
+
+   return buf;
+}
+
+/* Returns the mean time per block in microseconds, or a negative
+ * value if the preset does not load. */
+static double chain_run(const char *preset, float rate,
+      const float *signal, unsigned signal_frames, unsigned blocks)
+{
+   unsigned i, offset = 0;
+   unsigned warmup = signal_frames / CHAIN_FRAMES;
+   double start    = 0.0, elapsed;
+   float block[CHAIN_FRAMES * 2];
+   rarch_dsp_filter_t *dsp = rarch_dsp_filter_new(preset, rate);
+
+   if (!dsp)
+      return -1.0;
+
+   /* The first pass over the signal warms up the caches
+    * and fills the delay lines. */
+   for (i = 0; i < warmup + blocks; i++)
+   {
+      struct rarch_dsp_data data = {0};
+
+      if (i == warmup)
+         start = now_ns();
+
+      memcpy(block, signal + offset * 2, sizeof(block));
+      offset = (offset + CHAIN_FRAMES) % (signal_frames - CHAIN_FRAMES);
+
+      data.input        = block;
+      data.input_frames = CHAIN_FRAMES;
+      rarch_dsp_filter_process(dsp, &data);
+   }
+
+   elapsed = now_ns() - start;
+   rarch_dsp_filter_free(dsp);
+   return elapsed / blocks / 1000.0;
+}
+
+static void usage(void)
+{
+   fprintf(stderr, "Usage: dsp_chain [-r rate] [-n blocks] [preset.dsp ...]\n");
+}
+
+int main(int argc, char *argv[])
+{
+   int opt;
+   unsigned i;
+   unsigned blocks             = 2000;
+   float rate                  = 48000.0f;
+   unsigned signal_frames;
+   struct string_list *presets = NULL;
+   float *signal;
+
+   while ((opt = getopt(argc, argv, "r:n:")) != -1)
+   {
+      switch (opt)
+      {
+         case 'r':
+            rate = strtod(optarg, NULL);
+            break;
+         case 'n':
+            blocks = strtoul(optarg, NULL, 10);
+            break;
+         default:
+            usage();
+            return 1;
+      }
+   }
+
+   if (rate < 8000.0f || !blocks)
+   {
+      usage();
+      return 1;
+   }
+
+   if (optind < argc)
+   {
+      union string_list_elem_attr attr;
+
+      attr.i  = 0;
+      presets = string_list_new();
+      for (i = optind; i < (unsigned)argc; i++)
+         string_list_append(presets, argv[i], attr);
+   }
+   else
+   {
+      presets = dir_list_new("..", "dsp", false);
+      if (presets)
+         dir_list_sort(presets, false);
+   }
+
+   if (!presets || !presets->size)
+   {
+      fprintf(stderr, "No presets found.\n");
+      return 1;
+   }
+
+   signal_frames = (unsigned)rate * 4;
+   signal        = chain_signal(signal_frames, rate);
+   if (!signal)
+      return 1;
+
+   printf("%-24s %10s %10s\n", "preset", "us/1024", "of core");
+
+   for (i = 0; i < presets->size; i++)
+   {
+      const char *preset = presets->elems[i].data;
+      double us = chain_run(preset, rate, signal, signal_frames, blocks);
+
+      if (us < 0.0)
+         printf("%-24s %10s\n", path_basename(preset), "failed");
+      else
+         printf("%-24s %10.1f %9.2f%%\n", path_basename(preset),
+               us, 100.0 * us * rate / CHAIN_FRAMES / 1e6);
+   }
+
+   string_list_free(presets);
+   free(signal);
+   return 0;
+}
@@ -0,0 +1,27 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Every plugin in one translation unit, the way griffin builds them,
+ * since the EQ and the convolution reverb both include the FFT. */
+
+#include "../chorus.c"
+#include "../echo.c"
+#include "../eq.c"
+#include "../iir.c"
+#include "../panning.c"
+#include "../phaser.c"
+#include "../reverb.c"
+#include "../wahwah.c"
+#include "../convolution.c"
@@ -19,6 +19,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "stereo_simd.h"
+
 #define wahwahlfoskipsamples 30
 
 #ifndef M_PI
@@ -29,15 +31,15 @@ struct wahwah_data
 {
    float phase;
    float lfoskip;
-   float b0, b1, b2, a0, a1, a2;
+   /* Normalized by a0. */
+   float b0, b1, b2, a1, a2;
    float freq, startphase;
    float depth, freqofs, res;
    unsigned long skipcount;
 
-   struct
-   {
-      float xn1, xn2, yn1, yn2;
-   } l, r;
+   /* Interleaved stereo history. */
+   float xn1[2], xn2[2];
+   float yn1[2], yn2[2];
 };
 
 static void wahwah_free(void *data)
@@ -45,55 +47,89 @@ static void wahwah_free(void *data)
    free(data);
 }
 
+/* The LFO moves the filter once every wahwahlfoskipsamples frames. */
+static void wahwah_update(struct wahwah_data *wah, unsigned long skipcount)
+{
+   float omega, sn, cs, alpha, a0;
+   float frequency = (1.0 + cos(skipcount * wah->lfoskip + wah->phase)) / 2.0;
+
+   frequency = frequency * wah->depth * (1.0 - wah->freqofs) + wah->freqofs;
+   frequency = exp((frequency - 1.0) * 6.0);
+
+   omega = M_PI * frequency;
+   sn    = sin(omega);
+   cs    = cos(omega);
+   alpha = sn / (2.0 * wah->res);
+   a0    = 1.0 + alpha;
+
+   wah->b0 = (1.0 - cs) / 2.0 / a0;
+   wah->b1 = (1.0 - cs) / a0;
+   wah->b2 = (1.0 - cs) / 2.0 / a0;
+   wah->a1 = -2.0 * cs / a0;
+   wah->a2 = (1.0 - alpha) / a0;
+}
+
 static void wahwah_process(void *data, struct dspfilter_output *output,
       const struct dspfilter_input *input)
 {
    unsigned i;
+   float *out;
+   unsigned frames         = input->frames;
    struct wahwah_data *wah = (struct wahwah_data*)data;
+   stereo_t xn1            = stereo_load(wah->xn1);
+   stereo_t xn2            = stereo_load(wah->xn2);
+   stereo_t yn1            = stereo_load(wah->yn1);
+   stereo_t yn2            = stereo_load(wah->yn2);
 
    output->samples = input->samples;
    output->frames  = input->frames;
-   float *out = output->samples;
+   out = output->samples;
 
-   for (i = 0; i < input->frames; i++, out += 2)
+   /* Runs of frames which share the same coefficients. */
+   while (frames)
    {
-      float in[2] = { out[0], out[1] };
+      stereo_t b0, b1, b2, a1, a2;
+      unsigned offset = wah->skipcount % wahwahlfoskipsamples;
+      unsigned run    = wahwahlfoskipsamples - offset;
+
+      if (!offset)
+         wahwah_update(wah, wah->skipcount + 1);
 
-      if ((wah->skipcount++ % wahwahlfoskipsamples) == 0)
+      if (run > frames)
+         run = frames;
+
+      b0 = stereo_dup(wah->b0);
+      b1 = stereo_dup(wah->b1);
+      b2 = stereo_dup(wah->b2);
+      a1 = stereo_dup(-wah->a1);
+      a2 = stereo_dup(-wah->a2);
+
+      for (i = 0; i < run; i++, out += 2)
       {
-         float frequency = (1.0 + cos(wah->skipcount * wah->lfoskip + wah->phase)) / 2.0;
-         frequency = frequency * wah->depth * (1.0 - wah->freqofs) + wah->freqofs;
-         frequency = exp((frequency - 1.0) * 6.0);
-
-         float omega = M_PI * frequency;
-         float sn = sin(omega);
-         float cs = cos(omega);
-         float alpha = sn / (2.0 * wah->res);
-
-         wah->b0 = (1.0 - cs) / 2.0;
-         wah->b1 = 1.0 - cs;
-         wah->b2 = (1.0 - cs) / 2.0;
-         wah->a0 = 1.0 + alpha;
-         wah->a1 = -2.0 * cs;
-         wah->a2 = 1.0 - alpha;
-      }
+         stereo_t in = stereo_load(out);
+         stereo_t y  = stereo_mul(b0, in);
 
-      float out_l = (wah->b0 * in[0] + wah->b1 * wah->l.xn1 + wah->b2 * wah->l.xn2 - wah->a1 * wah->l.yn1 - wah->a2 * wah->l.yn2) / wah->a0;
-      float out_r = (wah->b0 * in[1] + wah->b1 * wah->r.xn1 + wah->b2 * wah->r.xn2 - wah->a1 * wah->r.yn1 - wah->a2 * wah->r.yn2) / wah->a0;
+         y   = stereo_mla(y, b1, xn1);
+         y   = stereo_mla(y, b2, xn2);
+         y   = stereo_mla(y, a1, yn1);
+         y   = stereo_mla(y, a2, yn2);
 
-      wah->l.xn2 = wah->l.xn1;
-      wah->l.xn1 = in[0];
-      wah->l.yn2 = wah->l.yn1;
-      wah->l.yn1 = out_l;
+         xn2 = xn1;
+         xn1 = in;
+         yn2 = yn1;
+         yn1 = y;
 
-      wah->r.xn2 = wah->r.xn1;
-      wah->r.xn1 = in[1];
-      wah->r.yn2 = wah->r.yn1;
-      wah->r.yn1 = out_r;
+         stereo_store(out, y);
+      }
 
-      out[0] = out_l;
-      out[1] = out_r;
+      wah->skipcount += run;
+      frames         -= run;
    }
+
+   stereo_store(wah->xn1, xn1);
+   stereo_store(wah->xn2, xn2);
+   stereo_store(wah->yn1, yn1);
+   stereo_store(wah->yn2, yn2);
 }
 
 static void *wahwah_init(const struct dspfilter_info *info,
@@ -38,6 +38,7 @@ static const struct resampler_config resampler_config = {
    config_userdata_get_int_array,
    config_userdata_get_string,
    config_userdata_free,
+   RESAMPLER_QUALITY_DONTCARE,
 };
 
 /**
@@ -182,6 +183,7 @@ static resampler_simd_mask_t resampler_get_cpu_features(void)
  * @re                         : Resampler handle
  * @backend                    : Resampler backend that is about to be set.
  * @bw_ratio                   : Bandwidth ratio.
+ * @quality                    : Requested quality (RESAMPLER_QUALITY_*).
  *
  * Initializes resampler driver based on queried CPU features.
  *
@@ -189,11 +191,13 @@ static resampler_simd_mask_t resampler_get_cpu_features(void)
  **/
 static bool resampler_append_plugs(void **re,
       const rarch_resampler_t **backend,
-      double bw_ratio)
+      double bw_ratio, enum resampler_quality quality)
 {
-   resampler_simd_mask_t mask = resampler_get_cpu_features();
+   struct resampler_config config = resampler_config;
+   resampler_simd_mask_t mask     = resampler_get_cpu_features();
 
-   *re = (*backend)->init(&resampler_config, bw_ratio, mask);
+   config.quality = quality;
+   *re = (*backend)->init(&config, bw_ratio, mask);
 
    if (!*re)
       return false;
@@ -206,6 +210,7 @@ static bool resampler_append_plugs(void **re,
  * @backend                    : Resampler backend that is about to be set.
  * @ident                      : Identifier name for resampler we want.
  * @bw_ratio                   : Bandwidth ratio.
+ * @quality                    : Requested quality (RESAMPLER_QUALITY_*).
  *
  * Reallocates resampler. Will free previous handle before 
  * allocating a new one. If ident is NULL, first resampler will be used.
@@ -213,7 +218,7 @@ static bool resampler_append_plugs(void **re,
  * Returns: true (1) if successful, otherwise false (0).
  **/
 bool rarch_resampler_realloc(void **re, const rarch_resampler_t **backend,
-      const char *ident, double bw_ratio)
+      const char *ident, double bw_ratio, enum resampler_quality quality)
 {
    if (*re && *backend)
       (*backend)->free(*re);
@@ -221,7 +226,7 @@ bool rarch_resampler_realloc(void **re, const rarch_resampler_t **backend,
    *re      = NULL;
    *backend = find_resampler_driver(ident);
 
-   if (!resampler_append_plugs(re, backend, bw_ratio))
+   if (!resampler_append_plugs(re, backend, bw_ratio, quality))
       goto error;
 
    return true;
@@ -53,7 +53,19 @@ extern "C" {
  */
 typedef unsigned resampler_simd_mask_t;
 
-#define RESAMPLER_API_VERSION 1
+#define RESAMPLER_API_VERSION 2
+
+/* Requested trade-off between quality and CPU time.
+ * DONTCARE lets the resampler pick its build default. */
+enum resampler_quality
+{
+   RESAMPLER_QUALITY_DONTCARE = 0,
+   RESAMPLER_QUALITY_LOWEST,
+   RESAMPLER_QUALITY_LOWER,
+   RESAMPLER_QUALITY_NORMAL,
+   RESAMPLER_QUALITY_HIGHER,
+   RESAMPLER_QUALITY_HIGHEST
+};
 
 struct resampler_data
 {
@@ -64,6 +76,10 @@ struct resampler_data
    size_t output_frames;
 
    double ratio;
+
+   /* Linear gain applied to every output sample.
+    * Use 1.0 for unity gain; 0.0 mutes. */
+   float gain;
 };
 
 /* Returns true if config key was found. Otherwise, 
@@ -103,6 +119,8 @@ struct resampler_config
    /* Avoid problems where resampler plug and host are 
     * linked against different C runtimes. */
    resampler_config_free_t free; 
+
+   enum resampler_quality quality;
 };
 
 /* Bandwidth factor. Will be < 1.0 for downsampling, > 1.0 for upsampling. 
@@ -178,6 +196,7 @@ const char *audio_resampler_driver_find_ident(int index);
  * @backend                    : Resampler backend that is about to be set.
  * @ident                      : Identifier name for resampler we want.
  * @bw_ratio                   : Bandwidth ratio.
+ * @quality                    : Requested quality (RESAMPLER_QUALITY_*).
  *
  * Reallocates resampler. Will free previous handle before 
  * allocating a new one. If ident is NULL, first resampler will be used.
@@ -185,7 +204,7 @@ const char *audio_resampler_driver_find_ident(int index);
  * Returns: true (1) if successful, otherwise false (0).
  **/
 bool rarch_resampler_realloc(void **re, const rarch_resampler_t **backend,
-      const char *ident, double bw_ratio);
+      const char *ident, double bw_ratio, enum resampler_quality quality);
 
 /* Convenience macros.
  * freep makes sure to set handles to NULL to avoid double-free 
@@ -25,6 +25,8 @@
 
 #ifdef RARCH_INTERNAL
 #include "../performance.h"
+#else
+#include "../libretro.h"
 #endif
 
 /**
@@ -20,7 +20,7 @@
 #include <alsa/asoundlib.h>
 #include "../../general.h"
 #include <rthreads/rthreads.h>
-#include <queues/fifo_buffer.h>
+#include <queues/spsc_ring.h>
 
 #define TRY_ALSA(x) if (x < 0) { \
                   goto error; \
@@ -38,13 +38,40 @@ typedef struct alsa_thread
    size_t period_size;
    snd_pcm_uframes_t period_frames;
 
-   fifo_buffer_t *buffer;
+   /* Samples go through a lock-free ring. The lock and condition
+    * are only used when the writer has to wait for room. */
+   spsc_ring_t *buffer;
    sthread_t *worker_thread;
-   slock_t *fifo_lock;
    scond_t *cond;
    slock_t *cond_lock;
+   retro_atomic_int_t writer_waiting;
 } alsa_thread_t;
 
+/* Wakes up alsa_thread_write() if it is waiting for room. */
+static void alsa_thread_wake_writer(alsa_thread_t *alsa)
+{
+   /* Orders our read index update before the check, pairs with
+    * the fence in alsa_thread_wait_writable(). */
+   retro_atomic_fence();
+   if (!retro_atomic_load_acquire(&alsa->writer_waiting))
+      return;
+
+   slock_lock(alsa->cond_lock);
+   scond_signal(alsa->cond);
+   slock_unlock(alsa->cond_lock);
+}
+
+static void alsa_thread_wait_writable(alsa_thread_t *alsa)
+{
+   slock_lock(alsa->cond_lock);
+   retro_atomic_store_release(&alsa->writer_waiting, 1);
+   retro_atomic_fence();
+   if (!spsc_ring_write_avail(alsa->buffer) && !alsa->thread_dead)
+      scond_wait(alsa->cond, alsa->cond_lock);
+   retro_atomic_store_release(&alsa->writer_waiting, 0);
+   slock_unlock(alsa->cond_lock);
+}
+
 static void alsa_worker_thread(void *data)
 {
    alsa_thread_t *alsa = (alsa_thread_t*)data;
@@ -58,18 +85,13 @@ static void alsa_worker_thread(void *data)
 
    while (!alsa->thread_dead)
    {
-      size_t avail;
-      size_t fifo_size;
       snd_pcm_sframes_t frames;
-      slock_lock(alsa->fifo_lock);
-      avail = fifo_read_avail(alsa->buffer);
-      fifo_size = min(alsa->period_size, avail);
-      fifo_read(alsa->buffer, buf, fifo_size);
-      scond_signal(alsa->cond);
-      slock_unlock(alsa->fifo_lock);
+      size_t read_size = spsc_ring_read(alsa->buffer, buf, alsa->period_size);
+
+      alsa_thread_wake_writer(alsa);
 
       /* If underrun, fill rest with silence. */
-      memset(buf + fifo_size, 0, alsa->period_size - fifo_size);
+      memset(buf + read_size, 0, alsa->period_size - read_size);
 
       frames = snd_pcm_writei(alsa->pcm, buf, alsa->period_frames);
 
@@ -131,11 +153,9 @@ static void alsa_thread_free(void *data)
          sthread_join(alsa->worker_thread);
       }
       if (alsa->buffer)
-         fifo_free(alsa->buffer);
+         spsc_ring_free(alsa->buffer);
       if (alsa->cond)
          scond_free(alsa->cond);
-      if (alsa->fifo_lock)
-         slock_free(alsa->fifo_lock);
       if (alsa->cond_lock)
          slock_free(alsa->cond_lock);
       if (alsa->pcm)
@@ -209,11 +229,10 @@ static void *alsa_thread_init(const char *device,
    snd_pcm_hw_params_free(params);
    snd_pcm_sw_params_free(sw_params);
 
-   alsa->fifo_lock = slock_new();
    alsa->cond_lock = slock_new();
    alsa->cond = scond_new();
-   alsa->buffer = fifo_new(alsa->buffer_size);
-   if (!alsa->fifo_lock || !alsa->cond_lock || !alsa->cond || !alsa->buffer)
+   alsa->buffer = spsc_ring_new(alsa->buffer_size);
+   if (!alsa->cond_lock || !alsa->cond || !alsa->buffer)
       goto error;
 
    alsa->worker_thread = sthread_create(alsa_worker_thread, alsa);
@@ -246,40 +265,17 @@ static ssize_t alsa_thread_write(void *data, const void *buf, size_t size)
       return -1;
 
    if (alsa->nonblock)
-   {
-      size_t avail;
-      size_t write_amt;
-      slock_lock(alsa->fifo_lock);
-      avail = fifo_write_avail(alsa->buffer);
-      write_amt = min(avail, size);
-      fifo_write(alsa->buffer, buf, write_amt);
-      slock_unlock(alsa->fifo_lock);
-      return write_amt;
-   }
+      return spsc_ring_write(alsa->buffer, buf, size);
    else
    {
       size_t written = 0;
       while (written < size && !alsa->thread_dead)
       {
-         size_t avail;
-         slock_lock(alsa->fifo_lock);
-         avail = fifo_write_avail(alsa->buffer);
+         written += spsc_ring_write(alsa->buffer,
+               (const char*)buf + written, size - written);
 
-         if (avail == 0)
-         {
-            slock_unlock(alsa->fifo_lock);
-            slock_lock(alsa->cond_lock);
-            if (!alsa->thread_dead)
-               scond_wait(alsa->cond, alsa->cond_lock);
-            slock_unlock(alsa->cond_lock);
-         }
-         else
-         {
-            size_t write_amt = min(size - written, avail);
-            fifo_write(alsa->buffer, (const char*)buf + written, write_amt);
-            slock_unlock(alsa->fifo_lock);
-            written += write_amt;
-         }
+         if (written < size)
+            alsa_thread_wait_writable(alsa);
       }
       return written;
    }
@@ -320,14 +316,10 @@ static bool alsa_thread_start(void *data)
 static size_t alsa_thread_write_avail(void *data)
 {
    alsa_thread_t *alsa = (alsa_thread_t*)data;
-   size_t val;
 
    if (alsa->thread_dead)
       return 0;
-   slock_lock(alsa->fifo_lock);
-   val = fifo_write_avail(alsa->buffer);
-   slock_unlock(alsa->fifo_lock);
-   return val;
+   return spsc_ring_write_avail(alsa->buffer);
 }
 
 static size_t alsa_thread_buffer_size(void *data)
@@ -83,6 +83,20 @@ static void memalign_free__(void *ptr)
    free(p[-1]);
 }
 
+/* The kernels below write unity gain output; scale
+ * it while the block is still hot in the cache. */
+static void resampler_CC_apply_gain(struct resampler_data *data)
+{
+   size_t i;
+   float *out = data->data_out;
+
+   if (data->gain == 1.0f)
+      return;
+
+   for (i = 0; i < data->output_frames * 2; i++)
+      out[i] *= data->gain;
+}
+
 #ifdef _MIPS_ARCH_ALLEGREX
 static void resampler_CC_process(void *re_, struct resampler_data *data)
 {
@@ -175,6 +189,7 @@ static void resampler_CC_process(void *re_, struct resampler_data *data)
 
 done:
    data->output_frames = outp - (audio_frame_float_t*)data->data_out;
+   resampler_CC_apply_gain(data);
 }
 
 
@@ -529,8 +544,11 @@ static void resampler_CC_upsample(void *re_, struct resampler_data *data)
 static void resampler_CC_process(void *re_, struct resampler_data *data)
 {
    rarch_CC_resampler_t *re = (rarch_CC_resampler_t*)re_;
-   if (re)
-      re->process(re_, data);
+   if (!re)
+      return;
+
+   re->process(re_, data);
+   resampler_CC_apply_gain(data);
 }
 
 static void resampler_CC_free(void *re_)
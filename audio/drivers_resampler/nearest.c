@@ -32,12 +32,15 @@ static void resampler_nearest_process(
    audio_frame_float_t  *inp_max = (audio_frame_float_t*)inp + data->input_frames;
    audio_frame_float_t  *outp    = (audio_frame_float_t*)data->data_out;
    float                   ratio = 1.0 / data->ratio;
+   float                   gain  = data->gain;
  
    while(inp != inp_max)
    {
       while(re->fraction > 1)
       {
-         *outp++ = *inp;
+         outp->l = inp->l * gain;
+         outp->r = inp->r * gain;
+         outp++;
          re->fraction -= ratio;
       }
       re->fraction++;
@@ -24,6 +24,30 @@
 #ifdef __SSE__
 #include <xmmintrin.h>
 #endif
+
+/* FMA/AVX2 kernel, built with a target attribute and picked
+ * at runtime, so the rest of the file keeps the baseline ISA. */
+#if (defined(__x86_64__) || defined(__i386__)) \
+   && (defined(__clang__) || (defined(__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SINC_HAVE_AVX2 1
+#define SINC_AVX2 __attribute__((target("avx2,fma")))
+#include <immintrin.h>
+
+/* Below this, the cost of going to 256-bit registers outweighs
+ * the wider loop and the 128-bit FMA kernel is faster. */
+#define SINC_AVX2_MIN_TAPS 128
+#endif
+
+/* __ARM_NEON is only defined when the compiler may emit NEON.
+ * Android defines __ARM_NEON__ by hand for plain ARMv7a builds,
+ * which only get the hand-written asm kernel. */
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#define SINC_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#include <memalign.h>
 #include <retro_inline.h>
 
 /* Rough SNR values for upsampling:
@@ -34,71 +58,69 @@
  * HIGHEST: 140 dB
  */
 
-/* TODO, make all this more configurable. */
+/* Used when the frontend asks for RESAMPLER_QUALITY_DONTCARE. */
 #if defined(SINC_LOWEST_QUALITY)
-#define SINC_WINDOW_LANCZOS
-#define CUTOFF 0.98
-#define PHASE_BITS 12
-#define SINC_COEFF_LERP 0
-#define SUBPHASE_BITS 10
-#define SIDELOBES 2
-#define ENABLE_AVX 0
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_LOWEST
 #elif defined(SINC_LOWER_QUALITY)
-#define SINC_WINDOW_LANCZOS
-#define CUTOFF 0.98
-#define PHASE_BITS 12
-#define SUBPHASE_BITS 10
-#define SINC_COEFF_LERP 0
-#define SIDELOBES 4
-#define ENABLE_AVX 0
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_LOWER
 #elif defined(SINC_HIGHER_QUALITY)
-#define SINC_WINDOW_KAISER
-#define SINC_WINDOW_KAISER_BETA 10.5
-#define CUTOFF 0.90
-#define PHASE_BITS 10
-#define SUBPHASE_BITS 14
-#define SINC_COEFF_LERP 1
-#define SIDELOBES 32
-#define ENABLE_AVX 1
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_HIGHER
 #elif defined(SINC_HIGHEST_QUALITY)
-#define SINC_WINDOW_KAISER
-#define SINC_WINDOW_KAISER_BETA 14.5
-#define CUTOFF 0.962
-#define PHASE_BITS 10
-#define SUBPHASE_BITS 14
-#define SINC_COEFF_LERP 1
-#define SIDELOBES 128
-#define ENABLE_AVX 1
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_HIGHEST
 #else
-#define SINC_WINDOW_KAISER
-#define SINC_WINDOW_KAISER_BETA 5.5
-#define CUTOFF 0.825
-#define PHASE_BITS 8
-#define SUBPHASE_BITS 16
-#define SINC_COEFF_LERP 1
-#define SIDELOBES 8
-#define ENABLE_AVX 0
+#define SINC_DEFAULT_QUALITY RESAMPLER_QUALITY_NORMAL
 #endif
 
-/* For the little amount of taps we're using,
- * SSE1 is faster than AVX for some reason.
- * AVX code is kept here though as by increasing number
- * of sinc taps, the AVX code is clearly faster than SSE1.
- */
+enum sinc_window
+{
+   SINC_WINDOW_LANCZOS = 0,
+   SINC_WINDOW_KAISER
+};
 
-#if defined(__AVX__) && ENABLE_AVX
-#include <immintrin.h>
-#endif
+struct sinc_params
+{
+   enum sinc_window window;
+   double kaiser_beta;
+   double cutoff;
+   unsigned phase_bits;
+   unsigned subphase_bits;
+   bool lerp;
+   unsigned sidelobes;
+};
 
-#define PHASES (1 << (PHASE_BITS + SUBPHASE_BITS))
+/* Indexed by RESAMPLER_QUALITY_* - RESAMPLER_QUALITY_LOWEST. */
+static const struct sinc_params sinc_params[] = {
+   { SINC_WINDOW_LANCZOS, 0.0,  0.98,  12, 10, false, 2   },
+   { SINC_WINDOW_LANCZOS, 0.0,  0.98,  12, 10, false, 4   },
+   { SINC_WINDOW_KAISER,  5.5,  0.825, 8,  16, true,  8   },
+   { SINC_WINDOW_KAISER,  10.5, 0.90,  10, 14, true,  32  },
+   { SINC_WINDOW_KAISER,  14.5, 0.962, 10, 14, true,  128 },
+};
 
-#define TAPS (SIDELOBES * 2)
-#define SUBPHASE_MASK ((1 << SUBPHASE_BITS) - 1)
-#define SUBPHASE_MOD (1.0f / (1 << SUBPHASE_BITS))
+/* Phase tables only depend on the quality, cutoff and number of
+ * taps, so every resampler with the same ones (e.g. the audio
+ * driver and the recording backend) shares one copy.
+ * Resamplers are created and freed on the main thread only. */
+struct sinc_phase_table
+{
+   float *data;
+   const struct sinc_params *params;
+   double cutoff;
+   unsigned taps;
+   unsigned refcount;
+   struct sinc_phase_table *next;
+};
 
-typedef struct rarch_sinc_resampler
+static struct sinc_phase_table *sinc_phase_tables;
+
+typedef struct rarch_sinc_resampler rarch_sinc_resampler_t;
+
+typedef void (*sinc_process_t)(rarch_sinc_resampler_t *resamp,
+      float *out_buffer);
+
+struct rarch_sinc_resampler
 {
-   float *phase_table;
+   const float *phase_table;
    float *buffer_l;
    float *buffer_r;
 
@@ -107,11 +129,22 @@ typedef struct rarch_sinc_resampler
    unsigned ptr;
    uint32_t time;
 
-   /* A buffer for phase_table, buffer_l and buffer_r 
-    * are created in a single calloc().
-    * Ensure that we get as good cache locality as we can hope for. */
+   uint32_t phases;
+   unsigned subphase_bits;
+   uint32_t subphase_mask;
+   float subphase_mod;
+   bool lerp;
+
+   /* Output gain of the current process() call. */
+   float gain;
+
+   sinc_process_t process;
+
+   struct sinc_phase_table *table;
+
+   /* buffer_l and buffer_r live in one allocation. */
    float *main_buffer;
-} rarch_sinc_resampler_t;
+};
 
 static INLINE double sinc(double val)
 {
@@ -120,12 +153,6 @@ static INLINE double sinc(double val)
    return sin(val) / val;
 }
 
-#if defined(SINC_WINDOW_LANCZOS)
-static INLINE double window_function(double idx)
-{
-   return sinc(M_PI * idx);
-}
-#elif defined(SINC_WINDOW_KAISER)
 /* Modified Bessel function of first order.
  * Check Wiki for mathematical definition ... */
 static INLINE double besseli0(double x)
@@ -153,19 +180,19 @@ static INLINE double besseli0(double x)
    return sum;
 }
 
-static INLINE double window_function(double idx)
+static INLINE double window_function(const struct sinc_params *params,
+      double idx)
 {
-   return besseli0(SINC_WINDOW_KAISER_BETA * sqrt(1 - idx * idx));
+   if (params->window == SINC_WINDOW_KAISER)
+      return besseli0(params->kaiser_beta * sqrt(1 - idx * idx));
+   return sinc(M_PI * idx);
 }
-#else
-#error "No SINC window function defined."
-#endif
 
-static void init_sinc_table(rarch_sinc_resampler_t *resamp, double cutoff,
+static void init_sinc_table(const struct sinc_params *params, double cutoff,
       float *phase_table, int phases, int taps, bool calculate_delta)
 {
    int i, j, p;
-   double    window_mod = window_function(0.0); /* Need to normalize w(0) to 1.0. */
+   double    window_mod = window_function(params, 0.0); /* Need to normalize w(0) to 1.0. */
    int           stride = calculate_delta ? 2 : 1;
    double     sidelobes = taps / 2.0;
 
@@ -181,7 +208,7 @@ static void init_sinc_table(rarch_sinc_resampler_t *resamp, double cutoff,
          sinc_phase = sidelobes * window_phase;
 
          val = cutoff * sinc(M_PI * sinc_phase * cutoff) * 
-            window_function(window_phase) / window_mod;
+            window_function(params, window_phase) / window_mod;
          phase_table[i * stride * taps + j] = val;
       }
    }
@@ -211,128 +238,130 @@ static void init_sinc_table(rarch_sinc_resampler_t *resamp, double cutoff,
          sinc_phase = sidelobes * window_phase;
 
          val = cutoff * sinc(M_PI * sinc_phase * cutoff) * 
-            window_function(window_phase) / window_mod;
+            window_function(params, window_phase) / window_mod;
          delta = (val - phase_table[phase * stride * taps + j]);
          phase_table[(phase * stride + 1) * taps + j] = delta;
       }
    }
 }
 
-/* No memalign() for us on Win32 ... */
-static void *aligned_alloc__(size_t boundary, size_t size)
+/**
+ * sinc_phase_table_get:
+ * @params                     : Quality parameters.
+ * @cutoff                     : Cutoff, already scaled for downsampling.
+ * @taps                       : Number of taps, already rounded for SIMD.
+ *
+ * Returns: a reference to a phase table matching the arguments,
+ * building it if no resampler holds one yet. NULL on OOM.
+ **/
+static struct sinc_phase_table *sinc_phase_table_get(
+      const struct sinc_params *params, double cutoff, unsigned taps)
 {
-   void **place;
-   uintptr_t addr = 0;
-   void *ptr = malloc(boundary + size + sizeof(uintptr_t));
+   size_t elems;
+   struct sinc_phase_table *table;
+
+   for (table = sinc_phase_tables; table; table = table->next)
+   {
+      if (table->params == params && table->cutoff == cutoff
+            && table->taps == taps)
+      {
+         table->refcount++;
+         return table;
+      }
+   }
 
-   if (!ptr)
+   table = (struct sinc_phase_table*)calloc(1, sizeof(*table));
+   if (!table)
       return NULL;
 
-   addr           = ((uintptr_t)ptr + sizeof(uintptr_t) + boundary) 
-                    & ~(boundary - 1);
-   place          = (void**)addr;
-   place[-1]      = ptr;
+   elems = ((size_t)1 << params->phase_bits) * taps;
+   if (params->lerp)
+      elems *= 2;
 
-   return (void*)addr;
-}
+   table->data = (float*)memalign_alloc(64, elems * sizeof(float));
+   if (!table->data)
+   {
+      free(table);
+      return NULL;
+   }
 
-static void aligned_free__(void *ptr)
-{
-   void **p = (void**)ptr;
-   free(p[-1]);
+   init_sinc_table(params, cutoff, table->data,
+         1 << params->phase_bits, taps, params->lerp);
+
+   table->params     = params;
+   table->cutoff     = cutoff;
+   table->taps       = taps;
+   table->refcount   = 1;
+   table->next       = sinc_phase_tables;
+   sinc_phase_tables = table;
+
+   return table;
 }
 
-#if !(defined(__AVX__) && ENABLE_AVX) && !defined(__SSE__)
-static INLINE void process_sinc_C(rarch_sinc_resampler_t *resamp,
-      float *out_buffer)
+static void sinc_phase_table_put(struct sinc_phase_table *table)
 {
-   unsigned i;
-   float sum_l = 0.0f;
-   float sum_r = 0.0f;
-   const float *buffer_l = resamp->buffer_l + resamp->ptr;
-   const float *buffer_r = resamp->buffer_r + resamp->ptr;
+   struct sinc_phase_table **link;
 
-   unsigned taps  = resamp->taps;
-   unsigned phase = resamp->time >> SUBPHASE_BITS;
-#if SINC_COEFF_LERP
-   const float *phase_table = resamp->phase_table + phase * taps * 2;
-   const float *delta_table = phase_table + taps;
-   float delta = (float)(resamp->time & SUBPHASE_MASK) * SUBPHASE_MOD;
-#else
-   const float *phase_table = resamp->phase_table + phase * taps;
-#endif
+   if (!table || --table->refcount)
+      return;
 
-   for (i = 0; i < taps; i++)
+   for (link = &sinc_phase_tables; *link; link = &(*link)->next)
    {
-#if SINC_COEFF_LERP
-      float sinc_val = phase_table[i] + delta_table[i] * delta;
-#else
-      float sinc_val = phase_table[i];
-#endif
-      sum_l         += buffer_l[i] * sinc_val;
-      sum_r         += buffer_r[i] * sinc_val;
+      if (*link == table)
+      {
+         *link = table->next;
+         break;
+      }
    }
 
-   out_buffer[0] = sum_l;
-   out_buffer[1] = sum_r;
+   memalign_free(table->data);
+   free(table);
 }
-#endif
 
-#if defined(__AVX__) && ENABLE_AVX
-#define process_sinc_func process_sinc
-static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
+static void process_sinc_C(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
 {
    unsigned i;
-   __m256 sum_l = _mm256_setzero_ps();
-   __m256 sum_r = _mm256_setzero_ps();
-
+   float sum_l = 0.0f;
+   float sum_r = 0.0f;
    const float *buffer_l = resamp->buffer_l + resamp->ptr;
    const float *buffer_r = resamp->buffer_r + resamp->ptr;
 
-   unsigned taps = resamp->taps;
-   unsigned phase = resamp->time >> SUBPHASE_BITS;
-#if SINC_COEFF_LERP
-   const float *phase_table = resamp->phase_table + phase * taps * 2;
-   const float *delta_table = phase_table + taps;
-   __m256 delta = _mm256_set1_ps((float)
-         (resamp->time & SUBPHASE_MASK) * SUBPHASE_MOD);
-#else
-   const float *phase_table = resamp->phase_table + phase * taps;
-#endif
+   unsigned taps  = resamp->taps;
+   unsigned phase = resamp->time >> resamp->subphase_bits;
 
-   for (i = 0; i < taps; i += 8)
+   if (resamp->lerp)
    {
-      __m256 buf_l = _mm256_loadu_ps(buffer_l + i);
-      __m256 buf_r = _mm256_loadu_ps(buffer_r + i);
+      const float *phase_table = resamp->phase_table + phase * taps * 2;
+      const float *delta_table = phase_table + taps;
+      float delta = (float)(resamp->time & resamp->subphase_mask)
+         * resamp->subphase_mod;
 
-#if SINC_COEFF_LERP
-      __m256 deltas = _mm256_load_ps(delta_table + i);
-      __m256 sinc = _mm256_add_ps(_mm256_load_ps(phase_table + i),
-            _mm256_mul_ps(deltas, delta));
-#else
-      __m256 sinc = _mm256_load_ps(phase_table + i);
-#endif
-      sum_l       = _mm256_add_ps(sum_l, _mm256_mul_ps(buf_l, sinc));
-      sum_r       = _mm256_add_ps(sum_r, _mm256_mul_ps(buf_r, sinc));
+      for (i = 0; i < taps; i++)
+      {
+         float sinc_val = phase_table[i] + delta_table[i] * delta;
+         sum_l         += buffer_l[i] * sinc_val;
+         sum_r         += buffer_r[i] * sinc_val;
+      }
    }
+   else
+   {
+      const float *phase_table = resamp->phase_table + phase * taps;
 
-   /* hadd on AVX is weird, and acts on low-lanes 
-    * and high-lanes separately. */
-   __m256 res_l = _mm256_hadd_ps(sum_l, sum_l);
-   __m256 res_r = _mm256_hadd_ps(sum_r, sum_r);
-   res_l = _mm256_hadd_ps(res_l, res_l);
-   res_r = _mm256_hadd_ps(res_r, res_r);
-   res_l = _mm256_add_ps(_mm256_permute2f128_ps(res_l, res_l, 1), res_l);
-   res_r = _mm256_add_ps(_mm256_permute2f128_ps(res_r, res_r, 1), res_r);
-
-   /* This is optimized to mov %xmmN, [mem].
-    * There doesn't seem to be any _mm256_store_ss intrinsic. */
-   _mm_store_ss(out_buffer + 0, _mm256_extractf128_ps(res_l, 0));
-   _mm_store_ss(out_buffer + 1, _mm256_extractf128_ps(res_r, 0));
+      for (i = 0; i < taps; i++)
+      {
+         sum_l += buffer_l[i] * phase_table[i];
+         sum_r += buffer_r[i] * phase_table[i];
+      }
+   }
+
+   out_buffer[0] = sum_l * resamp->gain;
+   out_buffer[1] = sum_r * resamp->gain;
 }
-#elif defined(__SSE__)
-#define process_sinc_func process_sinc
-static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
+
+#if defined(__SSE__)
+static void process_sinc_sse(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
 {
    unsigned i;
    __m128 sum_l = _mm_setzero_ps();
@@ -342,31 +371,41 @@ static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
    const float *buffer_r = resamp->buffer_r + resamp->ptr;
 
    unsigned taps = resamp->taps;
-   unsigned phase = resamp->time >> SUBPHASE_BITS;
-#if SINC_COEFF_LERP
-   const float *phase_table = resamp->phase_table + phase * taps * 2;
-   const float *delta_table = phase_table + taps;
-   __m128 delta = _mm_set1_ps((float)
-         (resamp->time & SUBPHASE_MASK) * SUBPHASE_MOD);
-#else
-   const float *phase_table = resamp->phase_table + phase * taps;
-#endif
+   unsigned phase = resamp->time >> resamp->subphase_bits;
    __m128 sum;
 
-   for (i = 0; i < taps; i += 4)
+   if (resamp->lerp)
    {
-      __m128 buf_l = _mm_loadu_ps(buffer_l + i);
-      __m128 buf_r = _mm_loadu_ps(buffer_r + i);
+      const float *phase_table = resamp->phase_table + phase * taps * 2;
+      const float *delta_table = phase_table + taps;
+      __m128 delta = _mm_set1_ps((float)
+            (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
 
-#if SINC_COEFF_LERP
-      __m128 deltas = _mm_load_ps(delta_table + i);
-      __m128 _sinc = _mm_add_ps(_mm_load_ps(phase_table + i),
-            _mm_mul_ps(deltas, delta));
-#else
-      __m128 _sinc = _mm_load_ps(phase_table + i);
-#endif
-      sum_l       = _mm_add_ps(sum_l, _mm_mul_ps(buf_l, _sinc));
-      sum_r       = _mm_add_ps(sum_r, _mm_mul_ps(buf_r, _sinc));
+      for (i = 0; i < taps; i += 4)
+      {
+         __m128 buf_l  = _mm_loadu_ps(buffer_l + i);
+         __m128 buf_r  = _mm_loadu_ps(buffer_r + i);
+         __m128 deltas = _mm_load_ps(delta_table + i);
+         __m128 _sinc  = _mm_add_ps(_mm_load_ps(phase_table + i),
+               _mm_mul_ps(deltas, delta));
+
+         sum_l         = _mm_add_ps(sum_l, _mm_mul_ps(buf_l, _sinc));
+         sum_r         = _mm_add_ps(sum_r, _mm_mul_ps(buf_r, _sinc));
+      }
+   }
+   else
+   {
+      const float *phase_table = resamp->phase_table + phase * taps;
+
+      for (i = 0; i < taps; i += 4)
+      {
+         __m128 buf_l = _mm_loadu_ps(buffer_l + i);
+         __m128 buf_r = _mm_loadu_ps(buffer_r + i);
+         __m128 _sinc = _mm_load_ps(phase_table + i);
+
+         sum_l        = _mm_add_ps(sum_l, _mm_mul_ps(buf_l, _sinc));
+         sum_r        = _mm_add_ps(sum_r, _mm_mul_ps(buf_r, _sinc));
+      }
    }
 
    /* Them annoying shuffles.
@@ -387,6 +426,7 @@ static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
    /* sum   = {R1, R1, L1, L1 } + { R1, R0, L1, L0 }
     * sum   = { X,  R,  X,  L } 
     */
+   sum = _mm_mul_ps(sum, _mm_set1_ps(resamp->gain));
 
    /* Store L */
    _mm_store_ss(out_buffer + 0, sum);
@@ -394,19 +434,204 @@ static void process_sinc(rarch_sinc_resampler_t *resamp, float *out_buffer)
    /* movehl { X, R, X, L } == { X, R, X, R } */
    _mm_store_ss(out_buffer + 1, _mm_movehl_ps(sum, sum));
 }
-#elif defined(__ARM_NEON__)
+#endif
+
+#ifdef SINC_HAVE_AVX2
+static bool sinc_cpu_has_fma(void)
+{
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
 
-#if SINC_COEFF_LERP
-#error "NEON asm does not support SINC lerp."
+/* Sums { l3, l2, l1, l0 } and { r3, r2, r1, r0 } into out_buffer,
+ * scaled by gain. */
+SINC_AVX2 static INLINE void sinc_store_sum_fma(float *out_buffer,
+      __m128 sum_l, __m128 sum_r, float gain)
+{
+   /* sum = { R23, R01, L23, L01 } */
+   __m128 sum = _mm_hadd_ps(sum_l, sum_r);
+
+   /* sum = { R, L, R, L } */
+   sum = _mm_hadd_ps(sum, sum);
+   sum = _mm_mul_ps(sum, _mm_set1_ps(gain));
+   _mm_storel_pi((__m64*)out_buffer, sum);
+}
+
+/* The SSE kernel with fused multiply-adds.
+ * Assumes that taps is a multiple of 4. */
+SINC_AVX2 static void process_sinc_fma(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
+{
+   unsigned i;
+   __m128 sum_l = _mm_setzero_ps();
+   __m128 sum_r = _mm_setzero_ps();
+
+   const float *buffer_l = resamp->buffer_l + resamp->ptr;
+   const float *buffer_r = resamp->buffer_r + resamp->ptr;
+
+   unsigned taps = resamp->taps;
+   unsigned phase = resamp->time >> resamp->subphase_bits;
+
+   if (resamp->lerp)
+   {
+      const float *phase_table = resamp->phase_table + phase * taps * 2;
+      const float *delta_table = phase_table + taps;
+      __m128 delta = _mm_set1_ps((float)
+            (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
+
+      for (i = 0; i < taps; i += 4)
+      {
+         __m128 _sinc = _mm_fmadd_ps(_mm_load_ps(delta_table + i),
+               delta, _mm_load_ps(phase_table + i));
+
+         sum_l = _mm_fmadd_ps(_mm_loadu_ps(buffer_l + i), _sinc, sum_l);
+         sum_r = _mm_fmadd_ps(_mm_loadu_ps(buffer_r + i), _sinc, sum_r);
+      }
+   }
+   else
+   {
+      const float *phase_table = resamp->phase_table + phase * taps;
+
+      for (i = 0; i < taps; i += 4)
+      {
+         __m128 _sinc = _mm_load_ps(phase_table + i);
+
+         sum_l = _mm_fmadd_ps(_mm_loadu_ps(buffer_l + i), _sinc, sum_l);
+         sum_r = _mm_fmadd_ps(_mm_loadu_ps(buffer_r + i), _sinc, sum_r);
+      }
+   }
+
+   sinc_store_sum_fma(out_buffer, sum_l, sum_r, resamp->gain);
+}
+
+/* 256-bit version, only a win for long filters (see SINC_AVX2_MIN_TAPS).
+ * Assumes that taps is a multiple of 4. As taps need not be a multiple
+ * of 8, rows of the phase table are only 16-byte aligned. */
+SINC_AVX2 static void process_sinc_avx2(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
+{
+   unsigned i;
+   __m256 sum_l = _mm256_setzero_ps();
+   __m256 sum_r = _mm256_setzero_ps();
+   __m128 tail_l = _mm_setzero_ps();
+   __m128 tail_r = _mm_setzero_ps();
+
+   const float *buffer_l = resamp->buffer_l + resamp->ptr;
+   const float *buffer_r = resamp->buffer_r + resamp->ptr;
+
+   unsigned taps = resamp->taps;
+   unsigned phase = resamp->time >> resamp->subphase_bits;
+
+   if (resamp->lerp)
+   {
+      const float *phase_table = resamp->phase_table + phase * taps * 2;
+      const float *delta_table = phase_table + taps;
+      __m256 delta = _mm256_set1_ps((float)
+            (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
+
+      for (i = 0; i + 8 <= taps; i += 8)
+      {
+         __m256 _sinc = _mm256_fmadd_ps(_mm256_loadu_ps(delta_table + i),
+               delta, _mm256_loadu_ps(phase_table + i));
+
+         sum_l = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_l + i), _sinc, sum_l);
+         sum_r = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_r + i), _sinc, sum_r);
+      }
+
+      if (i < taps)
+      {
+         __m128 _sinc = _mm_fmadd_ps(_mm_loadu_ps(delta_table + i),
+               _mm256_castps256_ps128(delta), _mm_loadu_ps(phase_table + i));
+
+         tail_l = _mm_mul_ps(_mm_loadu_ps(buffer_l + i), _sinc);
+         tail_r = _mm_mul_ps(_mm_loadu_ps(buffer_r + i), _sinc);
+      }
+   }
+   else
+   {
+      const float *phase_table = resamp->phase_table + phase * taps;
+
+      for (i = 0; i + 8 <= taps; i += 8)
+      {
+         __m256 _sinc = _mm256_loadu_ps(phase_table + i);
+
+         sum_l = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_l + i), _sinc, sum_l);
+         sum_r = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_r + i), _sinc, sum_r);
+      }
+
+      if (i < taps)
+      {
+         __m128 _sinc = _mm_loadu_ps(phase_table + i);
+
+         tail_l = _mm_mul_ps(_mm_loadu_ps(buffer_l + i), _sinc);
+         tail_r = _mm_mul_ps(_mm_loadu_ps(buffer_r + i), _sinc);
+      }
+   }
+
+   /* Fold the high lanes and the tail into the low lanes. */
+   sinc_store_sum_fma(out_buffer,
+         _mm_add_ps(_mm_add_ps(_mm256_castps256_ps128(sum_l),
+               _mm256_extractf128_ps(sum_l, 1)), tail_l),
+         _mm_add_ps(_mm_add_ps(_mm256_castps256_ps128(sum_r),
+               _mm256_extractf128_ps(sum_r, 1)), tail_r),
+         resamp->gain);
+}
 #endif
 
-/* Need to make this function pointer as Android doesn't 
- * have built-in targets for NEON and plain ARMv7a.
- */
-static void (*process_sinc_func)(rarch_sinc_resampler_t *resamp,
-      float *out_buffer);
+#if defined(SINC_HAVE_NEON)
+/* Assumes that taps is a multiple of 4. */
+static void process_sinc_neon(rarch_sinc_resampler_t *resamp,
+      float *out_buffer)
+{
+   unsigned i;
+   float32x2_t sum;
+   float32x4_t sum_l = vdupq_n_f32(0.0f);
+   float32x4_t sum_r = vdupq_n_f32(0.0f);
 
-/* Assumes that taps >= 8, and that taps is a multiple of 8. */
+   const float *buffer_l = resamp->buffer_l + resamp->ptr;
+   const float *buffer_r = resamp->buffer_r + resamp->ptr;
+
+   unsigned taps = resamp->taps;
+   unsigned phase = resamp->time >> resamp->subphase_bits;
+
+   if (resamp->lerp)
+   {
+      const float *phase_table = resamp->phase_table + phase * taps * 2;
+      const float *delta_table = phase_table + taps;
+      float32x4_t delta = vdupq_n_f32((float)
+            (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
+
+      for (i = 0; i < taps; i += 4)
+      {
+         float32x4_t _sinc = vmlaq_f32(vld1q_f32(phase_table + i),
+               vld1q_f32(delta_table + i), delta);
+
+         sum_l = vmlaq_f32(sum_l, vld1q_f32(buffer_l + i), _sinc);
+         sum_r = vmlaq_f32(sum_r, vld1q_f32(buffer_r + i), _sinc);
+      }
+   }
+   else
+   {
+      const float *phase_table = resamp->phase_table + phase * taps;
+
+      for (i = 0; i < taps; i += 4)
+      {
+         float32x4_t _sinc = vld1q_f32(phase_table + i);
+
+         sum_l = vmlaq_f32(sum_l, vld1q_f32(buffer_l + i), _sinc);
+         sum_r = vmlaq_f32(sum_r, vld1q_f32(buffer_r + i), _sinc);
+      }
+   }
+
+   /* { L01 + L23, R01 + R23 } */
+   sum = vpadd_f32(
+         vadd_f32(vget_low_f32(sum_l), vget_high_f32(sum_l)),
+         vadd_f32(vget_low_f32(sum_r), vget_high_f32(sum_r)));
+   vst1_f32(out_buffer, vmul_n_f32(sum, resamp->gain));
+}
+#elif defined(__ARM_NEON__)
+/* Assumes that taps >= 8, and that taps is a multiple of 8.
+ * Has no lerp support. */
 void process_sinc_neon_asm(float *out, const float *left, 
       const float *right, const float *coeff, unsigned taps);
 
@@ -416,29 +641,33 @@ static void process_sinc_neon(rarch_sinc_resampler_t *resamp,
    const float *buffer_l = resamp->buffer_l + resamp->ptr;
    const float *buffer_r = resamp->buffer_r + resamp->ptr;
 
-   unsigned phase = resamp->time >> SUBPHASE_BITS;
+   unsigned phase = resamp->time >> resamp->subphase_bits;
    unsigned taps = resamp->taps;
    const float *phase_table = resamp->phase_table + phase * taps;
 
    process_sinc_neon_asm(out_buffer, buffer_l, buffer_r, phase_table, taps);
+   out_buffer[0] *= resamp->gain;
+   out_buffer[1] *= resamp->gain;
 }
-#else /* Plain ol' C99 */
-#define process_sinc_func process_sinc_C
 #endif
 
 static void resampler_sinc_process(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *re = (rarch_sinc_resampler_t*)re_;
 
-   uint32_t ratio        = PHASES / data->ratio;
+   uint32_t phases       = re->phases;
+   uint32_t ratio        = phases / data->ratio;
+   sinc_process_t process = re->process;
    const float *input    = data->data_in;
    float *output         = data->data_out;
    size_t frames         = data->input_frames;
    size_t out_frames     = 0;
 
+   re->gain              = data->gain;
+
    while (frames)
    {
-      while (frames && re->time >= PHASES)
+      while (frames && re->time >= phases)
       {
          /* Push in reverse to make filter more obvious. */
          if (!re->ptr)
@@ -448,13 +677,13 @@ static void resampler_sinc_process(void *re_, struct resampler_data *data)
          re->buffer_l[re->ptr + re->taps] = re->buffer_l[re->ptr] = *input++;
          re->buffer_r[re->ptr + re->taps] = re->buffer_r[re->ptr] = *input++;
 
-         re->time -= PHASES;
+         re->time -= phases;
          frames--;
       }
 
-      while (re->time < PHASES)
+      while (re->time < phases)
       {
-         process_sinc_func(re, output);
+         process(re, output);
          output += 2;
          out_frames++;
          re->time += ratio;
@@ -468,25 +697,37 @@ static void resampler_sinc_free(void *re)
 {
    rarch_sinc_resampler_t *resampler = (rarch_sinc_resampler_t*)re;
    if (resampler)
-      aligned_free__(resampler->main_buffer);
+   {
+      sinc_phase_table_put(resampler->table);
+      memalign_free(resampler->main_buffer);
+   }
    free(resampler);
 }
 
 static void *resampler_sinc_new(const struct resampler_config *config,
       double bandwidth_mod, resampler_simd_mask_t mask)
 {
-   size_t phase_elems, elems;
    double cutoff;
-   rarch_sinc_resampler_t *re = (rarch_sinc_resampler_t*)
+   const struct sinc_params *params = NULL;
+   enum resampler_quality quality   = config->quality;
+   rarch_sinc_resampler_t *re       = (rarch_sinc_resampler_t*)
       calloc(1, sizeof(*re));
 
    if (!re)
       return NULL;
 
-   (void)config;
+   if (quality < RESAMPLER_QUALITY_LOWEST
+         || quality > RESAMPLER_QUALITY_HIGHEST)
+      quality = SINC_DEFAULT_QUALITY;
+   params = &sinc_params[quality - RESAMPLER_QUALITY_LOWEST];
 
-   re->taps = TAPS;
-   cutoff = CUTOFF;
+   re->taps          = params->sidelobes * 2;
+   re->lerp          = params->lerp;
+   re->subphase_bits = params->subphase_bits;
+   re->subphase_mask = (1 << params->subphase_bits) - 1;
+   re->subphase_mod  = 1.0f / (1 << params->subphase_bits);
+   re->phases        = 1 << (params->phase_bits + params->subphase_bits);
+   cutoff            = params->cutoff;
 
    /* Downsampling, must lower cutoff, and extend number of 
     * taps accordingly to keep same stopband attenuation. */
@@ -496,36 +737,43 @@ static void *resampler_sinc_new(const struct resampler_config *config,
       re->taps = (unsigned)ceil(re->taps / bandwidth_mod);
    }
 
-   /* Be SIMD-friendly. */
-#if (defined(__AVX__) && ENABLE_AVX) || defined(__ARM_NEON__)
-   re->taps = (re->taps + 7) & ~7;
-#else
+   /* Be SIMD-friendly. Rounded the same for every kernel,
+    * so the filter doesn't depend on the CPU. */
    re->taps = (re->taps + 3) & ~3;
-#endif
 
-   phase_elems = (1 << PHASE_BITS) * re->taps;
-#if SINC_COEFF_LERP
-   phase_elems *= 2;
+   re->process = process_sinc_C;
+#if defined(__SSE__)
+   re->process = process_sinc_sse;
+#endif
+#if defined(SINC_HAVE_AVX2)
+   if ((mask & RESAMPLER_SIMD_AVX2) && sinc_cpu_has_fma())
+      re->process = re->taps >= SINC_AVX2_MIN_TAPS
+         ? process_sinc_avx2 : process_sinc_fma;
+#endif
+#if defined(SINC_HAVE_NEON)
+   /* Need to check the mask as Android doesn't have 
+    * built-in targets for NEON and plain ARMv7a. */
+   if (mask & RESAMPLER_SIMD_NEON)
+      re->process = process_sinc_neon;
+#elif defined(__ARM_NEON__)
+   if ((mask & RESAMPLER_SIMD_NEON) && !params->lerp && !(re->taps & 7))
+      re->process = process_sinc_neon;
 #endif
-   elems = phase_elems + 4 * re->taps;
+
+   re->table = sinc_phase_table_get(params, cutoff, re->taps);
+   if (!re->table)
+      goto error;
+   re->phase_table = re->table->data;
 
    re->main_buffer = (float*)
-      aligned_alloc__(128, sizeof(float) * elems);
+      memalign_alloc(64, sizeof(float) * 4 * re->taps);
    if (!re->main_buffer)
       goto error;
 
-   re->phase_table = re->main_buffer;
-   re->buffer_l = re->main_buffer + phase_elems;
+   memset(re->main_buffer, 0, sizeof(float) * 4 * re->taps);
+   re->buffer_l = re->main_buffer;
    re->buffer_r = re->buffer_l + 2 * re->taps;
 
-   init_sinc_table(re, cutoff, re->phase_table,
-         1 << PHASE_BITS, re->taps, SINC_COEFF_LERP);
-
-#if defined(__ARM_NEON__)
-   process_sinc_func = mask & RESAMPLER_SIMD_NEON 
-      ? process_sinc_neon : process_sinc_C;
-#endif
-
    return re;
 
 error:
@@ -26,6 +26,22 @@
 #define RESAMPLER_IDENT "sinc"
 #endif
 
+// The driver asks for CPU features through this.
+static uint64_t get_cpu_features(void)
+{
+   uint64_t mask = 0;
+#if defined(__x86_64__) || defined(__i386__)
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("sse"))
+      mask |= RESAMPLER_SIMD_SSE;
+   if (__builtin_cpu_supports("avx2"))
+      mask |= RESAMPLER_SIMD_AVX2;
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   mask |= RESAMPLER_SIMD_NEON;
+#endif
+   return mask;
+}
+
 int main(int argc, char *argv[])
 {
    srand(time(NULL));
@@ -60,7 +76,9 @@ int main(int argc, char *argv[])
 
    const rarch_resampler_t *resampler = NULL;
    void *re = NULL;
-   if (!rarch_resampler_realloc(&re, &resampler, RESAMPLER_IDENT, out_rate / in_rate))
+   perf_get_cpu_features_cb = get_cpu_features;
+   if (!rarch_resampler_realloc(&re, &resampler, RESAMPLER_IDENT, out_rate / in_rate,
+            RESAMPLER_QUALITY_DONTCARE))
    {
       fprintf(stderr, "Failed to allocate resampler ...\n");
       return 1;
@@ -81,6 +99,7 @@ int main(int argc, char *argv[])
          .data_out = output_f,
          .input_frames = sizeof(input_f) / (2 * sizeof(float)),
          .ratio = ratio * rate_mod,
+         .gain = 1.0f,
       };
 
       rarch_resampler_process(resampler, re, &data);
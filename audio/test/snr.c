@@ -13,8 +13,12 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "../resamplers/resampler.h"
-#include "../audio_utils.h"
+/* Measures SNR and speed of a resampler backend (sinc unless
+ * RESAMPLER_IDENT says otherwise), with the baseline kernel (C, or SSE
+ * on x86) and with the SIMD kernel this CPU would get. Sinc is run at
+ * every quality level, other backends once at their default. */
+
+#include "../audio_resampler_driver.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
@@ -22,6 +26,8 @@
 #include <string.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
 
 #ifndef RESAMPLER_IDENT
 #define RESAMPLER_IDENT "sinc"
@@ -239,44 +245,76 @@ static void calculate_snr(struct snr_result *res,
       res->alias_power[i] = 10.0 * log10(res->alias_power[i]);
 }
 
-int main(int argc, char *argv[])
-{
-   if (argc != 2)
-   {
-      fprintf(stderr, "Usage: %s <ratio> (out-rate is fixed for FFT).\n", argv[0]);
-      return 1;
-   }
+static const char *quality_names[] = {
+   "lowest", "lower", "normal", "higher", "highest",
+};
 
-   double ratio = strtod(argv[1], NULL);
+/* Rough floors, a few dB below the SNR each level is tuned for. */
+static const double quality_min_snr[] = {
+   35.0, 45.0, 62.0, 105.0, 130.0,
+};
 
-   const unsigned fft_samples = 1024 * 128;
-   unsigned out_rate = fft_samples / 2;
-   unsigned in_rate = round(out_rate / ratio);
-   ratio = (double)out_rate / in_rate;
+static const float freq_list[] = {
+   0.001, 0.002, 0.003, 0.004, 0.005, 0.006, 0.007, 0.008, 0.009,
+   0.010, 0.015, 0.020, 0.025, 0.030, 0.035, 0.040, 0.045, 0.050,
+   0.060, 0.070, 0.080, 0.090,
+   0.10, 0.15, 0.20, 0.25, 0.30, 0.35,
+   0.40, 0.41, 0.42, 0.43, 0.44, 0.45,
+   0.46, 0.47, 0.48, 0.49,
+   0.495, 0.496, 0.497, 0.498, 0.499,
+};
 
-   static const float freq_list[] = {
-      0.001, 0.002, 0.003, 0.004, 0.005, 0.006, 0.007, 0.008, 0.009,
-      0.010, 0.015, 0.020, 0.025, 0.030, 0.035, 0.040, 0.045, 0.050,
-      0.060, 0.070, 0.080, 0.090,
-      0.10, 0.15, 0.20, 0.25, 0.30, 0.35,
-      0.40, 0.41, 0.42, 0.43, 0.44, 0.45,
-      0.46, 0.47, 0.48, 0.49,
-      0.495, 0.496, 0.497, 0.498, 0.499,
-   };
+/* SNR is only summarized below this, as every level
+ * is allowed to roll off towards Nyquist. */
+#define PASSBAND 0.20
 
-   unsigned samples = in_rate * 4;
-   float *input = calloc(sizeof(float), samples);
-   float *output = calloc(sizeof(float), (fft_samples + 16) * 2);
-   complex double *butterfly_buf = calloc(sizeof(complex double), fft_samples / 2);
-   assert(input);
-   assert(output);
+static const rarch_resampler_t *backend;
+static resampler_simd_mask_t backend_simd;
+
+/* The driver asks for CPU features through this. */
+static uint64_t get_cpu_features(void)
+{
+   return backend_simd;
+}
+
+static resampler_simd_mask_t detect_simd(void)
+{
+   resampler_simd_mask_t mask = 0;
+#if defined(__x86_64__) || defined(__i386__)
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+      mask |= RESAMPLER_SIMD_AVX2;
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   mask |= RESAMPLER_SIMD_NEON;
+#endif
+   return mask;
+}
 
+static void *new_resampler(enum resampler_quality quality, double ratio,
+      resampler_simd_mask_t mask)
+{
    void *re = NULL;
-   const rarch_resampler_t *resampler = NULL;
-   if (!rarch_resampler_realloc(&re, &resampler, RESAMPLER_IDENT, ratio))
-      return 1;
 
-   test_fft();
+   backend_simd = mask;
+   if (!rarch_resampler_realloc(&re, &backend, RESAMPLER_IDENT, ratio, quality))
+      return NULL;
+   return re;
+}
+
+static double now_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Returns the worst SNR in the passband. */
+static double measure_snr(void *re, unsigned in_rate, unsigned out_rate,
+      double ratio, float *input, float *output,
+      complex double *butterfly_buf, unsigned fft_samples, bool verbose)
+{
+   double worst = INFINITY;
+   unsigned samples = in_rate * 4;
 
    for (unsigned i = 0; i < sizeof(freq_list) / sizeof(freq_list[0]); i++)
    {
@@ -289,9 +327,10 @@ int main(int argc, char *argv[])
          .data_out = output,
          .input_frames = in_rate * 2,
          .ratio = ratio,
+         .gain = 1.0f,
       };
 
-      rarch_resampler_process(resampler, re, &data);
+      rarch_resampler_process(backend, re, &data);
 
       // We generate 2 seconds worth of audio, however, only the last second is considered so phase has stabilized.
       struct snr_result res = {0};
@@ -301,6 +340,12 @@ int main(int argc, char *argv[])
 
       calculate_snr(&res, freq, max_freq, output + fft_samples - 2048, butterfly_buf, fft_samples);
 
+      if (freq_list[i] <= PASSBAND && res.snr < worst)
+         worst = res.snr;
+
+      if (!verbose)
+         continue;
+
       printf("SNR @ w = %5.3f : %6.2lf dB, Gain: %6.1lf dB\n",
             freq_list[i], res.snr, res.gain);
 
@@ -310,9 +355,172 @@ int main(int argc, char *argv[])
             res.alias_freq[2] / (float)in_rate, res.alias_power[2]);
    }
 
-   rarch_resampler_freep(&resampler, &re);
+   return worst;
+}
+
+/* Returns nanoseconds per output frame. */
+static double measure_speed(void *re, unsigned in_rate, double ratio,
+      float *input, float *output)
+{
+   size_t out_frames = 0;
+   double start = now_ns();
+   double elapsed;
+
+   gen_signal(input, 0.1, 0, in_rate * 2);
+
+   do
+   {
+      struct resampler_data data = {
+         .data_in = input,
+         .data_out = output,
+         .input_frames = in_rate,
+         .ratio = ratio,
+         .gain = 1.0f,
+      };
+
+      rarch_resampler_process(backend, re, &data);
+      out_frames += data.output_frames;
+      elapsed = now_ns() - start;
+   } while (elapsed < 2e8);
+
+   return elapsed / out_frames;
+}
+
+/* Largest difference between two kernels fed the same signal. */
+static double compare_kernels(void *a, void *b, unsigned in_rate,
+      double ratio, float *input, float *output_a, float *output_b)
+{
+   double diff = 0.0;
+
+   gen_signal(input, 0.123, 0, in_rate * 2);
+
+   struct resampler_data data_a = {
+      .data_in = input,
+      .data_out = output_a,
+      .input_frames = in_rate,
+      .ratio = ratio,
+      .gain = 1.0f,
+   };
+   struct resampler_data data_b = data_a;
+   data_b.data_out = output_b;
+
+   rarch_resampler_process(backend, a, &data_a);
+   rarch_resampler_process(backend, b, &data_b);
+
+   if (data_a.output_frames != data_b.output_frames)
+      return INFINITY;
+
+   for (size_t i = 0; i < data_a.output_frames * 2; i++)
+      diff = fmax(diff, fabs(output_a[i] - output_b[i]));
+
+   return diff;
+}
+
+int main(int argc, char *argv[])
+{
+   bool test = false;
+   bool verbose = false;
+   double ratio = 48000.0 / 44100.0;
+   unsigned failed = 0;
+   int opt;
+
+   while ((opt = getopt(argc, argv, "tv")) != -1)
+   {
+      switch (opt)
+      {
+         case 't':
+            test = true;
+            break;
+         case 'v':
+            verbose = true;
+            break;
+         default:
+            fprintf(stderr, "Usage: %s [-t] [-v] [ratio] (out-rate is fixed for FFT).\n"
+                  "  -t: fail if a level misses its SNR floor or SIMD and C disagree.\n"
+                  "  -v: print SNR and aliases per frequency.\n", argv[0]);
+            return 1;
+      }
+   }
+
+   if (optind < argc)
+      ratio = strtod(argv[optind], NULL);
+
+   const unsigned fft_samples = 1024 * 128;
+   unsigned out_rate = fft_samples / 2;
+   unsigned in_rate = round(out_rate / ratio);
+   ratio = (double)out_rate / in_rate;
+
+   unsigned samples = in_rate * 4;
+   size_t out_size = (size_t)(ceil(in_rate * 2 * ratio) + 16) * 2;
+   float *input = calloc(sizeof(float), samples);
+   float *output = calloc(sizeof(float), out_size);
+   float *output_simd = calloc(sizeof(float), out_size);
+   complex double *butterfly_buf = calloc(sizeof(complex double), fft_samples / 2);
+   assert(input);
+   assert(output);
+   assert(output_simd);
+   assert(butterfly_buf);
+
+   resampler_simd_mask_t simd = detect_simd();
+   bool levels = strcmp(RESAMPLER_IDENT, "sinc") == 0;
+   unsigned q_first = levels ? RESAMPLER_QUALITY_LOWEST : RESAMPLER_QUALITY_DONTCARE;
+   unsigned q_last = levels ? RESAMPLER_QUALITY_HIGHEST : RESAMPLER_QUALITY_DONTCARE;
+
+   perf_get_cpu_features_cb = get_cpu_features;
+
+   if (verbose)
+      test_fft();
+
+   printf("%s, ratio %.4f (%u Hz -> %u Hz), SNR below w = %.2f.\n",
+         RESAMPLER_IDENT, ratio, in_rate, out_rate, PASSBAND);
+   printf("%-8s %10s %12s %12s %10s\n",
+         "quality", "SNR (dB)", "base (ns/f)", "SIMD (ns/f)", "max diff");
+
+   for (unsigned q = q_first; q <= q_last; q++)
+   {
+      const char *name = levels ? quality_names[q - RESAMPLER_QUALITY_LOWEST] : "default";
+      void *re_c = new_resampler(q, ratio, 0);
+      void *re_simd = new_resampler(q, ratio, simd);
+
+      if (!re_c || !re_simd)
+      {
+         fprintf(stderr, "Failed to allocate %s resampler.\n", name);
+         return 1;
+      }
+
+      if (verbose)
+         printf("\n%s:\n", name);
+
+      double snr = measure_snr(re_simd, in_rate, out_rate, ratio,
+            input, output, butterfly_buf, fft_samples, verbose);
+      double ns_c = measure_speed(re_c, in_rate, ratio, input, output);
+      double ns_simd = measure_speed(re_simd, in_rate, ratio, input, output);
+
+      backend->free(re_c);
+      backend->free(re_simd);
+
+      re_c = new_resampler(q, ratio, 0);
+      re_simd = new_resampler(q, ratio, simd);
+      double diff = compare_kernels(re_c, re_simd, in_rate, ratio,
+            input, output, output_simd);
+      backend->free(re_c);
+      backend->free(re_simd);
+
+      printf("%-8s %10.2f %12.2f %12.2f %10.2g\n", name,
+            snr, ns_c, ns_simd, diff);
+
+      /* Only the sinc levels have an SNR they are tuned for. */
+      if (test && ((levels && snr < quality_min_snr[q - RESAMPLER_QUALITY_LOWEST])
+               || diff > 1e-4))
+      {
+         fprintf(stderr, "FAIL: %s quality.\n", name);
+         failed++;
+      }
+   }
+
    free(input);
    free(output);
+   free(output_simd);
    free(butterfly_buf);
+   return failed ? 1 : 0;
 }
-
@@ -16,28 +16,448 @@
 
 #include "autosave.h"
 #include <rthreads/rthreads.h>
+#include <rthreads/rpool.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <boolean.h>
 #include <string.h>
 #include <stdio.h>
+#include <compat/strl.h>
+#include <file/file_path.h>
+#include "file_ops.h"
 #include "general.h"
+#include "performance.h"
+
+#if !defined(_WIN32) && !defined(RARCH_CONSOLE)
+#include <fcntl.h>
+#include <unistd.h>
+#define HAVE_AUTOSAVE_JOURNAL
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/* SRAM is compared and written in blocks of this size. */
+#define AUTOSAVE_BLOCK_SIZE 4096
+
+/* Journal layout: records of [u64 offset][u64 length][data], all
+ * little endian, followed by the magic once every record is on disk.
+ * A journal without the trailing magic was never committed and
+ * is thrown away. */
+static const char autosave_journal_magic[8] = {
+   'R', 'A', 'S', 'R', 'A', 'M', 'J', '1' };
+
+/* Time spent scanning for changes, then bytes scanned and bytes
+ * written, one call per autosave pass. Passes of different handles
+ * can run at once on the thread pool, so they update these under
+ * autosave_perf_lock. They are registered on the main
+ * thread, since rarch_perf_register() isn't thread-safe. */
+static struct retro_perf_counter autosave_compare = {
+   "autosave_compare" };
+static struct retro_perf_counter autosave_bytes_compared = {
+   "autosave_bytes_compared" };
+static struct retro_perf_counter autosave_bytes_written = {
+   "autosave_bytes_written" };
+static slock_t *autosave_perf_lock;
+static unsigned autosave_perf_users;
 
 struct autosave
 {
-   volatile bool quit;
    slock_t *lock;
 
-   slock_t *cond_lock;
-   scond_t *cond;
-   sthread_t *thread;
+   /* The pass running on the thread pool, if any. Only touched
+    * on the main thread. */
+   rpool_t *pool;
+   rpool_future_t *future;
+   retro_time_t next_pass;
+   bool first_log;
 
    void *buffer;
    const void *retro_buffer;
    const char *path;
    size_t bufsize;
    unsigned interval;
+
+   /* One flag per AUTOSAVE_BLOCK_SIZE block of buffer. */
+   uint8_t *dirty;
+   size_t num_blocks;
+   /* The file on disk is known to match buffer, so only
+    * dirty blocks need to be written. */
+   bool synced;
 };
 
+/**
+ * autosave_block_differs:
+ * @a               : first block
+ * @b               : second block
+ * @len             : size of both blocks
+ *
+ * Returns: true if the blocks differ.
+ **/
+static bool autosave_block_differs(const uint8_t *a, const uint8_t *b,
+      size_t len)
+{
+   size_t i = 0;
+
+#if defined(__SSE2__)
+   for (; i + 64 <= len; i += 64)
+   {
+      __m128i x0 = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i*)(a + i +  0)),
+            _mm_loadu_si128((const __m128i*)(b + i +  0)));
+      __m128i x1 = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i*)(a + i + 16)),
+            _mm_loadu_si128((const __m128i*)(b + i + 16)));
+      __m128i x2 = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i*)(a + i + 32)),
+            _mm_loadu_si128((const __m128i*)(b + i + 32)));
+      __m128i x3 = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i*)(a + i + 48)),
+            _mm_loadu_si128((const __m128i*)(b + i + 48)));
+      __m128i x  = _mm_or_si128(_mm_or_si128(x0, x1), _mm_or_si128(x2, x3));
+
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128())) != 0xffff)
+         return true;
+   }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   for (; i + 64 <= len; i += 64)
+   {
+      uint8x16_t x0 = veorq_u8(vld1q_u8(a + i +  0), vld1q_u8(b + i +  0));
+      uint8x16_t x1 = veorq_u8(vld1q_u8(a + i + 16), vld1q_u8(b + i + 16));
+      uint8x16_t x2 = veorq_u8(vld1q_u8(a + i + 32), vld1q_u8(b + i + 32));
+      uint8x16_t x3 = veorq_u8(vld1q_u8(a + i + 48), vld1q_u8(b + i + 48));
+      uint8x16_t x  = vorrq_u8(vorrq_u8(x0, x1), vorrq_u8(x2, x3));
+      uint64x2_t w  = vreinterpretq_u64_u8(x);
+
+      if (vgetq_lane_u64(w, 0) | vgetq_lane_u64(w, 1))
+         return true;
+   }
+#endif
+
+   return memcmp(a + i, b + i, len - i) != 0;
+}
+
+/**
+ * autosave_scan:
+ * @handle          : pointer to autosave object
+ *
+ * Compares SRAM against the shadow copy block by block, copying
+ * over and flagging every block which changed. Must be called
+ * with the autosave lock held.
+ *
+ * Returns: number of dirty blocks.
+ **/
+static size_t autosave_scan(autosave_t *handle)
+{
+   size_t i;
+   size_t dirty         = 0;
+   uint8_t *shadow      = (uint8_t*)handle->buffer;
+   const uint8_t *retro = (const uint8_t*)handle->retro_buffer;
+
+   for (i = 0; i < handle->num_blocks; i++)
+   {
+      size_t offset = i * AUTOSAVE_BLOCK_SIZE;
+      size_t len    = handle->bufsize - offset;
+
+      if (len > AUTOSAVE_BLOCK_SIZE)
+         len = AUTOSAVE_BLOCK_SIZE;
+
+      handle->dirty[i] = autosave_block_differs(shadow + offset,
+            retro + offset, len);
+
+      if (handle->dirty[i])
+      {
+         memcpy(shadow + offset, retro + offset, len);
+         dirty++;
+      }
+   }
+
+   return dirty;
+}
+
+#ifdef HAVE_AUTOSAVE_JOURNAL
+static void autosave_journal_path(char *s, size_t len, const char *path)
+{
+   strlcpy(s, path, len);
+   strlcat(s, ".journal", len);
+}
+#endif
+
+/**
+ * autosave_write_full:
+ * @handle          : pointer to autosave object
+ *
+ * Writes the whole shadow copy to a temporary file and renames
+ * it over the save file.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+static bool autosave_write_full(autosave_t *handle)
+{
+   bool failed                   = false;
+   char tmp[PATH_MAX_LENGTH]     = {0};
+   FILE *file                    = NULL;
+
+   strlcpy(tmp, handle->path, sizeof(tmp));
+   strlcat(tmp, ".tmp", sizeof(tmp));
+
+   if (!(file = fopen(tmp, "wb")))
+      return false;
+
+   failed |= fwrite(handle->buffer, 1, handle->bufsize, file)
+      != handle->bufsize;
+   failed |= fflush(file) != 0;
+#ifdef HAVE_AUTOSAVE_JOURNAL
+   failed |= fsync(fileno(file)) != 0;
+#endif
+   failed |= fclose(file) != 0;
+
+#ifdef _WIN32
+   /* rename() won't replace an existing file here. */
+   if (!failed)
+      remove(handle->path);
+#endif
+
+   if (!failed)
+      failed |= rename(tmp, handle->path) != 0;
+
+   if (failed)
+   {
+      remove(tmp);
+      return false;
+   }
+
+#ifdef HAVE_AUTOSAVE_JOURNAL
+   /* A journal left behind by a failed autosave_write_dirty()
+    * is older than what was just written, so must not be
+    * replayed over it. */
+   autosave_journal_path(tmp, sizeof(tmp), handle->path);
+   unlink(tmp);
+#endif
+
+   return true;
+}
+
+#ifdef HAVE_AUTOSAVE_JOURNAL
+static bool autosave_write_all(int fd, const void *data, size_t len)
+{
+   const uint8_t *in = (const uint8_t*)data;
+
+   while (len)
+   {
+      ssize_t ret = write(fd, in, len);
+      if (ret <= 0)
+         return false;
+      in  += ret;
+      len -= ret;
+   }
+
+   return true;
+}
+
+static bool autosave_pwrite_all(int fd, const void *data, size_t len,
+      off_t offset)
+{
+   const uint8_t *in = (const uint8_t*)data;
+
+   while (len)
+   {
+      ssize_t ret = pwrite(fd, in, len, offset);
+      if (ret <= 0)
+         return false;
+      in     += ret;
+      len    -= ret;
+      offset += ret;
+   }
+
+   return true;
+}
+
+static void autosave_write_le64(uint8_t *out, uint64_t val)
+{
+   unsigned i;
+   for (i = 0; i < 8; i++)
+      out[i] = (uint8_t)(val >> (8 * i));
+}
+
+static uint64_t autosave_read_le64(const uint8_t *in)
+{
+   unsigned i;
+   uint64_t val = 0;
+   for (i = 0; i < 8; i++)
+      val |= (uint64_t)in[i] << (8 * i);
+   return val;
+}
+
+/* Finds the next run of dirty blocks at or after *block.
+ * Returns false when there are none left. */
+static bool autosave_next_run(autosave_t *handle, size_t *block,
+      size_t *offset, size_t *len)
+{
+   size_t end;
+
+   while (*block < handle->num_blocks && !handle->dirty[*block])
+      (*block)++;
+
+   if (*block >= handle->num_blocks)
+      return false;
+
+   for (end = *block; end < handle->num_blocks && handle->dirty[end]; end++);
+
+   *offset = *block * AUTOSAVE_BLOCK_SIZE;
+   *len    = end * AUTOSAVE_BLOCK_SIZE;
+   if (*len > handle->bufsize)
+      *len = handle->bufsize;
+   *len   -= *offset;
+   *block  = end;
+
+   return true;
+}
+
+/**
+ * autosave_write_dirty:
+ * @handle          : pointer to autosave object
+ * @written         : number of bytes written to the save file
+ *
+ * Writes only the dirty blocks into the existing save file.
+ * The blocks are committed to a journal first, so a crash halfway
+ * through leaves either the old or the new SRAM behind once
+ * autosave_recover() has run.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+static bool autosave_write_dirty(autosave_t *handle, size_t *written)
+{
+   size_t block, offset, len;
+   char journal[PATH_MAX_LENGTH] = {0};
+   const uint8_t *shadow         = (const uint8_t*)handle->buffer;
+   bool failed                   = false;
+   int fd                        = -1;
+
+   autosave_journal_path(journal, sizeof(journal), handle->path);
+
+   fd = open(journal, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (fd < 0)
+      return false;
+
+   for (block = 0; !failed
+         && autosave_next_run(handle, &block, &offset, &len); )
+   {
+      uint8_t record[16];
+
+      autosave_write_le64(record + 0, offset);
+      autosave_write_le64(record + 8, len);
+
+      failed |= !autosave_write_all(fd, record, sizeof(record));
+      failed |= !autosave_write_all(fd, shadow + offset, len);
+   }
+
+   /* Records must hit the disk before the commit marker does. */
+   failed |= fsync(fd) != 0;
+   if (!failed)
+      failed |= !autosave_write_all(fd, autosave_journal_magic,
+            sizeof(autosave_journal_magic));
+   failed |= fsync(fd) != 0;
+   failed |= close(fd) != 0;
+
+   if (failed)
+   {
+      unlink(journal);
+      return false;
+   }
+
+   fd = open(handle->path, O_WRONLY);
+   if (fd < 0)
+      return false;
+
+   for (block = 0; !failed
+         && autosave_next_run(handle, &block, &offset, &len); )
+   {
+      failed |= !autosave_pwrite_all(fd, shadow + offset, len, offset);
+      *written += len;
+   }
+
+   failed |= fsync(fd) != 0;
+   failed |= close(fd) != 0;
+
+   /* On failure the journal stays, and gets replayed on next load. */
+   if (!failed)
+      unlink(journal);
+
+   return !failed;
+}
+#endif
+
+/**
+ * autosave_recover:
+ * @path            : path to save file
+ *
+ * Replays a committed autosave journal left behind by a crash
+ * into the save file at @path. Should be called before the
+ * save file is loaded.
+ **/
+void autosave_recover(const char *path)
+{
+#ifdef HAVE_AUTOSAVE_JOURNAL
+   ssize_t size;
+   void *buf                     = NULL;
+   char journal[PATH_MAX_LENGTH] = {0};
+
+   autosave_journal_path(journal, sizeof(journal), path);
+
+   if (!path_file_exists(journal))
+      return;
+
+   if (read_file(journal, &buf, &size) && size >= 8
+         && !memcmp((const uint8_t*)buf + size - 8,
+            autosave_journal_magic, 8))
+   {
+      bool failed        = false;
+      const uint8_t *in  = (const uint8_t*)buf;
+      const uint8_t *end = in + size - 8;
+      int fd             = open(path, O_WRONLY);
+
+      RARCH_LOG("Replaying SRAM journal \"%s\".\n", journal);
+
+      failed = fd < 0;
+
+      while (!failed && in + 16 <= end)
+      {
+         uint64_t offset = autosave_read_le64(in + 0);
+         uint64_t len    = autosave_read_le64(in + 8);
+
+         in += 16;
+         if (len > (uint64_t)(end - in))
+            break;
+
+         failed |= !autosave_pwrite_all(fd, in, len, offset);
+         in     += len;
+      }
+
+      if (fd >= 0)
+      {
+         failed |= fsync(fd) != 0;
+         failed |= close(fd) != 0;
+      }
+
+      if (failed)
+      {
+         RARCH_WARN("Failed to replay SRAM journal, keeping it.\n");
+         free(buf);
+         return;
+      }
+   }
+
+   free(buf);
+   unlink(journal);
+#else
+   (void)path;
+#endif
+}
+
 /**
  * autosave_lock:
  * @handle          : pointer to autosave object
@@ -61,63 +481,79 @@ static void autosave_unlock(autosave_t *handle)
 }
 
 /**
- * autosave_thread:
+ * autosave_pass:
  * @data            : pointer to autosave object
+ * @index           : unused
  *
- * Callback function for (threaded) autosave.
+ * Compares SRAM against the last saved copy and writes out what
+ * changed. Runs on the thread pool, once every interval.
  **/
-static void autosave_thread(void *data)
+static void autosave_pass(void *data, unsigned index)
 {
-   bool first_log = true;
    autosave_t *save = (autosave_t*)data;
+   size_t dirty     = 0;
+   size_t written   = 0;
 
-   while (!save->quit)
-   {
-      bool differ = false;
+   (void)index;
+
+   /* The counters are shared with the other autosave passes. */
+   slock_lock(autosave_perf_lock);
+
+   RARCH_PERFORMANCE_START(autosave_compare);
+
+   autosave_lock(save);
+   dirty = autosave_scan(save);
+   autosave_unlock(save);
+
+   RARCH_PERFORMANCE_STOP(autosave_compare);
+
+   autosave_bytes_compared.total += save->bufsize;
+   autosave_bytes_compared.call_cnt++;
 
-      autosave_lock(save);
-      differ = memcmp(save->buffer, save->retro_buffer,
-            save->bufsize) != 0;
-      if (differ)
-         memcpy(save->buffer, save->retro_buffer, save->bufsize);
-      autosave_unlock(save);
+   slock_unlock(autosave_perf_lock);
 
-      if (differ)
+   if (dirty)
+   {
+      bool ok = false;
+
+      /* Avoid spamming down stderr ... */
+      if (save->first_log)
       {
-         /* Should probably deal with this more elegantly. */
-         FILE *file = fopen(save->path, "wb");
-
-         if (file)
-         {
-            bool failed = false;
-
-            /* Avoid spamming down stderr ... */
-            if (first_log)
-            {
-               RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
-                     save->path, save->interval);
-               first_log = false;
-            }
-            else
-               RARCH_LOG("SRAM changed ... autosaving ...\n");
-
-            failed |= fwrite(save->buffer, 1, save->bufsize, file)
-               != save->bufsize;
-            failed |= fflush(file) != 0;
-            failed |= fclose(file) != 0;
-            if (failed)
-               RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
-         }
+         RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
+               save->path, save->interval);
+         save->first_log = false;
+      }
+      else
+         RARCH_LOG("SRAM changed ... autosaving %u/%u blocks ...\n",
+               (unsigned)dirty, (unsigned)save->num_blocks);
+
+#ifdef HAVE_AUTOSAVE_JOURNAL
+      if (save->synced)
+         ok = autosave_write_dirty(save, &written);
+#endif
+
+      /* First write, or the file can't be trusted to
+       * match the shadow copy anymore. */
+      if (!ok)
+      {
+         ok      = autosave_write_full(save);
+         written = save->bufsize;
       }
 
-      slock_lock(save->cond_lock);
-
-      if (!save->quit)
-         scond_wait_timeout(save->cond, save->cond_lock,
-               save->interval * 1000000LL);
+      save->synced = ok;
 
-      slock_unlock(save->cond_lock);
+      /* Only what actually made it to disk is counted. */
+      if (!ok)
+      {
+         written = 0;
+         RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
+      }
    }
+
+   slock_lock(autosave_perf_lock);
+   autosave_bytes_written.total += written;
+   autosave_bytes_written.call_cnt++;
+   slock_unlock(autosave_perf_lock);
 }
 
 /**
@@ -139,24 +575,35 @@ autosave_t *autosave_new(const char *path, const void *data, size_t size,
    if (!handle)
       return NULL;
 
+   handle->first_log    = true;
    handle->bufsize      = size;
    handle->interval     = interval;
    handle->path         = path;
    handle->buffer       = malloc(size);
    handle->retro_buffer = data;
+   handle->num_blocks   = (size + AUTOSAVE_BLOCK_SIZE - 1) / AUTOSAVE_BLOCK_SIZE;
+   handle->dirty        = (uint8_t*)calloc(handle->num_blocks, 1);
 
-   if (!handle->buffer)
+   if (!handle->buffer || !handle->dirty)
    {
+      free(handle->buffer);
+      free(handle->dirty);
       free(handle);
       return NULL;
    }
    memcpy(handle->buffer, handle->retro_buffer, handle->bufsize);
 
    handle->lock         = slock_new();
-   handle->cond_lock    = slock_new();
-   handle->cond         = scond_new();
+   handle->pool         = rarch_get_thread_pool();
+   handle->next_pass    = rarch_get_time_usec() + interval * 1000000LL;
 
-   handle->thread       = sthread_create(autosave_thread, handle);
+   /* Handles are created and freed on the main thread only. */
+   if (!autosave_perf_users++)
+      autosave_perf_lock = slock_new();
+
+   rarch_perf_register(&autosave_compare);
+   rarch_perf_register(&autosave_bytes_compared);
+   rarch_perf_register(&autosave_bytes_written);
 
    return handle;
 }
@@ -172,20 +619,60 @@ void autosave_free(autosave_t *handle)
    if (!handle)
       return;
 
-   slock_lock(handle->cond_lock);
-   handle->quit = true;
-   slock_unlock(handle->cond_lock);
-   scond_signal(handle->cond);
-   sthread_join(handle->thread);
+   rpool_future_wait(handle->future);
+
+   if (!--autosave_perf_users)
+   {
+      slock_free(autosave_perf_lock);
+      autosave_perf_lock = NULL;
+   }
 
    slock_free(handle->lock);
-   slock_free(handle->cond_lock);
-   scond_free(handle->cond);
 
    free(handle->buffer);
+   free(handle->dirty);
    free(handle);
 }
 
+/**
+ * autosave_iterate:
+ *
+ * Starts an autosave pass on the thread pool for every autosave
+ * object that is due one, and reaps the passes that finished.
+ * Only one pass per object is in flight at a time.
+ **/
+void autosave_iterate(void)
+{
+   unsigned i;
+   retro_time_t now = 0;
+   global_t *global = global_get_ptr();
+
+   for (i = 0; i < global->num_autosave; i++)
+   {
+      autosave_t *handle = global->autosave[i];
+
+      if (!handle)
+         continue;
+
+      if (handle->future)
+      {
+         if (!rpool_future_done(handle->future))
+            continue;
+         rpool_future_wait(handle->future);
+         handle->future = NULL;
+      }
+
+      if (!now)
+         now = rarch_get_time_usec();
+      if (now < handle->next_pass)
+         continue;
+
+      handle->next_pass = now + handle->interval * 1000000LL;
+      handle->future    = rpool_submit(handle->pool,
+            autosave_pass, handle);
+   }
+}
+
 /**
  * lock_autosave:
  *
@@ -48,6 +48,25 @@ autosave_t *autosave_new(const char *path, const void *data,
  **/
 void autosave_free(autosave_t *handle);
 
+/**
+ * autosave_recover:
+ * @path            : path to save file
+ *
+ * Replays a committed autosave journal left behind by a crash
+ * into the save file at @path. Should be called before the
+ * save file is loaded.
+ **/
+void autosave_recover(const char *path);
+
+/**
+ * autosave_iterate:
+ *
+ * Starts an autosave pass on the thread pool for every autosave
+ * object that is due one, and reaps the passes that finished.
+ * Called once per frame from the main thread.
+ **/
+void autosave_iterate(void);
+
 /**
  * lock_autosave:
  *
@@ -535,9 +535,17 @@ static void event_deinit_core(bool reinit)
    global_t *global     = global_get_ptr();
    settings_t *settings = config_get_ptr();
 
+   /* Don't leave a half-written save state behind. */
+   save_state_deinit();
+
    pretro_unload_game();
    pretro_deinit();
 
+   free(global->runahead.buffer);
+   global->runahead.buffer = NULL;
+   global->runahead.size   = 0;
+   global->runahead.failed = false;
+
    if (reinit)
       event_command(EVENT_CMD_DRIVERS_DEINIT);
 
@@ -917,6 +925,10 @@ static void event_save_state(const char *path,
       return;
    }
 
+   /* Reported by save_state() once it has actually been written. */
+   if (settings->savestate_threaded)
+      return;
+
    if (settings->state_slot < 0)
       snprintf(s, len, "%s #-1 (auto).", msg_hash_to_str(MSG_SAVED_STATE_TO_SLOT));
    else
@@ -955,17 +967,9 @@ static void event_main_state(unsigned cmd)
 {
    char path[PATH_MAX_LENGTH] = {0};
    char msg[PATH_MAX_LENGTH]  = {0};
-   global_t *global           = global_get_ptr();
    settings_t *settings       = config_get_ptr();
 
-   if (settings->state_slot > 0)
-      snprintf(path, sizeof(path), "%s%d",
-            global->savestate_name, settings->state_slot);
-   else if (settings->state_slot < 0)
-      fill_pathname_join_delim(path,
-            global->savestate_name, "auto", '.', sizeof(path));
-   else
-      strlcpy(path, global->savestate_name, sizeof(path));
+   fill_pathname_state_slot(path, settings->state_slot, sizeof(path));
 
    if (pretro_serialize_size())
    {
@@ -982,6 +986,9 @@ static void event_main_state(unsigned cmd)
    else
       strlcpy(msg, msg_hash_to_str(MSG_CORE_DOES_NOT_SUPPORT_SAVESTATES), sizeof(msg));
 
+   if (!msg[0])
+      return;
+
    rarch_main_msg_queue_push(msg, 2, 180, true);
    RARCH_LOG("%s\n", msg);
 }
@@ -1718,6 +1725,7 @@ bool event_command(enum event_command cmd)
          break;
       case EVENT_CMD_PERFCNT_REPORT_FRONTEND_LOG:
          rarch_perf_log();
+         rarch_main_frame_time_log();
          break;
       case EVENT_CMD_VOLUME_UP:
          event_set_volume(0.5f);
@@ -418,6 +418,12 @@ static unsigned swap_interval = 1;
  */
 static const bool video_threaded = false;
 
+/* With threaded video, hands frames over through three buffers
+ * instead of one, so the emulation thread never waits on the video
+ * thread and the newest frame is always the one shown.
+ */
+static const bool video_threaded_triple_buffer = false;
+
 #ifdef HAVE_THREADS
 static const bool threaded_data_runloop_enable = true;
 #else
@@ -593,6 +599,11 @@ static const bool rate_control = false;
  * is allowed to adjust input rate. */
 static const float rate_control_delta = 0.005;
 
+/* Quality of the audio resampler, if it supports more than one.
+ * 0 uses the build default, 1 (lowest) to 5 (highest) override it.
+ * Higher settings cost more CPU time. */
+static const unsigned audio_resampler_quality = 0;
+
 /* Maximum timing skew. Defines how much adjust_system_rates
  * is allowed to adjust input rate. */
 static const float max_timing_skew = 0.05;
@@ -616,6 +627,23 @@ static const unsigned rewind_buffer_size = 20 << 20; /* 20MiB */
 /* How many frames to rewind at a time. */
 static const unsigned rewind_granularity = 1;
 
+/* Generates rewind deltas on a separate thread, so the main loop 
+ * only has to serialize the state. */
+static const bool rewind_threaded = false;
+
+/* Stores a full state every N rewind entries, so it's possible to 
+ * jump far back without going through every delta in between.
+ * Costs one uncompressed state per keyframe. 0 disables keyframes. */
+static const unsigned rewind_keyframe_interval = 0;
+
+/* Rewind entries older than this are deflated on a background thread,
+ * which fits several times more history into the rewind buffer.
+ * 0 keeps everything as plain deltas. */
+static const unsigned rewind_deflate_age = 0;
+
+/* How far back the rewind seek hotkey jumps, in seconds. */
+static const unsigned rewind_seek_seconds = 10;
+
 /* Pause gameplay when gameplay loses focus. */
 static const bool pause_nonactive = false;
 
@@ -644,6 +672,29 @@ static const bool savestate_auto_index = false;
 static const bool savestate_auto_save = false;
 static const bool savestate_auto_load = false;
 
+/* Hands save states off to a worker thread which compresses and
+ * writes them, so saving doesn't stall the running content. */
+static const bool savestate_threaded = true;
+
+/* Compresses save states with zlib. */
+static const bool savestate_compression = true;
+
+/* Stores a small thumbnail of the current frame in the header of
+ * each save state, for tools that browse states. RetroArch itself
+ * skips over it when loading. */
+static const bool savestate_thumbnail = false;
+
+/* Runs the core this many frames ahead of what is shown and rolls
+ * it back every frame, hiding the core's internal input lag.
+ * Costs (run_ahead_frames + 1) emulated frames per displayed frame. */
+static const bool run_ahead_enabled = false;
+static const unsigned run_ahead_frames = 1;
+
+/* The frame limiter sleeps until this many microseconds before
+ * each frame's deadline, and busy-waits the rest of the way.
+ * Costs some CPU for much less frame pacing jitter. 0 disables it. */
+static const unsigned frame_limiter_spin_usec = 250;
+
 /* Slowmotion ratio. */
 static const float slowmotion_ratio = 3.0;
 
@@ -787,6 +838,7 @@ static const struct retro_keybind retro_keybinds_1[] = {
    { true, RARCH_STATE_SLOT_PLUS,          RETRO_LBL_STATE_SLOT_PLUS,      RETROK_F7,      NO_BTN, 0, AXIS_NONE },
    { true, RARCH_STATE_SLOT_MINUS,         RETRO_LBL_STATE_SLOT_MINUS,     RETROK_F6,      NO_BTN, 0, AXIS_NONE },
    { true, RARCH_REWIND,                   RETRO_LBL_REWIND,               RETROK_r,       NO_BTN, 0, AXIS_NONE },
+   { true, RARCH_REWIND_SEEK,              RETRO_LBL_REWIND_SEEK,          RETROK_UNKNOWN, NO_BTN, 0, AXIS_NONE },
    { true, RARCH_MOVIE_RECORD_TOGGLE,      RETRO_LBL_MOVIE_RECORD_TOGGLE,  RETROK_o,       NO_BTN, 0, AXIS_NONE },
    { true, RARCH_PAUSE_TOGGLE,             RETRO_LBL_PAUSE_TOGGLE,         RETROK_p,       NO_BTN, 0, AXIS_NONE },
    { true, RARCH_FRAMEADVANCE,             RETRO_LBL_FRAMEADVANCE,         RETROK_k,       NO_BTN, 0, AXIS_NONE },
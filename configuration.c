@@ -472,6 +472,7 @@ static void config_set_defaults(void)
 
    if (g_defaults.settings.video_threaded_enable != video_threaded)
       settings->video.threaded           = g_defaults.settings.video_threaded_enable;
+   settings->video.threaded_triple_buffer = video_threaded_triple_buffer;
 
 #ifdef HAVE_THREADS
    settings->menu.threaded_data_runloop_enable = threaded_data_runloop_enable;
@@ -529,12 +530,17 @@ static void config_set_defaults(void)
    settings->audio.rate_control_delta          = rate_control_delta;
    settings->audio.max_timing_skew             = max_timing_skew;
    settings->audio.volume                      = audio_volume;
+   settings->audio.resampler_quality           = audio_resampler_quality;
 
    audio_driver_set_volume_gain(db_to_gain(settings->audio.volume));
 
    settings->rewind_enable                     = rewind_enable;
    settings->rewind_buffer_size                = rewind_buffer_size;
    settings->rewind_granularity                = rewind_granularity;
+   settings->rewind_threaded                   = rewind_threaded;
+   settings->rewind_keyframe_interval          = rewind_keyframe_interval;
+   settings->rewind_deflate_age                = rewind_deflate_age;
+   settings->rewind_seek_seconds               = rewind_seek_seconds;
    settings->slowmotion_ratio                  = slowmotion_ratio;
    settings->fastforward_ratio                 = fastforward_ratio;
    settings->fastforward_ratio_throttle_enable = fastforward_ratio_throttle_enable;
@@ -545,6 +551,12 @@ static void config_set_defaults(void)
    settings->savestate_auto_index              = savestate_auto_index;
    settings->savestate_auto_save               = savestate_auto_save;
    settings->savestate_auto_load               = savestate_auto_load;
+   settings->savestate_threaded                = savestate_threaded;
+   settings->savestate_compression             = savestate_compression;
+   settings->savestate_thumbnail               = savestate_thumbnail;
+   settings->frame_limiter_spin_usec           = frame_limiter_spin_usec;
+   settings->run_ahead_enabled                 = run_ahead_enabled;
+   settings->run_ahead_frames                  = run_ahead_frames;
    settings->network_cmd_enable                = network_cmd_enable;
    settings->network_cmd_port                  = network_cmd_port;
    settings->stdin_cmd_enable                  = stdin_cmd_enable;
@@ -1290,6 +1302,8 @@ static bool config_load_file(const char *path, bool set_defaults)
    settings->video.swap_interval = max(settings->video.swap_interval, 1);
    settings->video.swap_interval = min(settings->video.swap_interval, 4);
    CONFIG_GET_BOOL_BASE(conf, settings, video.threaded, "video_threaded");
+   CONFIG_GET_BOOL_BASE(conf, settings, video.threaded_triple_buffer,
+         "video_threaded_triple_buffer");
    CONFIG_GET_BOOL_BASE(conf, settings, video.shared_context, "video_shared_context");
 #ifdef GEKKO
    CONFIG_GET_INT_BASE(conf, settings, video.viwidth, "video_viwidth");
@@ -1443,6 +1457,8 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_FLOAT_BASE(conf, settings, audio.max_timing_skew, "audio_max_timing_skew");
    CONFIG_GET_FLOAT_BASE(conf, settings, audio.volume, "audio_volume");
    CONFIG_GET_STRING_BASE(conf, settings, audio.resampler, "audio_resampler");
+   CONFIG_GET_INT_BASE(conf, settings, audio.resampler_quality,
+         "audio_resampler_quality");
    audio_driver_set_volume_gain(db_to_gain(settings->audio.volume));
 
    CONFIG_GET_STRING_BASE(conf, settings, camera.device, "camera_device");
@@ -1582,6 +1598,10 @@ static bool config_load_file(const char *path, bool set_defaults)
    }
 
    CONFIG_GET_INT_BASE(conf, settings, rewind_granularity, "rewind_granularity");
+   CONFIG_GET_BOOL_BASE(conf, settings, rewind_threaded, "rewind_threaded");
+   CONFIG_GET_INT_BASE(conf, settings, rewind_keyframe_interval, "rewind_keyframe_interval");
+   CONFIG_GET_INT_BASE(conf, settings, rewind_deflate_age, "rewind_deflate_age");
+   CONFIG_GET_INT_BASE(conf, settings, rewind_seek_seconds, "rewind_seek_seconds");
    CONFIG_GET_FLOAT_BASE(conf, settings, slowmotion_ratio, "slowmotion_ratio");
    if (settings->slowmotion_ratio < 1.0f)
       settings->slowmotion_ratio = 1.0f;
@@ -1608,6 +1628,12 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_BOOL_BASE(conf, settings, savestate_auto_index, "savestate_auto_index");
    CONFIG_GET_BOOL_BASE(conf, settings, savestate_auto_save, "savestate_auto_save");
    CONFIG_GET_BOOL_BASE(conf, settings, savestate_auto_load, "savestate_auto_load");
+   CONFIG_GET_BOOL_BASE(conf, settings, savestate_threaded, "savestate_threaded");
+   CONFIG_GET_BOOL_BASE(conf, settings, savestate_compression, "savestate_compression");
+   CONFIG_GET_BOOL_BASE(conf, settings, savestate_thumbnail, "savestate_thumbnail");
+   CONFIG_GET_INT_BASE(conf, settings, frame_limiter_spin_usec, "frame_limiter_spin_usec");
+   CONFIG_GET_BOOL_BASE(conf, settings, run_ahead_enabled, "run_ahead_enabled");
+   CONFIG_GET_INT_BASE(conf, settings, run_ahead_frames, "run_ahead_frames");
 
    CONFIG_GET_BOOL_BASE(conf, settings, network_cmd_enable, "network_cmd_enable");
    CONFIG_GET_INT_BASE(conf, settings, network_cmd_port, "network_cmd_port");
@@ -2382,6 +2408,10 @@ bool config_save_file(const char *path)
    config_set_bool(conf,  "audio_sync",    settings->audio.sync);
    config_set_int(conf,   "audio_block_frames", settings->audio.block_frames);
    config_set_int(conf,   "rewind_granularity", settings->rewind_granularity);
+   config_set_bool(conf,  "rewind_threaded", settings->rewind_threaded);
+   config_set_int(conf,   "rewind_keyframe_interval", settings->rewind_keyframe_interval);
+   config_set_int(conf,   "rewind_deflate_age", settings->rewind_deflate_age);
+   config_set_int(conf,   "rewind_seek_seconds", settings->rewind_seek_seconds);
    config_set_path(conf,  "video_shader", settings->video.shader_path);
    config_set_bool(conf,  "video_shader_enable",
          settings->video.shader_enable);
@@ -2399,6 +2429,8 @@ bool config_save_file(const char *path)
 #endif
    config_set_bool(conf,  "video_smooth", settings->video.smooth);
    config_set_bool(conf,  "video_threaded", settings->video.threaded);
+   config_set_bool(conf,  "video_threaded_triple_buffer",
+         settings->video.threaded_triple_buffer);
    config_set_bool(conf,  "video_shared_context",
          settings->video.shared_context);
    config_set_bool(conf,  "video_force_srgb_disable",
@@ -2496,6 +2528,8 @@ bool config_save_file(const char *path)
    config_set_path(conf, "resampler_directory",
          settings->resampler_directory);
    config_set_string(conf, "audio_resampler", settings->audio.resampler);
+   config_set_int(conf, "audio_resampler_quality",
+         settings->audio.resampler_quality);
    config_set_path(conf, "savefile_directory",
          *global->savefile_dir ? global->savefile_dir : "default");
    config_set_path(conf, "savestate_directory",
@@ -2619,6 +2653,18 @@ bool config_save_file(const char *path)
          settings->savestate_auto_save);
    config_set_bool(conf, "savestate_auto_load",
          settings->savestate_auto_load);
+   config_set_bool(conf, "savestate_threaded",
+         settings->savestate_threaded);
+   config_set_bool(conf, "savestate_compression",
+         settings->savestate_compression);
+   config_set_bool(conf, "savestate_thumbnail",
+         settings->savestate_thumbnail);
+   config_set_int(conf, "frame_limiter_spin_usec",
+         settings->frame_limiter_spin_usec);
+   config_set_bool(conf, "run_ahead_enabled",
+         settings->run_ahead_enabled);
+   config_set_int(conf, "run_ahead_frames",
+         settings->run_ahead_frames);
    config_set_bool(conf, "history_list_enable",
          settings->history_list_enable);
 
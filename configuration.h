@@ -68,6 +68,7 @@ typedef struct settings
       char softfilter_plugin[PATH_MAX_LENGTH];
       float refresh_rate;
       bool threaded;
+      bool threaded_triple_buffer;
 
       char filter_dir[PATH_MAX_LENGTH];
       char shader_dir[PATH_MAX_LENGTH];
@@ -197,6 +198,7 @@ typedef struct settings
       float max_timing_skew;
       float volume; /* dB scale. */
       char resampler[32];
+      unsigned resampler_quality;
    } audio;
 
    struct
@@ -302,6 +304,10 @@ typedef struct settings
    bool rewind_enable;
    size_t rewind_buffer_size;
    unsigned rewind_granularity;
+   bool rewind_threaded;
+   unsigned rewind_keyframe_interval;
+   unsigned rewind_deflate_age;
+   unsigned rewind_seek_seconds;
 
    float slowmotion_ratio;
    float fastforward_ratio;
@@ -314,6 +320,14 @@ typedef struct settings
    bool savestate_auto_index;
    bool savestate_auto_save;
    bool savestate_auto_load;
+   bool savestate_threaded;
+   bool savestate_compression;
+   bool savestate_thumbnail;
+
+   unsigned frame_limiter_spin_usec;
+
+   bool run_ahead_enabled;
+   unsigned run_ahead_frames;
 
    bool network_cmd_enable;
    unsigned network_cmd_port;
@@ -33,6 +33,9 @@
 #include <compat/strl.h>
 #include <file/file_path.h>
 #include <file/file_extract.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #include "msg_hash.h"
 #include "content.h"
@@ -42,6 +45,10 @@
 #include "movie.h"
 #include "patch.h"
 #include "system.h"
+#include "gfx/video_driver.h"
+#ifdef HAVE_THREADS
+#include "autosave.h"
+#endif
 
 /**
  * read_content_file:
@@ -136,19 +143,632 @@ struct sram_block
    size_t size;
 };
 
+/* Save states are stored behind a small versioned header, so they can be
+ * told apart from raw retro_serialize() dumps, and so their metadata can
+ * be read without touching the state itself. All fields are little endian.
+ *
+ *   0  magic            "RASTATE\x1a"
+ *   8  version          u32
+ *  12  compression      u32, enum state_compression
+ *  16  state size       u64
+ *  24  stored size      u64, size of the (compressed) state on disk
+ *  32  header size      u32, offset of the thumbnail
+ *  36  content CRC      u32
+ *  40  thumbnail width  u32
+ *  44  thumbnail height u32
+ *  64  core name        char[64]
+ *
+ * The thumbnail (XRGB8888, width * height * 4 bytes) follows the header,
+ * and the state follows the thumbnail. Version 1 headers end at offset 32.
+ */
+#define STATE_HEADER_SIZE        128
+#define STATE_HEADER_SIZE_V1     32
+#define STATE_HEADER_VERSION     2
+#define STATE_DEFLATE_LEVEL      6
+#define STATE_THUMBNAIL_WIDTH    160
+
+#if defined(HAVE_ZLIB) && defined(HAVE_ZLIB_DEFLATE)
+#define HAVE_STATE_DEFLATE
+#endif
+
+static const uint8_t state_magic[8] = { 'R', 'A', 'S', 'T', 'A', 'T', 'E', 0x1a };
+
+static void state_write_le(uint8_t *out, uint64_t val, unsigned bytes)
+{
+   unsigned i;
+   for (i = 0; i < bytes; i++)
+      out[i] = (uint8_t)(val >> (8 * i));
+}
+
+static uint64_t state_read_le(const uint8_t *in, unsigned bytes)
+{
+   unsigned i;
+   uint64_t val = 0;
+   for (i = 0; i < bytes; i++)
+      val |= (uint64_t)in[i] << (8 * i);
+   return val;
+}
+
+/**
+ * state_parse_header:
+ * @in        : start of the state file.
+ * @len       : bytes available at @in.
+ * @file_size : size of the whole state file.
+ * @info      : filled in from the header.
+ * @offset    : offset of the stored state.
+ * @stored    : size of the stored state.
+ *
+ * Returns: 1 if the file has a header, 0 if it's a raw state,
+ * -1 if the header is unusable.
+ **/
+static int state_parse_header(const uint8_t *in, size_t len,
+      uint64_t file_size, state_info_t *info,
+      uint64_t *offset, uint64_t *stored)
+{
+   uint64_t header_size = STATE_HEADER_SIZE_V1;
+   uint64_t thumb_size  = 0;
+
+   memset(info, 0, sizeof(*info));
+
+   if (len < STATE_HEADER_SIZE_V1
+         || memcmp(in, state_magic, sizeof(state_magic)) != 0)
+      return 0;
+
+   info->version     = (unsigned)state_read_le(in +  8, 4);
+   info->compression = (unsigned)state_read_le(in + 12, 4);
+   info->state_size  = state_read_le(in + 16, 8);
+   *stored           = state_read_le(in + 24, 8);
+
+   if (info->version == 0 || info->version > STATE_HEADER_VERSION)
+      return -1;
+
+   if (info->version >= 2)
+   {
+      if (len < STATE_HEADER_SIZE)
+         return -1;
+
+      header_size             = state_read_le(in + 32, 4);
+      info->content_crc       = (uint32_t)state_read_le(in + 36, 4);
+      info->thumbnail_width   = (unsigned)state_read_le(in + 40, 4);
+      info->thumbnail_height  = (unsigned)state_read_le(in + 44, 4);
+      memcpy(info->core_name, in + 64, sizeof(info->core_name) - 1);
+
+      thumb_size = (uint64_t)info->thumbnail_width
+         * info->thumbnail_height * 4;
+   }
+
+   *offset = header_size + thumb_size;
+
+   if (header_size < STATE_HEADER_SIZE_V1
+         || *offset > file_size
+         || *stored > file_size - *offset
+         || info->state_size > UINT32_MAX
+         || *stored > UINT32_MAX)
+      return -1;
+
+   return 1;
+}
+
+/**
+ * state_thumbnail_capture:
+ * @width     : width of the thumbnail.
+ * @height    : height of the thumbnail.
+ *
+ * Downscales the last frame the core rendered into an XRGB8888
+ * thumbnail, stored little endian.
+ *
+ * Returns: thumbnail, or NULL if there's no software frame to use.
+ **/
+static uint8_t *state_thumbnail_capture(unsigned *width, unsigned *height)
+{
+   unsigned x, y, w, h, step;
+   size_t pitch;
+   const void *frame = NULL;
+   uint8_t *thumb    = NULL;
+   uint8_t *out      = NULL;
+   enum retro_pixel_format fmt = video_driver_get_pixel_format();
+
+   video_driver_cached_frame_get(&frame, &w, &h, &pitch);
+
+   if (!frame || frame == RETRO_HW_FRAME_BUFFER_VALID || !w || !h)
+      return NULL;
+
+   step    = (w + STATE_THUMBNAIL_WIDTH - 1) / STATE_THUMBNAIL_WIDTH;
+   *width  = w / step;
+   *height = h / step;
+
+   if (!(thumb = (uint8_t*)malloc(*width * *height * 4)))
+      return NULL;
+
+   out = thumb;
+
+   for (y = 0; y < *height; y++)
+   {
+      const uint8_t *row = (const uint8_t*)frame + y * step * pitch;
+
+      for (x = 0; x < *width; x++, out += 4)
+      {
+         uint32_t r, g, b;
+
+         switch (fmt)
+         {
+            case RETRO_PIXEL_FORMAT_XRGB8888:
+               {
+                  uint32_t col = ((const uint32_t*)row)[x * step];
+                  r = (col >> 16) & 0xff;
+                  g = (col >>  8) & 0xff;
+                  b = (col >>  0) & 0xff;
+               }
+               break;
+            case RETRO_PIXEL_FORMAT_RGB565:
+               {
+                  uint16_t col = ((const uint16_t*)row)[x * step];
+                  r = (col >> 11) & 0x1f;
+                  g = (col >>  5) & 0x3f;
+                  b = (col >>  0) & 0x1f;
+                  r = (r << 3) | (r >> 2);
+                  g = (g << 2) | (g >> 4);
+                  b = (b << 3) | (b >> 2);
+               }
+               break;
+            default:
+               {
+                  uint16_t col = ((const uint16_t*)row)[x * step];
+                  r = (col >> 10) & 0x1f;
+                  g = (col >>  5) & 0x1f;
+                  b = (col >>  0) & 0x1f;
+                  r = (r << 3) | (r >> 2);
+                  g = (g << 3) | (g >> 2);
+                  b = (b << 3) | (b >> 2);
+               }
+               break;
+         }
+
+         out[0] = b;
+         out[1] = g;
+         out[2] = r;
+         out[3] = 0;
+      }
+   }
+
+   return thumb;
+}
+
+/**
+ * state_write_file:
+ * @path      : path of saved state that shall be written to.
+ * @data      : serialized state.
+ * @size      : size of @data.
+ * @compress  : deflate the state before writing it.
+ * @info      : metadata to store in the header. Compression
+ *              and sizes are filled in here.
+ * @thumbnail : thumbnail described by @info, or NULL.
+ *
+ * Writes a serialized state to disk. The state is stored
+ * uncompressed if compression is unavailable or doesn't
+ * make it any smaller.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+static bool state_write_file(const char *path, const void *data,
+      size_t size, bool compress, state_info_t *info,
+      const uint8_t *thumbnail)
+{
+   uint8_t header[STATE_HEADER_SIZE] = {0};
+   bool ret                          = false;
+   const void *stored                = data;
+   uint64_t stored_size              = size;
+   size_t thumb_size                 = 0;
+   uint8_t *deflated                 = NULL;
+   FILE *file                        = NULL;
+
+   info->compression = STATE_COMPRESSION_NONE;
+   info->state_size  = size;
+
+   if (!thumbnail)
+      info->thumbnail_width = info->thumbnail_height = 0;
+   thumb_size = info->thumbnail_width * info->thumbnail_height * 4;
+
+#ifdef HAVE_STATE_DEFLATE
+   if (compress && size <= UINT32_MAX)
+   {
+      void *stream = zlib_stream_new();
+      deflated     = (uint8_t*)malloc(size);
+
+      if (stream && deflated)
+      {
+         zlib_set_stream(stream, size, size,
+               (const uint8_t*)data, deflated);
+         zlib_deflate_init(stream, STATE_DEFLATE_LEVEL);
+
+         if (zlib_deflate_data_to_file(stream) == 1)
+         {
+            stored            = deflated;
+            stored_size       = zlib_stream_get_total_out(stream);
+            info->compression = STATE_COMPRESSION_ZLIB;
+         }
+
+         zlib_stream_deflate_free(stream);
+      }
+
+      free(stream);
+   }
+#endif
+
+   memcpy(header, state_magic, sizeof(state_magic));
+   state_write_le(header +  8, STATE_HEADER_VERSION,    4);
+   state_write_le(header + 12, info->compression,       4);
+   state_write_le(header + 16, size,                    8);
+   state_write_le(header + 24, stored_size,             8);
+   state_write_le(header + 32, STATE_HEADER_SIZE,       4);
+   state_write_le(header + 36, info->content_crc,       4);
+   state_write_le(header + 40, info->thumbnail_width,   4);
+   state_write_le(header + 44, info->thumbnail_height,  4);
+   memcpy(header + 64, info->core_name, strlen(info->core_name));
+
+   if ((file = fopen(path, "wb")))
+   {
+      ret = fwrite(header, 1, sizeof(header), file) == sizeof(header)
+         && (!thumb_size
+               || fwrite(thumbnail, 1, thumb_size, file) == thumb_size)
+         && fwrite(stored, 1, stored_size, file) == stored_size;
+
+      if (fclose(file) != 0)
+         ret = false;
+   }
+
+   free(deflated);
+   return ret;
+}
+
+static void state_unmap(void *handle)
+{
+#ifdef HAVE_ZLIB
+   zlib_get_default_file_backend()->free(handle);
+#else
+   free(handle);
+#endif
+}
+
+/**
+ * state_map:
+ * @path      : path of the state file.
+ * @state     : serialized state inside the file.
+ * @size      : size of @state.
+ * @inflated  : set if @state had to be decompressed into its
+ *              own buffer. Free it with free().
+ *
+ * Maps a state file into memory. Uncompressed states are used
+ * in place and compressed ones are inflated straight out of the
+ * mapping, so no copy of the file itself is ever made.
+ *
+ * Returns: handle to pass to state_unmap(), or NULL on error.
+ **/
+static void *state_map(const char *path, const void **state,
+      size_t *size, void **inflated)
+{
+   state_info_t info;
+   uint64_t offset, stored;
+   size_t len            = 0;
+   const uint8_t *data   = NULL;
+   void *handle          = NULL;
+
+   *inflated = NULL;
+
+#ifdef HAVE_ZLIB
+   handle = zlib_get_default_file_backend()->open(path);
+   if (!handle)
+      return NULL;
+   data = zlib_get_default_file_backend()->data(handle);
+   len  = zlib_get_default_file_backend()->size(handle);
+#else
+   {
+      ssize_t rc;
+      if (!read_file(path, &handle, &rc) || rc < 0)
+         return NULL;
+      data = (const uint8_t*)handle;
+      len  = rc;
+   }
+#endif
+
+   switch (state_parse_header(data, len, len, &info, &offset, &stored))
+   {
+      case 0:
+         *state = data;
+         *size  = len;
+         return handle;
+      case 1:
+         break;
+      default:
+         goto error;
+   }
+
+   *size = info.state_size;
+
+   switch (info.compression)
+   {
+      case STATE_COMPRESSION_NONE:
+         if (info.state_size > stored)
+            goto error;
+         *state = data + offset;
+         return handle;
+#ifdef HAVE_ZLIB
+      case STATE_COMPRESSION_ZLIB:
+         {
+            int ret      = -1;
+            void *stream = zlib_stream_new();
+            uint8_t *out = (uint8_t*)malloc(info.state_size);
+
+            if (stream && out && zlib_inflate_init(stream))
+            {
+               zlib_set_stream(stream, stored, info.state_size,
+                     data + offset, out);
+
+               do
+               {
+                  ret = zlib_inflate_data_to_file_iterate(stream);
+               } while (ret == 0);
+
+               if (zlib_stream_get_total_out(stream) != info.state_size)
+                  ret = -1;
+
+               zlib_stream_free(stream);
+            }
+            free(stream);
+
+            if (ret != 1)
+            {
+               free(out);
+               goto error;
+            }
+
+            *state    = out;
+            *inflated = out;
+         }
+         return handle;
+#endif
+      default:
+         break;
+   }
+
+error:
+   state_unmap(handle);
+   return NULL;
+}
+
+/**
+ * load_state_info:
+ * @path      : path of the state file.
+ * @info      : metadata of the state.
+ *
+ * Reads the metadata of a state without loading the state itself.
+ * Raw states without a header report version 0.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+bool load_state_info(const char *path, state_info_t *info)
+{
+   long file_size;
+   uint64_t offset, stored;
+   uint8_t header[STATE_HEADER_SIZE];
+   size_t len = 0;
+   FILE *file = fopen(path, "rb");
+
+   if (!file)
+      return false;
+
+   len = fread(header, 1, sizeof(header), file);
+   fseek(file, 0, SEEK_END);
+   file_size = ftell(file);
+   fclose(file);
+
+   if (file_size < 0)
+      return false;
+
+   switch (state_parse_header(header, len, file_size, info,
+            &offset, &stored))
+   {
+      case 0:
+         info->state_size = file_size;
+         return true;
+      case 1:
+         return true;
+      default:
+         break;
+   }
+
+   return false;
+}
+
+/**
+ * fill_pathname_state_slot:
+ * @path      : buffer for the path.
+ * @slot      : state slot, -1 for the auto slot.
+ * @size      : size of @path.
+ *
+ * Gets the path a state slot of the current content is saved to.
+ **/
+void fill_pathname_state_slot(char *path, int slot, size_t size)
+{
+   global_t *global = global_get_ptr();
+
+   if (slot > 0)
+      snprintf(path, size, "%s%d", global->savestate_name, slot);
+   else if (slot < 0)
+      fill_pathname_join_delim(path,
+            global->savestate_name, "auto", '.', size);
+   else
+      strlcpy(path, global->savestate_name, size);
+}
+
+
+/**
+ * save_state_report:
+ * @path      : path of saved state.
+ * @ret       : whether the state was written.
+ *
+ * Puts the outcome of a threaded save state on screen. The caller
+ * of save_state() can't, as the state is written after it returns.
+ * Thread-safe.
+ **/
+static void save_state_report(const char *path, bool ret)
+{
+   char msg[PATH_MAX_LENGTH + 64] = {0};
+
+   if (!ret)
+      RARCH_ERR("%s \"%s\".\n",
+            msg_hash_to_str(MSG_FAILED_TO_SAVE_STATE_TO),
+            path);
+
+   snprintf(msg, sizeof(msg), "%s \"%s\".",
+         msg_hash_to_str(ret ? MSG_SAVED_STATE_TO
+            : MSG_FAILED_TO_SAVE_STATE_TO),
+         path_basename(path));
+   rarch_main_msg_queue_push(msg, 2, 180, true);
+}
+
+#ifdef HAVE_THREADS
+/* A state handed off by save_state() which is still being
+ * compressed and written. Only one is in flight at a time. */
+typedef struct save_state_thread
+{
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+
+   char path[PATH_MAX_LENGTH];
+   void *data;
+   size_t size;
+   bool compress;
+   state_info_t info;
+   uint8_t *thumbnail;
+
+   bool busy;
+   bool quit;
+} save_state_thread_t;
+
+static save_state_thread_t *save_thread;
+
+static void save_state_thread_loop(void *data)
+{
+   save_state_thread_t *handle = (save_state_thread_t*)data;
+
+   slock_lock(handle->lock);
+
+   for (;;)
+   {
+      bool ret;
+
+      while (!handle->busy && !handle->quit)
+         scond_wait(handle->cond, handle->lock);
+
+      if (!handle->busy)
+         break;
+
+      /* Nothing else touches the job while it's busy, and readers of
+       * handle->data hold the lock, so we can run unlocked here. */
+      slock_unlock(handle->lock);
+
+      ret = state_write_file(handle->path, handle->data,
+            handle->size, handle->compress, &handle->info,
+            handle->thumbnail);
+
+      save_state_report(handle->path, ret);
+
+      slock_lock(handle->lock);
+      free(handle->data);
+      free(handle->thumbnail);
+      handle->data      = NULL;
+      handle->thumbnail = NULL;
+      handle->busy      = false;
+      scond_broadcast(handle->cond);
+   }
+
+   slock_unlock(handle->lock);
+}
+
+static save_state_thread_t *save_state_thread_new(void)
+{
+   save_state_thread_t *handle = (save_state_thread_t*)
+      calloc(1, sizeof(*handle));
+
+   if (!handle)
+      return NULL;
+
+   handle->lock   = slock_new();
+   handle->cond   = scond_new();
+
+   if (handle->lock && handle->cond)
+      handle->thread = sthread_create(save_state_thread_loop, handle);
+
+   if (!handle->thread)
+   {
+      if (handle->lock)
+         slock_free(handle->lock);
+      if (handle->cond)
+         scond_free(handle->cond);
+      free(handle);
+      return NULL;
+   }
+
+   return handle;
+}
+
+/* Must be called with the lock held. */
+static void save_state_thread_wait(save_state_thread_t *handle)
+{
+   while (handle->busy)
+      scond_wait(handle->cond, handle->lock);
+}
+#endif
+
+/**
+ * save_state_deinit:
+ *
+ * Waits for any save state which is still being written and
+ * stops the save state thread.
+ **/
+void save_state_deinit(void)
+{
+#ifdef HAVE_THREADS
+   if (!save_thread)
+      return;
+
+   slock_lock(save_thread->lock);
+   save_state_thread_wait(save_thread);
+   save_thread->quit = true;
+   scond_broadcast(save_thread->cond);
+   slock_unlock(save_thread->lock);
+
+   sthread_join(save_thread->thread);
+   slock_free(save_thread->lock);
+   scond_free(save_thread->cond);
+   free(save_thread);
+   save_thread = NULL;
+#endif
+}
+
 /**
  * save_state:
  * @path      : path of saved state that shall be written to.
  *
- * Save a state from memory to disk.
+ * Save a state from memory to disk. If savestate_threaded is set,
+ * only the snapshot is taken here and the state is written
+ * in the background, and its outcome is put on screen once known.
+ * So is success when the state ends up written here after all.
  *
  * Returns: true if successful, false otherwise.
  **/
 bool save_state(const char *path)
 {
-   bool ret    = false;
-   void *data  = NULL;
-   size_t size = pretro_serialize_size();
+   state_info_t info;
+   bool ret                    = false;
+   void *data                  = NULL;
+   uint8_t *thumbnail          = NULL;
+   size_t size                 = pretro_serialize_size();
+   settings_t *settings        = config_get_ptr();
+   global_t *global            = global_get_ptr();
+   rarch_system_info_t *system = rarch_system_info_get_ptr();
 
    RARCH_LOG("%s: \"%s\".\n",
          msg_hash_to_str(MSG_SAVING_STATE),
@@ -168,15 +788,56 @@ bool save_state(const char *path)
          msg_hash_to_str(MSG_BYTES));
    ret = pretro_serialize(data, size);
 
+   memset(&info, 0, sizeof(info));
+   info.content_crc = global->content_crc;
+   if (system->info.library_name)
+      strlcpy(info.core_name, system->info.library_name,
+            sizeof(info.core_name));
+   if (ret && settings->savestate_thumbnail)
+      thumbnail = state_thumbnail_capture(&info.thumbnail_width,
+            &info.thumbnail_height);
+
+#ifdef HAVE_THREADS
+   if (ret && settings->savestate_threaded && !save_thread)
+      save_thread = save_state_thread_new();
+
+   if (save_thread)
+   {
+      slock_lock(save_thread->lock);
+      /* Keep writes to the same slot in order. */
+      save_state_thread_wait(save_thread);
+
+      if (ret && settings->savestate_threaded)
+      {
+         strlcpy(save_thread->path, path, sizeof(save_thread->path));
+         save_thread->data     = data;
+         save_thread->size     = size;
+         save_thread->compress  = settings->savestate_compression;
+         save_thread->info      = info;
+         save_thread->thumbnail = thumbnail;
+         save_thread->busy      = true;
+         scond_broadcast(save_thread->cond);
+         slock_unlock(save_thread->lock);
+         return true;
+      }
+
+      slock_unlock(save_thread->lock);
+   }
+#endif
+
    if (ret)
-      ret = write_file(path, data, size);
+      ret = state_write_file(path, data, size,
+            settings->savestate_compression, &info, thumbnail);
 
-   if (!ret)
+   if (ret && settings->savestate_threaded)
+      save_state_report(path, ret);
+   else if (!ret)
       RARCH_ERR("%s \"%s\".\n", 
             msg_hash_to_str(MSG_FAILED_TO_SAVE_STATE_TO),
             path);
 
    free(data);
+   free(thumbnail);
 
    return ret;
 }
@@ -192,19 +853,39 @@ bool save_state(const char *path)
 bool load_state(const char *path)
 {
    unsigned i;
-   ssize_t size;
+   size_t size               = 0;
    unsigned num_blocks       = 0;
-   void *buf                 = NULL;
+   const void *buf           = NULL;
+   void *handle              = NULL;
+   void *inflated            = NULL;
+   bool in_flight            = false;
+   bool ret                  = false;
    struct sram_block *blocks = NULL;
    settings_t *settings      = config_get_ptr();
    global_t *global          = global_get_ptr();
-   bool ret                  = read_file(path, &buf, &size);
 
    RARCH_LOG("%s: \"%s\".\n",
          msg_hash_to_str(MSG_LOADING_STATE),
          path);
 
-   if (!ret || size < 0)
+#ifdef HAVE_THREADS
+   /* If this state is still being written, load the snapshot
+    * directly. Holding the lock keeps it from being freed under us. */
+   if (save_thread)
+   {
+      slock_lock(save_thread->lock);
+      if (save_thread->busy && !strcmp(save_thread->path, path))
+      {
+         buf       = save_thread->data;
+         size      = save_thread->size;
+         in_flight = true;
+      }
+      else
+         slock_unlock(save_thread->lock);
+   }
+#endif
+
+   if (!in_flight && !(handle = state_map(path, &buf, &size, &inflated)))
    {
       RARCH_ERR("%s \"%s\".\n",
             msg_hash_to_str(MSG_FAILED_TO_LOAD_STATE),
@@ -267,7 +948,14 @@ bool load_state(const char *path)
    for (i = 0; i < num_blocks; i++)
       free(blocks[i].data);
    free(blocks);
-   free(buf);
+
+#ifdef HAVE_THREADS
+   if (in_flight)
+      slock_unlock(save_thread->lock);
+#endif
+   if (handle)
+      state_unmap(handle);
+   free(inflated);
    return ret;
 }
 
@@ -289,6 +977,10 @@ void load_ram_file(const char *path, int type)
    if (size == 0 || !data)
       return;
 
+#ifdef HAVE_THREADS
+   autosave_recover(path);
+#endif
+
    ret = read_file(path, &buf, &rc);
 
    if (!ret)
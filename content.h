@@ -29,6 +29,26 @@ extern "C" {
 
 /* Handles files related to libretro. */
 
+enum state_compression
+{
+   STATE_COMPRESSION_NONE = 0,
+   STATE_COMPRESSION_ZLIB
+};
+
+/* Metadata stored in the header of a save state. */
+typedef struct state_info
+{
+   /* 0 for raw states without a header. */
+   unsigned version;
+   unsigned compression;
+   uint64_t state_size;
+   uint32_t content_crc;
+   char core_name[64];
+   /* Optional thumbnail in front of the state, 0x0 if there is none. */
+   unsigned thumbnail_width;
+   unsigned thumbnail_height;
+} state_info_t;
+
 /**
  * load_state:
  * @path      : path that state will be loaded from.
@@ -49,6 +69,36 @@ bool load_state(const char *path);
  **/
 bool save_state(const char *path);
 
+/**
+ * load_state_info:
+ * @path      : path of the state file.
+ * @info      : metadata of the state.
+ *
+ * Reads the metadata of a state without loading the state itself.
+ * Raw states without a header report version 0.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+bool load_state_info(const char *path, state_info_t *info);
+
+/**
+ * fill_pathname_state_slot:
+ * @path      : buffer for the path.
+ * @slot      : state slot, -1 for the auto slot.
+ * @size      : size of @path.
+ *
+ * Gets the path a state slot of the current content is saved to.
+ **/
+void fill_pathname_state_slot(char *path, int slot, size_t size);
+
+/**
+ * save_state_deinit:
+ *
+ * Waits for any save state which is still being written and
+ * stops the save state thread.
+ **/
+void save_state_deinit(void);
+
 /**
  * load_ram_file:
  * @path             : path of RAM state that will be loaded from.
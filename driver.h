@@ -109,6 +109,7 @@ enum
    RARCH_STATE_SLOT_PLUS,
    RARCH_STATE_SLOT_MINUS,
    RARCH_REWIND,
+   RARCH_REWIND_SEEK,
    RARCH_MOVIE_RECORD_TOGGLE,
    RARCH_PAUSE_TOGGLE,
    RARCH_FRAMEADVANCE,
@@ -777,6 +777,13 @@ bool rarch_environment_cb(unsigned cmd, void *data)
                settings->user_language);
          break;
 
+      case RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER:
+         /* Called every frame, so not logged. */
+         if (!video_driver_get_current_software_framebuffer(
+                  (struct retro_framebuffer*)data))
+            return false;
+         break;
+
       case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
       {
          enum retro_pixel_format pix_fmt = 
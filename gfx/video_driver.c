@@ -18,6 +18,7 @@
 #include <string/string_list.h>
 #include "video_driver.h"
 #include "video_thread_wrapper.h"
+#include "video_frame_pool.h"
 #include "video_pixel_converter.h"
 #include "video_monitor.h"
 #include "../general.h"
@@ -39,9 +40,15 @@ typedef struct video_driver_state
    unsigned video_height;
    float aspect_ratio;
 
+   /* Buffers handed between the pixel converter, softfilter
+    * and threaded wrapper. */
+   video_frame_pool_t *frame_pool;
+
    struct
    {
       const void *data;
+      /* Held while data is in the frame pool. */
+      video_frame_buffer_t *buffer;
       unsigned width;
       unsigned height;
       size_t pitch;
@@ -51,7 +58,7 @@ typedef struct video_driver_state
    {
       rarch_softfilter_t *filter;
 
-      void *buffer;
+      video_frame_buffer_t *buffer;
       unsigned scale;
       unsigned out_bpp;
       bool out_rgb32;
@@ -296,6 +303,50 @@ uintptr_t video_driver_get_current_framebuffer(void)
    return 0;
 }
 
+/**
+ * video_driver_get_current_software_framebuffer:
+ * @fb                        : Framebuffer, with width and height
+ *                              of the frame to be rendered set.
+ *
+ * Gets a frontend-owned buffer for the core to render its
+ * next frame into, so it reaches the video driver without
+ * being copied.
+ * Used by RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER.
+ *
+ * Returns: true (1) if @fb was filled in, otherwise false (0).
+ **/
+bool video_driver_get_current_software_framebuffer(
+      struct retro_framebuffer *fb)
+{
+   size_t pitch = 0;
+   void *data   = NULL;
+
+   if (!fb || video_state.hw_render_callback.context_type)
+      return false;
+
+   /* 0RGB1555 gets converted and softfilters write a frame of
+    * their own, so either way the core's frame is only read,
+    * and a buffer of ours would not save anything. */
+   if (video_state.pix_fmt == RETRO_PIXEL_FORMAT_0RGB1555
+         || video_state.filter.filter)
+      return false;
+
+   /* Unthreaded drivers upload straight from the core's frame,
+    * it's only the threaded wrapper which copies it. */
+#ifdef HAVE_THREADS
+   data = rarch_threaded_video_get_frame_buffer(fb->width, fb->height,
+         &pitch);
+#endif
+   if (!data)
+      return false;
+
+   fb->data         = data;
+   fb->pitch        = pitch;
+   fb->format       = video_state.pix_fmt;
+   fb->memory_flags = RETRO_MEMORY_TYPE_CACHED;
+   return true;
+}
+
 uint64_t video_driver_get_frame_count(void)
 {
    static bool warn_once = true;
@@ -354,7 +405,7 @@ bool video_driver_set_shader(enum rarch_shader_type type,
 static void deinit_video_filter(void)
 {
    rarch_softfilter_free(video_state.filter.filter);
-   free(video_state.filter.buffer);
+   video_frame_buffer_unref(video_state.filter.buffer);
    memset(&video_state.filter, 0, sizeof(video_state.filter));
 }
 
@@ -408,16 +459,8 @@ static void init_video_filter(enum retro_pixel_format colfmt)
    video_state.filter.out_bpp = video_state.filter.out_rgb32 ?
       sizeof(uint32_t) : sizeof(uint16_t);
 
-   /* TODO: Aligned output. */
-   video_state.filter.buffer = malloc(width * height * video_state.filter.out_bpp);
-   if (!video_state.filter.buffer)
-      goto error;
-
-   return;
-
-error:
-   RARCH_ERR("Softfilter initialization failed.\n");
-   deinit_video_filter();
+   /* The output buffer comes from the frame pool,
+    * sized for each frame as it's filtered. */
 }
 
 static void init_video_input(const input_driver_t *tmp)
@@ -473,6 +516,10 @@ void uninit_video_input(void)
 
    deinit_video_filter();
 
+   video_driver_cached_frame_set(NULL, 0, 0, 0);
+   video_frame_pool_free(video_state.frame_pool);
+   video_state.frame_pool = NULL;
+
    video_driver_unset_callback();
    event_command(EVENT_CMD_SHADER_DIR_DEINIT);
    video_monitor_compute_fps_statistics();
@@ -492,6 +539,9 @@ void init_video(void)
    struct retro_system_av_info *av_info = 
       video_viewport_get_system_av_info();
 
+   if (!video_state.frame_pool)
+      video_state.frame_pool = video_frame_pool_new();
+
    init_video_filter(video_state.pix_fmt);
    event_command(EVENT_CMD_SHADER_DIR_INIT);
 
@@ -551,7 +601,7 @@ void init_video(void)
    driver->video_display = 0;
    driver->video_window  = 0;
 
-   if (!init_video_pixel_converter(RARCH_SCALE_BASE * scale))
+   if (!init_video_pixel_converter())
    {
       RARCH_ERR("Failed to initialize pixel converter.\n");
       rarch_fail(1, "init_video()");
@@ -909,17 +959,31 @@ bool video_driver_cached_frame_has_valid_fb(void)
    return (video_state.frame_cache.data == RETRO_HW_FRAME_BUFFER_VALID);
 }
 
+/* Holds on to the cached frame while it lives in the frame pool,
+ * so it isn't reused for another frame underneath us. */
+static void video_driver_cached_frame_hold(const void *data)
+{
+   video_frame_buffer_t *buf = video_frame_pool_find(
+         video_state.frame_pool, data);
+
+   video_frame_buffer_ref(buf);
+   video_frame_buffer_unref(video_state.frame_cache.buffer);
+   video_state.frame_cache.buffer = buf;
+}
+
 void video_driver_cached_frame_set_ptr(const void *data)
 {
    if (!data)
       return;
 
+   video_driver_cached_frame_hold(data);
    video_state.frame_cache.data   = data;
 }
 
 void video_driver_cached_frame_set(const void *data, unsigned width,
       unsigned height, size_t pitch)
 {
+   video_driver_cached_frame_hold(data);
    video_state.frame_cache.data   = data;
    video_state.frame_cache.width  = width;
    video_state.frame_cache.height = height;
@@ -1208,6 +1272,7 @@ bool video_driver_frame_filter(const void *data,
       unsigned *output_width, unsigned *output_height,
       unsigned *output_pitch)
 {
+   uint8_t *output      = NULL;
    settings_t *settings = config_get_ptr();
 
    RARCH_PERFORMANCE_INIT(softfilter_process);
@@ -1222,14 +1287,21 @@ bool video_driver_frame_filter(const void *data,
 
    *output_pitch = (*output_width) * video_state.filter.out_bpp;
 
+   /* The last output is still in use if the threaded
+    * wrapper took it, in which case we get a fresh one. */
+   output = video_frame_pool_reserve(video_state.frame_pool,
+         &video_state.filter.buffer, *output_pitch * *output_height);
+   if (!output)
+      return false;
+
    RARCH_PERFORMANCE_START(softfilter_process);
    rarch_softfilter_process(video_state.filter.filter,
-         video_state.filter.buffer, *output_pitch,
+         output, *output_pitch,
          data, width, height, pitch);
    RARCH_PERFORMANCE_STOP(softfilter_process);
 
    if (settings->video.post_filter_record)
-      recording_dump_frame(video_state.filter.buffer,
+      recording_dump_frame(output,
             *output_width, *output_height, *output_pitch);
 
    return true;
@@ -1254,7 +1326,14 @@ rarch_softfilter_t *video_driver_frame_filter_get_ptr(void)
 
 void *video_driver_frame_filter_get_buf_ptr(void)
 {
-   return video_state.filter.buffer;
+   if (!video_state.filter.buffer)
+      return NULL;
+   return video_state.filter.buffer->data;
+}
+
+video_frame_pool_t *video_driver_get_frame_pool(void)
+{
+   return video_state.frame_pool;
 }
 
 enum retro_pixel_format video_driver_get_pixel_format(void)
@@ -269,6 +269,21 @@ void *video_driver_get_ptr(const video_driver_t **drv);
  **/
 uintptr_t video_driver_get_current_framebuffer(void);
 
+/**
+ * video_driver_get_current_software_framebuffer:
+ * @fb                        : Framebuffer, with width and height
+ *                              of the frame to be rendered set.
+ *
+ * Gets a frontend-owned buffer for the core to render its
+ * next frame into, so it reaches the video driver without
+ * being copied.
+ * Used by RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER.
+ *
+ * Returns: true (1) if @fb was filled in, otherwise false (0).
+ **/
+bool video_driver_get_current_software_framebuffer(
+      struct retro_framebuffer *fb);
+
 retro_proc_address_t video_driver_get_proc_address(const char *sym);
 
 bool video_driver_is_alive(void);
@@ -370,6 +385,16 @@ rarch_softfilter_t *video_driver_frame_filter_get_ptr(void);
 
 void *video_driver_frame_filter_get_buf_ptr(void);
 
+/**
+ * video_driver_get_frame_pool:
+ *
+ * Gets the pool of frame buffers shared by the stages
+ * between the core and the video driver.
+ *
+ * Returns: the frame pool, or NULL if video isn't inited.
+ **/
+struct video_frame_pool *video_driver_get_frame_pool(void);
+
 enum retro_pixel_format video_driver_get_pixel_format(void);
 
 void video_driver_set_pixel_format(enum retro_pixel_format fmt);
@@ -25,6 +25,10 @@
 #include "../performance.h"
 #include <stdlib.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rpool.h>
+#endif
+
 struct rarch_soft_plug
 {
 #ifdef HAVE_DYLIB
@@ -33,46 +37,6 @@ struct rarch_soft_plug
    const struct softfilter_implementation *impl;
 };
 
-#ifdef HAVE_THREADS
-#include <rthreads/rthreads.h>
-
-struct filter_thread_data
-{
-   sthread_t *thread;
-   const struct softfilter_work_packet *packet;
-   scond_t *cond;
-   slock_t *lock;
-   void *userdata;
-   bool die;
-   bool done;
-};
-
-static void filter_thread_loop(void *data)
-{
-   struct filter_thread_data *thr = (struct filter_thread_data*)data;
-
-   for (;;)
-   {
-      bool die;
-      slock_lock(thr->lock);
-      while (thr->done && !thr->die)
-         scond_wait(thr->cond, thr->lock);
-      die = thr->die;
-      slock_unlock(thr->lock);
-
-      if (die)
-         break;
-
-      if (thr->packet && thr->packet->work)
-         thr->packet->work(thr->userdata, thr->packet->thread_data);
-
-      slock_lock(thr->lock);
-      thr->done = true;
-      scond_signal(thr->cond);
-      slock_unlock(thr->lock);
-   }
-}
-#endif
 
 struct rarch_softfilter
 {
@@ -89,12 +53,17 @@ struct rarch_softfilter
 
    struct softfilter_work_packet *packets;
    unsigned threads;
-
-#ifdef HAVE_THREADS
-   struct filter_thread_data *thread_data;
-#endif
 };
 
+static void softfilter_work(void *data, unsigned index)
+{
+   rarch_softfilter_t *filt                    = (rarch_softfilter_t*)data;
+   const struct softfilter_work_packet *packet = &filt->packets[index];
+
+   if (packet->work)
+      packet->work(filt->impl_data, packet->thread_data);
+}
+
 static const struct softfilter_implementation *
 softfilter_find_implementation(rarch_softfilter_t *filt, const char *ident)
 {
@@ -124,7 +93,7 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
       softfilter_simd_mask_t cpu_features,
       unsigned threads)
 {
-   unsigned input_fmts, input_fmt, output_fmts, i;
+   unsigned input_fmts, input_fmt, output_fmts;
    struct config_file_userdata userdata;
    char key[64]  = {0};
    char name[64] = {0};
@@ -222,31 +191,8 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
       return false;
    }
 
-#ifdef HAVE_THREADS
-   filt->thread_data = (struct filter_thread_data*)
-      calloc(threads, sizeof(*filt->thread_data));
-   if (!filt->thread_data)
-      return false;
    filt->threads = threads;
 
-   for (i = 0; i < threads; i++)
-   {
-      filt->thread_data[i].userdata = filt->impl_data;
-      filt->thread_data[i].done = true;
-
-      filt->thread_data[i].lock = slock_new();
-      if (!filt->thread_data[i].lock)
-         return false;
-      filt->thread_data[i].cond = scond_new();
-      if (!filt->thread_data[i].cond)
-         return false;
-      filt->thread_data[i].thread = sthread_create(
-            filter_thread_loop, &filt->thread_data[i]);
-      if (!filt->thread_data[i].thread)
-         return false;
-   }
-#endif
-
    return true;
 }
 
@@ -448,24 +394,10 @@ void rarch_softfilter_free(rarch_softfilter_t *filt)
       if (filt->plugs[i].lib)
          dylib_close(filt->plugs[i].lib);
    }
-   free(filt->plugs);
 #endif
+   free(filt->plugs);
+   config_file_free(filt->conf);
 
-#ifdef HAVE_THREADS
-   for (i = 0; i < filt->threads; i++)
-   {
-      if (!filt->thread_data[i].thread)
-         continue;
-      slock_lock(filt->thread_data[i].lock);
-      filt->thread_data[i].die = true;
-      scond_signal(filt->thread_data[i].cond);
-      slock_unlock(filt->thread_data[i].lock);
-      sthread_join(filt->thread_data[i].thread);
-      slock_free(filt->thread_data[i].lock);
-      scond_free(filt->thread_data[i].cond);
-   }
-   free(filt->thread_data);
-#endif
    free(filt);
 }
 
@@ -495,40 +427,20 @@ void rarch_softfilter_process(rarch_softfilter_t *filt,
       void *output, size_t output_stride,
       const void *input, unsigned width, unsigned height, size_t input_stride)
 {
+#ifndef HAVE_THREADS
    unsigned i;
+#endif
 
    if (filt && filt->impl && filt->impl->get_work_packets)
       filt->impl->get_work_packets(filt->impl_data, filt->packets,
             output, output_stride, input, width, height, input_stride);
    
 #ifdef HAVE_THREADS
-   /* Fire off workers */
-   for (i = 0; i < filt->threads; i++)
-   {
-#if 0
-      RARCH_LOG("Firing off filter thread %u ...\n", i);
-#endif
-      filt->thread_data[i].packet = &filt->packets[i];
-      slock_lock(filt->thread_data[i].lock);
-      filt->thread_data[i].done = false;
-      scond_signal(filt->thread_data[i].cond);
-      slock_unlock(filt->thread_data[i].lock);
-   }
-
-   /* Wait for workers */
-   for (i = 0; i < filt->threads; i++)
-   {
-#if 0
-      RARCH_LOG("Waiting for filter thread %u ...\n", i);
-#endif
-      slock_lock(filt->thread_data[i].lock);
-      while (!filt->thread_data[i].done)
-         scond_wait(filt->thread_data[i].cond, filt->thread_data[i].lock);
-      slock_unlock(filt->thread_data[i].lock);
-   }
+   rpool_parallel_for(rarch_get_thread_pool(), filt->threads,
+         softfilter_work, filt);
 #else
    for (i = 0; i < filt->threads; i++)
-      filt->packets[i].work(filt->impl_data, filt->packets[i].thread_data);
+      softfilter_work(filt, i);
 #endif
 }
 
@@ -34,6 +34,7 @@
 */
  
 #include "softfilter.h"
+#include "softfilter_simd.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -45,6 +46,7 @@
 #endif
 
 #define TWOXBR_SCALE 2
+#define TWOXBR_MIN_BAND 2
 
 struct softfilter_thread_data
 {
@@ -59,11 +61,22 @@ struct softfilter_thread_data
    int last;
 };
 
+/* Vector rows skip over pixels that need no blending,
+ * see TWOXBR_SIMD. */
+typedef unsigned (*twoxbr_row_rgb565_t)(const uint16_t *in,
+      unsigned prevline, unsigned nextline,
+      uint16_t *out, unsigned dst_stride, unsigned count);
+typedef unsigned (*twoxbr_row_xrgb8888_t)(const uint32_t *in,
+      unsigned prevline, unsigned nextline,
+      uint32_t *out, unsigned dst_stride, unsigned count);
+
 struct filter_data
 {
    unsigned threads;
    struct softfilter_thread_data *workers;
    unsigned in_fmt;
+   twoxbr_row_rgb565_t row_rgb565;
+   twoxbr_row_xrgb8888_t row_xrgb8888;
    uint16_t RGBtoYUV[65536];
    uint16_t tbl_5_to_8[32];
    uint16_t tbl_6_to_8[64];
@@ -220,12 +233,80 @@ static void SetupFormat(void * data)
    }
 }
  
+/* A pixel where none of the four FILTRO corners has an edge
+ * (PE matches one of the two neighbours at each corner) comes
+ * out as four copies of PE, which is most of any frame.
+ * Writes those for the run of such pixels at the start of 'in',
+ * stopping at the first pixel that needs the scalar path, and
+ * returns how long the run was. */
+#define TWOXBR_SIMD(isa, bits, typename_t, name, target) \
+static target unsigned name(const typename_t *in, unsigned prevline, \
+      unsigned nextline, typename_t *out, unsigned dst_stride, \
+      unsigned count) \
+{ \
+   unsigned x = 0; \
+   \
+   while (x + SF_OP(isa, LANES, bits) <= count) \
+   { \
+      unsigned flat; \
+      SF_OP(isa, V, bits) edge, lo, hi; \
+      const typename_t *p = in + x; \
+      SF_OP(isa, V, bits) PE = SF_OP(isa, LOAD, bits)(p); \
+      SF_OP(isa, V, bits) eB = SF_OP(isa, EQ, bits)(PE, \
+            SF_OP(isa, LOAD, bits)(p - prevline)); \
+      SF_OP(isa, V, bits) eD = SF_OP(isa, EQ, bits)(PE, \
+            SF_OP(isa, LOAD, bits)(p - 1)); \
+      SF_OP(isa, V, bits) eF = SF_OP(isa, EQ, bits)(PE, \
+            SF_OP(isa, LOAD, bits)(p + 1)); \
+      SF_OP(isa, V, bits) eH = SF_OP(isa, EQ, bits)(PE, \
+            SF_OP(isa, LOAD, bits)(p + nextline)); \
+      \
+      edge = SF_OP(isa, NOT, bits)(SF_OP(isa, AND, bits)( \
+               SF_OP(isa, AND, bits)(SF_OP(isa, OR, bits)(eH, eF), \
+                  SF_OP(isa, OR, bits)(eF, eB)), \
+               SF_OP(isa, AND, bits)(SF_OP(isa, OR, bits)(eB, eD), \
+                  SF_OP(isa, OR, bits)(eD, eH)))); \
+      \
+      flat = SF_OP(isa, LEAD, bits)(edge); \
+      if (!flat) \
+         break; \
+      \
+      /* Lanes past the run are rewritten by whoever does them. */ \
+      SF_OP(isa, ZIP, bits)(PE, PE, lo, hi); \
+      SF_OP(isa, STORE, bits)(out + 2 * x, lo); \
+      SF_OP(isa, STORE, bits)(out + 2 * x + SF_OP(isa, LANES, bits), hi); \
+      SF_OP(isa, STORE, bits)(out + dst_stride + 2 * x, lo); \
+      SF_OP(isa, STORE, bits)(out + dst_stride + 2 * x \
+            + SF_OP(isa, LANES, bits), hi); \
+      \
+      x += flat; \
+      if (flat < SF_OP(isa, LANES, bits)) \
+         break; \
+   } \
+   \
+   return x; \
+}
+
+#ifdef SOFTFILTER_HAVE_SSE2
+TWOXBR_SIMD(SSE2, 16, uint16_t, twoxbr_row_rgb565_sse2, )
+TWOXBR_SIMD(SSE2, 32, uint32_t, twoxbr_row_xrgb8888_sse2, )
+#endif
+#ifdef SOFTFILTER_HAVE_AVX2
+TWOXBR_SIMD(AVX2, 16, uint16_t, twoxbr_row_rgb565_avx2,
+      SOFTFILTER_AVX2_TARGET)
+TWOXBR_SIMD(AVX2, 32, uint32_t, twoxbr_row_xrgb8888_avx2,
+      SOFTFILTER_AVX2_TARGET)
+#endif
+#ifdef SOFTFILTER_HAVE_NEON
+TWOXBR_SIMD(NEON, 16, uint16_t, twoxbr_row_rgb565_neon, )
+TWOXBR_SIMD(NEON, 32, uint32_t, twoxbr_row_xrgb8888_neon, )
+#endif
+
 static void *twoxbr_generic_create(const struct softfilter_config *config,
       unsigned in_fmt, unsigned out_fmt,
       unsigned max_width, unsigned max_height,
       unsigned threads, softfilter_simd_mask_t simd, void *userdata)
 {
-   (void)simd;
    (void)config;
    (void)userdata;
  
@@ -234,7 +315,7 @@ static void *twoxbr_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
@@ -242,6 +323,30 @@ static void *twoxbr_generic_create(const struct softfilter_config *config,
       return NULL;
    }
 
+   switch (softfilter_simd_kernel(simd))
+   {
+#ifdef SOFTFILTER_HAVE_AVX2
+      case SOFTFILTER_KERNEL_AVX2:
+         filt->row_rgb565   = twoxbr_row_rgb565_avx2;
+         filt->row_xrgb8888 = twoxbr_row_xrgb8888_avx2;
+         break;
+#endif
+#ifdef SOFTFILTER_HAVE_SSE2
+      case SOFTFILTER_KERNEL_SSE2:
+         filt->row_rgb565   = twoxbr_row_rgb565_sse2;
+         filt->row_xrgb8888 = twoxbr_row_xrgb8888_sse2;
+         break;
+#endif
+#ifdef SOFTFILTER_HAVE_NEON
+      case SOFTFILTER_KERNEL_NEON:
+         filt->row_rgb565   = twoxbr_row_rgb565_neon;
+         filt->row_xrgb8888 = twoxbr_row_xrgb8888_neon;
+         break;
+#endif
+      default:
+         break;
+   }
+
    SetupFormat(filt);
 
    return filt;
@@ -554,7 +659,7 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
       int first, int last, uint32_t *src,
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
-   unsigned nextline, finish;
+   unsigned finish, y;
    uint32_t pg_red_mask      = RED_MASK8888;
    uint32_t pg_green_mask    = GREEN_MASK8888;
    uint32_t pg_blue_mask     = BLUE_MASK8888;
@@ -562,12 +667,16 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
    uint32_t pg_alpha_mask    = ALPHA_MASK8888;
    struct filter_data *filt = (struct filter_data*)data;
 
-   (void)filt;
-
-   nextline = (last) ? 0 : src_stride;
-   
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows past the image edges are clamped to the edge;
+       * rows past the band edges come from the neighbouring band. */
+      unsigned prevline  = (first && y < 1) ? 0 : src_stride;
+      unsigned prevline2 = (first && y < 2)
+         ? prevline : prevline + src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint32_t *in  = (uint32_t*)src;
       uint32_t *out = (uint32_t*)dst;
  
@@ -575,14 +684,14 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
       {
          uint32_t E[4];
          uint32_t ex, e, i, ke, ki, ex2, ex3, px;
-         uint32_t A1 = *(in - nextline - nextline - 1);
-         uint32_t B1 = *(in - nextline - nextline);
-         uint32_t C1 = *(in - nextline - nextline + 1);
-         uint32_t A0 = *(in - nextline - 2);
-         uint32_t PA = *(in - nextline - 1);
-         uint32_t PB = *(in - nextline);
-         uint32_t PC = *(in - nextline + 1);
-         uint32_t C4 = *(in - nextline + 2);
+         uint32_t A1 = *(in - prevline2 - 1);
+         uint32_t B1 = *(in - prevline2);
+         uint32_t C1 = *(in - prevline2 + 1);
+         uint32_t A0 = *(in - prevline - 2);
+         uint32_t PA = *(in - prevline - 1);
+         uint32_t PB = *(in - prevline);
+         uint32_t PC = *(in - prevline + 1);
+         uint32_t C4 = *(in - prevline + 2);
          uint32_t D0 = *(in - 2);
          uint32_t PD = *(in - 1);
          uint32_t PE = *(in);
@@ -593,9 +702,9 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
          uint32_t PH = *(in + nextline);
          uint32_t _PI = *(in + nextline + 1);
          uint32_t I4 = *(in + nextline + 2);
-         uint32_t G5 = *(in + nextline + nextline - 1);
-         uint32_t H5 = *(in + nextline + nextline);
-         uint32_t I5 = *(in + nextline + nextline + 1);
+         uint32_t G5 = *(in + nextline2 - 1);
+         uint32_t H5 = *(in + nextline2);
+         uint32_t I5 = *(in + nextline2 + 1);
  
          /*
           * Map of the pixels:          A1 B1 C1
@@ -606,6 +715,15 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
           */
  
          twoxbr_function(FILTRO_RGB8888, filt);
+
+         if (filt->row_xrgb8888 && finish > 1)
+         {
+            unsigned flat = filt->row_xrgb8888(in, prevline, nextline,
+                  out, dst_stride, finish - 1);
+            in     += flat;
+            out    += 2 * flat;
+            finish -= flat;
+         }
       }
  
       src += src_stride;
@@ -618,18 +736,24 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
    uint16_t pg_red_mask, pg_green_mask, pg_blue_mask, pg_lbmask;
-   unsigned nextline, finish;
+   unsigned finish, y;
    struct filter_data *filt = (struct filter_data*)data;
 
    pg_red_mask   = RED_MASK565;
    pg_green_mask = GREEN_MASK565;
    pg_blue_mask  = BLUE_MASK565;
    pg_lbmask     = PG_LBMASK565;
-   nextline = (last) ? 0 : src_stride;
-   
- 
-   for (; height; height--)
+
+   for (y = 0; y < height; y++)
    {
+      /* Rows past the image edges are clamped to the edge;
+       * rows past the band edges come from the neighbouring band. */
+      unsigned prevline  = (first && y < 1) ? 0 : src_stride;
+      unsigned prevline2 = (first && y < 2)
+         ? prevline : prevline + src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint16_t *in  = (uint16_t*)src;
       uint16_t *out = (uint16_t*)dst;
  
@@ -637,14 +761,14 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
       {
          uint16_t E[4];
          uint16_t ex, e, i, ke, ki, ex2, ex3, px;
-         uint16_t A1 = *(in - nextline - nextline - 1);
-         uint16_t B1 = *(in - nextline - nextline);
-         uint16_t C1 = *(in - nextline - nextline + 1);
-         uint16_t A0 = *(in - nextline - 2);
-         uint16_t PA = *(in - nextline - 1);
-         uint16_t PB = *(in - nextline);
-         uint16_t PC = *(in - nextline + 1);
-         uint16_t C4 = *(in - nextline + 2);
+         uint16_t A1 = *(in - prevline2 - 1);
+         uint16_t B1 = *(in - prevline2);
+         uint16_t C1 = *(in - prevline2 + 1);
+         uint16_t A0 = *(in - prevline - 2);
+         uint16_t PA = *(in - prevline - 1);
+         uint16_t PB = *(in - prevline);
+         uint16_t PC = *(in - prevline + 1);
+         uint16_t C4 = *(in - prevline + 2);
          uint16_t D0 = *(in - 2);
          uint16_t PD = *(in - 1);
          uint16_t PE = *(in);
@@ -655,9 +779,9 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
          uint16_t PH = *(in + nextline);
          uint16_t _PI = *(in + nextline + 1);
          uint16_t I4 = *(in + nextline + 2);
-         uint16_t G5 = *(in + nextline + nextline - 1);
-         uint16_t H5 = *(in + nextline + nextline);
-         uint16_t I5 = *(in + nextline + nextline + 1);
+         uint16_t G5 = *(in + nextline2 - 1);
+         uint16_t H5 = *(in + nextline2);
+         uint16_t I5 = *(in + nextline2 + 1);
  
          /*
           * Map of the pixels:          A1 B1 C1
@@ -668,6 +792,15 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
           */
  
          twoxbr_function(FILTRO_RGB565, filt);
+
+         if (filt->row_rgb565 && finish > 1)
+         {
+            unsigned flat = filt->row_rgb565(in, prevline, nextline,
+                  out, dst_stride, finish - 1);
+            in     += flat;
+            out    += 2 * flat;
+            finish -= flat;
+         }
       }
  
       src += src_stride;
@@ -713,13 +846,24 @@ static void twoxbr_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   /* Bands are at least TWOXBR_MIN_BAND rows tall, so that
+    * 'first' and 'last' are all a kernel needs to clamp its reads
+    * to the image. Other rows it reads outside its band belong to
+    * the neighbouring bands. Leftover threads get empty bands. */
+   unsigned bands = height / TWOXBR_MIN_BAND;
+
+   if (bands > filt->threads)
+      bands = filt->threads;
+   if (!bands)
+      bands = 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
  
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = i < bands ? (height * i) / bands : height;
+      unsigned y_end   = i < bands ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * 
          TWOXBR_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
@@ -730,7 +874,7 @@ static void twoxbr_generic_packets(void *data,
  
       /* Workers need to know if they can access 
        * pixels outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
  
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
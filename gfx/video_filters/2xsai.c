@@ -15,6 +15,7 @@
  */
 
 #include "softfilter.h"
+#include "softfilter_simd.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -25,6 +26,7 @@
 #endif
 
 #define TWOXSAI_SCALE 2
+#define TWOXSAI_MIN_BAND 2
 
 struct softfilter_thread_data
 {
@@ -39,11 +41,22 @@ struct softfilter_thread_data
    int last;
 };
 
+/* Vector rows return how many pixels they did, from the start of
+ * the row; the scalar loop finishes the rest. */
+typedef unsigned (*twoxsai_row_rgb565_t)(const uint16_t *in,
+      unsigned prevline, unsigned nextline, unsigned nextline2,
+      uint16_t *out, unsigned dst_stride, unsigned count);
+typedef unsigned (*twoxsai_row_xrgb8888_t)(const uint32_t *in,
+      unsigned prevline, unsigned nextline, unsigned nextline2,
+      uint32_t *out, unsigned dst_stride, unsigned count);
+
 struct filter_data
 {
    unsigned threads;
    struct softfilter_thread_data *workers;
    unsigned in_fmt;
+   twoxsai_row_rgb565_t row_rgb565;
+   twoxsai_row_xrgb8888_t row_xrgb8888;
 };
 
 static unsigned twoxsai_generic_input_fmts(void)
@@ -62,12 +75,171 @@ static unsigned twoxsai_generic_threads(void *data)
    return filt->threads;
 }
 
+/* The same decisions as twoxsai_function, made for a whole vector
+ * of pixels at once and resolved with selects. */
+#define TWOXSAI_SIMD(isa, bits, typename_t, name, target, hi2, lo2, hi4, lo4) \
+static target unsigned name(const typename_t *in, unsigned prevline, \
+      unsigned nextline, unsigned nextline2, \
+      typename_t *out, unsigned dst_stride, unsigned count) \
+{ \
+   unsigned x; \
+   const SF_OP(isa, V, bits) h2 = SF_OP(isa, SPLAT, bits)(hi2); \
+   const SF_OP(isa, V, bits) l2 = SF_OP(isa, SPLAT, bits)(lo2); \
+   const SF_OP(isa, V, bits) h4 = SF_OP(isa, SPLAT, bits)(hi4); \
+   const SF_OP(isa, V, bits) l4 = SF_OP(isa, SPLAT, bits)(lo4); \
+   \
+   for (x = 0; x + SF_OP(isa, LANES, bits) <= count; \
+         x += SF_OP(isa, LANES, bits)) \
+   { \
+      SF_OP(isa, V, bits) product, product1, product2, r, lo, hi; \
+      const typename_t *p = in + x; \
+      SF_OP(isa, V, bits) I = SF_OP(isa, LOAD, bits)(p - prevline - 1); \
+      SF_OP(isa, V, bits) E = SF_OP(isa, LOAD, bits)(p - prevline); \
+      SF_OP(isa, V, bits) F = SF_OP(isa, LOAD, bits)(p - prevline + 1); \
+      SF_OP(isa, V, bits) J = SF_OP(isa, LOAD, bits)(p - prevline + 2); \
+      SF_OP(isa, V, bits) G = SF_OP(isa, LOAD, bits)(p - 1); \
+      SF_OP(isa, V, bits) A = SF_OP(isa, LOAD, bits)(p); \
+      SF_OP(isa, V, bits) B = SF_OP(isa, LOAD, bits)(p + 1); \
+      SF_OP(isa, V, bits) K = SF_OP(isa, LOAD, bits)(p + 2); \
+      SF_OP(isa, V, bits) H = SF_OP(isa, LOAD, bits)(p + nextline - 1); \
+      SF_OP(isa, V, bits) C = SF_OP(isa, LOAD, bits)(p + nextline); \
+      SF_OP(isa, V, bits) D = SF_OP(isa, LOAD, bits)(p + nextline + 1); \
+      SF_OP(isa, V, bits) L = SF_OP(isa, LOAD, bits)(p + nextline + 2); \
+      SF_OP(isa, V, bits) M = SF_OP(isa, LOAD, bits)(p + nextline2 - 1); \
+      SF_OP(isa, V, bits) N = SF_OP(isa, LOAD, bits)(p + nextline2); \
+      SF_OP(isa, V, bits) O = SF_OP(isa, LOAD, bits)(p + nextline2 + 1); \
+      \
+      SF_OP(isa, V, bits) eqAB = SF_OP(isa, EQ, bits)(A, B); \
+      SF_OP(isa, V, bits) eqAD = SF_OP(isa, EQ, bits)(A, D); \
+      SF_OP(isa, V, bits) eqBC = SF_OP(isa, EQ, bits)(B, C); \
+      SF_OP(isa, V, bits) eqAF = SF_OP(isa, EQ, bits)(A, F); \
+      SF_OP(isa, V, bits) eqAH = SF_OP(isa, EQ, bits)(A, H); \
+      SF_OP(isa, V, bits) eqAI = SF_OP(isa, EQ, bits)(A, I); \
+      SF_OP(isa, V, bits) eqBE = SF_OP(isa, EQ, bits)(B, E); \
+      SF_OP(isa, V, bits) eqCG = SF_OP(isa, EQ, bits)(C, G); \
+      SF_OP(isa, V, bits) eqCD = SF_OP(isa, EQ, bits)(C, D); \
+      /* A == C && A == F && B != E && B == J */ \
+      SF_OP(isa, V, bits) pat_a = SF_OP(isa, AND, bits)( \
+            SF_OP(isa, AND, bits)(SF_OP(isa, EQ, bits)(A, C), eqAF), \
+            SF_OP(isa, ANDNOT, bits)(SF_OP(isa, EQ, bits)(B, J), eqBE)); \
+      /* B == E && B == D && A != F && A == I */ \
+      SF_OP(isa, V, bits) pat_b = SF_OP(isa, AND, bits)( \
+            SF_OP(isa, AND, bits)(eqBE, SF_OP(isa, EQ, bits)(B, D)), \
+            SF_OP(isa, ANDNOT, bits)(eqAI, eqAF)); \
+      /* A == B && A == H && G != C && C == M */ \
+      SF_OP(isa, V, bits) pat_a1 = SF_OP(isa, AND, bits)( \
+            SF_OP(isa, AND, bits)(eqAB, eqAH), \
+            SF_OP(isa, ANDNOT, bits)(SF_OP(isa, EQ, bits)(C, M), eqCG)); \
+      /* C == G && C == D && A != H && A == I */ \
+      SF_OP(isa, V, bits) pat_c1 = SF_OP(isa, AND, bits)( \
+            SF_OP(isa, AND, bits)(eqCG, eqCD), \
+            SF_OP(isa, ANDNOT, bits)(eqAI, eqAH)); \
+      SF_OP(isa, V, bits) iAB = SF_BLEND2(isa, bits, A, B, h2, l2); \
+      SF_OP(isa, V, bits) iAC = SF_BLEND2(isa, bits, A, C, h2, l2); \
+      SF_OP(isa, V, bits) iABCD = SF_BLEND4(isa, bits, A, B, C, D, h4, l4); \
+      \
+      /* No diagonal match. */ \
+      product  = SF_OP(isa, SEL, bits)(pat_a, A, \
+            SF_OP(isa, SEL, bits)(pat_b, B, iAB)); \
+      product1 = SF_OP(isa, SEL, bits)(pat_a1, A, \
+            SF_OP(isa, SEL, bits)(pat_c1, C, iAC)); \
+      product2 = iABCD; \
+      \
+      /* Both diagonals match, twoxsai_result() votes per lane. \
+       * Its 0/1 terms are -1/0 masks here, hence the reversed order. */ \
+      r = SF_OP(isa, ADD, bits)(SF_OP(isa, ADD, bits)( \
+               TWOXSAI_SIMD_VOTE(isa, bits, A, B, G, E), \
+               TWOXSAI_SIMD_VOTE(isa, bits, B, A, K, F)), \
+            SF_OP(isa, ADD, bits)( \
+               TWOXSAI_SIMD_VOTE(isa, bits, B, A, H, N), \
+               TWOXSAI_SIMD_VOTE(isa, bits, A, B, L, O))); \
+      { \
+         SF_OP(isa, V, bits) both = SF_OP(isa, AND, bits)(eqAD, eqBC); \
+         product  = SF_OP(isa, SEL, bits)(both, \
+               SF_OP(isa, SEL, bits)(eqAB, A, iAB), product); \
+         product1 = SF_OP(isa, SEL, bits)(both, \
+               SF_OP(isa, SEL, bits)(eqAB, A, iAC), product1); \
+         product2 = SF_OP(isa, SEL, bits)(both, \
+               SF_OP(isa, SEL, bits)(SF_OP(isa, OR, bits)(eqAB, \
+                     SF_OP(isa, GTZ, bits)(r)), A, \
+                  SF_OP(isa, SEL, bits)(SF_OP(isa, LTZ, bits)(r), \
+                     B, iABCD)), product2); \
+      } \
+      \
+      /* B == C && A != D */ \
+      { \
+         SF_OP(isa, V, bits) bc = SF_OP(isa, ANDNOT, bits)(eqBC, eqAD); \
+         product  = SF_OP(isa, SEL, bits)(bc, SF_OP(isa, SEL, bits)( \
+                  SF_OP(isa, OR, bits)(SF_OP(isa, AND, bits)( \
+                        SF_OP(isa, EQ, bits)(B, F), eqAH), pat_b), \
+                  B, iAB), product); \
+         product1 = SF_OP(isa, SEL, bits)(bc, SF_OP(isa, SEL, bits)( \
+                  SF_OP(isa, OR, bits)(SF_OP(isa, AND, bits)( \
+                        SF_OP(isa, EQ, bits)(C, H), eqAF), pat_c1), \
+                  C, iAC), product1); \
+         product2 = SF_OP(isa, SEL, bits)(bc, B, product2); \
+      } \
+      \
+      /* A == D && B != C */ \
+      { \
+         SF_OP(isa, V, bits) ad = SF_OP(isa, ANDNOT, bits)(eqAD, eqBC); \
+         product  = SF_OP(isa, SEL, bits)(ad, SF_OP(isa, SEL, bits)( \
+                  SF_OP(isa, OR, bits)(SF_OP(isa, AND, bits)( \
+                        SF_OP(isa, EQ, bits)(A, E), \
+                        SF_OP(isa, EQ, bits)(B, L)), pat_a), \
+                  A, iAB), product); \
+         product1 = SF_OP(isa, SEL, bits)(ad, SF_OP(isa, SEL, bits)( \
+                  SF_OP(isa, OR, bits)(SF_OP(isa, AND, bits)( \
+                        SF_OP(isa, EQ, bits)(A, G), \
+                        SF_OP(isa, EQ, bits)(C, O)), pat_a1), \
+                  A, iAC), product1); \
+         product2 = SF_OP(isa, SEL, bits)(ad, A, product2); \
+      } \
+      \
+      SF_OP(isa, ZIP, bits)(A, product, lo, hi); \
+      SF_OP(isa, STORE, bits)(out + 2 * x, lo); \
+      SF_OP(isa, STORE, bits)(out + 2 * x + SF_OP(isa, LANES, bits), hi); \
+      SF_OP(isa, ZIP, bits)(product1, product2, lo, hi); \
+      SF_OP(isa, STORE, bits)(out + dst_stride + 2 * x, lo); \
+      SF_OP(isa, STORE, bits)(out + dst_stride + 2 * x \
+            + SF_OP(isa, LANES, bits), hi); \
+   } \
+   \
+   return x; \
+}
+
+/* twoxsai_result(P, Q, Y, Z) as a lane value. */
+#define TWOXSAI_SIMD_VOTE(isa, bits, P, Q, Y, Z) \
+   SF_OP(isa, SUB, bits)( \
+         SF_OP(isa, AND, bits)(SF_OP(isa, EQ, bits)(P, Y), \
+            SF_OP(isa, EQ, bits)(P, Z)), \
+         SF_OP(isa, AND, bits)(SF_OP(isa, EQ, bits)(Q, Y), \
+            SF_OP(isa, EQ, bits)(Q, Z)))
+
+#ifdef SOFTFILTER_HAVE_SSE2
+TWOXSAI_SIMD(SSE2, 16, uint16_t, twoxsai_row_rgb565_sse2, ,
+      0xF7DE, 0x0821, 0xE79C, 0x1863)
+TWOXSAI_SIMD(SSE2, 32, uint32_t, twoxsai_row_xrgb8888_sse2, ,
+      0xFEFEFEFE, 0x01010101, 0xFCFCFCFC, 0x03030303)
+#endif
+#ifdef SOFTFILTER_HAVE_AVX2
+TWOXSAI_SIMD(AVX2, 16, uint16_t, twoxsai_row_rgb565_avx2,
+      SOFTFILTER_AVX2_TARGET, 0xF7DE, 0x0821, 0xE79C, 0x1863)
+TWOXSAI_SIMD(AVX2, 32, uint32_t, twoxsai_row_xrgb8888_avx2,
+      SOFTFILTER_AVX2_TARGET, 0xFEFEFEFE, 0x01010101, 0xFCFCFCFC, 0x03030303)
+#endif
+#ifdef SOFTFILTER_HAVE_NEON
+TWOXSAI_SIMD(NEON, 16, uint16_t, twoxsai_row_rgb565_neon, ,
+      0xF7DE, 0x0821, 0xE79C, 0x1863)
+TWOXSAI_SIMD(NEON, 32, uint32_t, twoxsai_row_xrgb8888_neon, ,
+      0xFEFEFEFE, 0x01010101, 0xFCFCFCFC, 0x03030303)
+#endif
+
 static void *twoxsai_generic_create(const struct softfilter_config *config,
       unsigned in_fmt, unsigned out_fmt,
       unsigned max_width, unsigned max_height,
       unsigned threads, softfilter_simd_mask_t simd, void *userdata)
 {
-   (void)simd;
    (void)config;
    (void)userdata;
 
@@ -76,13 +248,37 @@ static void *twoxsai_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
       free(filt);
       return NULL;
    }
+
+   switch (softfilter_simd_kernel(simd))
+   {
+#ifdef SOFTFILTER_HAVE_AVX2
+      case SOFTFILTER_KERNEL_AVX2:
+         filt->row_rgb565   = twoxsai_row_rgb565_avx2;
+         filt->row_xrgb8888 = twoxsai_row_xrgb8888_avx2;
+         break;
+#endif
+#ifdef SOFTFILTER_HAVE_SSE2
+      case SOFTFILTER_KERNEL_SSE2:
+         filt->row_rgb565   = twoxsai_row_rgb565_sse2;
+         filt->row_xrgb8888 = twoxsai_row_xrgb8888_sse2;
+         break;
+#endif
+#ifdef SOFTFILTER_HAVE_NEON
+      case SOFTFILTER_KERNEL_NEON:
+         filt->row_rgb565   = twoxsai_row_rgb565_neon;
+         filt->row_xrgb8888 = twoxsai_row_xrgb8888_neon;
+         break;
+#endif
+      default:
+         break;
+   }
    return filt;
 }
 
@@ -118,12 +314,12 @@ static void twoxsai_generic_destroy(void *data)
 
 #define twoxsai_result(A, B, C, D) (((A) != (C) || (A) != (D)) - ((B) != (C) || (B) != (D)));
 
-#define twoxsai_declare_variables(typename_t, in, nextline) \
+#define twoxsai_declare_variables(typename_t, in, prevline, nextline, nextline2) \
          typename_t product, product1, product2; \
-         typename_t colorI = *(in - nextline - 1); \
-         typename_t colorE = *(in - nextline + 0); \
-         typename_t colorF = *(in - nextline + 1); \
-         typename_t colorJ = *(in - nextline + 2); \
+         typename_t colorI = *(in - prevline - 1); \
+         typename_t colorE = *(in - prevline + 0); \
+         typename_t colorF = *(in - prevline + 1); \
+         typename_t colorJ = *(in - prevline + 2); \
          typename_t colorG = *(in - 1); \
          typename_t colorA = *(in + 0); \
          typename_t colorB = *(in + 1); \
@@ -132,9 +328,9 @@ static void twoxsai_generic_destroy(void *data)
          typename_t colorC = *(in + nextline + 0); \
          typename_t colorD = *(in + nextline + 1); \
          typename_t colorL = *(in + nextline + 2); \
-         typename_t colorM = *(in + nextline + nextline - 1); \
-         typename_t colorN = *(in + nextline + nextline + 0); \
-         typename_t colorO = *(in + nextline + nextline + 1);
+         typename_t colorM = *(in + nextline2 - 1); \
+         typename_t colorN = *(in + nextline2 + 0); \
+         typename_t colorO = *(in + nextline2 + 1);
 
 #ifndef twoxsai_function
 #define twoxsai_function(result_cb, interpolate_cb, interpolate2_cb) \
@@ -226,19 +422,33 @@ static void twoxsai_generic_destroy(void *data)
 
 static void twoxsai_generic_xrgb8888(unsigned width, unsigned height,
       int first, int last, uint32_t *src, 
-      unsigned src_stride, uint32_t *dst, unsigned dst_stride)
+      unsigned src_stride, uint32_t *dst, unsigned dst_stride,
+      twoxsai_row_xrgb8888_t row)
 {
-   unsigned nextline, finish;
-   nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows past the image edges are clamped to the edge;
+       * rows past the band edges come from the neighbouring band. */
+      unsigned prevline  = (first && y < 1) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint32_t *in  = (uint32_t*)src;
       uint32_t *out = (uint32_t*)dst;
+      unsigned done = 0;
+
+      if (row)
+      {
+         done = row(in, prevline, nextline, nextline2, out, dst_stride, width);
+         in  += done;
+         out += 2 * done;
+      }
 
-      for (finish = width; finish; finish -= 1)
+      for (finish = width - done; finish; finish -= 1)
       {
-         twoxsai_declare_variables(uint32_t, in, nextline);
+         twoxsai_declare_variables(uint32_t, in, prevline, nextline, nextline2);
 
          /*
           * Map of the pixels:           I|E F|J
@@ -258,19 +468,33 @@ static void twoxsai_generic_xrgb8888(unsigned width, unsigned height,
 
 static void twoxsai_generic_rgb565(unsigned width, unsigned height,
       int first, int last, uint16_t *src, 
-      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride,
+      twoxsai_row_rgb565_t row)
 {
-   unsigned nextline, finish;
-   nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows past the image edges are clamped to the edge;
+       * rows past the band edges come from the neighbouring band. */
+      unsigned prevline  = (first && y < 1) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint16_t *in  = (uint16_t*)src;
       uint16_t *out = (uint16_t*)dst;
+      unsigned done = 0;
+
+      if (row)
+      {
+         done = row(in, prevline, nextline, nextline2, out, dst_stride, width);
+         in  += done;
+         out += 2 * done;
+      }
 
-      for (finish = width; finish; finish -= 1)
+      for (finish = width - done; finish; finish -= 1)
       {
-         twoxsai_declare_variables(uint16_t, in, nextline);
+         twoxsai_declare_variables(uint16_t, in, prevline, nextline, nextline2);
 
          /*
           * Map of the pixels:           I|E F|J
@@ -290,6 +514,7 @@ static void twoxsai_generic_rgb565(unsigned width, unsigned height,
 
 static void twoxsai_work_cb_rgb565(void *data, void *thread_data)
 {
+   struct filter_data *filt = (struct filter_data*)data;
    struct softfilter_thread_data *thr = 
       (struct softfilter_thread_data*)thread_data;
    uint16_t *input = (uint16_t*)thr->in_data;
@@ -301,11 +526,13 @@ static void twoxsai_work_cb_rgb565(void *data, void *thread_data)
          thr->first, thr->last, input,
          thr->in_pitch / SOFTFILTER_BPP_RGB565,
          output,
-         thr->out_pitch / SOFTFILTER_BPP_RGB565);
+         thr->out_pitch / SOFTFILTER_BPP_RGB565,
+         filt->row_rgb565);
 }
 
 static void twoxsai_work_cb_xrgb8888(void *data, void *thread_data)
 {
+   struct filter_data *filt = (struct filter_data*)data;
    struct softfilter_thread_data *thr = 
       (struct softfilter_thread_data*)thread_data;
    uint32_t *input = (uint32_t*)thr->in_data;
@@ -317,7 +544,8 @@ static void twoxsai_work_cb_xrgb8888(void *data, void *thread_data)
          thr->first, thr->last, input,
          thr->in_pitch / SOFTFILTER_BPP_XRGB8888,
          output,
-         thr->out_pitch / SOFTFILTER_BPP_XRGB8888);
+         thr->out_pitch / SOFTFILTER_BPP_XRGB8888,
+         filt->row_xrgb8888);
 }
 
 static void twoxsai_generic_packets(void *data,
@@ -328,13 +556,24 @@ static void twoxsai_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   /* Bands are at least TWOXSAI_MIN_BAND rows tall, so that
+    * 'first' and 'last' are all a kernel needs to clamp its reads
+    * to the image. Other rows it reads outside its band belong to
+    * the neighbouring bands. Leftover threads get empty bands. */
+   unsigned bands = height / TWOXSAI_MIN_BAND;
+
+   if (bands > filt->threads)
+      bands = filt->threads;
+   if (!bands)
+      bands = 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = i < bands ? (height * i) / bands : height;
+      unsigned y_end   = i < bands ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * 
          TWOXSAI_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
@@ -346,7 +585,7 @@ static void twoxsai_generic_packets(void *data,
       /* Workers need to know if they can access pixels 
        * outside their given buffer.
        */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
@@ -22,6 +22,8 @@
 #include "snes_ntsc/snes_ntsc.h"
 #include "snes_ntsc/snes_ntsc.c"
 
+#define BLARGG_NTSC_SNES_MIN_BAND 1
+
 #ifdef RARCH_INTERNAL
 #define softfilter_get_implementation blargg_ntsc_snes_get_implementation
 #define softfilter_thread_data blargg_ntsc_snes_softfilter_thread_data
@@ -39,6 +41,7 @@ struct softfilter_thread_data
    unsigned height;
    int first;
    int last;
+   int burst;
 };
 
 struct filter_data
@@ -128,7 +131,7 @@ static void *blargg_ntsc_snes_generic_create(const struct softfilter_config *con
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
@@ -165,26 +168,24 @@ static void blargg_ntsc_snes_generic_destroy(void *data)
 }
 
 static void blargg_ntsc_snes_render_rgb565(void *data, int width, int height,
-      int first, int last,
+      int first, int last, int burst,
       uint16_t *input, int pitch, uint16_t *output, int outpitch)
 {
    struct filter_data *filt = (struct filter_data*)data;
    if(width <= 256)
-      snes_ntsc_blit(filt->ntsc, input, pitch, filt->burst,
+      snes_ntsc_blit(filt->ntsc, input, pitch, burst,
             width, height, output, outpitch * 2, first, last);
    else
-      snes_ntsc_blit_hires(filt->ntsc, input, pitch, filt->burst,
+      snes_ntsc_blit_hires(filt->ntsc, input, pitch, burst,
             width, height, output, outpitch * 2, first, last);
-
-   filt->burst ^= filt->burst_toggle;
 }
 
 static void blargg_ntsc_snes_rgb565(void *data, unsigned width, unsigned height,
-      int first, int last, uint16_t *src, 
+      int first, int last, int burst, uint16_t *src, 
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
    blargg_ntsc_snes_render_rgb565(data, width, height,
-         first, last,
+         first, last, burst,
          src, src_stride,
          dst, dst_stride);
 
@@ -200,7 +201,7 @@ static void blargg_ntsc_snes_work_cb_rgb565(void *data, void *thread_data)
    unsigned height = thr->height;
 
    blargg_ntsc_snes_rgb565(data, width, height,
-         thr->first, thr->last, input,
+         thr->first, thr->last, thr->burst, input,
          thr->in_pitch / SOFTFILTER_BPP_RGB565,
          output,
          thr->out_pitch / SOFTFILTER_BPP_RGB565);
@@ -213,13 +214,22 @@ static void blargg_ntsc_snes_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   /* Rows are filtered independently, so bands can be as short as
+    * a single row. Leftover threads get empty bands. */
+   unsigned bands = height / BLARGG_NTSC_SNES_MIN_BAND;
+
+   if (bands > filt->threads)
+      bands = filt->threads;
+   if (!bands)
+      bands = 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = i < bands ? (height * i) / bands : height;
+      unsigned y_end   = i < bands ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
       thr->out_pitch = output_stride;
@@ -229,13 +239,18 @@ static void blargg_ntsc_snes_generic_packets(void *data,
 
       /* Workers need to know if they can 
        * access pixels outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
+      /* The burst phase advances by one every row. */
+      thr->burst = (filt->burst + y_start) % snes_ntsc_burst_count;
+
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
          packets[i].work = blargg_ntsc_snes_work_cb_rgb565;
       packets[i].thread_data = thr;
    }
+
+   filt->burst ^= filt->burst_toggle;
 }
 
 static const struct softfilter_implementation blargg_ntsc_snes_generic = {
@@ -15,6 +15,7 @@
  */
 
 #include "softfilter.h"
+#include "softfilter_simd.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -25,6 +26,7 @@
 #endif
 
 #define EPX_SCALE 2
+#define EPX_MIN_BAND 1
 
 struct softfilter_thread_data
 {
@@ -39,13 +41,31 @@ struct softfilter_thread_data
    int last;
 };
 
+/* Vector row over the inner pixels of a row with both vertical
+ * neighbours, see SOFTFILTER_SCALE2X_ROW. */
+typedef unsigned (*epx_row_t)(const uint16_t *src,
+      int prevline, int nextline,
+      uint16_t *out0, uint16_t *out1, unsigned count);
+
 struct filter_data
 {
    unsigned threads;
    struct softfilter_thread_data *workers;
    unsigned in_fmt;
+   epx_row_t row;
 };
 
+#ifdef SOFTFILTER_HAVE_SSE2
+SOFTFILTER_SCALE2X_ROW(SSE2, 16, uint16_t, epx_row_sse2, )
+#endif
+#ifdef SOFTFILTER_HAVE_AVX2
+SOFTFILTER_SCALE2X_ROW(AVX2, 16, uint16_t, epx_row_avx2,
+      SOFTFILTER_AVX2_TARGET)
+#endif
+#ifdef SOFTFILTER_HAVE_NEON
+SOFTFILTER_SCALE2X_ROW(NEON, 16, uint16_t, epx_row_neon, )
+#endif
+
 static unsigned epx_generic_input_fmts(void)
 {
    return SOFTFILTER_FMT_RGB565;
@@ -67,7 +87,6 @@ static void *epx_generic_create(const struct softfilter_config *config,
       unsigned max_width, unsigned max_height,
       unsigned threads, softfilter_simd_mask_t simd, void *userdata)
 {
-   (void)simd;
    (void)config;
    (void)userdata;
 
@@ -76,13 +95,35 @@ static void *epx_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
       free(filt);
       return NULL;
    }
+
+   switch (softfilter_simd_kernel(simd))
+   {
+#ifdef SOFTFILTER_HAVE_AVX2
+      case SOFTFILTER_KERNEL_AVX2:
+         filt->row = epx_row_avx2;
+         break;
+#endif
+#ifdef SOFTFILTER_HAVE_SSE2
+      case SOFTFILTER_KERNEL_SSE2:
+         filt->row = epx_row_sse2;
+         break;
+#endif
+#ifdef SOFTFILTER_HAVE_NEON
+      case SOFTFILTER_KERNEL_NEON:
+         filt->row = epx_row_neon;
+         break;
+#endif
+      default:
+         break;
+   }
+
    return filt;
 }
 
@@ -108,19 +149,21 @@ static void epx_generic_destroy(void *data)
 static void EPX_16(int width, int height,
       int first, int last,
       uint16_t *src, unsigned src_stride, uint16_t *dst,
-      unsigned dst_stride)
+      unsigned dst_stride, epx_row_t row)
 {
 	uint16_t	colorX, colorA, colorB, colorC, colorD;
 	uint16_t	*sP = NULL, *uP = NULL, *lP = NULL;
 	uint32_t	*dP1 = NULL, *dP2 = NULL;
-	int		w, prevline;
+	int		w, top, bottom;
 
-   if (!src || !dst)
+   if (!src || !dst || height <= 0)
       return;
 
-   prevline = (first) ? 0 : src_stride;
-
-	height -= 2;
+	/* Only rows at the image edges lack a neighbour; rows at the
+	 * other band edges read theirs from the neighbouring band. */
+	top     = first;
+	bottom  = last && height > top;
+	height -= top + bottom;
 
 	/*   D
 	 * A X C
@@ -129,52 +172,27 @@ static void EPX_16(int width, int height,
 
 	/* top edge */
 
-	sP  = (uint16_t *)(src - prevline);
-	lP  = (uint16_t *)(src + src_stride);
-	dP1 = (uint32_t *)(dst);
-	dP2 = (uint32_t *)(dst + dst_stride);
-
-	// left edge
-
-	colorX = *sP;
-	colorC = *++sP;
-	colorB = *lP++;
-
-	if ((colorX != colorC) && (colorB != colorX))
+	if (top)
 	{
-	#ifdef MSB_FIRST
-		*dP1 = (colorX << 16) + colorX;
-		*dP2 = (colorX << 16) + ((colorB == colorC) ? colorB : colorX);
-	#else
-		*dP1 = colorX + (colorX << 16);
-		*dP2 = colorX + (((colorB == colorC) ? colorB : colorX) << 16);
-	#endif
-	}
-	else
-		*dP1 = *dP2 = (colorX << 16) + colorX;
-
-	dP1++;
-	dP2++;
+		sP  = (uint16_t *)(src);
+		lP  = (uint16_t *)(src + src_stride);
+		dP1 = (uint32_t *)(dst);
+		dP2 = (uint32_t *)(dst + dst_stride);
 
-	//
+		// left edge
 
-	for (w = width - 2; w; w--)
-	{
-		colorA = colorX;
-		colorX = colorC;
+		colorX = *sP;
 		colorC = *++sP;
 		colorB = *lP++;
 
-		if ((colorA != colorC) && (colorB != colorX))
+		if ((colorX != colorC) && (colorB != colorX))
 		{
 		#ifdef MSB_FIRST
 			*dP1 = (colorX << 16) + colorX;
-			*dP2 = (((colorA == colorB) ? colorA : colorX) << 16) + 
-            ((colorB == colorC) ? colorB : colorX);
+			*dP2 = (colorX << 16) + ((colorB == colorC) ? colorB : colorX);
 		#else
 			*dP1 = colorX + (colorX << 16);
-			*dP2 = ((colorA == colorB) ? colorA : colorX) + 
-            (((colorB == colorC) ? colorB : colorX) << 16);
+			*dP2 = colorX + (((colorB == colorC) ? colorB : colorX) << 16);
 		#endif
 		}
 		else
@@ -182,29 +200,57 @@ static void EPX_16(int width, int height,
 
 		dP1++;
 		dP2++;
-	}
 
-	/* right edge */
+		//
 
-	colorA = colorX;
-	colorX = colorC;
-	colorB = *lP;
+		for (w = width - 2; w; w--)
+		{
+			colorA = colorX;
+			colorX = colorC;
+			colorC = *++sP;
+			colorB = *lP++;
 
-	if ((colorA != colorX) && (colorB != colorX))
-	{
-	#ifdef MSB_FIRST
-		*dP1 = (colorX << 16) + colorX;
-		*dP2 = (((colorA == colorB) ? colorA : colorX) << 16) + colorX;
-	#else
-		*dP1 = colorX + (colorX << 16);
-		*dP2 = ((colorA == colorB) ? colorA : colorX) + (colorX << 16);
-	#endif
-	}
-	else
-		*dP1 = *dP2 = (colorX << 16) + colorX;
+			if ((colorA != colorC) && (colorB != colorX))
+			{
+			#ifdef MSB_FIRST
+				*dP1 = (colorX << 16) + colorX;
+				*dP2 = (((colorA == colorB) ? colorA : colorX) << 16) + 
+	            ((colorB == colorC) ? colorB : colorX);
+			#else
+				*dP1 = colorX + (colorX << 16);
+				*dP2 = ((colorA == colorB) ? colorA : colorX) + 
+	            (((colorB == colorC) ? colorB : colorX) << 16);
+			#endif
+			}
+			else
+				*dP1 = *dP2 = (colorX << 16) + colorX;
+
+			dP1++;
+			dP2++;
+		}
+
+		/* right edge */
 
-	src += src_stride;
-	dst += dst_stride << 1;
+		colorA = colorX;
+		colorX = colorC;
+		colorB = *lP;
+
+		if ((colorA != colorX) && (colorB != colorX))
+		{
+		#ifdef MSB_FIRST
+			*dP1 = (colorX << 16) + colorX;
+			*dP2 = (((colorA == colorB) ? colorA : colorX) << 16) + colorX;
+		#else
+			*dP1 = colorX + (colorX << 16);
+			*dP2 = ((colorA == colorB) ? colorA : colorX) + (colorX << 16);
+		#endif
+		}
+		else
+			*dP1 = *dP2 = (colorX << 16) + colorX;
+
+		src += src_stride;
+		dst += dst_stride << 1;
+	}
 
 	for (; height; height--)
 	{
@@ -237,7 +283,24 @@ static void EPX_16(int width, int height,
 		dP1++;
 		dP2++;
 
-		for (w = width - 2; w; w--)
+		w = width - 2;
+
+		if (row)
+		{
+			unsigned n = row(sP, src_stride, src_stride,
+					(uint16_t*)dP1, (uint16_t*)dP2, w);
+
+			sP     += n;
+			lP     += n;
+			uP     += n;
+			dP1    += n;
+			dP2    += n;
+			w      -= n;
+			colorX  = sP[-1];
+			colorC  = *sP;
+		}
+
+		for (; w; w--)
 		{
 			colorA = colorX;
 			colorX = colorC;
@@ -292,6 +355,9 @@ static void EPX_16(int width, int height,
 
 	/* bottom edge */
 
+	if (!bottom)
+		return;
+
 	sP  = (uint16_t *) src;
 	uP  = (uint16_t *) (src - src_stride);
 	dP1 = (uint32_t *) dst;
@@ -367,17 +433,19 @@ static void EPX_16(int width, int height,
 
 static void epx_generic_rgb565(unsigned width, unsigned height,
       int first, int last, uint16_t *src, 
-      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride,
+      epx_row_t row)
 {
    EPX_16(width, height,
          first, last,
          src, src_stride,
-         dst, dst_stride);
+         dst, dst_stride, row);
 
 }
 
 static void epx_work_cb_rgb565(void *data, void *thread_data)
 {
+   struct filter_data *filt = (struct filter_data*)data;
    struct softfilter_thread_data *thr = 
       (struct softfilter_thread_data*)thread_data;
    uint16_t *input = (uint16_t*)thr->in_data;
@@ -389,7 +457,7 @@ static void epx_work_cb_rgb565(void *data, void *thread_data)
          thr->first, thr->last, input,
          thr->in_pitch / SOFTFILTER_BPP_RGB565,
          output,
-         thr->out_pitch / SOFTFILTER_BPP_RGB565);
+         thr->out_pitch / SOFTFILTER_BPP_RGB565, filt->row);
 }
 
 
@@ -400,13 +468,24 @@ static void epx_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   /* Bands are at least EPX_MIN_BAND rows tall, so that
+    * 'first' and 'last' are all a kernel needs to clamp its reads
+    * to the image. Other rows it reads outside its band belong to
+    * the neighbouring bands. Leftover threads get empty bands. */
+   unsigned bands = height / EPX_MIN_BAND;
+
+   if (bands > filt->threads)
+      bands = filt->threads;
+   if (!bands)
+      bands = 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = i < bands ? (height * i) / bands : height;
+      unsigned y_end   = i < bands ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * EPX_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
       thr->out_pitch = output_stride;
@@ -416,7 +495,7 @@ static void epx_generic_packets(void *data,
 
       /* Workers need to know if they can 
        * access pixels outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
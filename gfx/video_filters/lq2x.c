@@ -24,6 +24,7 @@
 #endif
 
 #define LQ2X_SCALE 2
+#define LQ2X_MIN_BAND 1
 
 struct softfilter_thread_data
 {
@@ -75,7 +76,7 @@ static void *lq2x_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
@@ -116,8 +117,8 @@ static void lq2x_generic_rgb565(unsigned width, unsigned height,
    for(y = 0; y < height; y++)
    {
       int prevline, nextline;
-      prevline = (y == 0 ? 0 : src_stride);
-      nextline = (y == height - 1 || last) ? 0 : src_stride;
+      prevline = (y == 0 && first) ? 0 : src_stride;
+      nextline = (y == height - 1 && last) ? 0 : src_stride;
 
       for(x = 0; x < width; x++)
       {
@@ -162,8 +163,8 @@ static void lq2x_generic_xrgb8888(unsigned width, unsigned height,
 
    for(y = 0; y < height; y++)
    {
-      int prevline = (y == 0 ? 0 : src_stride);
-      int nextline = (y == height - 1 || last) ? 0 : src_stride;
+      int prevline = (y == 0 && first) ? 0 : src_stride;
+      int nextline = (y == height - 1 && last) ? 0 : src_stride;
 
       for(x = 0; x < width; x++)
       {
@@ -238,13 +239,24 @@ static void lq2x_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   /* Bands are at least LQ2X_MIN_BAND rows tall, so that
+    * 'first' and 'last' are all a kernel needs to clamp its reads
+    * to the image. Other rows it reads outside its band belong to
+    * the neighbouring bands. Leftover threads get empty bands. */
+   unsigned bands = height / LQ2X_MIN_BAND;
+
+   if (bands > filt->threads)
+      bands = filt->threads;
+   if (!bands)
+      bands = 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = i < bands ? (height * i) / bands : height;
+      unsigned y_end   = i < bands ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * LQ2X_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
       thr->out_pitch = output_stride;
@@ -254,7 +266,7 @@ static void lq2x_generic_packets(void *data,
 
       /* Workers need to know if they can access pixels 
        * outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
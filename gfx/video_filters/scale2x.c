@@ -17,6 +17,7 @@
 // Compile: gcc -o scale2x.so -shared scale2x.c -std=c99 -O3 -Wall -pedantic -fPIC
 
 #include "softfilter.h"
+#include "softfilter_simd.h"
 #include <stdlib.h>
 
 #ifdef RARCH_INTERNAL
@@ -26,6 +27,7 @@
 #endif
 
 #define SCALE2X_SCALE 2
+#define SCALE2X_MIN_BAND 1
 
 struct softfilter_thread_data
 {
@@ -40,72 +42,104 @@ struct softfilter_thread_data
    int last;
 };
 
+/* Vector rows cover pixels whose left and right neighbours
+ * are both inside the row, and return how many they did. */
+typedef unsigned (*scale2x_row_rgb565_t)(const uint16_t *src,
+      int prevline, int nextline,
+      uint16_t *out0, uint16_t *out1, unsigned count);
+typedef unsigned (*scale2x_row_xrgb8888_t)(const uint32_t *src,
+      int prevline, int nextline,
+      uint32_t *out0, uint32_t *out1, unsigned count);
+
 struct filter_data
 {
    unsigned threads;
    struct softfilter_thread_data *workers;
    unsigned in_fmt;
+   scale2x_row_rgb565_t row_rgb565;
+   scale2x_row_xrgb8888_t row_xrgb8888;
 };
 
-#define SCALE2X_GENERIC(typename_t, width, height, first, last, src, src_stride, dst, dst_stride, out0, out1) \
+#define SCALE2X_PIXEL(typename_t, x) \
+   { \
+      const typename_t A = *(src + (x) - prevline); \
+      const typename_t B = (x) > 0 ? src[(x) - 1] : src[(x)]; \
+      const typename_t C = src[(x)]; \
+      const typename_t D = (x) < width - 1 ? src[(x) + 1] : src[(x)]; \
+      const typename_t E = *(src + (x) + nextline); \
+      \
+      if (A != E && B != D) \
+      { \
+         out0[2 * (x)]     = (A == B ? A : C); \
+         out0[2 * (x) + 1] = (A == D ? A : C); \
+         out1[2 * (x)]     = (E == B ? E : C); \
+         out1[2 * (x) + 1] = (E == D ? E : C); \
+      } \
+      else \
+      { \
+         out0[2 * (x)]     = C; \
+         out0[2 * (x) + 1] = C; \
+         out1[2 * (x)]     = C; \
+         out1[2 * (x) + 1] = C; \
+      } \
+   }
+
+#define SCALE2X_GENERIC(typename_t, width, height, first, last, src, src_stride, dst, dst_stride, row) \
    for (y = 0; y < height; ++y) \
    { \
       const int prevline = ((y == 0) && first) ? 0 : src_stride; \
       const int nextline = ((y == height - 1) && last) ? 0 : src_stride; \
+      typename_t *out0   = dst; \
+      typename_t *out1   = dst + dst_stride; \
       \
-      for (x = 0; x < width; ++x) \
+      x = 0; \
+      if (row && width > 2) \
       { \
-         const typename_t A = *(src - prevline); \
-         const typename_t B = (x > 0) ? *(src - 1) : *src; \
-         const typename_t C = *src; \
-         const typename_t D = (x < width - 1) ? *(src + 1) : *src; \
-         const typename_t E = *(src++ + nextline); \
-         \
-         if (A != E && B != D) \
-         { \
-            *out0++ = (A == B ? A : C); \
-            *out0++ = (A == D ? A : C); \
-            *out1++ = (E == B ? E : C); \
-            *out1++ = (E == D ? E : C); \
-         } \
-         else \
-         { \
-            *out0++ = C; \
-            *out0++ = C; \
-            *out1++ = C; \
-            *out1++ = C; \
-         } \
+         SCALE2X_PIXEL(typename_t, 0); \
+         x = 1 + row(src + 1, prevline, nextline, \
+               out0 + 2, out1 + 2, width - 2); \
       } \
       \
-      src += src_stride - width; \
-      out0 += dst_stride + dst_stride - (width * SCALE2X_SCALE); \
-      out1 += dst_stride + dst_stride - (width * SCALE2X_SCALE); \
+      for (; x < width; ++x) \
+         SCALE2X_PIXEL(typename_t, x); \
+      \
+      src += src_stride; \
+      dst += dst_stride + dst_stride; \
    }
 
+#ifdef SOFTFILTER_HAVE_SSE2
+SOFTFILTER_SCALE2X_ROW(SSE2, 16, uint16_t, scale2x_row_rgb565_sse2, )
+SOFTFILTER_SCALE2X_ROW(SSE2, 32, uint32_t, scale2x_row_xrgb8888_sse2, )
+#endif
+#ifdef SOFTFILTER_HAVE_AVX2
+SOFTFILTER_SCALE2X_ROW(AVX2, 16, uint16_t, scale2x_row_rgb565_avx2,
+      SOFTFILTER_AVX2_TARGET)
+SOFTFILTER_SCALE2X_ROW(AVX2, 32, uint32_t, scale2x_row_xrgb8888_avx2,
+      SOFTFILTER_AVX2_TARGET)
+#endif
+#ifdef SOFTFILTER_HAVE_NEON
+SOFTFILTER_SCALE2X_ROW(NEON, 16, uint16_t, scale2x_row_rgb565_neon, )
+SOFTFILTER_SCALE2X_ROW(NEON, 32, uint32_t, scale2x_row_xrgb8888_neon, )
+#endif
+
 static void scale2x_generic_rgb565(unsigned width, unsigned height,
       int first, int last,
       const uint16_t *src, unsigned src_stride,
-      uint16_t *dst, unsigned dst_stride)
+      uint16_t *dst, unsigned dst_stride, scale2x_row_rgb565_t row)
 {
    unsigned x, y;
-   uint16_t *out0, *out1;
-   out0 = (uint16_t*)dst;
-   out1 = (uint16_t*)(dst + dst_stride);
    SCALE2X_GENERIC(uint16_t, width, height, first, last,
-         src, src_stride, dst, dst_stride, out0, out1);
+         src, src_stride, dst, dst_stride, row);
 }
 
 static void scale2x_generic_xrgb8888(unsigned width, unsigned height,
       int first, int last,
       const uint32_t *src, unsigned src_stride,
-      uint32_t *dst, unsigned dst_stride)
+      uint32_t *dst, unsigned dst_stride, scale2x_row_xrgb8888_t row)
 {
    unsigned x, y;
-   uint32_t *out0, *out1;
-   out0 = (uint32_t*)dst;
-   out1 = (uint32_t*)(dst + dst_stride);
    SCALE2X_GENERIC(uint32_t, width, height, first, last,
-         src, src_stride, dst, dst_stride, out0, out1);
+         src, src_stride, dst, dst_stride, row);
 }
 
 static unsigned scale2x_generic_input_fmts(void)
@@ -129,7 +163,6 @@ static void *scale2x_generic_create(const struct softfilter_config *config,
       unsigned max_width, unsigned max_height,
       unsigned threads, softfilter_simd_mask_t simd, void *userdata)
 {
-   (void)simd;
    (void)config;
    (void)userdata;
 
@@ -138,13 +171,38 @@ static void *scale2x_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
       free(filt);
       return NULL;
    }
+
+   switch (softfilter_simd_kernel(simd))
+   {
+#ifdef SOFTFILTER_HAVE_AVX2
+      case SOFTFILTER_KERNEL_AVX2:
+         filt->row_rgb565   = scale2x_row_rgb565_avx2;
+         filt->row_xrgb8888 = scale2x_row_xrgb8888_avx2;
+         break;
+#endif
+#ifdef SOFTFILTER_HAVE_SSE2
+      case SOFTFILTER_KERNEL_SSE2:
+         filt->row_rgb565   = scale2x_row_rgb565_sse2;
+         filt->row_xrgb8888 = scale2x_row_xrgb8888_sse2;
+         break;
+#endif
+#ifdef SOFTFILTER_HAVE_NEON
+      case SOFTFILTER_KERNEL_NEON:
+         filt->row_rgb565   = scale2x_row_rgb565_neon;
+         filt->row_xrgb8888 = scale2x_row_xrgb8888_neon;
+         break;
+#endif
+      default:
+         break;
+   }
+
    return filt;
 }
 
@@ -169,6 +227,7 @@ static void scale2x_generic_destroy(void *data)
 
 static void scale2x_work_cb_xrgb8888(void *data, void *thread_data)
 {
+   struct filter_data *filt = (struct filter_data*)data;
    struct softfilter_thread_data *thr = 
       (struct softfilter_thread_data*)thread_data;
    const uint32_t *input = (const uint32_t*)thr->in_data;
@@ -180,11 +239,13 @@ static void scale2x_work_cb_xrgb8888(void *data, void *thread_data)
          thr->first, thr->last, input,
          thr->in_pitch / SOFTFILTER_BPP_XRGB8888,
          output,
-         thr->out_pitch / SOFTFILTER_BPP_XRGB8888);
+         thr->out_pitch / SOFTFILTER_BPP_XRGB8888,
+         filt->row_xrgb8888);
 }
 
 static void scale2x_work_cb_rgb565(void *data, void *thread_data)
 {
+   struct filter_data *filt = (struct filter_data*)data;
    struct softfilter_thread_data *thr = 
       (struct softfilter_thread_data*)thread_data;
    const uint16_t *input = (const uint16_t*)thr->in_data;
@@ -196,7 +257,8 @@ static void scale2x_work_cb_rgb565(void *data, void *thread_data)
          thr->first, thr->last, input, 
          thr->in_pitch / SOFTFILTER_BPP_RGB565,
          output,
-         thr->out_pitch / SOFTFILTER_BPP_RGB565);
+         thr->out_pitch / SOFTFILTER_BPP_RGB565,
+         filt->row_rgb565);
 }
 
 static void scale2x_generic_packets(void *data,
@@ -206,13 +268,24 @@ static void scale2x_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   /* Bands are at least SCALE2X_MIN_BAND rows tall, so that
+    * 'first' and 'last' are all a kernel needs to clamp its reads
+    * to the image. Other rows it reads outside its band belong to
+    * the neighbouring bands. Leftover threads get empty bands. */
+   unsigned bands = height / SCALE2X_MIN_BAND;
+
+   if (bands > filt->threads)
+      bands = filt->threads;
+   if (!bands)
+      bands = 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = i < bands ? (height * i) / bands : height;
+      unsigned y_end   = i < bands ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * 
          SCALE2X_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
@@ -223,7 +296,7 @@ static void scale2x_generic_packets(void *data,
 
       /* Workers need to know if they can access pixels 
        * outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
@@ -0,0 +1,365 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOFTFILTER_SIMD_H__
+#define SOFTFILTER_SIMD_H__
+
+/* Vector helpers shared by the bundled softfilters.
+ *
+ * A kernel is written once as a macro over SF_OP(isa, op, bits), and
+ * instantiated for every instruction set compiled in here. 'bits' is
+ * the lane size, 16 for RGB565 and 32 for XRGB8888. All operations
+ * are plain integer ops, so a vector kernel gives the exact same
+ * output as its scalar counterpart.
+ *
+ * Lanes are stored in memory order, which only matches the scalar
+ * kernels' packed writes on little-endian targets. */
+
+#include <stdint.h>
+#include <retro_inline.h>
+
+#include "softfilter.h"
+
+#define SF_OP(isa, op, bits) SF_##isa##_##op##bits
+
+enum softfilter_kernel
+{
+   SOFTFILTER_KERNEL_C = 0,
+   SOFTFILTER_KERNEL_SSE2,
+   SOFTFILTER_KERNEL_AVX2,
+   SOFTFILTER_KERNEL_NEON
+};
+
+#ifndef MSB_FIRST
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+      (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTFILTER_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(SOFTFILTER_HAVE_SSE2) && (defined(__clang__) || \
+      (defined(__GNUC__) && \
+       (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SOFTFILTER_HAVE_AVX2
+#include <immintrin.h>
+#define SOFTFILTER_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+#if (defined(__ARM_NEON__) || defined(__ARM_NEON)) && defined(__GNUC__)
+#define SOFTFILTER_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+#endif
+
+/* Number of leading lanes whose mask is clear, given a byte mask
+ * with 'bytes' bits per lane. */
+static INLINE unsigned softfilter_simd_lead(unsigned bits,
+      unsigned bytes, unsigned lanes)
+{
+   unsigned n = 0;
+
+   while (n < lanes && !(bits & (1u << (n * bytes))))
+      n++;
+   return n;
+}
+
+#ifdef SOFTFILTER_HAVE_SSE2
+#define SF_SSE2_V16             __m128i
+#define SF_SSE2_V32             __m128i
+#define SF_SSE2_LANES16         8
+#define SF_SSE2_LANES32         4
+#define SF_SSE2_LOAD16(p)       _mm_loadu_si128((const __m128i*)(p))
+#define SF_SSE2_LOAD32(p)       _mm_loadu_si128((const __m128i*)(p))
+#define SF_SSE2_STORE16(p, v)   _mm_storeu_si128((__m128i*)(p), (v))
+#define SF_SSE2_STORE32(p, v)   _mm_storeu_si128((__m128i*)(p), (v))
+#define SF_SSE2_SPLAT16(x)      _mm_set1_epi16((short)(x))
+#define SF_SSE2_SPLAT32(x)      _mm_set1_epi32((int)(x))
+#define SF_SSE2_EQ16(a, b)      _mm_cmpeq_epi16((a), (b))
+#define SF_SSE2_EQ32(a, b)      _mm_cmpeq_epi32((a), (b))
+#define SF_SSE2_AND16(a, b)     _mm_and_si128((a), (b))
+#define SF_SSE2_AND32(a, b)     _mm_and_si128((a), (b))
+#define SF_SSE2_OR16(a, b)      _mm_or_si128((a), (b))
+#define SF_SSE2_OR32(a, b)      _mm_or_si128((a), (b))
+#define SF_SSE2_NOT16(a)        _mm_andnot_si128((a), _mm_set1_epi32(-1))
+#define SF_SSE2_NOT32(a)        _mm_andnot_si128((a), _mm_set1_epi32(-1))
+#define SF_SSE2_ANDNOT16(a, b)  _mm_andnot_si128((b), (a))
+#define SF_SSE2_ANDNOT32(a, b)  _mm_andnot_si128((b), (a))
+#define SF_SSE2_SEL16(m, a, b)  _mm_or_si128(_mm_and_si128((m), (a)), \
+      _mm_andnot_si128((m), (b)))
+#define SF_SSE2_SEL32(m, a, b)  SF_SSE2_SEL16(m, a, b)
+#define SF_SSE2_ADD16(a, b)     _mm_add_epi16((a), (b))
+#define SF_SSE2_ADD32(a, b)     _mm_add_epi32((a), (b))
+#define SF_SSE2_SUB16(a, b)     _mm_sub_epi16((a), (b))
+#define SF_SSE2_SUB32(a, b)     _mm_sub_epi32((a), (b))
+#define SF_SSE2_SRL16(v, n)     _mm_srli_epi16((v), (n))
+#define SF_SSE2_SRL32(v, n)     _mm_srli_epi32((v), (n))
+#define SF_SSE2_GTZ16(v)        _mm_cmpgt_epi16((v), _mm_setzero_si128())
+#define SF_SSE2_GTZ32(v)        _mm_cmpgt_epi32((v), _mm_setzero_si128())
+#define SF_SSE2_LTZ16(v)        _mm_cmplt_epi16((v), _mm_setzero_si128())
+#define SF_SSE2_LTZ32(v)        _mm_cmplt_epi32((v), _mm_setzero_si128())
+#define SF_SSE2_ZIP16(a, b, lo, hi) \
+   lo = _mm_unpacklo_epi16((a), (b)); hi = _mm_unpackhi_epi16((a), (b))
+#define SF_SSE2_ZIP32(a, b, lo, hi) \
+   lo = _mm_unpacklo_epi32((a), (b)); hi = _mm_unpackhi_epi32((a), (b))
+#define SF_SSE2_ANY16(m)        (_mm_movemask_epi8(m) != 0)
+#define SF_SSE2_ANY32(m)        (_mm_movemask_epi8(m) != 0)
+#define SF_SSE2_LEAD16(m)       softfilter_simd_lead(_mm_movemask_epi8(m), 2, 8)
+#define SF_SSE2_LEAD32(m)       softfilter_simd_lead(_mm_movemask_epi8(m), 4, 4)
+#endif
+
+#ifdef SOFTFILTER_HAVE_AVX2
+/* Only usable inside functions marked SOFTFILTER_AVX2_TARGET.
+ * The 256-bit unpacks interleave within each 128-bit half,
+ * so ZIP puts the halves back in order. */
+#define SF_AVX2_V16             __m256i
+#define SF_AVX2_V32             __m256i
+#define SF_AVX2_LANES16         16
+#define SF_AVX2_LANES32         8
+#define SF_AVX2_LOAD16(p)       _mm256_loadu_si256((const __m256i*)(p))
+#define SF_AVX2_LOAD32(p)       _mm256_loadu_si256((const __m256i*)(p))
+#define SF_AVX2_STORE16(p, v)   _mm256_storeu_si256((__m256i*)(p), (v))
+#define SF_AVX2_STORE32(p, v)   _mm256_storeu_si256((__m256i*)(p), (v))
+#define SF_AVX2_SPLAT16(x)      _mm256_set1_epi16((short)(x))
+#define SF_AVX2_SPLAT32(x)      _mm256_set1_epi32((int)(x))
+#define SF_AVX2_EQ16(a, b)      _mm256_cmpeq_epi16((a), (b))
+#define SF_AVX2_EQ32(a, b)      _mm256_cmpeq_epi32((a), (b))
+#define SF_AVX2_AND16(a, b)     _mm256_and_si256((a), (b))
+#define SF_AVX2_AND32(a, b)     _mm256_and_si256((a), (b))
+#define SF_AVX2_OR16(a, b)      _mm256_or_si256((a), (b))
+#define SF_AVX2_OR32(a, b)      _mm256_or_si256((a), (b))
+#define SF_AVX2_NOT16(a)        _mm256_andnot_si256((a), _mm256_set1_epi32(-1))
+#define SF_AVX2_NOT32(a)        _mm256_andnot_si256((a), _mm256_set1_epi32(-1))
+#define SF_AVX2_ANDNOT16(a, b)  _mm256_andnot_si256((b), (a))
+#define SF_AVX2_ANDNOT32(a, b)  _mm256_andnot_si256((b), (a))
+#define SF_AVX2_SEL16(m, a, b)  _mm256_blendv_epi8((b), (a), (m))
+#define SF_AVX2_SEL32(m, a, b)  _mm256_blendv_epi8((b), (a), (m))
+#define SF_AVX2_ADD16(a, b)     _mm256_add_epi16((a), (b))
+#define SF_AVX2_ADD32(a, b)     _mm256_add_epi32((a), (b))
+#define SF_AVX2_SUB16(a, b)     _mm256_sub_epi16((a), (b))
+#define SF_AVX2_SUB32(a, b)     _mm256_sub_epi32((a), (b))
+#define SF_AVX2_SRL16(v, n)     _mm256_srli_epi16((v), (n))
+#define SF_AVX2_SRL32(v, n)     _mm256_srli_epi32((v), (n))
+#define SF_AVX2_GTZ16(v)        _mm256_cmpgt_epi16((v), _mm256_setzero_si256())
+#define SF_AVX2_GTZ32(v)        _mm256_cmpgt_epi32((v), _mm256_setzero_si256())
+#define SF_AVX2_LTZ16(v)        _mm256_cmpgt_epi16(_mm256_setzero_si256(), (v))
+#define SF_AVX2_LTZ32(v)        _mm256_cmpgt_epi32(_mm256_setzero_si256(), (v))
+#define SF_AVX2_ZIP(a, b, lo, hi, lo_op, hi_op) \
+   { \
+      __m256i zip_lo_ = lo_op((a), (b)); \
+      __m256i zip_hi_ = hi_op((a), (b)); \
+      lo = _mm256_permute2x128_si256(zip_lo_, zip_hi_, 0x20); \
+      hi = _mm256_permute2x128_si256(zip_lo_, zip_hi_, 0x31); \
+   }
+#define SF_AVX2_ZIP16(a, b, lo, hi) \
+   SF_AVX2_ZIP(a, b, lo, hi, _mm256_unpacklo_epi16, _mm256_unpackhi_epi16)
+#define SF_AVX2_ZIP32(a, b, lo, hi) \
+   SF_AVX2_ZIP(a, b, lo, hi, _mm256_unpacklo_epi32, _mm256_unpackhi_epi32)
+#define SF_AVX2_ANY16(m)        (_mm256_movemask_epi8(m) != 0)
+#define SF_AVX2_ANY32(m)        (_mm256_movemask_epi8(m) != 0)
+#define SF_AVX2_LEAD16(m) \
+   softfilter_simd_lead((unsigned)_mm256_movemask_epi8(m), 2, 16)
+#define SF_AVX2_LEAD32(m) \
+   softfilter_simd_lead((unsigned)_mm256_movemask_epi8(m), 4, 8)
+#endif
+
+#ifdef SOFTFILTER_HAVE_NEON
+static INLINE unsigned softfilter_neon_lead16(uint16x8_t m)
+{
+   uint16_t lanes[8];
+   unsigned n = 0;
+
+   vst1q_u16(lanes, m);
+   while (n < 8 && !lanes[n])
+      n++;
+   return n;
+}
+
+static INLINE unsigned softfilter_neon_lead32(uint32x4_t m)
+{
+   uint32_t lanes[4];
+   unsigned n = 0;
+
+   vst1q_u32(lanes, m);
+   while (n < 4 && !lanes[n])
+      n++;
+   return n;
+}
+
+#define SF_NEON_V16             uint16x8_t
+#define SF_NEON_V32             uint32x4_t
+#define SF_NEON_LANES16         8
+#define SF_NEON_LANES32         4
+#define SF_NEON_LOAD16(p)       vld1q_u16((const uint16_t*)(p))
+#define SF_NEON_LOAD32(p)       vld1q_u32((const uint32_t*)(p))
+#define SF_NEON_STORE16(p, v)   vst1q_u16((uint16_t*)(p), (v))
+#define SF_NEON_STORE32(p, v)   vst1q_u32((uint32_t*)(p), (v))
+#define SF_NEON_SPLAT16(x)      vdupq_n_u16((uint16_t)(x))
+#define SF_NEON_SPLAT32(x)      vdupq_n_u32((uint32_t)(x))
+#define SF_NEON_EQ16(a, b)      vceqq_u16((a), (b))
+#define SF_NEON_EQ32(a, b)      vceqq_u32((a), (b))
+#define SF_NEON_AND16(a, b)     vandq_u16((a), (b))
+#define SF_NEON_AND32(a, b)     vandq_u32((a), (b))
+#define SF_NEON_OR16(a, b)      vorrq_u16((a), (b))
+#define SF_NEON_OR32(a, b)      vorrq_u32((a), (b))
+#define SF_NEON_NOT16(a)        vmvnq_u16(a)
+#define SF_NEON_NOT32(a)        vmvnq_u32(a)
+#define SF_NEON_ANDNOT16(a, b)  vbicq_u16((a), (b))
+#define SF_NEON_ANDNOT32(a, b)  vbicq_u32((a), (b))
+#define SF_NEON_SEL16(m, a, b)  vbslq_u16((m), (a), (b))
+#define SF_NEON_SEL32(m, a, b)  vbslq_u32((m), (a), (b))
+#define SF_NEON_ADD16(a, b)     vaddq_u16((a), (b))
+#define SF_NEON_ADD32(a, b)     vaddq_u32((a), (b))
+#define SF_NEON_SUB16(a, b)     vsubq_u16((a), (b))
+#define SF_NEON_SUB32(a, b)     vsubq_u32((a), (b))
+#define SF_NEON_SRL16(v, n)     vshrq_n_u16((v), (n))
+#define SF_NEON_SRL32(v, n)     vshrq_n_u32((v), (n))
+#define SF_NEON_GTZ16(v)        vcgtq_s16(vreinterpretq_s16_u16(v), vdupq_n_s16(0))
+#define SF_NEON_GTZ32(v)        vcgtq_s32(vreinterpretq_s32_u32(v), vdupq_n_s32(0))
+#define SF_NEON_LTZ16(v)        vcltq_s16(vreinterpretq_s16_u16(v), vdupq_n_s16(0))
+#define SF_NEON_LTZ32(v)        vcltq_s32(vreinterpretq_s32_u32(v), vdupq_n_s32(0))
+#define SF_NEON_ZIP16(a, b, lo, hi) \
+   { \
+      uint16x8x2_t zip_ = vzipq_u16((a), (b)); \
+      lo = zip_.val[0]; \
+      hi = zip_.val[1]; \
+   }
+#define SF_NEON_ZIP32(a, b, lo, hi) \
+   { \
+      uint32x4x2_t zip_ = vzipq_u32((a), (b)); \
+      lo = zip_.val[0]; \
+      hi = zip_.val[1]; \
+   }
+#define SF_NEON_ANY(m64)        (vget_lane_u64((m64), 0) != 0)
+#define SF_NEON_ANY16(m)        SF_NEON_ANY(vreinterpret_u64_u16( \
+         vorr_u16(vget_low_u16(m), vget_high_u16(m))))
+#define SF_NEON_ANY32(m)        SF_NEON_ANY(vreinterpret_u64_u32( \
+         vorr_u32(vget_low_u32(m), vget_high_u32(m))))
+#define SF_NEON_LEAD16(m)       softfilter_neon_lead16(m)
+#define SF_NEON_LEAD32(m)       softfilter_neon_lead32(m)
+#endif
+
+/* Per-lane ((A & hi) >> 1) + ((B & hi) >> 1) + (A & B & lo),
+ * the 50% blend used by the SaI family. */
+#define SF_BLEND2(isa, bits, a, b, hi, lo) \
+   SF_OP(isa, ADD, bits)(SF_OP(isa, ADD, bits)( \
+         SF_OP(isa, SRL, bits)(SF_OP(isa, AND, bits)(a, hi), 1), \
+         SF_OP(isa, SRL, bits)(SF_OP(isa, AND, bits)(b, hi), 1)), \
+      SF_OP(isa, AND, bits)(SF_OP(isa, AND, bits)(a, b), lo))
+
+/* Per-lane 25% blend of four colors with carry of the low bits. */
+#define SF_BLEND4(isa, bits, a, b, c, d, hi, lo) \
+   SF_OP(isa, ADD, bits)(SF_OP(isa, ADD, bits)( \
+         SF_OP(isa, ADD, bits)( \
+            SF_OP(isa, SRL, bits)(SF_OP(isa, AND, bits)(a, hi), 2), \
+            SF_OP(isa, SRL, bits)(SF_OP(isa, AND, bits)(b, hi), 2)), \
+         SF_OP(isa, ADD, bits)( \
+            SF_OP(isa, SRL, bits)(SF_OP(isa, AND, bits)(c, hi), 2), \
+            SF_OP(isa, SRL, bits)(SF_OP(isa, AND, bits)(d, hi), 2))), \
+      SF_OP(isa, AND, bits)(SF_OP(isa, SRL, bits)( \
+            SF_OP(isa, ADD, bits)( \
+               SF_OP(isa, ADD, bits)(SF_OP(isa, AND, bits)(a, lo), \
+                  SF_OP(isa, AND, bits)(b, lo)), \
+               SF_OP(isa, ADD, bits)(SF_OP(isa, AND, bits)(c, lo), \
+                  SF_OP(isa, AND, bits)(d, lo))), 2), lo))
+
+/* Scale2x over 'count' pixels of a row, all of which must have their
+ * left and right neighbours in the row. Returns how many pixels were
+ * done; the caller finishes the rest. Away from the image edges EPX
+ * gives the same pixels, so it shares this kernel. */
+#define SOFTFILTER_SCALE2X_ROW(isa, bits, typename_t, name, target) \
+static target unsigned name(const typename_t *src, \
+      int prevline, int nextline, \
+      typename_t *out0, typename_t *out1, unsigned count) \
+{ \
+   unsigned x; \
+   \
+   for (x = 0; x + SF_OP(isa, LANES, bits) <= count; \
+         x += SF_OP(isa, LANES, bits)) \
+   { \
+      SF_OP(isa, V, bits) p00, p01, p10, p11, lo, hi; \
+      SF_OP(isa, V, bits) A = SF_OP(isa, LOAD, bits)(src + x - prevline); \
+      SF_OP(isa, V, bits) B = SF_OP(isa, LOAD, bits)(src + x - 1); \
+      SF_OP(isa, V, bits) C = SF_OP(isa, LOAD, bits)(src + x); \
+      SF_OP(isa, V, bits) D = SF_OP(isa, LOAD, bits)(src + x + 1); \
+      SF_OP(isa, V, bits) E = SF_OP(isa, LOAD, bits)(src + x + nextline); \
+      /* Lanes where A == E or B == D keep C everywhere. */ \
+      SF_OP(isa, V, bits) flat = SF_OP(isa, OR, bits)( \
+            SF_OP(isa, EQ, bits)(A, E), SF_OP(isa, EQ, bits)(B, D)); \
+      \
+      p00 = SF_OP(isa, SEL, bits)(SF_OP(isa, ANDNOT, bits)( \
+               SF_OP(isa, EQ, bits)(A, B), flat), A, C); \
+      p01 = SF_OP(isa, SEL, bits)(SF_OP(isa, ANDNOT, bits)( \
+               SF_OP(isa, EQ, bits)(A, D), flat), A, C); \
+      p10 = SF_OP(isa, SEL, bits)(SF_OP(isa, ANDNOT, bits)( \
+               SF_OP(isa, EQ, bits)(E, B), flat), E, C); \
+      p11 = SF_OP(isa, SEL, bits)(SF_OP(isa, ANDNOT, bits)( \
+               SF_OP(isa, EQ, bits)(E, D), flat), E, C); \
+      \
+      SF_OP(isa, ZIP, bits)(p00, p01, lo, hi); \
+      SF_OP(isa, STORE, bits)(out0 + 2 * x, lo); \
+      SF_OP(isa, STORE, bits)(out0 + 2 * x + SF_OP(isa, LANES, bits), hi); \
+      SF_OP(isa, ZIP, bits)(p10, p11, lo, hi); \
+      SF_OP(isa, STORE, bits)(out1 + 2 * x, lo); \
+      SF_OP(isa, STORE, bits)(out1 + 2 * x + SF_OP(isa, LANES, bits), hi); \
+   } \
+   \
+   return x; \
+}
+
+/**
+ * softfilter_simd_kernel:
+ * @simd                 : SIMD mask passed to the filter's create().
+ *
+ * Picks the widest kernel that is both compiled in and
+ * allowed by @simd.
+ *
+ * Returns: one of enum softfilter_kernel.
+ **/
+static INLINE unsigned softfilter_simd_kernel(softfilter_simd_mask_t simd)
+{
+#ifdef SOFTFILTER_HAVE_AVX2
+   if ((simd & (SOFTFILTER_SIMD_AVX | SOFTFILTER_SIMD_AVX2)) ==
+         (SOFTFILTER_SIMD_AVX | SOFTFILTER_SIMD_AVX2))
+      return SOFTFILTER_KERNEL_AVX2;
+#endif
+#ifdef SOFTFILTER_HAVE_SSE2
+   if (simd & SOFTFILTER_SIMD_SSE2)
+      return SOFTFILTER_KERNEL_SSE2;
+#endif
+#ifdef SOFTFILTER_HAVE_NEON
+   if (simd & SOFTFILTER_SIMD_NEON)
+      return SOFTFILTER_KERNEL_NEON;
+#endif
+   (void)simd;
+   return SOFTFILTER_KERNEL_C;
+}
+
+static INLINE const char *softfilter_simd_kernel_name(unsigned kernel)
+{
+   switch (kernel)
+   {
+      case SOFTFILTER_KERNEL_SSE2:
+         return "SSE2";
+      case SOFTFILTER_KERNEL_AVX2:
+         return "AVX2";
+      case SOFTFILTER_KERNEL_NEON:
+         return "NEON";
+   }
+   return "C";
+}
+
+#endif
@@ -26,6 +26,7 @@
 #endif
 
 #define SUPERTWOXSAI_SCALE 2
+#define SUPERTWOXSAI_MIN_BAND 2
 
 struct softfilter_thread_data
 {
@@ -76,7 +77,7 @@ static void *supertwoxsai_generic_create(const struct softfilter_config *config,
    if (!filt)
       return NULL;
    filt->workers = (struct softfilter_thread_data*)calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
@@ -115,12 +116,12 @@ static void supertwoxsai_generic_destroy(void *data)
 #define supertwoxsai_result(A, B, C, D) (((A) != (C) || (A) != (D)) - ((B) != (C) || (B) != (D)))
 
 #ifndef supertwoxsai_declare_variables
-#define supertwoxsai_declare_variables(typename_t, in, nextline) \
+#define supertwoxsai_declare_variables(typename_t, in, prevline, nextline, nextline2) \
          typename_t product1a, product1b, product2a, product2b; \
-         const typename_t colorB0 = *(in - nextline - 1); \
-         const typename_t colorB1 = *(in - nextline + 0); \
-         const typename_t colorB2 = *(in - nextline + 1); \
-         const typename_t colorB3 = *(in - nextline + 2); \
+         const typename_t colorB0 = *(in - prevline - 1); \
+         const typename_t colorB1 = *(in - prevline + 0); \
+         const typename_t colorB2 = *(in - prevline + 1); \
+         const typename_t colorB3 = *(in - prevline + 2); \
          const typename_t color4  = *(in - 1); \
          const typename_t color5  = *(in + 0); \
          const typename_t color6  = *(in + 1); \
@@ -129,10 +130,10 @@ static void supertwoxsai_generic_destroy(void *data)
          const typename_t color2  = *(in + nextline + 0); \
          const typename_t color3  = *(in + nextline + 1); \
          const typename_t colorS1 = *(in + nextline + 2); \
-         const typename_t colorA0 = *(in + nextline + nextline - 1); \
-         const typename_t colorA1 = *(in + nextline + nextline + 0); \
-         const typename_t colorA2 = *(in + nextline + nextline + 1); \
-         const typename_t colorA3 = *(in + nextline + nextline + 2)
+         const typename_t colorA0 = *(in + nextline2 - 1); \
+         const typename_t colorA1 = *(in + nextline2 + 0); \
+         const typename_t colorA2 = *(in + nextline2 + 1); \
+         const typename_t colorA3 = *(in + nextline2 + 2)
 #endif
 
 #ifndef supertwoxsai_function
@@ -202,17 +203,22 @@ static void supertwoxsai_generic_xrgb8888(unsigned width, unsigned height,
       int first, int last, uint32_t *src, 
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
-   unsigned nextline, finish;
-   nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows past the image edges are clamped to the edge;
+       * rows past the band edges come from the neighbouring band. */
+      unsigned prevline  = (first && y < 1) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint32_t *in  = (uint32_t*)src;
       uint32_t *out = (uint32_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         supertwoxsai_declare_variables(uint32_t, in, nextline);
+         supertwoxsai_declare_variables(uint32_t, in, prevline, nextline, nextline2);
 
          //---------------------------    B1 B2
          //                             4  5  6 S2
@@ -232,17 +238,22 @@ static void supertwoxsai_generic_rgb565(unsigned width, unsigned height,
       int first, int last, uint16_t *src, 
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
-   unsigned nextline, finish;
-   nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows past the image edges are clamped to the edge;
+       * rows past the band edges come from the neighbouring band. */
+      unsigned prevline  = (first && y < 1) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint16_t *in  = (uint16_t*)src;
       uint16_t *out = (uint16_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         supertwoxsai_declare_variables(uint16_t, in, nextline);
+         supertwoxsai_declare_variables(uint16_t, in, prevline, nextline, nextline2);
 
          //---------------------------    B1 B2
          //                             4  5  6 S2
@@ -289,12 +300,23 @@ static void supertwoxsai_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   /* Bands are at least SUPERTWOXSAI_MIN_BAND rows tall, so that
+    * 'first' and 'last' are all a kernel needs to clamp its reads
+    * to the image. Other rows it reads outside its band belong to
+    * the neighbouring bands. Leftover threads get empty bands. */
+   unsigned bands = height / SUPERTWOXSAI_MIN_BAND;
+
+   if (bands > filt->threads)
+      bands = filt->threads;
+   if (!bands)
+      bands = 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = i < bands ? (height * i) / bands : height;
+      unsigned y_end   = i < bands ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * SUPERTWOXSAI_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
       thr->out_pitch = output_stride;
@@ -303,7 +325,7 @@ static void supertwoxsai_generic_packets(void *data,
       thr->height = y_end - y_start;
 
       // Workers need to know if they can access pixels outside their given buffer.
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
@@ -17,6 +17,7 @@
 // Compile: gcc -o supereagle.so -shared supereagle.c -std=c99 -O3 -Wall -pedantic -fPIC
 
 #include "softfilter.h"
+#include "softfilter_simd.h"
 #include <stdlib.h>
 
 #ifdef RARCH_INTERNAL
@@ -26,6 +27,7 @@
 #endif
 
 #define SUPEREAGLE_SCALE 2
+#define SUPEREAGLE_MIN_BAND 2
 
 struct softfilter_thread_data
 {
@@ -40,11 +42,22 @@ struct softfilter_thread_data
    int last;
 };
 
+/* Vector rows return how many pixels they did, from the start of
+ * the row; the scalar loop finishes the rest. */
+typedef unsigned (*supereagle_row_rgb565_t)(const uint16_t *in,
+      unsigned prevline, unsigned nextline, unsigned nextline2,
+      uint16_t *out, unsigned dst_stride, unsigned count);
+typedef unsigned (*supereagle_row_xrgb8888_t)(const uint32_t *in,
+      unsigned prevline, unsigned nextline, unsigned nextline2,
+      uint32_t *out, unsigned dst_stride, unsigned count);
+
 struct filter_data
 {
    unsigned threads;
    struct softfilter_thread_data *workers;
    unsigned in_fmt;
+   supereagle_row_rgb565_t row_rgb565;
+   supereagle_row_xrgb8888_t row_xrgb8888;
 };
 
 static unsigned supereagle_generic_input_fmts(void)
@@ -63,12 +76,147 @@ static unsigned supereagle_generic_threads(void *data)
    return filt->threads;
 }
 
+/* The same decisions as supereagle_function, made for a whole vector
+ * of pixels at once and resolved with selects. */
+#define SUPEREAGLE_SIMD(isa, bits, typename_t, name, target, hi2, lo2, hi4, lo4) \
+static target unsigned name(const typename_t *in, unsigned prevline, \
+      unsigned nextline, unsigned nextline2, \
+      typename_t *out, unsigned dst_stride, unsigned count) \
+{ \
+   unsigned x; \
+   const SF_OP(isa, V, bits) h2 = SF_OP(isa, SPLAT, bits)(hi2); \
+   const SF_OP(isa, V, bits) l2 = SF_OP(isa, SPLAT, bits)(lo2); \
+   const SF_OP(isa, V, bits) h4 = SF_OP(isa, SPLAT, bits)(hi4); \
+   const SF_OP(isa, V, bits) l4 = SF_OP(isa, SPLAT, bits)(lo4); \
+   \
+   for (x = 0; x + SF_OP(isa, LANES, bits) <= count; \
+         x += SF_OP(isa, LANES, bits)) \
+   { \
+      SF_OP(isa, V, bits) product1a, product1b, product2a, product2b; \
+      SF_OP(isa, V, bits) r, m, lo, hi; \
+      const typename_t *p = in + x; \
+      SF_OP(isa, V, bits) colorB1 = SF_OP(isa, LOAD, bits)(p - prevline); \
+      SF_OP(isa, V, bits) colorB2 = SF_OP(isa, LOAD, bits)(p - prevline + 1); \
+      SF_OP(isa, V, bits) color4  = SF_OP(isa, LOAD, bits)(p - 1); \
+      SF_OP(isa, V, bits) color5  = SF_OP(isa, LOAD, bits)(p); \
+      SF_OP(isa, V, bits) color6  = SF_OP(isa, LOAD, bits)(p + 1); \
+      SF_OP(isa, V, bits) colorS2 = SF_OP(isa, LOAD, bits)(p + 2); \
+      SF_OP(isa, V, bits) color1  = SF_OP(isa, LOAD, bits)(p + nextline - 1); \
+      SF_OP(isa, V, bits) color2  = SF_OP(isa, LOAD, bits)(p + nextline); \
+      SF_OP(isa, V, bits) color3  = SF_OP(isa, LOAD, bits)(p + nextline + 1); \
+      SF_OP(isa, V, bits) colorS1 = SF_OP(isa, LOAD, bits)(p + nextline + 2); \
+      SF_OP(isa, V, bits) colorA1 = SF_OP(isa, LOAD, bits)(p + nextline2); \
+      SF_OP(isa, V, bits) colorA2 = SF_OP(isa, LOAD, bits)(p + nextline2 + 1); \
+      \
+      SF_OP(isa, V, bits) eq26 = SF_OP(isa, EQ, bits)(color2, color6); \
+      SF_OP(isa, V, bits) eq53 = SF_OP(isa, EQ, bits)(color5, color3); \
+      SF_OP(isa, V, bits) i56  = SF_BLEND2(isa, bits, color5, color6, h2, l2); \
+      SF_OP(isa, V, bits) i23  = SF_BLEND2(isa, bits, color2, color3, h2, l2); \
+      SF_OP(isa, V, bits) i26  = SF_BLEND2(isa, bits, color2, color6, h2, l2); \
+      SF_OP(isa, V, bits) i53  = SF_BLEND2(isa, bits, color5, color3, h2, l2); \
+      \
+      /* Neither diagonal matches. */ \
+      product2b = SF_BLEND4(isa, bits, color3, color3, color3, i26, h4, l4); \
+      product1a = SF_BLEND4(isa, bits, color5, color5, color5, i26, h4, l4); \
+      product2a = SF_BLEND4(isa, bits, color2, color2, color2, i53, h4, l4); \
+      product1b = SF_BLEND4(isa, bits, color6, color6, color6, i53, h4, l4); \
+      \
+      /* Both diagonals match, supereagle_result() votes per lane. \
+       * Its 0/1 terms are -1/0 masks here, hence the reversed order. */ \
+      r = SF_OP(isa, ADD, bits)(SF_OP(isa, ADD, bits)( \
+               SUPEREAGLE_SIMD_VOTE(isa, bits, color6, color5, color1, colorA1), \
+               SUPEREAGLE_SIMD_VOTE(isa, bits, color6, color5, color4, colorB1)), \
+            SF_OP(isa, ADD, bits)( \
+               SUPEREAGLE_SIMD_VOTE(isa, bits, color6, color5, colorA2, colorS1), \
+               SUPEREAGLE_SIMD_VOTE(isa, bits, color6, color5, colorB2, colorS2))); \
+      m = SF_OP(isa, AND, bits)(eq26, eq53); \
+      product1a = SF_OP(isa, SEL, bits)(m, SF_OP(isa, SEL, bits)( \
+               SF_OP(isa, GTZ, bits)(r), i56, color5), product1a); \
+      product2b = SF_OP(isa, SEL, bits)(m, SF_OP(isa, SEL, bits)( \
+               SF_OP(isa, GTZ, bits)(r), i56, color5), product2b); \
+      product1b = SF_OP(isa, SEL, bits)(m, SF_OP(isa, SEL, bits)( \
+               SF_OP(isa, LTZ, bits)(r), i56, color2), product1b); \
+      product2a = SF_OP(isa, SEL, bits)(m, SF_OP(isa, SEL, bits)( \
+               SF_OP(isa, LTZ, bits)(r), i56, color2), product2a); \
+      \
+      /* color5 == color3 && color2 != color6 */ \
+      m = SF_OP(isa, ANDNOT, bits)(eq53, eq26); \
+      product1a = SF_OP(isa, SEL, bits)(m, color5, product1a); \
+      product2b = SF_OP(isa, SEL, bits)(m, color5, product2b); \
+      product1b = SF_OP(isa, SEL, bits)(m, SF_OP(isa, SEL, bits)( \
+               SF_OP(isa, OR, bits)( \
+                  SF_OP(isa, EQ, bits)(colorB1, color5), \
+                  SF_OP(isa, EQ, bits)(color3, colorS1)), \
+               SF_BLEND2(isa, bits, color5, i56, h2, l2), i56), product1b); \
+      product2a = SF_OP(isa, SEL, bits)(m, SF_OP(isa, SEL, bits)( \
+               SF_OP(isa, OR, bits)( \
+                  SF_OP(isa, EQ, bits)(color3, colorA2), \
+                  SF_OP(isa, EQ, bits)(color4, color5)), \
+               SF_BLEND2(isa, bits, color5, \
+                  SF_BLEND2(isa, bits, color5, color2, h2, l2), h2, l2), \
+               i23), product2a); \
+      \
+      /* color2 == color6 && color5 != color3 */ \
+      m = SF_OP(isa, ANDNOT, bits)(eq26, eq53); \
+      product1b = SF_OP(isa, SEL, bits)(m, color2, product1b); \
+      product2a = SF_OP(isa, SEL, bits)(m, color2, product2a); \
+      product1a = SF_OP(isa, SEL, bits)(m, SF_OP(isa, SEL, bits)( \
+               SF_OP(isa, OR, bits)( \
+                  SF_OP(isa, EQ, bits)(color1, color2), \
+                  SF_OP(isa, EQ, bits)(color6, colorB2)), \
+               SF_BLEND2(isa, bits, color2, \
+                  SF_BLEND2(isa, bits, color2, color5, h2, l2), h2, l2), \
+               i56), product1a); \
+      product2b = SF_OP(isa, SEL, bits)(m, SF_OP(isa, SEL, bits)( \
+               SF_OP(isa, OR, bits)( \
+                  SF_OP(isa, EQ, bits)(color6, colorS2), \
+                  SF_OP(isa, EQ, bits)(color2, colorA1)), \
+               SF_BLEND2(isa, bits, color2, i23, h2, l2), i23), product2b); \
+      \
+      SF_OP(isa, ZIP, bits)(product1a, product1b, lo, hi); \
+      SF_OP(isa, STORE, bits)(out + 2 * x, lo); \
+      SF_OP(isa, STORE, bits)(out + 2 * x + SF_OP(isa, LANES, bits), hi); \
+      SF_OP(isa, ZIP, bits)(product2a, product2b, lo, hi); \
+      SF_OP(isa, STORE, bits)(out + dst_stride + 2 * x, lo); \
+      SF_OP(isa, STORE, bits)(out + dst_stride + 2 * x \
+            + SF_OP(isa, LANES, bits), hi); \
+   } \
+   \
+   return x; \
+}
+
+/* supereagle_result(P, Q, Y, Z) as a lane value. */
+#define SUPEREAGLE_SIMD_VOTE(isa, bits, P, Q, Y, Z) \
+   SF_OP(isa, SUB, bits)( \
+         SF_OP(isa, AND, bits)(SF_OP(isa, EQ, bits)(P, Y), \
+            SF_OP(isa, EQ, bits)(P, Z)), \
+         SF_OP(isa, AND, bits)(SF_OP(isa, EQ, bits)(Q, Y), \
+            SF_OP(isa, EQ, bits)(Q, Z)))
+
+#ifdef SOFTFILTER_HAVE_SSE2
+SUPEREAGLE_SIMD(SSE2, 16, uint16_t, supereagle_row_rgb565_sse2, ,
+      0xF7DE, 0x0821, 0xE79C, 0x1863)
+SUPEREAGLE_SIMD(SSE2, 32, uint32_t, supereagle_row_xrgb8888_sse2, ,
+      0xFEFEFEFE, 0x01010101, 0xFCFCFCFC, 0x03030303)
+#endif
+#ifdef SOFTFILTER_HAVE_AVX2
+SUPEREAGLE_SIMD(AVX2, 16, uint16_t, supereagle_row_rgb565_avx2,
+      SOFTFILTER_AVX2_TARGET, 0xF7DE, 0x0821, 0xE79C, 0x1863)
+SUPEREAGLE_SIMD(AVX2, 32, uint32_t, supereagle_row_xrgb8888_avx2,
+      SOFTFILTER_AVX2_TARGET, 0xFEFEFEFE, 0x01010101, 0xFCFCFCFC, 0x03030303)
+#endif
+#ifdef SOFTFILTER_HAVE_NEON
+SUPEREAGLE_SIMD(NEON, 16, uint16_t, supereagle_row_rgb565_neon, ,
+      0xF7DE, 0x0821, 0xE79C, 0x1863)
+SUPEREAGLE_SIMD(NEON, 32, uint32_t, supereagle_row_xrgb8888_neon, ,
+      0xFEFEFEFE, 0x01010101, 0xFCFCFCFC, 0x03030303)
+#endif
+
 static void *supereagle_generic_create(const struct softfilter_config *config,
       unsigned in_fmt, unsigned out_fmt,
       unsigned max_width, unsigned max_height,
       unsigned threads, softfilter_simd_mask_t simd, void *userdata)
 {
-   (void)simd;
    (void)config;
    (void)userdata;
 
@@ -76,13 +224,37 @@ static void *supereagle_generic_create(const struct softfilter_config *config,
    if (!filt)
       return NULL;
    filt->workers = (struct softfilter_thread_data*)calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
       free(filt);
       return NULL;
    }
+
+   switch (softfilter_simd_kernel(simd))
+   {
+#ifdef SOFTFILTER_HAVE_AVX2
+      case SOFTFILTER_KERNEL_AVX2:
+         filt->row_rgb565   = supereagle_row_rgb565_avx2;
+         filt->row_xrgb8888 = supereagle_row_xrgb8888_avx2;
+         break;
+#endif
+#ifdef SOFTFILTER_HAVE_SSE2
+      case SOFTFILTER_KERNEL_SSE2:
+         filt->row_rgb565   = supereagle_row_rgb565_sse2;
+         filt->row_xrgb8888 = supereagle_row_xrgb8888_sse2;
+         break;
+#endif
+#ifdef SOFTFILTER_HAVE_NEON
+      case SOFTFILTER_KERNEL_NEON:
+         filt->row_rgb565   = supereagle_row_rgb565_neon;
+         filt->row_xrgb8888 = supereagle_row_xrgb8888_neon;
+         break;
+#endif
+      default:
+         break;
+   }
    return filt;
 }
 
@@ -114,10 +286,10 @@ static void supereagle_generic_destroy(void *data)
 
 #define supereagle_result(A, B, C, D) (((A) != (C) || (A) != (D)) - ((B) != (C) || (B) != (D)));
 
-#define supereagle_declare_variables(typename_t, in, nextline) \
+#define supereagle_declare_variables(typename_t, in, prevline, nextline, nextline2) \
          typename_t product1a, product1b, product2a, product2b; \
-         const typename_t colorB1 = *(in - nextline + 0); \
-         const typename_t colorB2 = *(in - nextline + 1); \
+         const typename_t colorB1 = *(in - prevline + 0); \
+         const typename_t colorB2 = *(in - prevline + 1); \
          const typename_t color4  = *(in - 1); \
          const typename_t color5  = *(in + 0); \
          const typename_t color6  = *(in + 1); \
@@ -126,8 +298,8 @@ static void supereagle_generic_destroy(void *data)
          const typename_t color2  = *(in + nextline + 0); \
          const typename_t color3  = *(in + nextline + 1); \
          const typename_t colorS1 = *(in + nextline + 2); \
-         const typename_t colorA1 = *(in + nextline + nextline + 0); \
-         const typename_t colorA2 = *(in + nextline + nextline + 1)
+         const typename_t colorA1 = *(in + nextline2 + 0); \
+         const typename_t colorA2 = *(in + nextline2 + 1)
 
 #ifndef supereagle_function
 #define supereagle_function(result_cb, interpolate_cb, interpolate2_cb) \
@@ -217,19 +389,33 @@ static void supereagle_generic_destroy(void *data)
 
 static void supereagle_generic_xrgb8888(unsigned width, unsigned height,
       int first, int last, uint32_t *src, 
-      unsigned src_stride, uint32_t *dst, unsigned dst_stride)
+      unsigned src_stride, uint32_t *dst, unsigned dst_stride,
+      supereagle_row_xrgb8888_t row)
 {
-   unsigned finish, nextline;
-   nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows past the image edges are clamped to the edge;
+       * rows past the band edges come from the neighbouring band. */
+      unsigned prevline  = (first && y < 1) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint32_t *in  = (uint32_t*)src;
       uint32_t *out = (uint32_t*)dst;
+      unsigned done = 0;
+
+      if (row)
+      {
+         done = row(in, prevline, nextline, nextline2, out, dst_stride, width);
+         in  += done;
+         out += 2 * done;
+      }
 
-      for (finish = width; finish; finish -= 1)
+      for (finish = width - done; finish; finish -= 1)
       {
-         supereagle_declare_variables(uint32_t, in, nextline);
+         supereagle_declare_variables(uint32_t, in, prevline, nextline, nextline2);
 
          supereagle_function(supereagle_result, supereagle_interpolate_xrgb8888, supereagle_interpolate2_xrgb8888);
       }
@@ -241,19 +427,33 @@ static void supereagle_generic_xrgb8888(unsigned width, unsigned height,
 
 static void supereagle_generic_rgb565(unsigned width, unsigned height,
       int first, int last, uint16_t *src, 
-      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride,
+      supereagle_row_rgb565_t row)
 {
-   unsigned nextline, finish;
-   nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Rows past the image edges are clamped to the edge;
+       * rows past the band edges come from the neighbouring band. */
+      unsigned prevline  = (first && y < 1) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint16_t *in  = (uint16_t*)src;
       uint16_t *out = (uint16_t*)dst;
+      unsigned done = 0;
+
+      if (row)
+      {
+         done = row(in, prevline, nextline, nextline2, out, dst_stride, width);
+         in  += done;
+         out += 2 * done;
+      }
 
-      for (finish = width; finish; finish -= 1)
+      for (finish = width - done; finish; finish -= 1)
       {
-         supereagle_declare_variables(uint16_t, in, nextline);
+         supereagle_declare_variables(uint16_t, in, prevline, nextline, nextline2);
 
          supereagle_function(supereagle_result, supereagle_interpolate_rgb565, supereagle_interpolate2_rgb565);
       }
@@ -265,6 +465,7 @@ static void supereagle_generic_rgb565(unsigned width, unsigned height,
 
 static void supereagle_work_cb_rgb565(void *data, void *thread_data)
 {
+   struct filter_data *filt = (struct filter_data*)data;
    struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
    uint16_t *input = (uint16_t*)thr->in_data;
    uint16_t *output = (uint16_t*)thr->out_data;
@@ -272,11 +473,13 @@ static void supereagle_work_cb_rgb565(void *data, void *thread_data)
    unsigned height = thr->height;
 
    supereagle_generic_rgb565(width, height,
-         thr->first, thr->last, input, thr->in_pitch / SOFTFILTER_BPP_RGB565, output, thr->out_pitch / SOFTFILTER_BPP_RGB565);
+         thr->first, thr->last, input, thr->in_pitch / SOFTFILTER_BPP_RGB565, output, thr->out_pitch / SOFTFILTER_BPP_RGB565,
+         filt->row_rgb565);
 }
 
 static void supereagle_work_cb_xrgb8888(void *data, void *thread_data)
 {
+   struct filter_data *filt = (struct filter_data*)data;
    struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
    uint32_t *input = (uint32_t*)thr->in_data;
    uint32_t *output = (uint32_t*)thr->out_data;
@@ -284,7 +487,8 @@ static void supereagle_work_cb_xrgb8888(void *data, void *thread_data)
    unsigned height = thr->height;
 
    supereagle_generic_xrgb8888(width, height,
-         thr->first, thr->last, input, thr->in_pitch / SOFTFILTER_BPP_XRGB8888, output, thr->out_pitch / SOFTFILTER_BPP_XRGB8888);
+         thr->first, thr->last, input, thr->in_pitch / SOFTFILTER_BPP_XRGB8888, output, thr->out_pitch / SOFTFILTER_BPP_XRGB8888,
+         filt->row_xrgb8888);
 }
 
 static void supereagle_generic_packets(void *data,
@@ -294,12 +498,23 @@ static void supereagle_generic_packets(void *data,
 {
    struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   /* Bands are at least SUPEREAGLE_MIN_BAND rows tall, so that
+    * 'first' and 'last' are all a kernel needs to clamp its reads
+    * to the image. Other rows it reads outside its band belong to
+    * the neighbouring bands. Leftover threads get empty bands. */
+   unsigned bands = height / SUPEREAGLE_MIN_BAND;
+
+   if (bands > filt->threads)
+      bands = filt->threads;
+   if (!bands)
+      bands = 1;
+
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = i < bands ? (height * i) / bands : height;
+      unsigned y_end   = i < bands ? (height * (i + 1)) / bands : height;
       thr->out_data = (uint8_t*)output + y_start * SUPEREAGLE_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
       thr->out_pitch = output_stride;
@@ -308,7 +523,7 @@ static void supereagle_generic_packets(void *data,
       thr->height = y_end - y_start;
 
       // Workers need to know if they can access pixels outside their given buffer.
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
@@ -0,0 +1,196 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Throughput of every bundled softfilter, for each pixel format and
+ * each SIMD kernel this CPU can run.
+ *
+ * Usage: bench [-t threads,...] [filter]
+ *
+ * By default everything runs on one thread. With -t, each kernel is
+ * also run with the work packets spread over the given numbers of
+ * threads, through a thread pool the way video_filter.c does it.
+ *
+ * Two inputs are used: 'noise' is every pixel picked at random from a
+ * small palette, 'tiles' is flat 8x8 blocks with a little noise, which
+ * is closer to what a game frame looks like. Speed is reported in
+ * input megapixels per second. Filters without vector kernels run
+ * their C path whatever the ISA, which shows how noisy the numbers are.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "softfilter_simd.h"
+
+#define BENCH_WIDTH  320
+#define BENCH_HEIGHT 240
+#define BENCH_TIME   0.1
+#define BENCH_RUNS   5
+
+static rpool_t *pool;
+
+/* Copies the top-left pixel of each 8x8 block over the rest of it,
+ * leaving one pixel in 32 as it was. */
+static void bench_tile_frame(uint8_t *buf, size_t stride,
+      unsigned width, unsigned height, unsigned bpp)
+{
+   unsigned x, y;
+
+   for (y = 0; y < height; y++)
+      for (x = 0; x < width; x++)
+      {
+         if (((x * 7 + y * 13) & 31) == 0)
+            continue;
+         memmove(buf + y * stride + x * bpp,
+               buf + (y & ~7u) * stride + (x & ~7u) * bpp, bpp);
+      }
+}
+
+static double bench_run(const struct softfilter_implementation *impl,
+      unsigned fmt, unsigned threads, softfilter_simd_mask_t simd,
+      const uint8_t *in, size_t in_stride)
+{
+   unsigned run;
+   struct test_filter filt;
+   double best = 0.0;
+
+   if (!test_filter_init(&filt, impl, fmt, threads, simd,
+            BENCH_WIDTH, BENCH_HEIGHT))
+      return 0.0;
+
+   /* Warm up the caches and branch predictors. */
+   test_filter_run(&filt, pool, in, BENCH_WIDTH, BENCH_HEIGHT, in_stride);
+
+   /* Best of a few short runs, to ride out other load on the machine. */
+   for (run = 0; run < BENCH_RUNS; run++)
+   {
+      double mpix;
+      unsigned frames = 0;
+      double start    = test_time();
+      double elapsed;
+
+      do
+      {
+         test_filter_run(&filt, pool, in,
+               BENCH_WIDTH, BENCH_HEIGHT, in_stride);
+         frames++;
+         elapsed = test_time() - start;
+      } while (elapsed < BENCH_TIME);
+
+      mpix = (double)frames * BENCH_WIDTH * BENCH_HEIGHT
+         / elapsed / 1000000.0;
+      if (mpix > best)
+         best = mpix;
+   }
+
+   test_filter_free(&filt);
+   return best;
+}
+
+int main(int argc, char *argv[])
+{
+   int opt;
+   unsigned f, k, t, fmt, content;
+   softfilter_simd_mask_t masks[4];
+   unsigned threads[TEST_MAX_THREADS] = { 1 };
+   unsigned num_threads               = 1;
+   unsigned max_threads               = 1;
+   const char *only                   = NULL;
+   unsigned num_simd                  = test_simd_masks(masks, 4);
+
+   while ((opt = getopt(argc, argv, "t:")) != -1)
+   {
+      switch (opt)
+      {
+         case 't':
+            num_threads = test_parse_threads(optarg, threads);
+            if (num_threads)
+               break;
+            /* fallthrough */
+         default:
+            fprintf(stderr, "Usage: bench [-t threads,...] [filter]\n");
+            return 1;
+      }
+   }
+
+   if (optind < argc)
+      only = argv[optind];
+
+   for (t = 0; t < num_threads; t++)
+      if (threads[t] > max_threads)
+         max_threads = threads[t];
+   if (max_threads > 1)
+      pool = rpool_new(max_threads - 1);
+
+   printf("%-16s %-9s %-6s %-5s %3s %10s %8s\n",
+         "filter", "format", "input", "isa", "thr", "MPix/s", "vs C");
+
+   for (f = 0; f < test_num_filters; f++)
+   {
+      const struct softfilter_implementation *impl = test_filters[f](0);
+
+      if (only && strcmp(only, impl->short_ident))
+         continue;
+
+      for (fmt = SOFTFILTER_FMT_RGB565; fmt <= SOFTFILTER_FMT_XRGB8888;
+            fmt <<= 1)
+      {
+         unsigned bpp = test_fmt_bpp(fmt);
+
+         if (!(impl->query_input_formats() & fmt))
+            continue;
+
+         for (content = 0; content < 2; content++)
+         {
+            double base      = 0.0;
+            size_t in_stride = (BENCH_WIDTH + PAD_COLS) * bpp;
+            size_t in_size   = in_stride * (BENCH_HEIGHT + 2 * PAD_ROWS);
+            uint8_t *in_buf  = (uint8_t*)malloc(in_size);
+            const uint8_t *in = in_buf + PAD_ROWS * in_stride
+               + PAD_COLS / 2 * bpp;
+
+            test_fill_frame(in_buf, in_size, bpp);
+            if (content)
+               bench_tile_frame(in_buf, in_stride, BENCH_WIDTH + PAD_COLS,
+                     BENCH_HEIGHT + 2 * PAD_ROWS, bpp);
+
+            for (k = 0; k < num_simd; k++)
+               for (t = 0; t < num_threads; t++)
+               {
+                  double mpix = bench_run(impl, fmt, threads[t], masks[k],
+                        in, in_stride);
+
+                  if (!k && !t)
+                     base = mpix;
+
+                  printf("%-16s %-9s %-6s %-5s %3u %10.1f %7.2fx\n",
+                        impl->short_ident, test_fmt_name(fmt),
+                        content ? "tiles" : "noise",
+                        softfilter_simd_kernel_name(
+                           softfilter_simd_kernel(masks[k])),
+                        threads[t], mpix, base > 0.0 ? mpix / base : 0.0);
+               }
+
+            free(in_buf);
+         }
+      }
+   }
+
+   rpool_free(pool);
+   return 0;
+}
@@ -0,0 +1,254 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+
+extern const struct softfilter_implementation *blargg_ntsc_snes_get_implementation(softfilter_simd_mask_t simd);
+extern const struct softfilter_implementation *lq2x_get_implementation(softfilter_simd_mask_t simd);
+extern const struct softfilter_implementation *phosphor2x_get_implementation(softfilter_simd_mask_t simd);
+extern const struct softfilter_implementation *twoxbr_get_implementation(softfilter_simd_mask_t simd);
+extern const struct softfilter_implementation *epx_get_implementation(softfilter_simd_mask_t simd);
+extern const struct softfilter_implementation *twoxsai_get_implementation(softfilter_simd_mask_t simd);
+extern const struct softfilter_implementation *supereagle_get_implementation(softfilter_simd_mask_t simd);
+extern const struct softfilter_implementation *supertwoxsai_get_implementation(softfilter_simd_mask_t simd);
+extern const struct softfilter_implementation *darken_get_implementation(softfilter_simd_mask_t simd);
+extern const struct softfilter_implementation *scale2x_get_implementation(softfilter_simd_mask_t simd);
+
+const softfilter_get_implementation_t test_filters[] = {
+   blargg_ntsc_snes_get_implementation,
+   lq2x_get_implementation,
+   phosphor2x_get_implementation,
+   twoxbr_get_implementation,
+   darken_get_implementation,
+   twoxsai_get_implementation,
+   supertwoxsai_get_implementation,
+   supereagle_get_implementation,
+   epx_get_implementation,
+   scale2x_get_implementation,
+};
+
+const unsigned test_num_filters = sizeof(test_filters) / sizeof(test_filters[0]);
+
+unsigned test_simd_masks(softfilter_simd_mask_t *masks, unsigned max)
+{
+   unsigned n = 0;
+
+   masks[n++] = 0;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+   __builtin_cpu_init();
+   if (n < max && __builtin_cpu_supports("sse2"))
+      masks[n++] = SOFTFILTER_SIMD_SSE2;
+   if (n < max && __builtin_cpu_supports("avx2"))
+      masks[n++] = SOFTFILTER_SIMD_SSE2
+         | SOFTFILTER_SIMD_AVX | SOFTFILTER_SIMD_AVX2;
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   if (n < max)
+      masks[n++] = SOFTFILTER_SIMD_NEON;
+#endif
+
+   return n;
+}
+
+double test_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+unsigned test_cpu_cores(void)
+{
+   long ret = sysconf(_SC_NPROCESSORS_ONLN);
+   return ret > 0 ? (unsigned)ret : 1;
+}
+
+unsigned test_parse_threads(const char *arg, unsigned *threads)
+{
+   unsigned n = 0;
+   char *end;
+
+   if (!arg)
+   {
+      unsigned t, cores = test_cpu_cores();
+
+      threads[n++] = 1;
+      for (t = 2; t < cores && t <= 8; t *= 2)
+         threads[n++] = t;
+      if (cores > 1)
+         threads[n++] = cores < TEST_MAX_THREADS ? cores : TEST_MAX_THREADS;
+      return n;
+   }
+
+   while (*arg && n < TEST_MAX_THREADS)
+   {
+      unsigned long t = strtoul(arg, &end, 10);
+
+      if (end == arg || !t || t > TEST_MAX_THREADS)
+         return 0;
+      threads[n++] = t;
+      arg = *end == ',' ? end + 1 : end;
+   }
+
+   return n;
+}
+
+const char *test_fmt_name(unsigned fmt)
+{
+   return fmt == SOFTFILTER_FMT_RGB565 ? "RGB565" : "XRGB8888";
+}
+
+unsigned test_fmt_bpp(unsigned fmt)
+{
+   return fmt == SOFTFILTER_FMT_RGB565
+      ? SOFTFILTER_BPP_RGB565 : SOFTFILTER_BPP_XRGB8888;
+}
+
+static int config_get_float(void *userdata, const char *key,
+      float *value, float default_value)
+{
+   *value = default_value;
+   return 0;
+}
+
+static int config_get_int(void *userdata, const char *key,
+      int *value, int default_value)
+{
+   *value = default_value;
+   return 0;
+}
+
+static int config_get_string(void *userdata, const char *key,
+      char **output, const char *default_output)
+{
+   *output = strdup(default_output);
+   return 0;
+}
+
+static const struct softfilter_config config = {
+   config_get_float,
+   config_get_int,
+   NULL,
+   NULL,
+   config_get_string,
+   free,
+};
+
+static uint32_t rand_state = 1;
+
+static uint32_t rand_next(void)
+{
+   rand_state = rand_state * 1103515245 + 12345;
+   return rand_state >> 8;
+}
+
+void test_fill_frame(uint8_t *buf, size_t size, unsigned bpp)
+{
+   static const uint32_t palette[] = {
+      0x00000000, 0x00ffffff, 0x00ff0000, 0x0000ff00,
+      0x000000ff, 0x00808080, 0x00f0c020, 0x00102030,
+   };
+   size_t i;
+
+   rand_state = 1 + size;
+
+   for (i = 0; i < size / bpp; i++)
+   {
+      uint32_t color = palette[rand_next() & 7];
+
+      if (rand_next() % 16 == 0)
+         color = rand_next();
+
+      if (bpp == SOFTFILTER_BPP_RGB565)
+      {
+         uint16_t c = ((color >> 8) & 0xf800)
+            | ((color >> 5) & 0x07e0) | ((color >> 3) & 0x001f);
+         memcpy(buf + i * bpp, &c, sizeof(c));
+      }
+      else
+         memcpy(buf + i * bpp, &color, sizeof(color));
+   }
+}
+
+bool test_filter_init(struct test_filter *filt,
+      const struct softfilter_implementation *impl,
+      unsigned fmt, unsigned threads, softfilter_simd_mask_t simd,
+      unsigned width, unsigned height)
+{
+   unsigned out_width, out_height;
+
+   memset(filt, 0, sizeof(*filt));
+   filt->impl = impl;
+   filt->data = impl->create(&config, fmt, fmt, width, height,
+         threads, simd, NULL);
+   if (!filt->data)
+      return false;
+
+   filt->threads = impl->query_num_threads(filt->data);
+   if (filt->threads != threads)
+   {
+      fprintf(stderr, "%s: asked for %u threads, got %u.\n",
+            impl->short_ident, threads, filt->threads);
+      test_filter_free(filt);
+      return false;
+   }
+
+   impl->query_output_size(filt->data, &out_width, &out_height,
+         width, height);
+   filt->out_stride = out_width * test_fmt_bpp(fmt);
+   filt->out_size   = filt->out_stride * out_height;
+   filt->output     = (uint8_t*)calloc(1, filt->out_size);
+   filt->packets    = (struct softfilter_work_packet*)
+      calloc(filt->threads, sizeof(*filt->packets));
+
+   if (!filt->output || !filt->packets)
+   {
+      test_filter_free(filt);
+      return false;
+   }
+
+   return true;
+}
+
+static void filter_work(void *data, unsigned index)
+{
+   struct test_filter *filt = (struct test_filter*)data;
+   filt->packets[index].work(filt->data, filt->packets[index].thread_data);
+}
+
+void test_filter_run(struct test_filter *filt, rpool_t *pool,
+      const uint8_t *input, unsigned width, unsigned height,
+      size_t in_stride)
+{
+   filt->impl->get_work_packets(filt->data, filt->packets,
+         filt->output, filt->out_stride,
+         input, width, height, in_stride);
+   rpool_parallel_for(pool, filt->threads, filter_work, filt);
+}
+
+void test_filter_free(struct test_filter *filt)
+{
+   if (filt->data)
+      filt->impl->destroy(filt->data);
+   free(filt->packets);
+   free(filt->output);
+   memset(filt, 0, sizeof(*filt));
+}
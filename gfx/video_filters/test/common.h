@@ -0,0 +1,80 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOFTFILTER_TEST_COMMON_H__
+#define SOFTFILTER_TEST_COMMON_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <boolean.h>
+#include <rthreads/rpool.h>
+
+#include "softfilter.h"
+
+#define PAD_ROWS 4
+#define PAD_COLS 8
+
+#define TEST_MAX_THREADS 16
+
+extern const softfilter_get_implementation_t test_filters[];
+extern const unsigned test_num_filters;
+
+/* SIMD masks this CPU can run, one per kernel, C first. */
+unsigned test_simd_masks(softfilter_simd_mask_t *masks, unsigned max);
+
+unsigned test_cpu_cores(void);
+
+/* Monotonic time in seconds. */
+double test_time(void);
+
+/* Parses a comma-separated list of thread counts into 'threads',
+ * or picks 1, 2, 4, 8 and the number of cores up to that if 'arg' is
+ * NULL. Returns how many there are, or 0 if 'arg' is malformed. */
+unsigned test_parse_threads(const char *arg, unsigned *threads);
+
+const char *test_fmt_name(unsigned fmt);
+
+unsigned test_fmt_bpp(unsigned fmt);
+
+/* Fills a whole padded frame from a small palette, so that the
+ * pattern-matching filters actually take their interesting branches.
+ * Frames of the same size are always the same. */
+void test_fill_frame(uint8_t *buf, size_t size, unsigned bpp);
+
+struct test_filter
+{
+   const struct softfilter_implementation *impl;
+   void *data;
+   unsigned threads;
+   struct softfilter_work_packet *packets;
+   uint8_t *output;
+   size_t out_stride;
+   size_t out_size;
+};
+
+bool test_filter_init(struct test_filter *filt,
+      const struct softfilter_implementation *impl,
+      unsigned fmt, unsigned threads, softfilter_simd_mask_t simd,
+      unsigned width, unsigned height);
+
+/* Runs one frame, with the packets spread over 'pool'
+ * like video_filter.c does. */
+void test_filter_run(struct test_filter *filt, rpool_t *pool,
+      const uint8_t *input, unsigned width, unsigned height,
+      size_t in_stride);
+
+void test_filter_free(struct test_filter *filt);
+
+#endif
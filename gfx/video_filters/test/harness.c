@@ -0,0 +1,461 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Runs softfilter presets through rarch_softfilter_new() the same way
+ * the frontend does, times them and checks their output against golden
+ * hashes.
+ *
+ * Usage: harness [-u] [-q] [-c] [-v] [-g golden] [-t threads,...]
+ *                [-n frames] [preset.filt ...]
+ *
+ * With no presets, every .filt in the parent directory is run. Each
+ * preset is tried with RGB565 and XRGB8888 input at a few sizes, on
+ * frames from test_fill_frame(). For every thread count the harness
+ * reports throughput in input megapixels per second, p50 and p99 frame
+ * times over 'frames' frames (60 by default), and the speedup over the
+ * first thread count. bench times the bare kernels instead; this is
+ * what the frontend actually pays, thread pool and all.
+ *
+ * The CRC32 of the output frame is checked against the golden file,
+ * and must also be the same for every thread count. Formats a preset
+ * refuses are recorded as '-' in the golden file.
+ *
+ *  -u  Write the hashes of this run to the golden file instead.
+ *  -q  Only check hashes, don't time anything.
+ *  -c  Hide all SIMD features from the filters.
+ *  -v  Show the frontend log.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <file/dir_list.h>
+#include <file/file_path.h>
+#include <string/string_list.h>
+#include <rthreads/rpool.h>
+#include <rhash.h>
+#include <compat/strl.h>
+
+#include "video_filter.h"
+#include "common.h"
+
+#define HARNESS_MAX_GOLDEN 512
+
+static const unsigned corpus_sizes[][2] = {
+   { 256, 224 },
+   { 320, 240 },
+   { 512, 448 },
+   { 640, 480 },
+};
+
+static const enum retro_pixel_format corpus_formats[] = {
+   RETRO_PIXEL_FORMAT_RGB565,
+   RETRO_PIXEL_FORMAT_XRGB8888,
+};
+
+struct golden_entry
+{
+   char key[128];
+   char hash[16];
+};
+
+static struct golden_entry golden[HARNESS_MAX_GOLDEN];
+static unsigned num_golden;
+
+static rpool_t *pool;
+static bool verbose;
+static bool c_only;
+
+/* The parts of the frontend video_filter.c depends on. */
+
+bool rarch_main_verbosity(void)
+{
+   return verbose;
+}
+
+unsigned rarch_get_cpu_cores(void)
+{
+   return test_cpu_cores();
+}
+
+/* The widest kernel this CPU can run. */
+uint64_t rarch_get_cpu_features(void)
+{
+   softfilter_simd_mask_t masks[4];
+   unsigned num_simd = test_simd_masks(masks, 4);
+
+   return c_only ? 0 : masks[num_simd - 1];
+}
+
+rpool_t *rarch_get_thread_pool(void)
+{
+   return pool;
+}
+
+/* The softfilter test helpers use SOFTFILTER_FMT_*. */
+static unsigned harness_fmt(enum retro_pixel_format fmt)
+{
+   return fmt == RETRO_PIXEL_FORMAT_RGB565
+      ? SOFTFILTER_FMT_RGB565 : SOFTFILTER_FMT_XRGB8888;
+}
+
+/* Hashes only the visible part of each row. */
+static uint32_t frame_crc32(const uint8_t *frame, size_t stride,
+      unsigned width, unsigned height, unsigned bpp)
+{
+   unsigned x, y;
+   uint32_t crc = 0xffffffff;
+
+   for (y = 0; y < height; y++)
+      for (x = 0; x < width * bpp; x++)
+         crc = crc32_adjust(crc, frame[y * stride + x]);
+
+   return ~crc;
+}
+
+static struct golden_entry *golden_find(const char *key, bool create)
+{
+   unsigned i;
+
+   for (i = 0; i < num_golden; i++)
+      if (!strcmp(golden[i].key, key))
+         return &golden[i];
+
+   if (!create || num_golden >= HARNESS_MAX_GOLDEN)
+      return NULL;
+
+   memset(&golden[num_golden], 0, sizeof(golden[0]));
+   strlcpy(golden[num_golden].key, key, sizeof(golden[0].key));
+   return &golden[num_golden++];
+}
+
+static void golden_load(const char *path)
+{
+   char line[256];
+   FILE *file = fopen(path, "r");
+
+   if (!file)
+      return;
+
+   while (fgets(line, sizeof(line), file))
+   {
+      char name[64], fmt[16], size[16], hash[16];
+      char key[128];
+      struct golden_entry *entry;
+
+      if (line[0] == '#'
+            || sscanf(line, "%63s %15s %15s %15s", name, fmt, size, hash) != 4)
+         continue;
+
+      snprintf(key, sizeof(key), "%s %s %s", name, fmt, size);
+      entry = golden_find(key, true);
+      if (entry)
+         strlcpy(entry->hash, hash, sizeof(entry->hash));
+   }
+
+   fclose(file);
+}
+
+static bool golden_save(const char *path)
+{
+   unsigned i;
+   FILE *file = fopen(path, "w");
+
+   if (!file)
+      return false;
+
+   fprintf(file, "# Softfilter output CRC32s, written by 'harness -u'.\n");
+   fprintf(file, "# preset format size crc32 ('-' if the format is refused)\n");
+   for (i = 0; i < num_golden; i++)
+      fprintf(file, "%s %s\n", golden[i].key, golden[i].hash);
+
+   fclose(file);
+   return true;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+   double x = *(const double*)a;
+   double y = *(const double*)b;
+   return x < y ? -1 : x > y;
+}
+
+/* Creates the filter through the frontend, hashes the first frame and
+ * times 'frames' more. Returns false if the preset refuses the input
+ * format. */
+static bool harness_run(const char *preset, unsigned threads,
+      enum retro_pixel_format fmt,
+      const uint8_t *in, size_t in_stride, unsigned width, unsigned height,
+      unsigned frames, double *times, char *hash, size_t hash_size)
+{
+   unsigned i, out_width = 0, out_height = 0, out_bpp;
+   size_t out_stride;
+   uint8_t *out;
+   rarch_softfilter_t *filt = rarch_softfilter_new(preset, threads,
+         fmt, width, height);
+
+   if (!filt)
+      return false;
+
+   rarch_softfilter_get_output_size(filt, &out_width, &out_height,
+         width, height);
+   out_bpp    = test_fmt_bpp(harness_fmt(
+            rarch_softfilter_get_output_format(filt)));
+   out_stride = out_width * out_bpp;
+   out        = (uint8_t*)calloc(out_height, out_stride);
+
+   /* The first frame also warms up the caches. */
+   rarch_softfilter_process(filt, out, out_stride,
+         in, width, height, in_stride);
+   snprintf(hash, hash_size, "%08x",
+         (unsigned)frame_crc32(out, out_stride, out_width, out_height,
+            out_bpp));
+
+   for (i = 0; i < frames; i++)
+   {
+      double start = test_time();
+      rarch_softfilter_process(filt, out, out_stride,
+            in, width, height, in_stride);
+      times[i] = test_time() - start;
+   }
+
+   free(out);
+   rarch_softfilter_free(filt);
+   return true;
+}
+
+static void usage(void)
+{
+   fprintf(stderr, "Usage: harness [-u] [-q] [-c] [-v] [-g golden] "
+         "[-t threads,...] [-n frames] [preset.filt ...]\n");
+}
+
+int main(int argc, char *argv[])
+{
+   int opt;
+   unsigned p, s, f, t;
+   unsigned threads[TEST_MAX_THREADS];
+   unsigned num_threads         = 0;
+   unsigned frames              = 60;
+   unsigned failed = 0, checked = 0;
+   double *times                = NULL;
+   const char *golden_path      = "golden.txt";
+   const char *threads_arg      = NULL;
+   bool update                  = false;
+   bool quick                   = false;
+   struct string_list *presets  = NULL;
+
+   while ((opt = getopt(argc, argv, "uqcvg:t:n:")) != -1)
+   {
+      switch (opt)
+      {
+         case 'u':
+            update = true;
+            break;
+         case 'q':
+            quick = true;
+            break;
+         case 'c':
+            c_only = true;
+            break;
+         case 'v':
+            verbose = true;
+            break;
+         case 'g':
+            golden_path = optarg;
+            break;
+         case 't':
+            threads_arg = optarg;
+            break;
+         case 'n':
+            frames = strtoul(optarg, NULL, 10);
+            break;
+         default:
+            usage();
+            return 1;
+      }
+   }
+
+   num_threads = test_parse_threads(threads_arg, threads);
+   if (!num_threads)
+   {
+      usage();
+      return 1;
+   }
+
+   if (optind < argc)
+   {
+      union string_list_elem_attr attr;
+
+      attr.i  = 0;
+      presets = string_list_new();
+      for (; optind < argc; optind++)
+         string_list_append(presets, argv[optind], attr);
+   }
+   else
+   {
+      presets = dir_list_new("..", "filt", false);
+      if (presets)
+         dir_list_sort(presets, false);
+   }
+
+   if (!presets || !presets->size)
+   {
+      fprintf(stderr, "No softfilter presets found.\n");
+      return 1;
+   }
+
+   golden_load(golden_path);
+
+   /* One worker for every core but this one, like the frontend. */
+   pool  = rpool_new(test_cpu_cores() - 1);
+   frames = quick ? 0 : frames;
+   times  = (double*)calloc(frames ? frames : 1, sizeof(*times));
+
+   if (frames)
+      printf("%-32s %-8s %-7s %3s %9s %8s %8s %6s  %s\n",
+            "preset", "format", "size", "thr",
+            "MPix/s", "p50 ms", "p99 ms", "scale", "crc32");
+
+   for (p = 0; p < presets->size; p++)
+   {
+      const char *preset = presets->elems[p].data;
+      const char *name   = path_basename(preset);
+
+      for (f = 0; f < sizeof(corpus_formats) / sizeof(corpus_formats[0]); f++)
+      {
+         enum retro_pixel_format fmt = corpus_formats[f];
+         const char *fmt_name        = test_fmt_name(harness_fmt(fmt));
+         unsigned bpp                = test_fmt_bpp(harness_fmt(fmt));
+
+         for (s = 0; s < sizeof(corpus_sizes) / sizeof(corpus_sizes[0]); s++)
+         {
+            char key[128];
+            char hash[16]               = "-";
+            double base                 = 0.0;
+            bool ok                     = true;
+            unsigned width              = corpus_sizes[s][0];
+            unsigned height             = corpus_sizes[s][1];
+            size_t in_stride            = (width + PAD_COLS) * bpp;
+            size_t in_size              = in_stride * (height + 2 * PAD_ROWS);
+            uint8_t *in_buf             = (uint8_t*)malloc(in_size);
+            const uint8_t *in           = in_buf + PAD_ROWS * in_stride
+               + PAD_COLS / 2 * bpp;
+            struct golden_entry *entry;
+
+            test_fill_frame(in_buf, in_size, bpp);
+
+            for (t = 0; t < num_threads; t++)
+            {
+               char run_hash[16] = "-";
+               double mpix, total = 0.0;
+               unsigned i;
+
+               if (!harness_run(preset, threads[t], fmt, in, in_stride,
+                        width, height, frames, times,
+                        run_hash, sizeof(run_hash)))
+               {
+                  /* Refusing the format is fine, as long as every
+                   * thread count agrees on it. */
+                  if (t > 0)
+                  {
+                     fprintf(stderr, "FAIL: %s, %s, %ux%u: could not "
+                           "create with %u threads.\n", name,
+                           fmt_name, width, height, threads[t]);
+                     ok = false;
+                  }
+                  break;
+               }
+
+               if (t == 0)
+                  strlcpy(hash, run_hash, sizeof(hash));
+               else if (strcmp(hash, run_hash))
+               {
+                  fprintf(stderr, "FAIL: %s, %s, %ux%u: %u threads gave %s, "
+                        "%u gave %s.\n", name, fmt_name,
+                        width, height, threads[0], hash,
+                        threads[t], run_hash);
+                  ok = false;
+               }
+
+               if (!frames)
+                  continue;
+
+               for (i = 0; i < frames; i++)
+                  total += times[i];
+               qsort(times, frames, sizeof(*times), compare_double);
+
+               mpix = (double)frames * width * height / total / 1000000.0;
+               if (t == 0)
+                  base = mpix;
+
+               printf("%-32s %-8s %3ux%-3u %3u %9.1f %8.3f %8.3f %5.2fx  %s\n",
+                     name, fmt_name, width, height, threads[t],
+                     mpix, times[frames / 2] * 1000.0,
+                     times[(frames * 99) / 100] * 1000.0,
+                     mpix / base, run_hash);
+            }
+
+            free(in_buf);
+
+            snprintf(key, sizeof(key), "%s %s %ux%u",
+                  name, fmt_name, width, height);
+            entry = golden_find(key, update);
+            checked++;
+
+            if (update)
+            {
+               if (entry)
+                  strlcpy(entry->hash, hash, sizeof(entry->hash));
+            }
+            else if (!entry)
+            {
+               fprintf(stderr, "FAIL: %s: no golden hash.\n", key);
+               ok = false;
+            }
+            else if (strcmp(entry->hash, hash))
+            {
+               fprintf(stderr, "FAIL: %s: got %s, golden is %s.\n",
+                     key, hash, entry->hash);
+               ok = false;
+            }
+
+            if (!ok)
+               failed++;
+         }
+      }
+   }
+
+   if (update)
+   {
+      if (!golden_save(golden_path))
+      {
+         fprintf(stderr, "Could not write %s.\n", golden_path);
+         failed++;
+      }
+      else
+         printf("Wrote %u hashes to %s.\n", num_golden, golden_path);
+   }
+   else
+      printf("%u/%u preset outputs matched %s.\n",
+            checked - failed, checked, golden_path);
+
+   free(times);
+   rpool_free(pool);
+   string_list_free(presets);
+   return failed ? 1 : 0;
+}
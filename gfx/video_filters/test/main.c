@@ -0,0 +1,137 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that every bundled softfilter gives bit-identical output
+ * no matter how many threads it is split across, and that the SIMD
+ * kernels match the C ones.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "softfilter_simd.h"
+
+static const unsigned thread_counts[] = { 2, 3, 4, 7, 16 };
+
+static const unsigned sizes[][2] = {
+   { 256, 224 },
+   { 320, 240 },
+   { 61,  17  },
+   { 8,   3   },
+   { 5,   1   },
+};
+
+static rpool_t *pool;
+
+static bool check_run(const struct softfilter_implementation *impl,
+      unsigned fmt, unsigned threads, softfilter_simd_mask_t simd,
+      const uint8_t *in, unsigned width, unsigned height, size_t in_stride,
+      const struct test_filter *ref)
+{
+   struct test_filter filt;
+   bool ok;
+
+   if (!test_filter_init(&filt, impl, fmt, threads, simd, width, height))
+      return false;
+
+   test_filter_run(&filt, pool, in, width, height, in_stride);
+   ok = filt.out_size == ref->out_size
+      && !memcmp(filt.output, ref->output, ref->out_size);
+
+   if (!ok)
+      fprintf(stderr, "FAIL: %s, %s, %s, %ux%u, %u threads.\n",
+            impl->short_ident, test_fmt_name(fmt),
+            softfilter_simd_kernel_name(softfilter_simd_kernel(simd)),
+            width, height, threads);
+
+   test_filter_free(&filt);
+   return ok;
+}
+
+int main(void)
+{
+   unsigned f, s, t, k, fmt;
+   softfilter_simd_mask_t masks[4];
+   unsigned failed   = 0, run = 0;
+   unsigned num_simd = test_simd_masks(masks, 4);
+
+   pool = rpool_new(3);
+
+   for (f = 0; f < test_num_filters; f++)
+   {
+      const struct softfilter_implementation *impl = test_filters[f](0);
+
+      for (fmt = SOFTFILTER_FMT_RGB565; fmt <= SOFTFILTER_FMT_XRGB8888;
+            fmt <<= 1)
+      {
+         unsigned bpp = test_fmt_bpp(fmt);
+
+         if (!(impl->query_input_formats() & fmt))
+            continue;
+
+         for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+         {
+            struct test_filter ref;
+            unsigned width     = sizes[s][0];
+            unsigned height    = sizes[s][1];
+            size_t in_stride   = (width + PAD_COLS) * bpp;
+            size_t in_size     = in_stride * (height + 2 * PAD_ROWS);
+            uint8_t *in_buf    = (uint8_t*)malloc(in_size);
+            const uint8_t *in  = in_buf + PAD_ROWS * in_stride
+               + PAD_COLS / 2 * bpp;
+
+            test_fill_frame(in_buf, in_size, bpp);
+
+            if (!test_filter_init(&ref, impl, fmt, 1, 0, width, height))
+            {
+               fprintf(stderr, "%s: failed to create filter.\n",
+                     impl->short_ident);
+               return 1;
+            }
+            test_filter_run(&ref, pool, in, width, height, in_stride);
+
+            for (t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++)
+            {
+               run++;
+               if (!check_run(impl, fmt, thread_counts[t], 0,
+                        in, width, height, in_stride, &ref))
+                  failed++;
+            }
+
+            for (k = 1; k < num_simd; k++)
+            {
+               for (t = 1; t <= 3; t += 2)
+               {
+                  run++;
+                  if (!check_run(impl, fmt, t, masks[k],
+                           in, width, height, in_stride, &ref))
+                     failed++;
+               }
+            }
+
+            test_filter_free(&ref);
+            free(in_buf);
+         }
+      }
+   }
+
+   printf("%u/%u threaded and SIMD runs matched single-threaded C output.\n",
+         run - failed, run);
+
+   rpool_free(pool);
+   return failed ? 1 : 0;
+}
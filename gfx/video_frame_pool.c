@@ -0,0 +1,166 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include <memalign.h>
+
+#include "video_frame_pool.h"
+#include "../general.h"
+
+struct video_frame_pool
+{
+   video_frame_buffer_t *buffers;
+   unsigned count;
+   size_t resident;
+   size_t peak;
+};
+
+video_frame_pool_t *video_frame_pool_new(void)
+{
+   return (video_frame_pool_t*)calloc(1, sizeof(video_frame_pool_t));
+}
+
+void video_frame_pool_free(video_frame_pool_t *pool)
+{
+   video_frame_buffer_t *buf = NULL;
+
+   if (!pool)
+      return;
+
+   if (pool->count)
+      RARCH_LOG("Frame pool: %u buffers, peak of %u KiB resident.\n",
+            pool->count, (unsigned)(pool->peak >> 10));
+
+   buf = pool->buffers;
+   while (buf)
+   {
+      video_frame_buffer_t *next = buf->next;
+
+      memalign_free(buf->data);
+      free(buf);
+      buf = next;
+   }
+
+   free(pool);
+}
+
+static bool video_frame_pool_resize(video_frame_pool_t *pool,
+      video_frame_buffer_t *buf, size_t size)
+{
+   uint8_t *data = (uint8_t*)memalign_alloc(VIDEO_FRAME_POOL_ALIGN, size);
+
+   if (!data)
+      return false;
+
+   memalign_free(buf->data);
+   pool->resident += size - buf->size;
+   if (pool->resident > pool->peak)
+      pool->peak = pool->resident;
+
+   buf->data = data;
+   buf->size = size;
+   return true;
+}
+
+video_frame_buffer_t *video_frame_pool_get(video_frame_pool_t *pool,
+      size_t size)
+{
+   video_frame_buffer_t *buf     = NULL;
+   video_frame_buffer_t *best    = NULL;
+   video_frame_buffer_t *largest = NULL;
+
+   if (!pool || !size)
+      return NULL;
+
+   for (buf = pool->buffers; buf; buf = buf->next)
+   {
+      if (buf->refcount)
+         continue;
+
+      if (buf->size >= size && (!best || buf->size < best->size))
+         best = buf;
+      if (!largest || buf->size > largest->size)
+         largest = buf;
+   }
+
+   /* Rather grow an idle buffer than keep adding more. */
+   if (!best && largest && video_frame_pool_resize(pool, largest, size))
+      best = largest;
+
+   if (!best)
+   {
+      best = (video_frame_buffer_t*)calloc(1, sizeof(*best));
+      if (!best)
+         return NULL;
+
+      if (!video_frame_pool_resize(pool, best, size))
+      {
+         free(best);
+         return NULL;
+      }
+
+      best->next    = pool->buffers;
+      pool->buffers = best;
+      pool->count++;
+   }
+
+   best->refcount = 1;
+   return best;
+}
+
+uint8_t *video_frame_pool_reserve(video_frame_pool_t *pool,
+      video_frame_buffer_t **buf, size_t size)
+{
+   video_frame_buffer_t *fresh = NULL;
+
+   if (*buf && (*buf)->refcount == 1 && (*buf)->size >= size)
+      return (*buf)->data;
+
+   fresh = video_frame_pool_get(pool, size);
+   if (!fresh)
+      return NULL;
+
+   video_frame_buffer_unref(*buf);
+   *buf = fresh;
+   return fresh->data;
+}
+
+video_frame_buffer_t *video_frame_pool_find(video_frame_pool_t *pool,
+      const void *data)
+{
+   video_frame_buffer_t *buf = NULL;
+
+   if (!pool || !data)
+      return NULL;
+
+   for (buf = pool->buffers; buf; buf = buf->next)
+      if (buf->refcount && buf->data == (const uint8_t*)data)
+         return buf;
+
+   return NULL;
+}
+
+void video_frame_buffer_ref(video_frame_buffer_t *buf)
+{
+   if (buf)
+      buf->refcount++;
+}
+
+void video_frame_buffer_unref(video_frame_buffer_t *buf)
+{
+   if (buf && buf->refcount)
+      buf->refcount--;
+}
@@ -0,0 +1,112 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _VIDEO_FRAME_POOL_H
+#define _VIDEO_FRAME_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Alignment of every buffer handed out by the pool. */
+#define VIDEO_FRAME_POOL_ALIGN 64
+
+/* A reference counted frame buffer. Stages of the video pipeline
+ * hand frames to each other by taking a reference instead of
+ * copying, and only write into a buffer nobody else references.
+ * Once the last reference is dropped, the buffer goes back to
+ * the pool to be reused.
+ *
+ * The pool and its buffers are only to be used from the main
+ * thread. The threaded video wrapper renders buffers it holds
+ * references to, but takes and drops them on the main thread. */
+typedef struct video_frame_buffer
+{
+   uint8_t *data;
+   size_t size;
+   unsigned refcount;
+   struct video_frame_buffer *next;
+} video_frame_buffer_t;
+
+typedef struct video_frame_pool video_frame_pool_t;
+
+video_frame_pool_t *video_frame_pool_new(void);
+
+/**
+ * video_frame_pool_free:
+ * @pool                      : Frame pool handle.
+ *
+ * Frees the pool and all its buffers, including any
+ * still referenced.
+ **/
+void video_frame_pool_free(video_frame_pool_t *pool);
+
+/**
+ * video_frame_pool_get:
+ * @pool                      : Frame pool handle.
+ * @size                      : Minimum size of the buffer in bytes.
+ *
+ * Gets an unreferenced buffer from the pool, growing or
+ * allocating one if none is large enough.
+ *
+ * Returns: buffer with a reference count of one, or NULL on failure.
+ **/
+video_frame_buffer_t *video_frame_pool_get(video_frame_pool_t *pool,
+      size_t size);
+
+/**
+ * video_frame_pool_reserve:
+ * @pool                      : Frame pool handle.
+ * @buf                       : Buffer held by the caller, or NULL.
+ * @size                      : Minimum size of the buffer in bytes.
+ *
+ * Makes sure *@buf is at least @size bytes and referenced by
+ * the caller alone, so it can be written to. Otherwise, it is
+ * replaced by one from the pool. The old buffer is released
+ * only after the new one is taken, so it may still be read
+ * from when writing the new one.
+ *
+ * Returns: pointer to the buffer's data, or NULL on failure.
+ * *@buf is left untouched on failure.
+ **/
+uint8_t *video_frame_pool_reserve(video_frame_pool_t *pool,
+      video_frame_buffer_t **buf, size_t size);
+
+/**
+ * video_frame_pool_find:
+ * @pool                      : Frame pool handle.
+ * @data                      : Pointer to the start of a frame.
+ *
+ * Finds the referenced pool buffer @data points to, so a stage
+ * given a frame can take a reference to it instead of copying.
+ *
+ * Returns: the buffer, or NULL if @data is not the start of one.
+ **/
+video_frame_buffer_t *video_frame_pool_find(video_frame_pool_t *pool,
+      const void *data);
+
+void video_frame_buffer_ref(video_frame_buffer_t *buf);
+
+void video_frame_buffer_unref(video_frame_buffer_t *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
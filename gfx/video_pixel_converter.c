@@ -21,6 +21,7 @@
 #include "../general.h"
 #include "../performance.h"
 #include "video_pixel_converter.h"
+#include "video_frame_pool.h"
 
 /* Used for 16-bit -> 16-bit conversions that take place before
  * being passed to video driver. */
@@ -40,13 +41,13 @@ void deinit_pixel_converter(void)
 
    free(scaler_ptr->scaler);
    scaler_ptr->scaler     = NULL;
-   free(scaler_ptr->scaler_out);
-   scaler_ptr->scaler_out = NULL;
+   video_frame_buffer_unref(scaler_ptr->out);
+   scaler_ptr->out        = NULL;
    free(scaler_ptr);
    scaler_ptr = NULL;
 }
 
-bool init_video_pixel_converter(unsigned size)
+bool init_video_pixel_converter(void)
 {
    /* This function can be called multiple times
     * without deiniting first on consoles. */
@@ -78,16 +79,11 @@ bool init_video_pixel_converter(unsigned size)
    if (!scaler_ctx_gen_filter(scaler_ptr->scaler))
       goto error;
 
-   scaler_ptr->scaler_out = calloc(sizeof(uint16_t), size * size);
-
-   if (!scaler_ptr->scaler_out)
-      goto error;
-
+   /* The output buffer comes from the frame pool,
+    * sized for each frame as it's converted. */
    return true;
 
 error:
-   if (scaler_ptr->scaler_out)
-      free(scaler_ptr->scaler_out);
    if (scaler_ptr->scaler)
       free(scaler_ptr->scaler);
    if (scaler_ptr)
@@ -112,6 +108,7 @@ bool video_pixel_frame_scale(const void *data,
       unsigned width, unsigned height,
       size_t pitch)
 {
+   uint8_t *out                 = NULL;
    video_pixel_scaler_t *scaler = scaler_get_ptr();
 
    RARCH_PERFORMANCE_INIT(video_frame_conv);
@@ -123,6 +120,13 @@ bool video_pixel_frame_scale(const void *data,
    if (data == RETRO_HW_FRAME_BUFFER_VALID)
       return false;
 
+   /* The last output is still in use if it was cached or
+    * handed on, in which case we convert into a fresh one. */
+   out = video_frame_pool_reserve(video_driver_get_frame_pool(),
+         &scaler->out, width * height * sizeof(uint16_t));
+   if (!out)
+      return false;
+
    RARCH_PERFORMANCE_START(video_frame_conv);
 
    scaler->scaler->in_width      = width;
@@ -132,7 +136,7 @@ bool video_pixel_frame_scale(const void *data,
    scaler->scaler->in_stride     = pitch;
    scaler->scaler->out_stride    = width * sizeof(uint16_t);
 
-   scaler_ctx_scale(scaler->scaler, scaler->scaler_out, data);
+   scaler_ctx_scale(scaler->scaler, out, data);
 
    RARCH_PERFORMANCE_STOP(video_frame_conv);
 
@@ -26,12 +26,13 @@ extern "C" {
 typedef struct video_pixel_scaler
 {
    struct scaler_ctx *scaler;
-   void *scaler_out;
+   /* Last converted frame, from the frame pool. */
+   struct video_frame_buffer *out;
 } video_pixel_scaler_t;
 
 void deinit_pixel_converter(void);
 
-bool init_video_pixel_converter(unsigned size);
+bool init_video_pixel_converter(void);
 
 unsigned video_pixel_get_alignment(unsigned pitch);
 
@@ -21,6 +21,12 @@
 #include <string.h>
 #include <limits.h>
 
+/* Frames rendered, frames superseded before the video thread got to
+ * them, and time from handoff to pickup (usec). */
+static struct retro_perf_counter thr_frame_hits    = { "thr_frame_hits" };
+static struct retro_perf_counter thr_frame_misses  = { "thr_frame_misses" };
+static struct retro_perf_counter thr_frame_latency = { "thr_frame_latency" };
+
 static void *thread_init_never_call(const video_info_t *video,
       const input_driver_t **input, void **input_data)
 {
@@ -354,6 +360,46 @@ static bool thread_handle_packet(thread_video_t *thr, const thread_packet_t *inc
    return false;
 }
 
+/**
+ * thread_frame_acquire:
+ * @thr                       : Threaded video handle.
+ *
+ * Takes the newest frame handed off by thread_frame(), if there
+ * is one the video thread hasn't rendered yet. Must be called
+ * with thr->lock held.
+ *
+ * Returns: the frame to render, or NULL.
+ **/
+static thread_frame_slot_t *thread_frame_acquire(thread_video_t *thr)
+{
+#ifdef HAVE_RETRO_ATOMIC
+   if (thr->frame.triple_buffer)
+   {
+      thread_frame_slot_t *slot = NULL;
+
+      if (!(retro_atomic_load_acquire(&thr->frame.middle)
+               & THREAD_FRAME_FRESH))
+         return NULL;
+
+      thr->frame.front = retro_atomic_xchg(&thr->frame.middle,
+            thr->frame.front) & THREAD_FRAME_INDEX_MASK;
+      slot             = &thr->frame.slots[thr->frame.front];
+
+      thr_frame_latency.total += rarch_get_time_usec() - slot->time;
+      thr_frame_latency.call_cnt++;
+      return slot;
+   }
+#endif
+
+   if (!thr->frame.updated)
+      return NULL;
+
+   thr_frame_latency.total += rarch_get_time_usec()
+      - thr->frame.slots[0].time;
+   thr_frame_latency.call_cnt++;
+   return &thr->frame.slots[0];
+}
+
 static void thread_loop(void *data)
 {
    thread_video_t *thr = (thread_video_t*)data;
@@ -364,13 +410,12 @@ static void thread_loop(void *data)
    {
       thread_packet_t pkt;
       bool ret = false;
-      bool updated = false;
+      thread_frame_slot_t *slot = NULL;
 
       slock_lock(thr->lock);
-      while (thr->send_cmd == CMD_NONE && !thr->frame.updated)
+      while (thr->send_cmd == CMD_NONE
+            && !(slot = thread_frame_acquire(thr)))
          scond_wait(thr->cond_thread, thr->lock);
-      if (thr->frame.updated)
-         updated = true;
 
       /* To avoid race condition where send_cmd is updated 
        * right after the switch is checked. */
@@ -381,7 +426,7 @@ static void thread_loop(void *data)
       if (thread_handle_packet(thr, &pkt))
          return;
 
-      if (updated)
+      if (slot)
       {
          ret = false;
          bool alive = false;
@@ -395,8 +440,9 @@ static void thread_loop(void *data)
 
          if (thr->driver && thr->driver->frame)
             ret = thr->driver->frame(thr->driver_data,
-               thr->frame.buffer, thr->frame.width, thr->frame.height,
-               thr->frame.pitch, *thr->frame.msg ? thr->frame.msg : NULL);
+               slot->buffer ? slot->buffer->data : NULL,
+               slot->width, slot->height,
+               slot->pitch, *slot->msg ? slot->msg : NULL);
 
          slock_unlock(thr->frame.lock);
 
@@ -483,12 +529,75 @@ static bool thread_has_windowed(void *data)
    return ret;
 }
 
+/**
+ * thread_frame_slot_fill:
+ * @thr                       : Threaded video wrapper handle.
+ * @slot                      : Slot owned by the emulation thread.
+ *
+ * Puts a frame in @slot. Frames from the frame pool, made by
+ * the pixel converter, a softfilter, or rendered into a buffer
+ * from rarch_threaded_video_get_frame_buffer(), are handed over
+ * by reference. Anything else is copied into a pool buffer.
+ **/
+static void thread_frame_slot_fill(thread_video_t *thr,
+      thread_frame_slot_t *slot, const void *frame,
+      unsigned width, unsigned height, unsigned pitch, const char *msg)
+{
+   video_frame_buffer_t *buf = video_frame_pool_find(
+         thr->frame.pool, frame);
+
+   if (buf)
+   {
+      video_frame_buffer_ref(buf);
+      video_frame_buffer_unref(slot->buffer);
+      slot->buffer = buf;
+      slot->pitch  = pitch;
+   }
+   else if (frame)
+   {
+      unsigned h;
+      const uint8_t *src   = (const uint8_t*)frame;
+      uint8_t *dst         = NULL;
+      unsigned copy_stride = width * (thr->info.rgb32 
+            ? sizeof(uint32_t) : sizeof(uint16_t));
+
+      dst = video_frame_pool_reserve(thr->frame.pool,
+            &slot->buffer, copy_stride * height);
+
+      if (dst)
+      {
+         for (h = 0; h < height; h++, src += pitch, dst += copy_stride)
+            memcpy(dst, src, copy_stride);
+      }
+      else
+      {
+         video_frame_buffer_unref(slot->buffer);
+         slot->buffer = NULL;
+      }
+
+      slot->pitch = copy_stride;
+   }
+   else
+   {
+      /* Duped frame, the driver shows the last one again. */
+      video_frame_buffer_unref(slot->buffer);
+      slot->buffer = NULL;
+      slot->pitch  = pitch;
+   }
+
+   slot->width  = width;
+   slot->height = height;
+   slot->time   = rarch_get_time_usec();
+
+   if (msg)
+      strlcpy(slot->msg, msg, sizeof(slot->msg));
+   else
+      *slot->msg = '\0';
+}
+
 static bool thread_frame(void *data, const void *frame_,
       unsigned width, unsigned height, unsigned pitch, const char *msg)
 {
-   unsigned copy_stride;
-   const uint8_t *src  = NULL;
-   uint8_t *dst        = NULL;
    thread_video_t *thr = (thread_video_t*)data;
 
    /* If called from within read_viewport, we're actually in the 
@@ -506,11 +615,50 @@ static bool thread_frame(void *data, const void *frame_,
    RARCH_PERFORMANCE_INIT(thr_frame);
    RARCH_PERFORMANCE_START(thr_frame);
 
-   copy_stride = width * (thr->info.rgb32 
-         ? sizeof(uint32_t) : sizeof(uint16_t));
+#ifdef HAVE_RETRO_ATOMIC
+   if (thr->frame.triple_buffer)
+   {
+      long old;
+      thread_frame_slot_t *slot = &thr->frame.slots[thr->frame.back];
+
+      /* slots[back] is ours alone, so no locking while filling it. */
+      thread_frame_slot_fill(thr, slot, frame_, width, height, pitch, msg);
+
+      old = retro_atomic_xchg(&thr->frame.middle,
+            (long)(thr->frame.back | THREAD_FRAME_FRESH));
+      thr->frame.back = old & THREAD_FRAME_INDEX_MASK;
+
+      /* Nothing renders the new back slot, so let go
+       * of its frame for the pool to reuse. */
+      slot         = &thr->frame.slots[thr->frame.back];
+      video_frame_buffer_unref(slot->buffer);
+      slot->buffer = NULL;
+
+      /* If the frame we swapped out was never rendered,
+       * it has been superseded by this one. */
+      if (old & THREAD_FRAME_FRESH)
+      {
+         thr->miss_count++;
+         thr_frame_misses.call_cnt++;
+      }
+      else
+      {
+         thr->hit_count++;
+         thr_frame_hits.call_cnt++;
+      }
+
+      /* Only taken to avoid a lost wakeup, the video
+       * thread never holds it for long. */
+      slock_lock(thr->lock);
+      scond_signal(thr->cond_thread);
+      slock_unlock(thr->lock);
 
-   src = (const uint8_t*)frame_;
-   dst = thr->frame.buffer;
+      RARCH_PERFORMANCE_STOP(thr_frame);
+
+      thr->last_time = rarch_get_time_usec();
+      return true;
+   }
+#endif
 
    slock_lock(thr->lock);
 
@@ -540,22 +688,9 @@ static bool thread_frame(void *data, const void *frame_,
     * still working on last frame. */
    if (!thr->frame.updated)
    {
-      if (src)
-      {
-         unsigned h;
-         for (h = 0; h < height; h++, src += pitch, dst += copy_stride)
-            memcpy(dst, src, copy_stride);
-      }
-
+      thread_frame_slot_fill(thr, &thr->frame.slots[0],
+            frame_, width, height, pitch, msg);
       thr->frame.updated = true;
-      thr->frame.width  = width;
-      thr->frame.height = height;
-      thr->frame.pitch  = copy_stride;
-
-      if (msg)
-         strlcpy(thr->frame.msg, msg, sizeof(thr->frame.msg));
-      else
-         *thr->frame.msg = '\0';
 
       scond_signal(thr->cond_thread);
 
@@ -567,9 +702,13 @@ static bool thread_frame(void *data, const void *frame_,
       }
 #endif
       thr->hit_count++;
+      thr_frame_hits.call_cnt++;
    }
    else
+   {
       thr->miss_count++;
+      thr_frame_misses.call_cnt++;
+   }
 
    slock_unlock(thr->lock);
 
@@ -589,8 +728,8 @@ static void thread_set_nonblock_state(void *data, bool state)
 static bool thread_init(thread_video_t *thr, const video_info_t *info,
       const input_driver_t **input, void **input_data)
 {
-   size_t max_size;
-   thread_packet_t pkt = {CMD_INIT};
+   thread_packet_t pkt  = {CMD_INIT};
+   settings_t *settings = config_get_ptr();
 
    thr->lock                 = slock_new();
    thr->alpha_lock           = slock_new();
@@ -605,15 +744,21 @@ static bool thread_init(thread_video_t *thr, const video_info_t *info,
    thr->has_windowed         = true;
    thr->suppress_screensaver = true;
 
-   max_size                  = info->input_scale * RARCH_SCALE_BASE;
-   max_size                 *= max_size;
-   max_size                 *= info->rgb32 ? sizeof(uint32_t) : sizeof(uint16_t);
-   thr->frame.buffer        = (uint8_t*)malloc(max_size);
-
-   if (!thr->frame.buffer)
+   /* Slots take their buffers from the pool as frames come in. */
+   thr->frame.pool           = video_driver_get_frame_pool();
+   if (!thr->frame.pool)
       return false;
 
-   memset(thr->frame.buffer, 0x80, max_size);
+#ifdef HAVE_RETRO_ATOMIC
+   thr->frame.triple_buffer  = settings->video.threaded_triple_buffer;
+   thr->frame.back           = 0;
+   thr->frame.middle         = 1;
+   thr->frame.front          = 2;
+#endif
+
+   rarch_perf_register(&thr_frame_hits);
+   rarch_perf_register(&thr_frame_misses);
+   rarch_perf_register(&thr_frame_latency);
 
    thr->last_time       = rarch_get_time_usec();
    thr->thread          = sthread_create(thread_loop, thr);
@@ -708,6 +853,7 @@ static bool thread_read_viewport(void *data, uint8_t *buffer)
 
 static void thread_free(void *data)
 {
+   unsigned i;
    thread_video_t *thr = (thread_video_t*)data;
    thread_packet_t pkt = { CMD_FREE };
 
@@ -721,7 +867,9 @@ static void thread_free(void *data)
 #if defined(HAVE_MENU)
    free(thr->texture.frame);
 #endif
-   free(thr->frame.buffer);
+   for (i = 0; i < ARRAY_SIZE(thr->frame.slots); i++)
+      video_frame_buffer_unref(thr->frame.slots[i].buffer);
+   video_frame_buffer_unref(thr->frame.pending);
    slock_free(thr->frame.lock);
    slock_free(thr->lock);
    scond_free(thr->cond_cmd);
@@ -1119,6 +1267,47 @@ bool rarch_threaded_video_init(const video_driver_t **out_driver,
    return thread_init(thr, info, input, input_data);
 }
 
+/**
+ * rarch_threaded_video_get_frame_buffer:
+ * @width                     : Width of the frame to be written.
+ * @height                    : Height of the frame to be written.
+ * @pitch                     : Pitch of the returned buffer.
+ *
+ * Gets a buffer from the frame pool for the next frame to be
+ * written into directly. When that buffer is passed back as
+ * the frame, it is handed to the video thread without being
+ * copied. Only valid until the next frame.
+ *
+ * Returns: pointer to the buffer, or NULL if the threaded
+ * wrapper is not in use.
+ **/
+void *rarch_threaded_video_get_frame_buffer(unsigned width,
+      unsigned height, size_t *pitch)
+{
+   size_t stride;
+   thread_video_t *thr = NULL;
+   driver_t *driver    = driver_get_ptr();
+
+   /* The threaded setting can be toggled before the
+    * video driver is reinited, so check the driver itself. */
+   if (!driver->video || driver->video->frame != thread_frame)
+      return NULL;
+
+   thr = (thread_video_t*)driver->video_data;
+
+   if (!thr || !width || !height)
+      return NULL;
+
+   stride = width * (thr->info.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t));
+   *pitch = (stride + VIDEO_FRAME_POOL_ALIGN - 1)
+      & ~(VIDEO_FRAME_POOL_ALIGN - 1);
+
+   /* The last one is still referenced by a slot
+    * if it was handed over, so take a fresh one. */
+   return video_frame_pool_reserve(thr->frame.pool,
+         &thr->frame.pending, *pitch * height);
+}
+
 /**
  * rarch_threaded_video_get_ptr:
  * @drv                       : Found driver.
@@ -20,8 +20,10 @@
 #include "../driver.h"
 #include "../general.h"
 #include <boolean.h>
+#include <retro_atomic.h>
 #include <rthreads/rthreads.h>
 #include "font_driver.h"
+#include "video_frame_pool.h"
 
 enum thread_cmd
 {
@@ -144,6 +146,23 @@ typedef struct
    } data;
 } thread_packet_t;
 
+/* One frame handed from the emulation thread to the video thread. */
+typedef struct thread_frame_slot
+{
+   /* Held by the slot; NULL for a duped frame. */
+   video_frame_buffer_t *buffer;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   /* When the frame was handed off. */
+   retro_time_t time;
+   char msg[PATH_MAX_LENGTH];
+} thread_frame_slot_t;
+
+/* Set in frame.middle while the frame in it is yet to be rendered. */
+#define THREAD_FRAME_FRESH      4
+#define THREAD_FRAME_INDEX_MASK 3
+
 typedef struct thread_video
 {
    slock_t *lock;
@@ -207,13 +226,25 @@ typedef struct thread_video
    struct
    {
       slock_t *lock;
-      uint8_t *buffer;
-      unsigned width;
-      unsigned height;
-      unsigned pitch;
+      /* Only the first slot is used unless triple buffering. */
+      thread_frame_slot_t slots[3];
+      /* Slot buffers come from the video driver's frame pool. */
+      video_frame_pool_t *pool;
+      /* Last buffer handed out to render into,
+       * see rarch_threaded_video_get_frame_buffer(). */
+      video_frame_buffer_t *pending;
       bool updated;
       bool within_thread;
-      char msg[PATH_MAX_LENGTH];
+
+      /* Triple buffering: the emulation thread fills slots[back],
+       * the video thread renders slots[front], and middle holds the
+       * newest completed frame, swapped in and out atomically. */
+      bool triple_buffer;
+      unsigned back;
+      unsigned front;
+#ifdef HAVE_RETRO_ATOMIC
+      retro_atomic_int_t middle;
+#endif
    } frame;
 
    video_driver_t video_thread;
@@ -239,6 +270,23 @@ bool rarch_threaded_video_init(
       const input_driver_t **input, void **input_data,
       const video_driver_t *driver, const video_info_t *info);
 
+/**
+ * rarch_threaded_video_get_frame_buffer:
+ * @width                     : Width of the frame to be written.
+ * @height                    : Height of the frame to be written.
+ * @pitch                     : Pitch of the returned buffer.
+ *
+ * Gets a buffer from the frame pool for the next frame to be
+ * written into directly. When that buffer is passed back as
+ * the frame, it is handed to the video thread without being
+ * copied. Only valid until the next frame.
+ *
+ * Returns: pointer to the buffer, or NULL if the threaded
+ * wrapper is not in use.
+ **/
+void *rarch_threaded_video_get_frame_buffer(unsigned width,
+      unsigned height, size_t *pitch);
+
 /**
  * rarch_threaded_video_get_ptr:
  * @drv                       : Found driver.
@@ -416,6 +416,12 @@ STATE TRACKER
 FIFO BUFFER
 ============================================================ */
 #include "../libretro-common/queues/fifo_buffer.c"
+#include "../libretro-common/queues/spsc_ring.c"
+
+/*============================================================
+MEMALIGN
+============================================================ */
+#include "../libretro-common/memmap/memalign.c"
 
 /*============================================================
 AUDIO RESAMPLER
@@ -506,6 +512,7 @@ DRIVERS
 ============================================================ */
 #include "../gfx/video_driver.c"
 #include "../gfx/video_pixel_converter.c"
+#include "../gfx/video_frame_pool.c"
 #include "../gfx/video_viewport.c"
 #include "../input/input_driver.c"
 #include "../audio/audio_driver.c"
@@ -546,6 +553,7 @@ FILTERS
 #include "../audio/audio_filters/phaser.c"
 #include "../audio/audio_filters/reverb.c"
 #include "../audio/audio_filters/wahwah.c"
+#include "../audio/audio_filters/convolution.c"
 #endif
 /*============================================================
 DYNAMIC
@@ -700,6 +708,7 @@ THREAD
 #include "../thread/xenon_sdl_threads.c"
 #elif defined(HAVE_THREADS)
 #include "../libretro-common/rthreads/rthreads.c"
+#include "../libretro-common/rthreads/rpool.c"
 #include "../gfx/video_thread_wrapper.c"
 #include "../audio/audio_thread_wrapper.c"
 #include "../autosave.c"
@@ -82,6 +82,8 @@ const char *msg_hash_to_str_pt(uint32_t hash)
          return "O core no suporta savestates.";
       case MSG_SAVED_STATE_TO_SLOT:
          return "Estado salvo no slot";
+      case MSG_SAVED_STATE_TO:
+         return "Estado salvo em";
       case MSG_SAVED_SUCCESSFULLY_TO:
          return "Salvo com sucesso em";
       case MSG_BYTES:
@@ -128,6 +130,8 @@ const char *msg_hash_to_str_pt(uint32_t hash)
          return "Falha ao iniciar gravao de vdeo.";
       case MSG_STATE_SLOT:
          return "Slot de estado";
+      case MSG_STATE_SLOT_EMPTY:
+         return "vazio";
       case MSG_RESTARTING_RECORDING_DUE_TO_DRIVER_REINIT:
          return "Reiniciando gravao devido a reincio de driver.";
       case MSG_SLOW_MOTION:
@@ -130,6 +130,8 @@ const char *msg_hash_to_str_us(uint32_t hash)
          return "Core does not support save states.";
       case MSG_SAVED_STATE_TO_SLOT:
          return "Saved state to slot";
+      case MSG_SAVED_STATE_TO:
+         return "Saved state to";
       case MSG_SAVED_SUCCESSFULLY_TO:
          return "Saved successfully to";
       case MSG_BYTES:
@@ -176,6 +178,8 @@ const char *msg_hash_to_str_us(uint32_t hash)
          return "Failed to start movie record.";
       case MSG_STATE_SLOT:
          return "State slot";
+      case MSG_STATE_SLOT_EMPTY:
+         return "empty";
       case MSG_RESTARTING_RECORDING_DUE_TO_DRIVER_REINIT:
          return "Restarting recording due to driver reinit.";
       case MSG_SLOW_MOTION:
@@ -30,19 +30,6 @@
 #include <string.h>
 #include <zlib.h>
 
-/* File backends. Can be fleshed out later, but keep it simple for now.
- * The file is mapped to memory directly (via mmap() or just 
- * plain zlib_read_file()).
- */
-
-struct zlib_file_backend
-{
-   void          *(*open)(const char *path);
-   const uint8_t *(*data)(void *handle);
-   size_t         (*size)(void *handle);
-   void           (*free)(void *handle); /* Closes, unmaps and frees. */
-};
-
 #ifndef CENTRAL_FILE_HEADER_SIGNATURE
 #define CENTRAL_FILE_HEADER_SIGNATURE 0x02014b50
 #endif
@@ -266,7 +253,7 @@ static const struct zlib_file_backend zlib_backend = {
    zlib_file_free,
 };
 
-static const struct zlib_file_backend *zlib_get_default_file_backend(void)
+const struct zlib_file_backend *zlib_get_default_file_backend(void)
 {
    return &zlib_backend;
 }
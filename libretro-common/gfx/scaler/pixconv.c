@@ -21,6 +21,7 @@
  */
 
 #include <gfx/scaler/pixconv.h>
+#include <gfx/scaler/scaler_int.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,7 +36,1716 @@
 #include <emmintrin.h>
 #endif
 
-#if defined(__SSE2_)
+#if defined(__SSE2__) && defined(SCALER_HAVE_AVX2)
+#define PIXCONV_X86 1
+#define PIXCONV_SSSE3 __attribute__((target("ssse3")))
+#define PIXCONV_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+#if !defined(SCALER_NO_SIMD) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#define PIXCONV_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Hands the whole conversion over to a SIMD version of the
+ * converter, if the CPU has what it needs. */
+#if defined(PIXCONV_X86)
+#define PIXCONV_SIMD(conv, isa) \
+   do { \
+      if (scaler_cpu_has_##isa()) \
+      { \
+         conv##_##isa(output_, input_, width, height, out_stride, in_stride); \
+         return; \
+      } \
+   } while (0)
+#elif defined(PIXCONV_NEON)
+#define PIXCONV_SIMD(conv, isa) \
+   do { \
+      conv##_neon(output_, input_, width, height, out_stride, in_stride); \
+      return; \
+   } while (0)
+#else
+#define PIXCONV_SIMD(conv, isa) do {} while (0)
+#endif
+
+#define YUV_SHIFT 6
+#define YUV_OFFSET (1 << (YUV_SHIFT - 1))
+#define YUV_MAT_Y (1 << 6)
+#define YUV_MAT_U_G (-22)
+#define YUV_MAT_U_B (113)
+#define YUV_MAT_V_R (90)
+#define YUV_MAT_V_G (-46)
+
+/* One pixel pair of YUYV, for what the SIMD versions leave over. */
+static INLINE void yuyv_argb8888_pair(uint32_t *dst, const uint8_t *src)
+{
+   int _y0    = src[0];
+   int  u     = src[1] - 128;
+   int _y1    = src[2];
+   int  v     = src[3] - 128;
+
+   uint8_t r0 = clamp_8bit((YUV_MAT_Y * _y0 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
+   uint8_t g0 = clamp_8bit((YUV_MAT_Y * _y0 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
+   uint8_t b0 = clamp_8bit((YUV_MAT_Y * _y0 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
+
+   uint8_t r1 = clamp_8bit((YUV_MAT_Y * _y1 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
+   uint8_t g1 = clamp_8bit((YUV_MAT_Y * _y1 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
+   uint8_t b1 = clamp_8bit((YUV_MAT_Y * _y1 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
+
+   dst[0] = 0xff000000u | (r0 << 16) | (g0 << 8) | (b0 << 0);
+   dst[1] = 0xff000000u | (r1 << 16) | (g1 << 8) | (b1 << 0);
+}
+
+#ifdef PIXCONV_X86
+/* Runtime dispatched. The AVX2 versions cover converters that work
+ * within 128-bit lanes, and the SSSE3 ones those that shuffle bytes
+ * to and from 24-bit pixels, which AVX2 can't do across lanes.
+ * Their output is identical to the C versions. */
+
+/* ARGB8888 from 16 lanes of 8-bit r, g and b in 16-bit words.
+ * Pixels 0-7 end up in 'lo', 8-15 in 'hi'. */
+static INLINE PIXCONV_AVX2 void pack_argb8888_avx2(__m256i r, __m256i g,
+      __m256i b, __m256i *lo, __m256i *hi)
+{
+   const __m256i a     = _mm256_set1_epi16(0x00ff);
+   __m256i res_lo      = _mm256_or_si256(_mm256_unpacklo_epi8(b, g),
+         _mm256_slli_si256(_mm256_unpacklo_epi8(r, a), 2));
+   __m256i res_hi      = _mm256_or_si256(_mm256_unpackhi_epi8(b, g),
+         _mm256_slli_si256(_mm256_unpackhi_epi8(r, a), 2));
+
+   /* The unpacks stay within lanes. */
+   *lo = _mm256_permute2x128_si256(res_lo, res_hi, 0x20);
+   *hi = _mm256_permute2x128_si256(res_lo, res_hi, 0x31);
+}
+
+static PIXCONV_AVX2 void conv_rgb565_0rgb1555_avx2(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+   const __m256i hi_mask = _mm256_set1_epi16(0x7fe0);
+   const __m256i lo_mask = _mm256_set1_epi16(0x1f);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      for (w = 0; w + 16 <= width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i hi       = _mm256_and_si256(_mm256_srli_epi16(in, 1), hi_mask);
+         __m256i lo       = _mm256_and_si256(in, lo_mask);
+         _mm256_storeu_si256((__m256i*)(output + w), _mm256_or_si256(hi, lo));
+      }
+
+      for (; w < width; w++)
+      {
+         uint16_t col = input[w];
+         uint16_t hi  = (col >> 1) & 0x7fe0;
+         uint16_t lo  = col & 0x1f;
+         output[w]    = hi | lo;
+      }
+   }
+}
+
+static PIXCONV_AVX2 void conv_0rgb1555_rgb565_avx2(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input   = (const uint16_t*)input_;
+   uint16_t *output        = (uint16_t*)output_;
+   const __m256i hi_mask   = _mm256_set1_epi16(
+         (int16_t)((0x1f << 11) | (0x1f << 6)));
+   const __m256i lo_mask   = _mm256_set1_epi16(0x1f);
+   const __m256i glow_mask = _mm256_set1_epi16(1 << 5);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      for (w = 0; w + 16 <= width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i rg       = _mm256_and_si256(_mm256_slli_epi16(in, 1), hi_mask);
+         __m256i b        = _mm256_and_si256(in, lo_mask);
+         __m256i glow     = _mm256_and_si256(_mm256_srli_epi16(in, 4), glow_mask);
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_or_si256(rg, _mm256_or_si256(b, glow)));
+      }
+
+      for (; w < width; w++)
+      {
+         uint16_t col  = input[w];
+         uint16_t rg   = (col << 1) & ((0x1f << 11) | (0x1f << 6));
+         uint16_t b    = col & 0x1f;
+         uint16_t glow = (col >> 4) & (1 << 5);
+         output[w]     = rg | b | glow;
+      }
+   }
+}
+
+static PIXCONV_AVX2 void conv_0rgb1555_argb8888_avx2(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input     = (const uint16_t*)input_;
+   uint32_t *output          = (uint32_t*)output_;
+   const __m256i pix_mask_r  = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_gb = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul15_mid   = _mm256_set1_epi16(0x4200);
+   const __m256i mul15_hi    = _mm256_set1_epi16(0x0210);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w + 16 <= width; w += 16)
+      {
+         __m256i lo, hi;
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i r = _mm256_and_si256(in, pix_mask_r);
+         __m256i g = _mm256_and_si256(in, pix_mask_gb);
+         __m256i b = _mm256_and_si256(_mm256_slli_epi16(in, 5), pix_mask_gb);
+
+         r = _mm256_mulhi_epi16(r, mul15_hi);
+         g = _mm256_mulhi_epi16(g, mul15_mid);
+         b = _mm256_mulhi_epi16(b, mul15_mid);
+
+         pack_argb8888_avx2(r, g, b, &lo, &hi);
+         _mm256_storeu_si256((__m256i*)(output + w + 0), lo);
+         _mm256_storeu_si256((__m256i*)(output + w + 8), hi);
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r   = (col >> 10) & 0x1f;
+         uint32_t g   = (col >>  5) & 0x1f;
+         uint32_t b   = (col >>  0) & 0x1f;
+         r = (r << 3) | (r >> 2);
+         g = (g << 3) | (g >> 2);
+         b = (b << 3) | (b >> 2);
+
+         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+      }
+   }
+}
+
+static PIXCONV_AVX2 void conv_rgb565_argb8888_avx2(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input    = (const uint16_t*)input_;
+   uint32_t *output         = (uint32_t*)output_;
+   const __m256i pix_mask_r = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_g = _mm256_set1_epi16(0x3f <<  5);
+   const __m256i pix_mask_b = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul16_r    = _mm256_set1_epi16(0x0210);
+   const __m256i mul16_g    = _mm256_set1_epi16(0x2080);
+   const __m256i mul16_b    = _mm256_set1_epi16(0x4200);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w + 16 <= width; w += 16)
+      {
+         __m256i lo, hi;
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i r = _mm256_and_si256(_mm256_srli_epi16(in, 1), pix_mask_r);
+         __m256i g = _mm256_and_si256(in, pix_mask_g);
+         __m256i b = _mm256_and_si256(_mm256_slli_epi16(in, 5), pix_mask_b);
+
+         r = _mm256_mulhi_epi16(r, mul16_r);
+         g = _mm256_mulhi_epi16(g, mul16_g);
+         b = _mm256_mulhi_epi16(b, mul16_b);
+
+         pack_argb8888_avx2(r, g, b, &lo, &hi);
+         _mm256_storeu_si256((__m256i*)(output + w + 0), lo);
+         _mm256_storeu_si256((__m256i*)(output + w + 8), hi);
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r   = (col >> 11) & 0x1f;
+         uint32_t g   = (col >>  5) & 0x3f;
+         uint32_t b   = (col >>  0) & 0x1f;
+         r = (r << 3) | (r >> 2);
+         g = (g << 2) | (g >> 4);
+         b = (b << 3) | (b >> 2);
+
+         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+      }
+   }
+}
+
+static PIXCONV_AVX2 void conv_rgba4444_argb8888_avx2(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+   const __m256i mask_lo = _mm256_set1_epi16(0x000f);
+   const __m256i mask_hi = _mm256_set1_epi16(0x0f00);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w + 16 <= width; w += 16)
+      {
+         __m256i bg, ra, lo, hi;
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+
+         /* Nibbles of B and G, and of R and A, in the low nibble
+          * of each byte, then widened to 8 bits. */
+         bg = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(in, 4), mask_lo),
+               _mm256_and_si256(in, mask_hi));
+         ra = _mm256_or_si256(_mm256_srli_epi16(in, 12),
+               _mm256_and_si256(_mm256_slli_epi16(in, 8), mask_hi));
+         bg = _mm256_or_si256(bg, _mm256_slli_epi16(bg, 4));
+         ra = _mm256_or_si256(ra, _mm256_slli_epi16(ra, 4));
+
+         lo = _mm256_unpacklo_epi16(bg, ra);
+         hi = _mm256_unpackhi_epi16(bg, ra);
+         _mm256_storeu_si256((__m256i*)(output + w + 0),
+               _mm256_permute2x128_si256(lo, hi, 0x20));
+         _mm256_storeu_si256((__m256i*)(output + w + 8),
+               _mm256_permute2x128_si256(lo, hi, 0x31));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r   = (col >> 12) & 0xf;
+         uint32_t g   = (col >>  8) & 0xf;
+         uint32_t b   = (col >>  4) & 0xf;
+         uint32_t a   = (col >>  0) & 0xf;
+         r = (r << 4) | r;
+         g = (g << 4) | g;
+         b = (b << 4) | b;
+         a = (a << 4) | a;
+
+         output[w] = (a << 24) | (r << 16) | (g << 8) | (b << 0);
+      }
+   }
+}
+
+static PIXCONV_AVX2 void conv_rgba4444_rgb565_avx2(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+   const __m256i mask_r  = _mm256_set1_epi16((int16_t)0xf000);
+   const __m256i mask_g  = _mm256_set1_epi16(0x0780);
+   const __m256i mask_b  = _mm256_set1_epi16(0x001e);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      for (w = 0; w + 16 <= width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i r = _mm256_and_si256(in, mask_r);
+         __m256i g = _mm256_and_si256(_mm256_srli_epi16(in, 1), mask_g);
+         __m256i b = _mm256_and_si256(_mm256_srli_epi16(in, 3), mask_b);
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_or_si256(r, _mm256_or_si256(g, b)));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r   = (col >> 12) & 0xf;
+         uint32_t g   = (col >>  8) & 0xf;
+         uint32_t b   = (col >>  4) & 0xf;
+
+         output[w] = (r << 12) | (g << 7) | (b << 1);
+      }
+   }
+}
+
+static PIXCONV_AVX2 void conv_argb8888_0rgb1555_avx2(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+   const __m256i mask_r  = _mm256_set1_epi32(0x1f << 10);
+   const __m256i mask_g  = _mm256_set1_epi32(0x1f <<  5);
+   const __m256i mask_b  = _mm256_set1_epi32(0x1f);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      for (w = 0; w + 16 <= width; w += 16)
+      {
+         __m256i res[2];
+         int i;
+
+         for (i = 0; i < 2; i++)
+         {
+            const __m256i in = _mm256_loadu_si256(
+                  (const __m256i*)(input + w + 8 * i));
+            __m256i r = _mm256_and_si256(_mm256_srli_epi32(in, 9), mask_r);
+            __m256i g = _mm256_and_si256(_mm256_srli_epi32(in, 6), mask_g);
+            __m256i b = _mm256_and_si256(_mm256_srli_epi32(in, 3), mask_b);
+            res[i]    = _mm256_or_si256(r, _mm256_or_si256(g, b));
+         }
+
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_permute4x64_epi64(_mm256_packus_epi32(res[0], res[1]),
+                  _MM_SHUFFLE(3, 1, 2, 0)));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint16_t r   = (col >> 19) & 0x1f;
+         uint16_t g   = (col >> 11) & 0x1f;
+         uint16_t b   = (col >>  3) & 0x1f;
+         output[w]    = (r << 10) | (g << 5) | (b << 0);
+      }
+   }
+}
+
+static PIXCONV_AVX2 void conv_argb8888_rgb565_avx2(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+   const __m256i mask_r  = _mm256_set1_epi32(0x1f << 11);
+   const __m256i mask_g  = _mm256_set1_epi32(0x3f <<  5);
+   const __m256i mask_b  = _mm256_set1_epi32(0x1f);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      for (w = 0; w + 16 <= width; w += 16)
+      {
+         __m256i res[2];
+         int i;
+
+         for (i = 0; i < 2; i++)
+         {
+            const __m256i in = _mm256_loadu_si256(
+                  (const __m256i*)(input + w + 8 * i));
+            __m256i r = _mm256_and_si256(_mm256_srli_epi32(in, 8), mask_r);
+            __m256i g = _mm256_and_si256(_mm256_srli_epi32(in, 5), mask_g);
+            __m256i b = _mm256_and_si256(_mm256_srli_epi32(in, 3), mask_b);
+            res[i]    = _mm256_or_si256(r, _mm256_or_si256(g, b));
+         }
+
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_permute4x64_epi64(_mm256_packus_epi32(res[0], res[1]),
+                  _MM_SHUFFLE(3, 1, 2, 0)));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint16_t r   = (col >> 19) & 0x1f;
+         uint16_t g   = (col >> 10) & 0x3f;
+         uint16_t b   = (col >>  3) & 0x1f;
+         output[w]    = (r << 11) | (g << 5) | (b << 0);
+      }
+   }
+}
+
+static PIXCONV_AVX2 void conv_argb8888_abgr8888_avx2(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+   const __m256i swap_rb = _mm256_setr_epi8(
+         2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+         2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 2)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+         _mm256_storeu_si256((__m256i*)(output + w), _mm256_shuffle_epi8(
+                  _mm256_loadu_si256((const __m256i*)(input + w)), swap_rb));
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         output[w] = ((col << 16) & 0xff0000) |
+            ((col >> 16) & 0xff) | (col & 0xff00ff00);
+      }
+   }
+}
+
+/* YUYV is 16 pixels to a 256-bit load. The shuffles pick the U or V
+ * of each pixel pair twice, so chroma comes out upscaled already,
+ * and both stay within lanes. The sums can't overflow 16 bits. */
+static PIXCONV_AVX2 void conv_yuyv_argb8888_avx2(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint8_t *input        = (const uint8_t*)input_;
+   uint32_t *output            = (uint32_t*)output_;
+   const __m256i shuf_u        = _mm256_setr_epi8(
+         1, -1, 1, -1, 5, -1, 5, -1, 9, -1, 9, -1, 13, -1, 13, -1,
+         1, -1, 1, -1, 5, -1, 5, -1, 9, -1, 9, -1, 13, -1, 13, -1);
+   const __m256i shuf_v        = _mm256_setr_epi8(
+         3, -1, 3, -1, 7, -1, 7, -1, 11, -1, 11, -1, 15, -1, 15, -1,
+         3, -1, 3, -1, 7, -1, 7, -1, 11, -1, 11, -1, 15, -1, 15, -1);
+   const __m256i mask_y        = _mm256_set1_epi16(0xff);
+   const __m256i chroma_offset = _mm256_set1_epi16(128);
+   const __m256i round_offset  = _mm256_set1_epi16(YUV_OFFSET);
+   const __m256i yuv_mul       = _mm256_set1_epi16(YUV_MAT_Y);
+   const __m256i u_g_mul       = _mm256_set1_epi16(YUV_MAT_U_G);
+   const __m256i u_b_mul       = _mm256_set1_epi16(YUV_MAT_U_B);
+   const __m256i v_r_mul       = _mm256_set1_epi16(YUV_MAT_V_R);
+   const __m256i v_g_mul       = _mm256_set1_epi16(YUV_MAT_V_G);
+   const __m256i a             = _mm256_set1_epi8(-1);
+
+   for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride)
+   {
+      const uint8_t *src = input;
+      uint32_t      *dst = output;
+
+      for (w = 0; w + 32 <= width; w += 32, src += 64, dst += 32)
+      {
+         __m256i r[2], g[2], b[2];
+         __m256i lo_bg, hi_bg, lo_ra, hi_ra, res0, res1, res2, res3;
+         int i;
+
+         /* Pixels 0-15, then 16-31. */
+         for (i = 0; i < 2; i++)
+         {
+            const __m256i yuv = _mm256_loadu_si256((const __m256i*)(src + 32 * i));
+            __m256i y = _mm256_add_epi16(_mm256_mullo_epi16(
+                     _mm256_and_si256(yuv, mask_y), yuv_mul), round_offset);
+            __m256i u = _mm256_sub_epi16(_mm256_shuffle_epi8(yuv, shuf_u),
+                  chroma_offset);
+            __m256i v = _mm256_sub_epi16(_mm256_shuffle_epi8(yuv, shuf_v),
+                  chroma_offset);
+
+            r[i] = _mm256_srai_epi16(_mm256_add_epi16(y,
+                     _mm256_mullo_epi16(v, v_r_mul)), YUV_SHIFT);
+            g[i] = _mm256_srai_epi16(_mm256_add_epi16(y, _mm256_add_epi16(
+                        _mm256_mullo_epi16(u, u_g_mul),
+                        _mm256_mullo_epi16(v, v_g_mul))), YUV_SHIFT);
+            b[i] = _mm256_srai_epi16(_mm256_add_epi16(y,
+                     _mm256_mullo_epi16(u, u_b_mul)), YUV_SHIFT);
+         }
+
+         /* Saturate into 8-bit. Lane 0 has pixels 0-7 and 16-23,
+          * lane 1 pixels 8-15 and 24-31. */
+         r[0] = _mm256_packus_epi16(r[0], r[1]);
+         g[0] = _mm256_packus_epi16(g[0], g[1]);
+         b[0] = _mm256_packus_epi16(b[0], b[1]);
+
+         lo_bg = _mm256_unpacklo_epi8(b[0], g[0]);
+         hi_bg = _mm256_unpackhi_epi8(b[0], g[0]);
+         lo_ra = _mm256_unpacklo_epi8(r[0], a);
+         hi_ra = _mm256_unpackhi_epi8(r[0], a);
+         res0  = _mm256_unpacklo_epi16(lo_bg, lo_ra);
+         res1  = _mm256_unpackhi_epi16(lo_bg, lo_ra);
+         res2  = _mm256_unpacklo_epi16(hi_bg, hi_ra);
+         res3  = _mm256_unpackhi_epi16(hi_bg, hi_ra);
+
+         _mm256_storeu_si256((__m256i*)(dst +  0),
+               _mm256_permute2x128_si256(res0, res1, 0x20));
+         _mm256_storeu_si256((__m256i*)(dst +  8),
+               _mm256_permute2x128_si256(res0, res1, 0x31));
+         _mm256_storeu_si256((__m256i*)(dst + 16),
+               _mm256_permute2x128_si256(res2, res3, 0x20));
+         _mm256_storeu_si256((__m256i*)(dst + 24),
+               _mm256_permute2x128_si256(res2, res3, 0x31));
+      }
+
+      for (; w < width; w += 2, src += 4, dst += 2)
+         yuyv_argb8888_pair(dst, src);
+   }
+}
+
+/* One unaligned store lines the destination up on 32 bytes,
+ * the rest of the row is stored aligned and the tail overlaps
+ * the last full vector. Rows shorter than a vector go to memcpy(). */
+static PIXCONV_AVX2 void conv_copy_avx2(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, i;
+   int copy_len         = abs(out_stride);
+   const uint8_t *input = (const uint8_t*)input_;
+   uint8_t *output      = (uint8_t*)output_;
+
+   if (abs(in_stride) < copy_len)
+      copy_len = abs(in_stride);
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride)
+   {
+      if (copy_len < 32)
+      {
+         memcpy(output, input, copy_len);
+         continue;
+      }
+
+      _mm256_storeu_si256((__m256i*)output,
+            _mm256_loadu_si256((const __m256i*)input));
+
+      for (i = 32 - ((uintptr_t)output & 31); i + 128 <= copy_len; i += 128)
+      {
+         const __m256i a = _mm256_loadu_si256((const __m256i*)(input + i +  0));
+         const __m256i b = _mm256_loadu_si256((const __m256i*)(input + i + 32));
+         const __m256i c = _mm256_loadu_si256((const __m256i*)(input + i + 64));
+         const __m256i d = _mm256_loadu_si256((const __m256i*)(input + i + 96));
+         _mm256_store_si256((__m256i*)(output + i +  0), a);
+         _mm256_store_si256((__m256i*)(output + i + 32), b);
+         _mm256_store_si256((__m256i*)(output + i + 64), c);
+         _mm256_store_si256((__m256i*)(output + i + 96), d);
+      }
+
+      for (; i + 32 <= copy_len; i += 32)
+         _mm256_store_si256((__m256i*)(output + i),
+               _mm256_loadu_si256((const __m256i*)(input + i)));
+
+      if (i < copy_len)
+         _mm256_storeu_si256((__m256i*)(output + copy_len - 32),
+               _mm256_loadu_si256((const __m256i*)(input + copy_len - 32)));
+   }
+}
+
+/* Packs 16 ARGB8888 pixels into 48 bytes of BGR24. */
+static INLINE PIXCONV_SSSE3 void store_bgr24_ssse3(void *output, __m128i a,
+      __m128i b, __m128i c, __m128i d)
+{
+   const __m128i pack = _mm_setr_epi8(
+         0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+   __m128i *out       = (__m128i*)output;
+
+   a = _mm_shuffle_epi8(a, pack);
+   b = _mm_shuffle_epi8(b, pack);
+   c = _mm_shuffle_epi8(c, pack);
+   d = _mm_shuffle_epi8(d, pack);
+
+   _mm_storeu_si128(out + 0, _mm_or_si128(a, _mm_slli_si128(b, 12)));
+   _mm_storeu_si128(out + 1, _mm_or_si128(_mm_srli_si128(b, 4),
+            _mm_slli_si128(c, 8)));
+   _mm_storeu_si128(out + 2, _mm_or_si128(_mm_srli_si128(c, 8),
+            _mm_slli_si128(d, 4)));
+}
+
+/* ARGB8888 from 8 lanes of 8-bit r, g and b in 16-bit words. */
+static INLINE void pack_argb8888_sse2(__m128i r, __m128i g, __m128i b,
+      __m128i *lo, __m128i *hi)
+{
+   const __m128i a = _mm_set1_epi16(0x00ff);
+
+   *lo = _mm_or_si128(_mm_unpacklo_epi8(b, g),
+         _mm_slli_si128(_mm_unpacklo_epi8(r, a), 2));
+   *hi = _mm_or_si128(_mm_unpackhi_epi8(b, g),
+         _mm_slli_si128(_mm_unpackhi_epi8(r, a), 2));
+}
+
+static PIXCONV_SSSE3 void conv_0rgb1555_bgr24_ssse3(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input     = (const uint16_t*)input_;
+   uint8_t *output           = (uint8_t*)output_;
+   const __m128i pix_mask_r  = _mm_set1_epi16(0x1f << 10);
+   const __m128i pix_mask_gb = _mm_set1_epi16(0x1f <<  5);
+   const __m128i mul15_mid   = _mm_set1_epi16(0x4200);
+   const __m128i mul15_hi    = _mm_set1_epi16(0x0210);
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+   {
+      uint8_t *out = output;
+
+      for (w = 0; w + 16 <= width; w += 16, out += 48)
+      {
+         __m128i res[4];
+         int i;
+
+         for (i = 0; i < 2; i++)
+         {
+            const __m128i in = _mm_loadu_si128((const __m128i*)(input + w + 8 * i));
+            __m128i r = _mm_and_si128(in, pix_mask_r);
+            __m128i g = _mm_and_si128(in, pix_mask_gb);
+            __m128i b = _mm_and_si128(_mm_slli_epi16(in, 5), pix_mask_gb);
+
+            r = _mm_mulhi_epi16(r, mul15_hi);
+            g = _mm_mulhi_epi16(g, mul15_mid);
+            b = _mm_mulhi_epi16(b, mul15_mid);
+
+            pack_argb8888_sse2(r, g, b, &res[2 * i], &res[2 * i + 1]);
+         }
+
+         store_bgr24_ssse3(out, res[0], res[1], res[2], res[3]);
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t b   = (col >>  0) & 0x1f;
+         uint32_t g   = (col >>  5) & 0x1f;
+         uint32_t r   = (col >> 10) & 0x1f;
+         b = (b << 3) | (b >> 2);
+         g = (g << 3) | (g >> 2);
+         r = (r << 3) | (r >> 2);
+
+         *out++ = b;
+         *out++ = g;
+         *out++ = r;
+      }
+   }
+}
+
+static PIXCONV_SSSE3 void conv_rgb565_bgr24_ssse3(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input    = (const uint16_t*)input_;
+   uint8_t *output          = (uint8_t*)output_;
+   const __m128i pix_mask_r = _mm_set1_epi16(0x1f << 10);
+   const __m128i pix_mask_g = _mm_set1_epi16(0x3f <<  5);
+   const __m128i pix_mask_b = _mm_set1_epi16(0x1f <<  5);
+   const __m128i mul16_r    = _mm_set1_epi16(0x0210);
+   const __m128i mul16_g    = _mm_set1_epi16(0x2080);
+   const __m128i mul16_b    = _mm_set1_epi16(0x4200);
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+   {
+      uint8_t *out = output;
+
+      for (w = 0; w + 16 <= width; w += 16, out += 48)
+      {
+         __m128i res[4];
+         int i;
+
+         for (i = 0; i < 2; i++)
+         {
+            const __m128i in = _mm_loadu_si128((const __m128i*)(input + w + 8 * i));
+            __m128i r = _mm_and_si128(_mm_srli_epi16(in, 1), pix_mask_r);
+            __m128i g = _mm_and_si128(in, pix_mask_g);
+            __m128i b = _mm_and_si128(_mm_slli_epi16(in, 5), pix_mask_b);
+
+            r = _mm_mulhi_epi16(r, mul16_r);
+            g = _mm_mulhi_epi16(g, mul16_g);
+            b = _mm_mulhi_epi16(b, mul16_b);
+
+            pack_argb8888_sse2(r, g, b, &res[2 * i], &res[2 * i + 1]);
+         }
+
+         store_bgr24_ssse3(out, res[0], res[1], res[2], res[3]);
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r   = (col >> 11) & 0x1f;
+         uint32_t g   = (col >>  5) & 0x3f;
+         uint32_t b   = (col >>  0) & 0x1f;
+         r = (r << 3) | (r >> 2);
+         g = (g << 2) | (g >> 4);
+         b = (b << 3) | (b >> 2);
+
+         *out++ = b;
+         *out++ = g;
+         *out++ = r;
+      }
+   }
+}
+
+static PIXCONV_SSSE3 void conv_bgr24_argb8888_ssse3(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint8_t *input  = (const uint8_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+   const __m128i unpack  = _mm_setr_epi8(
+         0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+   const __m128i a       = _mm_set1_epi32(0xff000000);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride)
+   {
+      const uint8_t *inp = input;
+
+      for (w = 0; w + 16 <= width; w += 16, inp += 48)
+      {
+         __m128i in0 = _mm_loadu_si128((const __m128i*)(inp +  0));
+         __m128i in1 = _mm_loadu_si128((const __m128i*)(inp + 16));
+         __m128i in2 = _mm_loadu_si128((const __m128i*)(inp + 32));
+
+         /* Four pixels start every 12 bytes. */
+         _mm_storeu_si128((__m128i*)(output + w +  0), _mm_or_si128(a,
+                  _mm_shuffle_epi8(in0, unpack)));
+         _mm_storeu_si128((__m128i*)(output + w +  4), _mm_or_si128(a,
+                  _mm_shuffle_epi8(_mm_alignr_epi8(in1, in0, 12), unpack)));
+         _mm_storeu_si128((__m128i*)(output + w +  8), _mm_or_si128(a,
+                  _mm_shuffle_epi8(_mm_alignr_epi8(in2, in1, 8), unpack)));
+         _mm_storeu_si128((__m128i*)(output + w + 12), _mm_or_si128(a,
+                  _mm_shuffle_epi8(_mm_srli_si128(in2, 4), unpack)));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t b = *inp++;
+         uint32_t g = *inp++;
+         uint32_t r = *inp++;
+         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+      }
+   }
+}
+
+static PIXCONV_SSSE3 void conv_argb8888_bgr24_ssse3(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 2)
+   {
+      uint8_t *out = output;
+
+      for (w = 0; w + 16 <= width; w += 16, out += 48)
+         store_bgr24_ssse3(out,
+               _mm_loadu_si128((const __m128i*)(input + w +  0)),
+               _mm_loadu_si128((const __m128i*)(input + w +  4)),
+               _mm_loadu_si128((const __m128i*)(input + w +  8)),
+               _mm_loadu_si128((const __m128i*)(input + w + 12)));
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         *out++ = (uint8_t)(col >>  0);
+         *out++ = (uint8_t)(col >>  8);
+         *out++ = (uint8_t)(col >> 16);
+      }
+   }
+}
+
+/* Like the AVX2 version, 8 pixels to a load. */
+static PIXCONV_SSSE3 void conv_yuyv_argb8888_ssse3(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint8_t *input        = (const uint8_t*)input_;
+   uint32_t *output            = (uint32_t*)output_;
+   const __m128i shuf_u        = _mm_setr_epi8(
+         1, -1, 1, -1, 5, -1, 5, -1, 9, -1, 9, -1, 13, -1, 13, -1);
+   const __m128i shuf_v        = _mm_setr_epi8(
+         3, -1, 3, -1, 7, -1, 7, -1, 11, -1, 11, -1, 15, -1, 15, -1);
+   const __m128i mask_y        = _mm_set1_epi16(0xff);
+   const __m128i chroma_offset = _mm_set1_epi16(128);
+   const __m128i round_offset  = _mm_set1_epi16(YUV_OFFSET);
+   const __m128i yuv_mul       = _mm_set1_epi16(YUV_MAT_Y);
+   const __m128i u_g_mul       = _mm_set1_epi16(YUV_MAT_U_G);
+   const __m128i u_b_mul       = _mm_set1_epi16(YUV_MAT_U_B);
+   const __m128i v_r_mul       = _mm_set1_epi16(YUV_MAT_V_R);
+   const __m128i v_g_mul       = _mm_set1_epi16(YUV_MAT_V_G);
+   const __m128i a             = _mm_set1_epi8(-1);
+
+   for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride)
+   {
+      const uint8_t *src = input;
+      uint32_t      *dst = output;
+
+      for (w = 0; w + 16 <= width; w += 16, src += 32, dst += 16)
+      {
+         __m128i r[2], g[2], b[2];
+         __m128i lo_bg, hi_bg, lo_ra, hi_ra;
+         int i;
+
+         /* Pixels 0-7, then 8-15. */
+         for (i = 0; i < 2; i++)
+         {
+            const __m128i yuv = _mm_loadu_si128((const __m128i*)(src + 16 * i));
+            __m128i y = _mm_add_epi16(_mm_mullo_epi16(
+                     _mm_and_si128(yuv, mask_y), yuv_mul), round_offset);
+            __m128i u = _mm_sub_epi16(_mm_shuffle_epi8(yuv, shuf_u),
+                  chroma_offset);
+            __m128i v = _mm_sub_epi16(_mm_shuffle_epi8(yuv, shuf_v),
+                  chroma_offset);
+
+            r[i] = _mm_srai_epi16(_mm_add_epi16(y,
+                     _mm_mullo_epi16(v, v_r_mul)), YUV_SHIFT);
+            g[i] = _mm_srai_epi16(_mm_add_epi16(y, _mm_add_epi16(
+                        _mm_mullo_epi16(u, u_g_mul),
+                        _mm_mullo_epi16(v, v_g_mul))), YUV_SHIFT);
+            b[i] = _mm_srai_epi16(_mm_add_epi16(y,
+                     _mm_mullo_epi16(u, u_b_mul)), YUV_SHIFT);
+         }
+
+         r[0] = _mm_packus_epi16(r[0], r[1]);
+         g[0] = _mm_packus_epi16(g[0], g[1]);
+         b[0] = _mm_packus_epi16(b[0], b[1]);
+
+         lo_bg = _mm_unpacklo_epi8(b[0], g[0]);
+         hi_bg = _mm_unpackhi_epi8(b[0], g[0]);
+         lo_ra = _mm_unpacklo_epi8(r[0], a);
+         hi_ra = _mm_unpackhi_epi8(r[0], a);
+
+         _mm_storeu_si128((__m128i*)(dst +  0), _mm_unpacklo_epi16(lo_bg, lo_ra));
+         _mm_storeu_si128((__m128i*)(dst +  4), _mm_unpackhi_epi16(lo_bg, lo_ra));
+         _mm_storeu_si128((__m128i*)(dst +  8), _mm_unpacklo_epi16(hi_bg, hi_ra));
+         _mm_storeu_si128((__m128i*)(dst + 12), _mm_unpackhi_epi16(hi_bg, hi_ra));
+      }
+
+      for (; w < width; w += 2, src += 4, dst += 2)
+         yuyv_argb8888_pair(dst, src);
+   }
+}
+
+/* Same as the AVX2 version, on 16-byte vectors. */
+static PIXCONV_SSSE3 void conv_copy_ssse3(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, i;
+   int copy_len         = abs(out_stride);
+   const uint8_t *input = (const uint8_t*)input_;
+   uint8_t *output      = (uint8_t*)output_;
+
+   if (abs(in_stride) < copy_len)
+      copy_len = abs(in_stride);
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride)
+   {
+      if (copy_len < 16)
+      {
+         memcpy(output, input, copy_len);
+         continue;
+      }
+
+      _mm_storeu_si128((__m128i*)output,
+            _mm_loadu_si128((const __m128i*)input));
+
+      for (i = 16 - ((uintptr_t)output & 15); i + 64 <= copy_len; i += 64)
+      {
+         const __m128i a = _mm_loadu_si128((const __m128i*)(input + i +  0));
+         const __m128i b = _mm_loadu_si128((const __m128i*)(input + i + 16));
+         const __m128i c = _mm_loadu_si128((const __m128i*)(input + i + 32));
+         const __m128i d = _mm_loadu_si128((const __m128i*)(input + i + 48));
+         _mm_store_si128((__m128i*)(output + i +  0), a);
+         _mm_store_si128((__m128i*)(output + i + 16), b);
+         _mm_store_si128((__m128i*)(output + i + 32), c);
+         _mm_store_si128((__m128i*)(output + i + 48), d);
+      }
+
+      for (; i + 16 <= copy_len; i += 16)
+         _mm_store_si128((__m128i*)(output + i),
+               _mm_loadu_si128((const __m128i*)(input + i)));
+
+      if (i < copy_len)
+         _mm_storeu_si128((__m128i*)(output + copy_len - 16),
+               _mm_loadu_si128((const __m128i*)(input + copy_len - 16)));
+   }
+}
+
+static PIXCONV_SSSE3 void conv_rgba4444_argb8888_ssse3(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+   const __m128i mask_lo = _mm_set1_epi16(0x000f);
+   const __m128i mask_hi = _mm_set1_epi16(0x0f00);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         __m128i bg, ra;
+         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+
+         bg = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(in, 4), mask_lo),
+               _mm_and_si128(in, mask_hi));
+         ra = _mm_or_si128(_mm_srli_epi16(in, 12),
+               _mm_and_si128(_mm_slli_epi16(in, 8), mask_hi));
+         bg = _mm_or_si128(bg, _mm_slli_epi16(bg, 4));
+         ra = _mm_or_si128(ra, _mm_slli_epi16(ra, 4));
+
+         _mm_storeu_si128((__m128i*)(output + w + 0),
+               _mm_unpacklo_epi16(bg, ra));
+         _mm_storeu_si128((__m128i*)(output + w + 4),
+               _mm_unpackhi_epi16(bg, ra));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r   = (col >> 12) & 0xf;
+         uint32_t g   = (col >>  8) & 0xf;
+         uint32_t b   = (col >>  4) & 0xf;
+         uint32_t a   = (col >>  0) & 0xf;
+         r = (r << 4) | r;
+         g = (g << 4) | g;
+         b = (b << 4) | b;
+         a = (a << 4) | a;
+
+         output[w] = (a << 24) | (r << 16) | (g << 8) | (b << 0);
+      }
+   }
+}
+
+static PIXCONV_SSSE3 void conv_rgba4444_rgb565_ssse3(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+   const __m128i mask_r  = _mm_set1_epi16((int16_t)0xf000);
+   const __m128i mask_g  = _mm_set1_epi16(0x0780);
+   const __m128i mask_b  = _mm_set1_epi16(0x001e);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+         __m128i r = _mm_and_si128(in, mask_r);
+         __m128i g = _mm_and_si128(_mm_srli_epi16(in, 1), mask_g);
+         __m128i b = _mm_and_si128(_mm_srli_epi16(in, 3), mask_b);
+         _mm_storeu_si128((__m128i*)(output + w),
+               _mm_or_si128(r, _mm_or_si128(g, b)));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r   = (col >> 12) & 0xf;
+         uint32_t g   = (col >>  8) & 0xf;
+         uint32_t b   = (col >>  4) & 0xf;
+
+         output[w] = (r << 12) | (g << 7) | (b << 1);
+      }
+   }
+}
+
+/* The low halves of the 32-bit words in lo, then those in hi.
+ * There is no unsigned 32-bit pack before SSE4.1. */
+static INLINE PIXCONV_SSSE3 __m128i pack_lo16_ssse3(__m128i lo, __m128i hi)
+{
+   const __m128i pick = _mm_setr_epi8(
+         0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+
+   return _mm_unpacklo_epi64(_mm_shuffle_epi8(lo, pick),
+         _mm_shuffle_epi8(hi, pick));
+}
+
+static PIXCONV_SSSE3 void conv_argb8888_0rgb1555_ssse3(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+   const __m128i mask_r  = _mm_set1_epi32(0x1f << 10);
+   const __m128i mask_g  = _mm_set1_epi32(0x1f <<  5);
+   const __m128i mask_b  = _mm_set1_epi32(0x1f);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         __m128i res[2];
+         int i;
+
+         for (i = 0; i < 2; i++)
+         {
+            const __m128i in = _mm_loadu_si128(
+                  (const __m128i*)(input + w + 4 * i));
+            __m128i r = _mm_and_si128(_mm_srli_epi32(in, 9), mask_r);
+            __m128i g = _mm_and_si128(_mm_srli_epi32(in, 6), mask_g);
+            __m128i b = _mm_and_si128(_mm_srli_epi32(in, 3), mask_b);
+            res[i]    = _mm_or_si128(r, _mm_or_si128(g, b));
+         }
+
+         _mm_storeu_si128((__m128i*)(output + w),
+               pack_lo16_ssse3(res[0], res[1]));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint16_t r   = (col >> 19) & 0x1f;
+         uint16_t g   = (col >> 11) & 0x1f;
+         uint16_t b   = (col >>  3) & 0x1f;
+         output[w]    = (r << 10) | (g << 5) | (b << 0);
+      }
+   }
+}
+
+static PIXCONV_SSSE3 void conv_argb8888_rgb565_ssse3(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+   const __m128i mask_r  = _mm_set1_epi32(0x1f << 11);
+   const __m128i mask_g  = _mm_set1_epi32(0x3f <<  5);
+   const __m128i mask_b  = _mm_set1_epi32(0x1f);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         __m128i res[2];
+         int i;
+
+         for (i = 0; i < 2; i++)
+         {
+            const __m128i in = _mm_loadu_si128(
+                  (const __m128i*)(input + w + 4 * i));
+            __m128i r = _mm_and_si128(_mm_srli_epi32(in, 8), mask_r);
+            __m128i g = _mm_and_si128(_mm_srli_epi32(in, 5), mask_g);
+            __m128i b = _mm_and_si128(_mm_srli_epi32(in, 3), mask_b);
+            res[i]    = _mm_or_si128(r, _mm_or_si128(g, b));
+         }
+
+         _mm_storeu_si128((__m128i*)(output + w),
+               pack_lo16_ssse3(res[0], res[1]));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint16_t r   = (col >> 19) & 0x1f;
+         uint16_t g   = (col >> 10) & 0x3f;
+         uint16_t b   = (col >>  3) & 0x1f;
+         output[w]    = (r << 11) | (g << 5) | (b << 0);
+      }
+   }
+}
+
+static PIXCONV_SSSE3 void conv_argb8888_abgr8888_ssse3(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+   const __m128i swap_rb = _mm_setr_epi8(
+         2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 2)
+   {
+      for (w = 0; w + 4 <= width; w += 4)
+         _mm_storeu_si128((__m128i*)(output + w), _mm_shuffle_epi8(
+                  _mm_loadu_si128((const __m128i*)(input + w)), swap_rb));
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         output[w] = ((col << 16) & 0xff0000) |
+            ((col >> 16) & 0xff) | (col & 0xff00ff00);
+      }
+   }
+}
+#endif
+
+#ifdef PIXCONV_NEON
+/* 8 pixels at a time, with the structured loads and stores
+ * doing the (de)interleaving. */
+
+static INLINE uint8x8_t expand5_neon(uint8x8_t x)
+{
+   return vorr_u8(vshl_n_u8(x, 3), vshr_n_u8(x, 2));
+}
+
+static INLINE uint8x8_t expand6_neon(uint8x8_t x)
+{
+   return vorr_u8(vshl_n_u8(x, 2), vshr_n_u8(x, 4));
+}
+
+static INLINE uint8x8_t expand4_neon(uint8x8_t x)
+{
+   return vorr_u8(vshl_n_u8(x, 4), x);
+}
+
+/* Eight pixels, expanded to 8-bit R, G and B. */
+static INLINE void unpack_0rgb1555_neon(const uint16_t *input,
+      uint8x8_t *r, uint8x8_t *g, uint8x8_t *b)
+{
+   const uint16x8_t in = vld1q_u16(input);
+   const uint8x8_t mask = vdup_n_u8(0x1f);
+
+   *r = expand5_neon(vand_u8(vmovn_u16(vshrq_n_u16(in, 10)), mask));
+   *g = expand5_neon(vand_u8(vmovn_u16(vshrq_n_u16(in,  5)), mask));
+   *b = expand5_neon(vand_u8(vmovn_u16(in), mask));
+}
+
+static INLINE void unpack_rgb565_neon(const uint16_t *input,
+      uint8x8_t *r, uint8x8_t *g, uint8x8_t *b)
+{
+   const uint16x8_t in = vld1q_u16(input);
+
+   *r = expand5_neon(vmovn_u16(vshrq_n_u16(in, 11)));
+   *g = expand6_neon(vand_u8(vmovn_u16(vshrq_n_u16(in, 5)), vdup_n_u8(0x3f)));
+   *b = expand5_neon(vand_u8(vmovn_u16(in), vdup_n_u8(0x1f)));
+}
+
+static void conv_rgb565_0rgb1555_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         uint16x8_t in = vld1q_u16(input + w);
+         vst1q_u16(output + w, vorrq_u16(
+                  vandq_u16(vshrq_n_u16(in, 1), vdupq_n_u16(0x7fe0)),
+                  vandq_u16(in, vdupq_n_u16(0x1f))));
+      }
+
+      for (; w < width; w++)
+      {
+         uint16_t col = input[w];
+         uint16_t hi  = (col >> 1) & 0x7fe0;
+         uint16_t lo  = col & 0x1f;
+         output[w]    = hi | lo;
+      }
+   }
+}
+
+static void conv_0rgb1555_rgb565_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         uint16x8_t in   = vld1q_u16(input + w);
+         uint16x8_t rg   = vandq_u16(vshlq_n_u16(in, 1),
+               vdupq_n_u16((0x1f << 11) | (0x1f << 6)));
+         uint16x8_t b    = vandq_u16(in, vdupq_n_u16(0x1f));
+         uint16x8_t glow = vandq_u16(vshrq_n_u16(in, 4), vdupq_n_u16(1 << 5));
+         vst1q_u16(output + w, vorrq_u16(rg, vorrq_u16(b, glow)));
+      }
+
+      for (; w < width; w++)
+      {
+         uint16_t col  = input[w];
+         uint16_t rg   = (col << 1) & ((0x1f << 11) | (0x1f << 6));
+         uint16_t b    = col & 0x1f;
+         uint16_t glow = (col >> 4) & (1 << 5);
+         output[w]     = rg | b | glow;
+      }
+   }
+}
+
+static void conv_0rgb1555_argb8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         uint8x8x4_t res;
+         unpack_0rgb1555_neon(input + w, &res.val[2], &res.val[1], &res.val[0]);
+         res.val[3] = vdup_n_u8(0xff);
+         vst4_u8((uint8_t*)(output + w), res);
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r   = (col >> 10) & 0x1f;
+         uint32_t g   = (col >>  5) & 0x1f;
+         uint32_t b   = (col >>  0) & 0x1f;
+         r = (r << 3) | (r >> 2);
+         g = (g << 3) | (g >> 2);
+         b = (b << 3) | (b >> 2);
+
+         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+      }
+   }
+}
+
+static void conv_rgb565_argb8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         uint8x8x4_t res;
+         unpack_rgb565_neon(input + w, &res.val[2], &res.val[1], &res.val[0]);
+         res.val[3] = vdup_n_u8(0xff);
+         vst4_u8((uint8_t*)(output + w), res);
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r   = (col >> 11) & 0x1f;
+         uint32_t g   = (col >>  5) & 0x3f;
+         uint32_t b   = (col >>  0) & 0x1f;
+         r = (r << 3) | (r >> 2);
+         g = (g << 2) | (g >> 4);
+         b = (b << 3) | (b >> 2);
+
+         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+      }
+   }
+}
+
+static void conv_rgba4444_argb8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         uint8x8x4_t res;
+         const uint16x8_t in  = vld1q_u16(input + w);
+         const uint8x8_t mask = vdup_n_u8(0xf);
+
+         res.val[0] = expand4_neon(vand_u8(vmovn_u16(vshrq_n_u16(in,  4)), mask));
+         res.val[1] = expand4_neon(vand_u8(vmovn_u16(vshrq_n_u16(in,  8)), mask));
+         res.val[2] = expand4_neon(vmovn_u16(vshrq_n_u16(in, 12)));
+         res.val[3] = expand4_neon(vand_u8(vmovn_u16(in), mask));
+         vst4_u8((uint8_t*)(output + w), res);
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r   = (col >> 12) & 0xf;
+         uint32_t g   = (col >>  8) & 0xf;
+         uint32_t b   = (col >>  4) & 0xf;
+         uint32_t a   = (col >>  0) & 0xf;
+         r = (r << 4) | r;
+         g = (g << 4) | g;
+         b = (b << 4) | b;
+         a = (a << 4) | a;
+
+         output[w] = (a << 24) | (r << 16) | (g << 8) | (b << 0);
+      }
+   }
+}
+
+static void conv_rgba4444_rgb565_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         uint16x8_t in = vld1q_u16(input + w);
+         uint16x8_t r  = vandq_u16(in, vdupq_n_u16(0xf000));
+         uint16x8_t g  = vandq_u16(vshrq_n_u16(in, 1), vdupq_n_u16(0x0780));
+         uint16x8_t b  = vandq_u16(vshrq_n_u16(in, 3), vdupq_n_u16(0x001e));
+         vst1q_u16(output + w, vorrq_u16(r, vorrq_u16(g, b)));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t r   = (col >> 12) & 0xf;
+         uint32_t g   = (col >>  8) & 0xf;
+         uint32_t b   = (col >>  4) & 0xf;
+
+         output[w] = (r << 12) | (g << 7) | (b << 1);
+      }
+   }
+}
+
+static void conv_0rgb1555_bgr24_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+   {
+      uint8_t *out = output;
+
+      for (w = 0; w + 8 <= width; w += 8, out += 24)
+      {
+         uint8x8x3_t res;
+         unpack_0rgb1555_neon(input + w, &res.val[2], &res.val[1], &res.val[0]);
+         vst3_u8(out, res);
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t b   = (col >>  0) & 0x1f;
+         uint32_t g   = (col >>  5) & 0x1f;
+         uint32_t r   = (col >> 10) & 0x1f;
+         b = (b << 3) | (b >> 2);
+         g = (g << 3) | (g >> 2);
+         r = (r << 3) | (r >> 2);
+
+         *out++ = b;
+         *out++ = g;
+         *out++ = r;
+      }
+   }
+}
+
+static void conv_rgb565_bgr24_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+   {
+      uint8_t *out = output;
+
+      for (w = 0; w + 8 <= width; w += 8, out += 24)
+      {
+         uint8x8x3_t res;
+         unpack_rgb565_neon(input + w, &res.val[2], &res.val[1], &res.val[0]);
+         vst3_u8(out, res);
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint32_t b   = (col >>  0) & 0x1f;
+         uint32_t g   = (col >>  5) & 0x3f;
+         uint32_t r   = (col >> 11) & 0x1f;
+         b = (b << 3) | (b >> 2);
+         g = (g << 2) | (g >> 4);
+         r = (r << 3) | (r >> 2);
+
+         *out++ = b;
+         *out++ = g;
+         *out++ = r;
+      }
+   }
+}
+
+static void conv_bgr24_argb8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint8_t *input = (const uint8_t*)input_;
+   uint32_t *output     = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride)
+   {
+      const uint8_t *inp = input;
+
+      for (w = 0; w + 8 <= width; w += 8, inp += 24)
+      {
+         uint8x8x3_t in = vld3_u8(inp);
+         uint8x8x4_t res;
+
+         res.val[0] = in.val[0];
+         res.val[1] = in.val[1];
+         res.val[2] = in.val[2];
+         res.val[3] = vdup_n_u8(0xff);
+         vst4_u8((uint8_t*)(output + w), res);
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t b = *inp++;
+         uint32_t g = *inp++;
+         uint32_t r = *inp++;
+         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+      }
+   }
+}
+
+static void conv_argb8888_0rgb1555_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+         uint16x8_t r   = vshlq_n_u16(vmovl_u8(vshr_n_u8(in.val[2], 3)), 10);
+         uint16x8_t g   = vshlq_n_u16(vmovl_u8(vshr_n_u8(in.val[1], 3)),  5);
+         uint16x8_t b   = vmovl_u8(vshr_n_u8(in.val[0], 3));
+         vst1q_u16(output + w, vorrq_u16(r, vorrq_u16(g, b)));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint16_t r   = (col >> 19) & 0x1f;
+         uint16_t g   = (col >> 11) & 0x1f;
+         uint16_t b   = (col >>  3) & 0x1f;
+         output[w]    = (r << 10) | (g << 5) | (b << 0);
+      }
+   }
+}
+
+static void conv_argb8888_rgb565_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+         uint16x8_t r   = vshlq_n_u16(vmovl_u8(vshr_n_u8(in.val[2], 3)), 11);
+         uint16x8_t g   = vshlq_n_u16(vmovl_u8(vshr_n_u8(in.val[1], 2)),  5);
+         uint16x8_t b   = vmovl_u8(vshr_n_u8(in.val[0], 3));
+         vst1q_u16(output + w, vorrq_u16(r, vorrq_u16(g, b)));
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint16_t r   = (col >> 19) & 0x1f;
+         uint16_t g   = (col >> 10) & 0x3f;
+         uint16_t b   = (col >>  3) & 0x1f;
+         output[w]    = (r << 11) | (g << 5) | (b << 0);
+      }
+   }
+}
+
+static void conv_argb8888_bgr24_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 2)
+   {
+      uint8_t *out = output;
+
+      for (w = 0; w + 8 <= width; w += 8, out += 24)
+      {
+         uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+         uint8x8x3_t res;
+
+         res.val[0] = in.val[0];
+         res.val[1] = in.val[1];
+         res.val[2] = in.val[2];
+         vst3_u8(out, res);
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         *out++ = (uint8_t)(col >>  0);
+         *out++ = (uint8_t)(col >>  8);
+         *out++ = (uint8_t)(col >> 16);
+      }
+   }
+}
+
+static void conv_argb8888_abgr8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 2)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+         uint8x8_t b    = in.val[0];
+
+         in.val[0] = in.val[2];
+         in.val[2] = b;
+         vst4_u8((uint8_t*)(output + w), in);
+      }
+
+      for (; w < width; w++)
+      {
+         uint32_t col = input[w];
+         output[w] = ((col << 16) & 0xff0000) |
+            ((col >> 16) & 0xff) | (col & 0xff00ff00);
+      }
+   }
+}
+
+static void conv_yuyv_argb8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint8_t *input = (const uint8_t*)input_;
+   uint32_t *output     = (uint32_t*)output_;
+   const uint8x8_t a    = vdup_n_u8(0xff);
+
+   for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride)
+   {
+      const uint8_t *src = input;
+      uint32_t      *dst = output;
+
+      for (w = 0; w + 16 <= width; w += 16, src += 32, dst += 16)
+      {
+         uint8x8_t r[2], g[2], b[2];
+         uint8x8x2_t r_zip, g_zip, b_zip;
+         uint8x8x4_t res;
+         int i;
+         /* Y0, U, Y1 and V of 8 pixel pairs. */
+         const uint8x8x4_t yuyv = vld4_u8(src);
+         const int16x8_t u      = vreinterpretq_s16_u16(
+               vsubl_u8(yuyv.val[1], vdup_n_u8(128)));
+         const int16x8_t v      = vreinterpretq_s16_u16(
+               vsubl_u8(yuyv.val[3], vdup_n_u8(128)));
+         const int16x8_t r_uv   = vmulq_n_s16(v, YUV_MAT_V_R);
+         const int16x8_t g_uv   = vmlaq_n_s16(
+               vmulq_n_s16(u, YUV_MAT_U_G), v, YUV_MAT_V_G);
+         const int16x8_t b_uv   = vmulq_n_s16(u, YUV_MAT_U_B);
+
+         /* Even pixels, then odd. The rounding narrowing shift
+          * adds YUV_OFFSET and saturates like clamp_8bit(). */
+         for (i = 0; i < 2; i++)
+         {
+            const int16x8_t y = vmulq_n_s16(vreinterpretq_s16_u16(
+                     vmovl_u8(yuyv.val[2 * i])), YUV_MAT_Y);
+
+            r[i] = vqrshrun_n_s16(vaddq_s16(y, r_uv), YUV_SHIFT);
+            g[i] = vqrshrun_n_s16(vaddq_s16(y, g_uv), YUV_SHIFT);
+            b[i] = vqrshrun_n_s16(vaddq_s16(y, b_uv), YUV_SHIFT);
+         }
+
+         r_zip = vzip_u8(r[0], r[1]);
+         g_zip = vzip_u8(g[0], g[1]);
+         b_zip = vzip_u8(b[0], b[1]);
+
+         for (i = 0; i < 2; i++)
+         {
+            res.val[0] = b_zip.val[i];
+            res.val[1] = g_zip.val[i];
+            res.val[2] = r_zip.val[i];
+            res.val[3] = a;
+            vst4_u8((uint8_t*)(dst + 8 * i), res);
+         }
+      }
+
+      for (; w < width; w += 2, src += 4, dst += 2)
+         yuyv_argb8888_pair(dst, src);
+   }
+}
+
+static void conv_copy_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, i;
+   int copy_len         = abs(out_stride);
+   const uint8_t *input = (const uint8_t*)input_;
+   uint8_t *output      = (uint8_t*)output_;
+
+   if (abs(in_stride) < copy_len)
+      copy_len = abs(in_stride);
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride)
+   {
+      for (i = 0; i + 64 <= copy_len; i += 64)
+      {
+         const uint8x16_t a = vld1q_u8(input + i +  0);
+         const uint8x16_t b = vld1q_u8(input + i + 16);
+         const uint8x16_t c = vld1q_u8(input + i + 32);
+         const uint8x16_t d = vld1q_u8(input + i + 48);
+         vst1q_u8(output + i +  0, a);
+         vst1q_u8(output + i + 16, b);
+         vst1q_u8(output + i + 32, c);
+         vst1q_u8(output + i + 48, d);
+      }
+
+      memcpy(output + i, input + i, copy_len - i);
+   }
+}
+#endif
+
+
+#if defined(__SSE2__)
 void conv_rgb565_0rgb1555(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
@@ -49,13 +1759,15 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
    const __m128i hi_mask   = _mm_set1_epi16(0x7fe0);
    const __m128i lo_mask   = _mm_set1_epi16(0x1f);
 
+   PIXCONV_SIMD(conv_rgb565_0rgb1555, avx2);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
       for (w = 0; w < max_width; w += 8)
       {
          const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i hi = _mm_and_si128(_mm_slli_epi16(in, 1), hi_mask);
+         __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 1), hi_mask);
          __m128i lo = _mm_and_si128(in, lo_mask);
          _mm_storeu_si128((__m128i*)(output + w), _mm_or_si128(hi, lo));
       }
@@ -78,6 +1790,8 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint16_t      *output = (uint16_t*)output_;
 
+   PIXCONV_SIMD(conv_rgb565_0rgb1555, avx2);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
@@ -109,6 +1823,8 @@ void conv_0rgb1555_rgb565(void *output_, const void *input_,
    const __m128i lo_mask   = _mm_set1_epi16(0x1f);
    const __m128i glow_mask = _mm_set1_epi16(1 << 5);
 
+   PIXCONV_SIMD(conv_0rgb1555_rgb565, avx2);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
@@ -141,6 +1857,8 @@ void conv_0rgb1555_rgb565(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint16_t *output = (uint16_t*)output_;
 
+   PIXCONV_SIMD(conv_0rgb1555_rgb565, avx2);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
@@ -173,6 +1891,8 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
 
    int max_width = width - 7;
 
+   PIXCONV_SIMD(conv_0rgb1555_argb8888, avx2);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
@@ -227,6 +1947,8 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
+   PIXCONV_SIMD(conv_0rgb1555_argb8888, avx2);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
@@ -265,6 +1987,8 @@ void conv_rgb565_argb8888(void *output_, const void *input_,
 
    int max_width            = width - 7;
 
+   PIXCONV_SIMD(conv_rgb565_argb8888, avx2);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
@@ -318,6 +2042,8 @@ void conv_rgb565_argb8888(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
+   PIXCONV_SIMD(conv_rgb565_argb8888, avx2);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
@@ -345,6 +2071,9 @@ void conv_rgba4444_argb8888(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
+   PIXCONV_SIMD(conv_rgba4444_argb8888, avx2);
+   PIXCONV_SIMD(conv_rgba4444_argb8888, ssse3);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
@@ -373,6 +2102,9 @@ void conv_rgba4444_rgb565(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint16_t *output      = (uint16_t*)output_;
 
+   PIXCONV_SIMD(conv_rgba4444_rgb565, avx2);
+   PIXCONV_SIMD(conv_rgba4444_rgb565, ssse3);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
@@ -450,6 +2182,8 @@ void conv_0rgb1555_bgr24(void *output_, const void *input_,
 
    int max_width             = width - 15;
 
+   PIXCONV_SIMD(conv_0rgb1555_bgr24, ssse3);
+
    for (h = 0; h < height;
          h++, output += out_stride, input += in_stride >> 1)
    {
@@ -533,6 +2267,8 @@ void conv_rgb565_bgr24(void *output_, const void *input_,
 
    int max_width            = width - 15;
 
+   PIXCONV_SIMD(conv_rgb565_bgr24, ssse3);
+
    for (h = 0; h < height; h++, output += out_stride, input += in_stride >> 1)
    {
       uint8_t *out = output;
@@ -604,6 +2340,8 @@ void conv_0rgb1555_bgr24(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint8_t *output       = (uint8_t*)output_;
 
+   PIXCONV_SIMD(conv_0rgb1555_bgr24, ssse3);
+
    for (h = 0; h < height;
          h++, output += out_stride, input += in_stride >> 1)
    {
@@ -633,6 +2371,8 @@ void conv_rgb565_bgr24(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint8_t *output       = (uint8_t*)output_;
 
+   PIXCONV_SIMD(conv_rgb565_bgr24, ssse3);
+
    for (h = 0; h < height;
          h++, output += out_stride, input += in_stride >> 1)
    {
@@ -663,6 +2403,8 @@ void conv_bgr24_argb8888(void *output_, const void *input_,
    const uint8_t *input = (const uint8_t*)input_;
    uint32_t *output     = (uint32_t*)output_;
 
+   PIXCONV_SIMD(conv_bgr24_argb8888, ssse3);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride)
    {
@@ -685,6 +2427,9 @@ void conv_argb8888_0rgb1555(void *output_, const void *input_,
    const uint32_t *input = (const uint32_t*)input_;
    uint16_t *output      = (uint16_t*)output_;
 
+   PIXCONV_SIMD(conv_argb8888_0rgb1555, avx2);
+   PIXCONV_SIMD(conv_argb8888_0rgb1555, ssse3);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 2)
    {
@@ -699,6 +2444,31 @@ void conv_argb8888_0rgb1555(void *output_, const void *input_,
    }
 }
 
+void conv_argb8888_rgb565(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   PIXCONV_SIMD(conv_argb8888_rgb565, avx2);
+   PIXCONV_SIMD(conv_argb8888_rgb565, ssse3);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      for (w = 0; w < width; w++)
+      {
+         uint32_t col = input[w];
+         uint16_t r = (col >> 19) & 0x1f;
+         uint16_t g = (col >> 10) & 0x3f;
+         uint16_t b = (col >>  3) & 0x1f;
+         output[w] = (r << 11) | (g << 5) | (b << 0);
+      }
+   }
+}
+
 #if defined(__SSE2__)
 void conv_argb8888_bgr24(void *output_, const void *input_,
       int width, int height,
@@ -710,6 +2480,8 @@ void conv_argb8888_bgr24(void *output_, const void *input_,
 
    int max_width = width - 15;
 
+   PIXCONV_SIMD(conv_argb8888_bgr24, ssse3);
+
    for (h = 0; h < height;
          h++, output += out_stride, input += in_stride >> 2)
    {
@@ -742,6 +2514,8 @@ void conv_argb8888_bgr24(void *output_, const void *input_,
    const uint32_t *input = (const uint32_t*)input_;
    uint8_t *output       = (uint8_t*)output_;
 
+   PIXCONV_SIMD(conv_argb8888_bgr24, ssse3);
+
    for (h = 0; h < height;
          h++, output += out_stride, input += in_stride >> 2)
    {
@@ -765,6 +2539,9 @@ void conv_argb8888_abgr8888(void *output_, const void *input_,
    const uint32_t *input = (const uint32_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
+   PIXCONV_SIMD(conv_argb8888_abgr8888, avx2);
+   PIXCONV_SIMD(conv_argb8888_abgr8888, ssse3);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 2)
    {
@@ -777,14 +2554,6 @@ void conv_argb8888_abgr8888(void *output_, const void *input_,
    }
 }
 
-#define YUV_SHIFT 6
-#define YUV_OFFSET (1 << (YUV_SHIFT - 1))
-#define YUV_MAT_Y (1 << 6)
-#define YUV_MAT_U_G (-22)
-#define YUV_MAT_U_B (113)
-#define YUV_MAT_V_R (90)
-#define YUV_MAT_V_G (-46)
-
 #if defined(__SSE2__)
 void conv_yuyv_argb8888(void *output_, const void *input_,
       int width, int height,
@@ -808,6 +2577,9 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
    const __m128i a             = _mm_cmpeq_epi16(
          _mm_setzero_si128(), _mm_setzero_si128());
 
+   PIXCONV_SIMD(conv_yuyv_argb8888, avx2);
+   PIXCONV_SIMD(conv_yuyv_argb8888, ssse3);
+
    for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride)
    {
       const uint8_t *src = input;
@@ -898,23 +2670,7 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
 
       /* Finish off the rest (if any) in C. */
       for (; w < width; w += 2, src += 4, dst += 2)
-      {
-         int _y0    = src[0];
-         int  u     = src[1] - 128;
-         int _y1    = src[2];
-         int  v     = src[3] - 128;
-
-         uint8_t r0 = clamp_8bit((YUV_MAT_Y * _y0 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t g0 = clamp_8bit((YUV_MAT_Y * _y0 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t b0 = clamp_8bit((YUV_MAT_Y * _y0 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
-
-         uint8_t r1 = clamp_8bit((YUV_MAT_Y * _y1 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t g1 = clamp_8bit((YUV_MAT_Y * _y1 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t b1 = clamp_8bit((YUV_MAT_Y * _y1 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
-
-         dst[0] = 0xff000000u | (r0 << 16) | (g0 << 8) | (b0 << 0);
-         dst[1] = 0xff000000u | (r1 << 16) | (g1 << 8) | (b1 << 0);
-      }
+         yuyv_argb8888_pair(dst, src);
    }
 }
 #else
@@ -926,6 +2682,8 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
    const uint8_t *input = (const uint8_t*)input_;
    uint32_t *output     = (uint32_t*)output_;
 
+   PIXCONV_SIMD(conv_yuyv_argb8888, avx2);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride)
    {
@@ -933,23 +2691,7 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
       uint32_t      *dst = output;
 
       for (w = 0; w < width; w += 2, src += 4, dst += 2)
-      {
-         int _y0    = src[0];
-         int  u     = src[1] - 128;
-         int _y1    = src[2];
-         int  v     = src[3] - 128;
-
-         uint8_t r0 = clamp_8bit((YUV_MAT_Y * _y0 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t g0 = clamp_8bit((YUV_MAT_Y * _y0 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t b0 = clamp_8bit((YUV_MAT_Y * _y0 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
-
-         uint8_t r1 = clamp_8bit((YUV_MAT_Y * _y1 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t g1 = clamp_8bit((YUV_MAT_Y * _y1 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t b1 = clamp_8bit((YUV_MAT_Y * _y1 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
-
-         dst[0] = 0xff000000u | (r0 << 16) | (g0 << 8) | (b0 << 0);
-         dst[1] = 0xff000000u | (r1 << 16) | (g1 << 8) | (b1 << 0);
-      }
+         yuyv_argb8888_pair(dst, src);
    }
 }
 #endif
@@ -966,6 +2708,9 @@ void conv_copy(void *output_, const void *input_,
    if (abs(in_stride) < copy_len)
       copy_len = abs(in_stride);
 
+   PIXCONV_SIMD(conv_copy, avx2);
+   PIXCONV_SIMD(conv_copy, ssse3);
+
    for (h = 0; h < height;
          h++, output += out_stride, input += in_stride)
       memcpy(output, input, copy_len);
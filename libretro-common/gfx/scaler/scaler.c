@@ -28,6 +28,11 @@
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
+#include <retro_miscellaneous.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rpool.h>
+#endif
 
 /* In case aligned allocs are needed later. */
 
@@ -61,14 +66,73 @@ void scaler_free(void *ptr)
       free(ptr);
 }
 
-static bool allocate_frames(struct scaler_ctx *ctx)
+/* Budget for the horizontally scaled lines of one band. The buffer
+ * holds two bands' worth, and still stays in L2 along with the
+ * band's input and output lines. */
+#define SCALER_BAND_SIZE (64 * 1024)
+
+/* Most horizontally scaled lines any band of 'lines' output lines needs. */
+static int scaler_band_height(const struct scaler_ctx *ctx, int lines)
 {
-   ctx->scaled.stride = ((ctx->out_width + 7) & ~7) * sizeof(uint64_t);
+   int line;
+   int height = 0;
+
+   for (line = 0; line < ctx->out_height; line += lines)
+   {
+      int last = min(line + lines, ctx->out_height) - 1;
+      int band = ctx->vert.filter_pos[last] - ctx->vert.filter_pos[line]
+         + ctx->vert.filter_len;
+
+      if (band > height)
+         height = band;
+   }
+
+   return height;
+}
+
+/**
+ * gen_bands:
+ * @ctx          : pointer to scaler context object.
+ *
+ * Picks the tallest band of output lines whose horizontally scaled
+ * input still fits in SCALER_BAND_SIZE, and splits the bands into
+ * slices. Must be called after the filters have been generated.
+ **/
+static void gen_bands(struct scaler_ctx *ctx)
+{
+   int lines     = 1;
+   int threads   = 1;
+   int stride    = ((ctx->out_width + 7) & ~7) * sizeof(uint64_t);
+   int max_lines = SCALER_BAND_SIZE / stride;
+   int max_band;
+
+#ifdef HAVE_THREADS
+   if (ctx->pool && ctx->threads > 1)
+      threads = min((int)ctx->threads, ctx->out_height);
+#endif
+
+   /* Leave at least one band per thread. */
+   max_band = (ctx->out_height + threads - 1) / threads;
+
+   while (lines < max_band
+         && scaler_band_height(ctx, lines + 1) <= max_lines)
+      lines++;
+
+   ctx->band_lines    = lines;
+   ctx->slices        = min(threads,
+         (ctx->out_height + lines - 1) / lines);
+   ctx->scaled.stride = stride;
    ctx->scaled.width  = ctx->out_width;
-   ctx->scaled.height = ctx->in_height;
+   /* Room to slide down the buffer for a while before the lines
+    * still needed have to be moved back to the top. */
+   ctx->scaled.height = 2 * scaler_band_height(ctx, lines);
+}
+
+static bool allocate_frames(struct scaler_ctx *ctx)
+{
    ctx->scaled.frame  = (uint64_t*)
       scaler_alloc(sizeof(uint64_t),
-            (ctx->scaled.stride * ctx->scaled.height) >> 3);
+            ((ctx->scaled.stride * ctx->scaled.height) >> 3) * ctx->slices);
    if (!ctx->scaled.frame)
       return false;
 
@@ -77,7 +141,7 @@ static bool allocate_frames(struct scaler_ctx *ctx)
       ctx->input.stride = ((ctx->in_width + 7) & ~7) * sizeof(uint32_t);
       ctx->input.frame = (uint32_t*)
          scaler_alloc(sizeof(uint32_t),
-               (ctx->input.stride * ctx->in_height) >> 2);
+               (ctx->input.stride >> 2) * ctx->slices);
       if (!ctx->input.frame)
          return false;
    }
@@ -87,7 +151,7 @@ static bool allocate_frames(struct scaler_ctx *ctx)
       ctx->output.stride = ((ctx->out_width + 7) & ~7) * sizeof(uint32_t);
       ctx->output.frame  = (uint32_t*)
          scaler_alloc(sizeof(uint32_t),
-               (ctx->output.stride * ctx->out_height) >> 2);
+               ((ctx->output.stride * ctx->band_lines) >> 2) * ctx->slices);
       if (!ctx->output.frame)
          return false;
    }
@@ -213,56 +277,237 @@ static bool set_pix_conv(struct scaler_ctx *ctx)
    return true;
 }
 
-bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
+/**
+ * scaler_point_convert_special:
+ *
+ * Point sampling with pixel conversion on either side, one band of
+ * output lines at a time. Samples the same pixels as
+ * scaler_argb8888_point_special(), using the filter positions.
+ **/
+static void scaler_point_convert_special(const struct scaler_ctx *ctx,
+      void *output_, const void *input_,
+      int out_width, int out_height,
+      int in_width, int in_height,
+      int out_stride, int in_stride)
 {
-   scaler_ctx_gen_reset(ctx);
+   int line, h, w;
+   int last              = -1;
+   const uint8_t *input  = (const uint8_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
 
-   if (ctx->in_width == ctx->out_width && ctx->in_height == ctx->out_height)
-      ctx->unscaled = true; /* Only pixel format conversion ... */
-   else
+   (void)in_height;
+
+   for (line = 0; line < out_height; line += ctx->band_lines)
    {
-      ctx->scaler_horiz = scaler_argb8888_horiz;
-      ctx->scaler_vert  = scaler_argb8888_vert;
-      ctx->unscaled     = false;
+      int lines      = min(ctx->band_lines, out_height - line);
+      uint32_t *out  = (uint32_t*)(output + line * out_stride);
+      int out_pitch  = out_stride >> 2;
+
+      if (ctx->out_fmt != SCALER_FMT_ARGB8888)
+      {
+         out       = ctx->output.frame;
+         out_pitch = ctx->output.stride >> 2;
+      }
+
+      for (h = 0; h < lines; h++, out += out_pitch)
+      {
+         int y               = ctx->vert.filter_pos[line + h];
+         const uint32_t *src = (const uint32_t*)(input + y * in_stride);
+
+         if (ctx->in_fmt != SCALER_FMT_ARGB8888)
+         {
+            /* Upscaling samples the same line several times in a row. */
+            if (y != last)
+               ctx->in_pixconv(ctx->input.frame, src,
+                     in_width, 1, ctx->input.stride, in_stride);
+            last = y;
+            src  = ctx->input.frame;
+         }
+
+         for (w = 0; w < out_width; w++)
+            out[w] = src[ctx->horiz.filter_pos[w]];
+      }
+
+      if (ctx->out_fmt != SCALER_FMT_ARGB8888)
+         ctx->out_pixconv(output + line * out_stride, ctx->output.frame,
+               out_width, lines, out_stride, ctx->output.stride);
    }
+}
 
-   ctx->scaler_special = NULL;
+/* Frees everything but the filter banks. */
+static void scaler_ctx_reset(struct scaler_ctx *ctx)
+{
+   scaler_free(ctx->scaled.frame);
+   scaler_free(ctx->input.frame);
+   scaler_free(ctx->output.frame);
 
-   if (!allocate_frames(ctx))
-      return false;
+   memset(&ctx->horiz, 0, sizeof(ctx->horiz));
+   memset(&ctx->vert, 0, sizeof(ctx->vert));
+   memset(&ctx->scaled, 0, sizeof(ctx->scaled));
+   memset(&ctx->input, 0, sizeof(ctx->input));
+   memset(&ctx->output, 0, sizeof(ctx->output));
+   ctx->band_lines = 0;
+   ctx->slices     = 0;
+}
 
-   if (ctx->unscaled)
+void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
+{
+   scaler_ctx_reset(ctx);
+   scaler_free_filter_banks(ctx);
+}
+
+bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
+{
+   scaler_ctx_reset(ctx);
+
+   ctx->scaler_special = NULL;
+
+   if (ctx->in_width == ctx->out_width && ctx->in_height == ctx->out_height)
    {
-      if (!set_direct_pix_conv(ctx))
-         return false;
+      /* Only pixel format conversion ... */
+      ctx->unscaled = true;
+      return set_direct_pix_conv(ctx);
    }
-   else
+
+   ctx->scaler_horiz = scaler_argb8888_horiz;
+   ctx->scaler_vert  = scaler_argb8888_vert;
+   ctx->unscaled     = false;
+
+#ifdef SCALER_HAVE_AVX2
+   if (scaler_cpu_has_avx2())
    {
-      if (!set_pix_conv(ctx))
-         return false;
+      ctx->scaler_horiz = scaler_argb8888_horiz_avx2;
+      ctx->scaler_vert  = scaler_argb8888_vert_avx2;
    }
+#endif
 
-   if (!ctx->unscaled && !scaler_gen_filter(ctx))
+   if (!set_pix_conv(ctx))
       return false;
 
-   return true;
+   if (!scaler_gen_filter(ctx))
+      return false;
+
+   /* The point special path works on whole ARGB8888 frames.
+    * Rather than converting whole frames around it, convert
+    * each line as it is sampled. */
+   if (ctx->scaler_special == scaler_argb8888_point_special
+         && (ctx->in_fmt != SCALER_FMT_ARGB8888
+            || ctx->out_fmt != SCALER_FMT_ARGB8888))
+      ctx->scaler_special = scaler_point_convert_special;
+
+   gen_bands(ctx);
+
+   return allocate_frames(ctx);
 }
 
-void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
+struct scaler_slice
 {
-   scaler_free(ctx->horiz.filter);
-   scaler_free(ctx->horiz.filter_pos);
-   scaler_free(ctx->vert.filter);
-   scaler_free(ctx->vert.filter_pos);
-   scaler_free(ctx->scaled.frame);
-   scaler_free(ctx->input.frame);
-   scaler_free(ctx->output.frame);
+   struct scaler_ctx *ctx;
+   void *output;
+   const void *input;
+};
 
-   memset(&ctx->horiz, 0, sizeof(ctx->horiz));
-   memset(&ctx->vert, 0, sizeof(ctx->vert));
-   memset(&ctx->scaled, 0, sizeof(ctx->scaled));
-   memset(&ctx->input, 0, sizeof(ctx->input));
-   memset(&ctx->output, 0, sizeof(ctx->output));
+/**
+ * scaler_scale_slice:
+ * @data         : pointer to a struct scaler_slice.
+ * @slice        : index of the slice to scale.
+ *
+ * Scales one slice of bands of output lines with that slice's
+ * buffers. Each input line is converted, scaled horizontally and
+ * consumed by the vertical pass while it is still in cache.
+ **/
+static void scaler_scale_slice(void *data, unsigned slice)
+{
+   int line;
+   const struct scaler_slice *job = (const struct scaler_slice*)data;
+   struct scaler_ctx *ctx = job->ctx;
+   int first              = 0; /* First input line in the buffer. */
+   int count              = 0; /* How many lines follow it. */
+   int base               = 0; /* Buffer row holding 'first'. */
+   const int scaled_pitch = ctx->scaled.stride >> 3;
+   int bands              = (ctx->out_height + ctx->band_lines - 1)
+      / ctx->band_lines;
+   int start              = bands * slice / ctx->slices * ctx->band_lines;
+   int end                = min(bands * (slice + 1) / ctx->slices
+         * ctx->band_lines, ctx->out_height);
+   uint64_t *scaled_frame = ctx->scaled.frame
+      + slice * ctx->scaled.height * scaled_pitch;
+   uint32_t *input_frame  = NULL;
+   uint32_t *output_frame = NULL;
+
+   if (ctx->input.frame)
+      input_frame  = ctx->input.frame + slice * (ctx->input.stride >> 2);
+   if (ctx->output.frame)
+      output_frame = ctx->output.frame
+         + slice * ctx->band_lines * (ctx->output.stride >> 2);
+
+   for (line = start; line < end; line += ctx->band_lines)
+   {
+      int y;
+      int lines    = min(ctx->band_lines, end - line);
+      int top      = ctx->vert.filter_pos[line];
+      int bottom   = ctx->vert.filter_pos[line + lines - 1]
+         + ctx->vert.filter_len;
+      uint8_t *out = (uint8_t*)job->output + line * ctx->out_stride;
+      uint64_t *scaled;
+
+      /* The last band's bottom lines are usually this one's top ones. */
+      if (top < first + count)
+      {
+         base  += top - first;
+         count -= top - first;
+      }
+      else
+      {
+         base  = 0;
+         count = 0;
+      }
+      first = top;
+
+      if (base + (bottom - top) > ctx->scaled.height)
+      {
+         memmove(scaled_frame,
+               scaled_frame + base * scaled_pitch,
+               count * ctx->scaled.stride);
+         base = 0;
+      }
+
+      scaled = scaled_frame + base * scaled_pitch;
+
+      if (ctx->in_fmt == SCALER_FMT_ARGB8888)
+      {
+         if (first + count < bottom)
+            ctx->scaler_horiz(ctx,
+                  (const uint8_t*)job->input + (first + count) * ctx->in_stride,
+                  ctx->in_stride, scaled + count * scaled_pitch,
+                  bottom - first - count);
+      }
+      else
+      {
+         for (y = first + count; y < bottom; y++)
+         {
+            ctx->in_pixconv(input_frame,
+                  (const uint8_t*)job->input + y * ctx->in_stride,
+                  ctx->in_width, 1, ctx->input.stride, ctx->in_stride);
+            ctx->scaler_horiz(ctx, input_frame, ctx->input.stride,
+                  scaled + (y - first) * scaled_pitch, 1);
+         }
+      }
+
+      count = max(count, bottom - first);
+
+      if (ctx->out_fmt == SCALER_FMT_ARGB8888)
+         ctx->scaler_vert(ctx, out, ctx->out_stride,
+               scaled, top, line, lines);
+      else
+      {
+         ctx->scaler_vert(ctx, output_frame, ctx->output.stride,
+               scaled, top, line, lines);
+         ctx->out_pixconv(out, output_frame,
+               ctx->out_width, lines,
+               ctx->out_stride, ctx->output.stride);
+      }
+   }
 }
 
 /**
@@ -276,10 +521,7 @@ void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
 void scaler_ctx_scale(struct scaler_ctx *ctx,
       void *output, const void *input)
 {
-   const void *input_frame = input;
-   void *output_frame      = output;
-   int input_stride        = ctx->in_stride;
-   int output_stride       = ctx->out_stride;
+   struct scaler_slice job;
 
    if (ctx->unscaled)
    {
@@ -290,41 +532,28 @@ void scaler_ctx_scale(struct scaler_ctx *ctx,
       return;
    }
 
-   if (ctx->in_fmt != SCALER_FMT_ARGB8888)
-   {
-      ctx->in_pixconv(ctx->input.frame, input,
-            ctx->in_width, ctx->in_height,
-            ctx->input.stride, ctx->in_stride);
-
-      input_frame       = ctx->input.frame;
-      input_stride      = ctx->input.stride;
-   }
-
-   if (ctx->out_fmt != SCALER_FMT_ARGB8888)
-   {
-      output_frame  = ctx->output.frame;
-      output_stride = ctx->output.stride;
-   }
-
    if (ctx->scaler_special)
    {
       /* Take some special, and (hopefully) more optimized path. */
-      ctx->scaler_special(ctx, output_frame, input_frame,
+      ctx->scaler_special(ctx, output, input,
             ctx->out_width, ctx->out_height,
             ctx->in_width, ctx->in_height,
-            output_stride, input_stride);
+            ctx->out_stride, ctx->in_stride);
+      return;
    }
-   else
+
+   /* Take generic filter path, one slice of bands per thread. */
+   job.ctx    = ctx;
+   job.output = output;
+   job.input  = input;
+
+#ifdef HAVE_THREADS
+   if (ctx->slices > 1)
    {
-      /* Take generic filter path. */
-      if (ctx->scaler_horiz)
-         ctx->scaler_horiz(ctx, input_frame, input_stride);
-      if (ctx->scaler_vert)
-         ctx->scaler_vert (ctx, output, output_stride);
+      rpool_parallel_for(ctx->pool, ctx->slices, scaler_scale_slice, &job);
+      return;
    }
+#endif
 
-   if (ctx->out_fmt != SCALER_FMT_ARGB8888)
-      ctx->out_pixconv(output, ctx->output.frame,
-            ctx->out_width, ctx->out_height,
-            ctx->out_stride, ctx->output.stride);
+   scaler_scale_slice(&job, 0);
 }
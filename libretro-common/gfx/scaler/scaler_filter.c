@@ -28,84 +28,57 @@
 #include <string.h>
 #include <retro_inline.h>
 
-static bool allocate_filters(struct scaler_ctx *ctx)
+static bool allocate_filter(struct scaler_filter *filter,
+      int len, int out_len)
 {
-   ctx->horiz.filter     = (int16_t*)scaler_alloc(sizeof(int16_t), ctx->horiz.filter_stride * ctx->out_width);
-   ctx->horiz.filter_pos = (int*)scaler_alloc(sizeof(int), ctx->out_width);
+   filter->filter_len    = len;
+   filter->filter_stride = len;
+   filter->filter        = (int16_t*)scaler_alloc(sizeof(int16_t), len * out_len);
+   filter->filter_pos    = (int*)scaler_alloc(sizeof(int), out_len);
 
-   ctx->vert.filter      = (int16_t*)scaler_alloc(sizeof(int16_t), ctx->vert.filter_stride * ctx->out_height);
-   ctx->vert.filter_pos  = (int*)scaler_alloc(sizeof(int), ctx->out_height);
-
-   return ctx->horiz.filter && ctx->vert.filter;
+   return filter->filter && filter->filter_pos;
 }
 
-static void gen_filter_point_sub(struct scaler_filter *filter,
-      int len, int pos, int step)
+static bool gen_filter_point(struct scaler_filter *filter,
+      int in_len, int out_len)
 {
    int i;
-   for (i = 0; i < len; i++, pos += step)
-   {
-      filter->filter_pos[i] = pos >> 16;
-      filter->filter[i]     = FILTER_UNITY;
-   }
-}
-
-static bool gen_filter_point(struct scaler_ctx *ctx)
-{
-   int x_pos, x_step, y_pos, y_step;
-
-   ctx->horiz.filter_len    = 1;
-   ctx->horiz.filter_stride = 1;
-   ctx->vert.filter_len     = 1;
-   ctx->vert.filter_stride  = 1;
+   int pos  = (1 << 15) * in_len / out_len - (1 << 15);
+   int step = (1 << 16) * in_len / out_len;
 
-   if (!allocate_filters(ctx))
+   if (!allocate_filter(filter, 1, out_len))
       return false;
 
-   x_pos  = (1 << 15) * ctx->in_width / ctx->out_width - (1 << 15);
-   x_step = (1 << 16) * ctx->in_width / ctx->out_width;
-   y_pos  = (1 << 15) * ctx->in_height / ctx->out_height - (1 << 15);
-   y_step = (1 << 16) * ctx->in_height / ctx->out_height;
+   /* Sample the same pixels as scaler_argb8888_point_special(),
+    * which only handles ARGB8888 frames. */
+   if (pos < 0)
+      pos = 0;
 
-   gen_filter_point_sub(&ctx->horiz, ctx->out_width, x_pos, x_step);
-   gen_filter_point_sub(&ctx->vert, ctx->out_height, y_pos, y_step);
-
-   ctx->scaler_special = scaler_argb8888_point_special;
+   for (i = 0; i < out_len; i++, pos += step)
+   {
+      filter->filter_pos[i] = pos >> 16;
+      filter->filter[i]     = FILTER_UNITY;
+   }
 
    return true;
 }
 
-static void gen_filter_bilinear_sub(struct scaler_filter *filter,
-      int len, int pos, int step)
+static bool gen_filter_bilinear(struct scaler_filter *filter,
+      int in_len, int out_len)
 {
    int i;
-   for (i = 0; i < len; i++, pos += step)
+   int pos  = (1 << 15) * in_len / out_len - (1 << 15);
+   int step = (1 << 16) * in_len / out_len;
+
+   if (!allocate_filter(filter, 2, out_len))
+      return false;
+
+   for (i = 0; i < out_len; i++, pos += step)
    {
       filter->filter_pos[i]     = pos >> 16;
       filter->filter[i * 2 + 1] = (pos & 0xffff) >> 2;
       filter->filter[i * 2 + 0] = FILTER_UNITY - filter->filter[i * 2 + 1];
    }
-}
-
-static bool gen_filter_bilinear(struct scaler_ctx *ctx)
-{
-   int x_pos, x_step, y_pos, y_step;
-
-   ctx->horiz.filter_len    = 2;
-   ctx->horiz.filter_stride = 2;
-   ctx->vert.filter_len     = 2;
-   ctx->vert.filter_stride  = 2;
-
-   if (!allocate_filters(ctx))
-      return false;
-
-   x_pos  = (1 << 15) * ctx->in_width / ctx->out_width - (1 << 15);
-   x_step = (1 << 16) * ctx->in_width / ctx->out_width;
-   y_pos  = (1 << 15) * ctx->in_height / ctx->out_height - (1 << 15);
-   y_step = (1 << 16) * ctx->in_height / ctx->out_height;
-
-   gen_filter_bilinear_sub(&ctx->horiz, ctx->out_width, x_pos, x_step);
-   gen_filter_bilinear_sub(&ctx->vert, ctx->out_height, y_pos, y_step);
 
    return true;
 }
@@ -117,13 +90,22 @@ static INLINE double filter_sinc(double phase)
    return sin(phase) / phase;
 }
 
-static void gen_filter_sinc_sub(struct scaler_filter *filter,
-      int len, int pos, int step, double phase_mul)
+static bool gen_filter_sinc(struct scaler_filter *filter,
+      int in_len, int out_len)
 {
    int i, j;
-   const int sinc_size = filter->filter_len;
+   /* Need to expand the filter when downsampling 
+    * to get a proper low-pass effect. */
+   const int sinc_size = 8 * ((in_len > out_len)
+         ? next_pow2(in_len / out_len) : 1);
+   int pos             = (1 << 15) * in_len / out_len - (1 << 15) - (sinc_size << 15);
+   int step            = (1 << 16) * in_len / out_len;
+   double phase_mul    = in_len > out_len ? (double)out_len / in_len : 1.0;
 
-   for (i = 0; i < len; i++, pos += step)
+   if (!allocate_filter(filter, sinc_size, out_len))
+      return false;
+
+   for (i = 0; i < out_len; i++, pos += step)
    {
       filter->filter_pos[i] = pos >> 16;
 
@@ -136,62 +118,153 @@ static void gen_filter_sinc_sub(struct scaler_filter *filter,
          filter->filter[i * sinc_size + j] = sinc_val;
       }
    }
+
+   return true;
 }
 
-static bool gen_filter_sinc(struct scaler_ctx *ctx)
+static double kernel_bicubic(double x)
 {
-   int x_pos, x_step, y_pos, y_step;
-   double phase_mul_horiz, phase_mul_vert;
-   /* Need to expand the filter when downsampling 
-    * to get a proper low-pass effect. */
-   const int sinc_size      = 8 * ((ctx->in_width > ctx->out_width)
-         ? next_pow2(ctx->in_width / ctx->out_width) : 1);
+   /* Keys' cubic with a = -0.5, i.e. Catmull-Rom. */
+   const double a = -0.5;
+
+   x = fabs(x);
+   if (x < 1.0)
+      return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+   if (x < 2.0)
+      return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+   return 0.0;
+}
+
+static double kernel_lanczos3(double x)
+{
+   if (fabs(x) >= 3.0)
+      return 0.0;
+   return filter_sinc(M_PI * x) * filter_sinc(M_PI * x / 3.0);
+}
 
-   ctx->horiz.filter_len    = sinc_size;
-   ctx->horiz.filter_stride = sinc_size;
-   ctx->vert.filter_len     = sinc_size;
-   ctx->vert.filter_stride  = sinc_size;
+/**
+ * gen_filter_weights:
+ * @filter       : filter to fill in.
+ * @type         : SCALER_TYPE_BICUBIC, SCALER_TYPE_LANCZOS3 or
+ *                 SCALER_TYPE_AREA.
+ * @in_len       : input length.
+ * @out_len      : output length.
+ *
+ * Generates filters from a continuous kernel, which is stretched
+ * over the input when downscaling. Taps falling outside the input
+ * are folded onto the edge pixels, and each filter is normalized
+ * to FILTER_UNITY, so they never need fixing up.
+ **/
+static bool gen_filter_weights(struct scaler_filter *filter,
+      enum scaler_type type, int in_len, int out_len)
+{
+   int i, j;
+   double *weights;
+   double ratio   = (double)in_len / out_len;
+   double scale   = ratio > 1.0 ? ratio : 1.0;
+   double support = 0.0;
+   int taps;
 
-   if (!allocate_filters(ctx))
+   switch (type)
+   {
+      case SCALER_TYPE_BICUBIC:
+         support = 2.0 * scale;
+         break;
+      case SCALER_TYPE_LANCZOS3:
+         support = 3.0 * scale;
+         break;
+      case SCALER_TYPE_AREA:
+         /* Covers the output pixel's footprint, plus the input pixel
+          * it starts in. */
+         support = (ratio + 1.0) / 2.0;
+         break;
+      default:
+         return false;
+   }
+
+   taps = (int)ceil(2.0 * support);
+   if (taps > in_len)
+      taps = in_len;
+
+   if (!allocate_filter(filter, taps, out_len))
       return false;
 
-   x_pos  = (1 << 15) * ctx->in_width / ctx->out_width - (1 << 15) - (sinc_size << 15);
-   x_step = (1 << 16) * ctx->in_width / ctx->out_width;
-   y_pos  = (1 << 15) * ctx->in_height / ctx->out_height - (1 << 15) - (sinc_size << 15);
-   y_step = (1 << 16) * ctx->in_height / ctx->out_height;
+   weights = (double*)calloc(taps, sizeof(double));
+   if (!weights)
+      return false;
 
-   phase_mul_horiz = ctx->in_width  > ctx->out_width  ? (double)ctx->out_width  / ctx->in_width  : 1.0;
-   phase_mul_vert  = ctx->in_height > ctx->out_height ? (double)ctx->out_height / ctx->in_height : 1.0;
+   for (i = 0; i < out_len; i++)
+   {
+      double sum    = 0.0;
+      double center = (i + 0.5) * ratio - 0.5;
+      int first    = (int)floor(center - support) + 1;
+      int last     = (int)ceil(center + support) - 1;
+      int pos      = first;
+      int16_t *dst = filter->filter + i * filter->filter_stride;
+      int total    = 0;
+      int peak     = 0;
+
+      if (pos > in_len - taps)
+         pos = in_len - taps;
+      if (pos < 0)
+         pos = 0;
+
+      memset(weights, 0, taps * sizeof(double));
+
+      for (j = first; j <= last; j++)
+      {
+         double w;
+         int in = j < 0 ? 0 : (j >= in_len ? in_len - 1 : j);
 
-   gen_filter_sinc_sub(&ctx->horiz, ctx->out_width, x_pos, x_step, phase_mul_horiz);
-   gen_filter_sinc_sub(&ctx->vert, ctx->out_height, y_pos, y_step, phase_mul_vert);
+         if (type == SCALER_TYPE_AREA)
+         {
+            /* How much of input pixel j the output pixel covers. */
+            double lo = max(i * ratio, (double)j);
+            double hi = min((i + 1) * ratio, (double)(j + 1));
+            w = hi > lo ? hi - lo : 0.0;
+         }
+         else if (type == SCALER_TYPE_BICUBIC)
+            w = kernel_bicubic((j - center) / scale);
+         else
+            w = kernel_lanczos3((j - center) / scale);
 
-   return true;
-}
+         /* Can't happen, the window always covers [first, last]. */
+         if (in - pos < 0 || in - pos >= taps)
+            continue;
 
+         weights[in - pos] += w;
+         sum               += w;
+      }
 
-static bool validate_filter(struct scaler_ctx *ctx)
-{
-   int i;
-   int max_h_pos;
-   int max_w_pos = ctx->in_width - ctx->horiz.filter_len;
+      filter->filter_pos[i] = pos;
 
-   for (i = 0; i < ctx->out_width; i++)
-   {
-      if (ctx->horiz.filter_pos[i] > max_w_pos || ctx->horiz.filter_pos[i] < 0)
+      for (j = 0; j < taps; j++)
       {
-         fprintf(stderr, "Out X = %d => In X = %d\n", i, ctx->horiz.filter_pos[i]); 
-         return false;
+         dst[j] = (int16_t)floor(weights[j] / sum * FILTER_UNITY + 0.5);
+         total += dst[j];
+         if (dst[j] > dst[peak])
+            peak = j;
       }
+
+      /* Rounding error goes to the biggest tap. */
+      dst[peak] += FILTER_UNITY - total;
    }
 
-   max_h_pos = ctx->in_height - ctx->vert.filter_len;
+   free(weights);
+   return true;
+}
+
+static bool validate_filter(const struct scaler_filter *filter,
+      int in_len, int out_len)
+{
+   int i;
+   int max_pos = in_len - filter->filter_len;
 
-   for (i = 0; i < ctx->out_height; i++)
+   for (i = 0; i < out_len; i++)
    {
-      if (ctx->vert.filter_pos[i] > max_h_pos || ctx->vert.filter_pos[i] < 0)
+      if (filter->filter_pos[i] > max_pos || filter->filter_pos[i] < 0)
       {
-         fprintf(stderr, "Out Y = %d => In Y = %d\n", i, ctx->vert.filter_pos[i]); 
+         fprintf(stderr, "Out %d => In %d\n", i, filter->filter_pos[i]); 
          return false;
       }
    }
@@ -199,7 +272,8 @@ static bool validate_filter(struct scaler_ctx *ctx)
    return true;
 }
 
-static void fixup_filter_sub(struct scaler_filter *filter, int out_len, int in_len)
+/* Makes sure that we never sample outside our rectangle. */
+static void fixup_filter(struct scaler_filter *filter, int out_len, int in_len)
 {
    int i;
    int max_pos = in_len - filter->filter_len;
@@ -244,41 +318,125 @@ static void fixup_filter_sub(struct scaler_filter *filter, int out_len, int in_l
    }
 }
 
-/* Makes sure that we never sample outside our rectangle. */
-static void fixup_filter(struct scaler_ctx *ctx)
+static void free_filter(struct scaler_filter *filter)
 {
-   fixup_filter_sub(&ctx->horiz, ctx->out_width, ctx->in_width);
-   fixup_filter_sub(&ctx->vert, ctx->out_height, ctx->in_height);
+   scaler_free(filter->filter);
+   scaler_free(filter->filter_pos);
+   memset(filter, 0, sizeof(*filter));
 }
 
-
-bool scaler_gen_filter(struct scaler_ctx *ctx)
+static bool gen_filter(struct scaler_filter *filter,
+      enum scaler_type type, int in_len, int out_len)
 {
-   bool ret = true;
+   bool ret = false;
 
-   switch (ctx->scaler_type)
+   switch (type)
    {
       case SCALER_TYPE_POINT:
-         ret = gen_filter_point(ctx);
+         ret = gen_filter_point(filter, in_len, out_len);
          break;
 
       case SCALER_TYPE_BILINEAR:
-         ret = gen_filter_bilinear(ctx);
+         ret = gen_filter_bilinear(filter, in_len, out_len);
          break;
 
       case SCALER_TYPE_SINC:
-         ret = gen_filter_sinc(ctx);
+         ret = gen_filter_sinc(filter, in_len, out_len);
+         break;
+
+      case SCALER_TYPE_LANCZOS3:
+      case SCALER_TYPE_BICUBIC:
+      case SCALER_TYPE_AREA:
+         ret = gen_filter_weights(filter, type, in_len, out_len);
          break;
 
       default:
-         return false;
+         break;
+   }
+
+   if (ret)
+   {
+      fixup_filter(filter, out_len, in_len);
+      ret = validate_filter(filter, in_len, out_len);
    }
 
    if (!ret)
-      return false;
+      free_filter(filter);
 
-   fixup_filter(ctx);
+   return ret;
+}
+
+/**
+ * get_filter_bank:
+ * @ctx          : pointer to scaler context object.
+ * @in_len       : input length.
+ * @out_len      : output length.
+ * @avoid        : bank that must not be replaced, or NULL.
+ *
+ * Finds the bank of filters for one axis in the context's cache,
+ * generating it if it isn't there.
+ *
+ * Returns: the bank, or NULL if the filters couldn't be generated.
+ **/
+static struct scaler_filter_bank *get_filter_bank(struct scaler_ctx *ctx,
+      int in_len, int out_len, const struct scaler_filter_bank *avoid)
+{
+   unsigned i;
+   struct scaler_filter_bank *bank = NULL;
+
+   for (i = 0; i < SCALER_FILTER_BANKS; i++)
+   {
+      bank = &ctx->banks[i];
+      if (bank->filter.filter && bank->type == ctx->scaler_type
+            && bank->in_len == in_len && bank->out_len == out_len)
+         return bank;
+   }
+
+   bank = &ctx->banks[ctx->next_bank];
+   if (bank == avoid)
+   {
+      ctx->next_bank = (ctx->next_bank + 1) % SCALER_FILTER_BANKS;
+      bank           = &ctx->banks[ctx->next_bank];
+   }
+   ctx->next_bank = (ctx->next_bank + 1) % SCALER_FILTER_BANKS;
 
-   return validate_filter(ctx);
+   free_filter(&bank->filter);
+
+   if (!gen_filter(&bank->filter, ctx->scaler_type, in_len, out_len))
+      return NULL;
+
+   bank->type    = ctx->scaler_type;
+   bank->in_len  = in_len;
+   bank->out_len = out_len;
+   return bank;
 }
 
+void scaler_free_filter_banks(struct scaler_ctx *ctx)
+{
+   unsigned i;
+
+   for (i = 0; i < SCALER_FILTER_BANKS; i++)
+      free_filter(&ctx->banks[i].filter);
+
+   ctx->next_bank = 0;
+}
+
+bool scaler_gen_filter(struct scaler_ctx *ctx)
+{
+   const struct scaler_filter_bank *horiz = get_filter_bank(ctx,
+         ctx->in_width, ctx->out_width, NULL);
+   const struct scaler_filter_bank *vert  = horiz ? get_filter_bank(ctx,
+         ctx->in_height, ctx->out_height, horiz) : NULL;
+
+   if (!vert)
+      return false;
+
+   /* The filters stay owned by the banks. */
+   ctx->horiz = horiz->filter;
+   ctx->vert  = vert->filter;
+
+   if (ctx->scaler_type == SCALER_TYPE_POINT)
+      ctx->scaler_special = scaler_argb8888_point_special;
+
+   return true;
+}
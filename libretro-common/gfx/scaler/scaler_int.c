@@ -34,6 +34,11 @@
 #endif
 #endif
 
+#ifdef SCALER_HAVE_AVX2
+#include <immintrin.h>
+#define SCALER_AVX2 __attribute__((target("avx2")))
+#endif
+
 /* ARGB8888 scaler is split in two:
  *
  * First, horizontal scaler is applied.
@@ -53,17 +58,17 @@
  */
 
 #if defined(__SSE2__)
-void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride,
+      const uint64_t *input, int first, int line, int lines)
 {
    int h, w, y;
-   const uint64_t *input = ctx->scaled.frame;
    uint32_t      *output = (uint32_t*)output_;
 
-   const int16_t *filter_vert = ctx->vert.filter;
+   const int16_t *filter_vert = ctx->vert.filter + line * ctx->vert.filter_stride;
 
-   for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   for (h = line; h < line + lines; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
    {
-      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * (ctx->scaled.stride >> 3);
+      const uint64_t *input_base = input + (ctx->vert.filter_pos[h] - first) * (ctx->scaled.stride >> 3);
 
       for (w = 0; w < ctx->out_width; w++)
       {
@@ -74,7 +79,7 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
 
          for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2, input_base_y += (ctx->scaled.stride >> 2))
          {
-            __m128i coeff = _mm_set_epi64x(filter_vert[y + 1] * 0x0001000100010001ll, filter_vert[y + 0] * 0x0001000100010001ll);
+            __m128i coeff = _mm_set_epi64x((uint16_t)filter_vert[y + 1] * 0x0001000100010001ull, (uint16_t)filter_vert[y + 0] * 0x0001000100010001ull);
             __m128i col   = _mm_set_epi64x(input_base_y[ctx->scaled.stride >> 3], input_base_y[0]);
 
             res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
@@ -82,7 +87,7 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
 
          for (; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
          {
-            __m128i coeff = _mm_set_epi64x(0, filter_vert[y] * 0x0001000100010001ll);
+            __m128i coeff = _mm_set_epi64x(0, (uint16_t)filter_vert[y] * 0x0001000100010001ull);
             __m128i col   = _mm_set_epi64x(0, input_base_y[0]);
 
             res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
@@ -98,17 +103,17 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
    }
 }
 #else
-void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride,
+      const uint64_t *input, int first, int line, int lines)
 {
    int h, w, y;
-   const uint64_t      *input = ctx->scaled.frame;
    uint32_t           *output = (uint32_t*)output_;
 
-   const int16_t *filter_vert = ctx->vert.filter;
+   const int16_t *filter_vert = ctx->vert.filter + line * ctx->vert.filter_stride;
 
-   for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   for (h = line; h < line + lines; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
    {
-      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * (ctx->scaled.stride >> 3);
+      const uint64_t *input_base = input + (ctx->vert.filter_pos[h] - first) * (ctx->scaled.stride >> 3);
 
       for (w = 0; w < ctx->out_width; w++)
       {
@@ -147,13 +152,13 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
 #endif
 
 #if defined(__SSE2__)
-void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride,
+      uint64_t *output, int lines)
 {
    int h, w, x;
    const uint32_t *input = (const uint32_t*)input_;
-   uint64_t *output      = ctx->scaled.frame;
 
-   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   for (h = 0; h < lines; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
    {
       const int16_t *filter_horiz = ctx->horiz.filter;
 
@@ -165,7 +170,7 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
 
          for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
          {
-            __m128i coeff = _mm_set_epi64x(filter_horiz[x + 1] * 0x0001000100010001ll, filter_horiz[x + 0] * 0x0001000100010001ll);
+            __m128i coeff = _mm_set_epi64x((uint16_t)filter_horiz[x + 1] * 0x0001000100010001ull, (uint16_t)filter_horiz[x + 0] * 0x0001000100010001ull);
 
             __m128i col = _mm_unpacklo_epi8(_mm_set_epi64x(0,
                      ((uint64_t)input_base_x[x + 1] << 32) | input_base_x[x + 0]), _mm_setzero_si128());
@@ -176,7 +181,7 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
 
          for (; x < ctx->horiz.filter_len; x++)
          {
-            __m128i coeff = _mm_set_epi64x(0, filter_horiz[x] * 0x0001000100010001ll);
+            __m128i coeff = _mm_set_epi64x(0, (uint16_t)filter_horiz[x] * 0x0001000100010001ull);
             __m128i col   = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, 0, input_base_x[x]), _mm_setzero_si128());
 
             col = _mm_slli_epi16(col, 7);
@@ -206,13 +211,13 @@ static INLINE uint64_t build_argb64(uint16_t a, uint16_t r, uint16_t g, uint16_t
    return ((uint64_t)a << 48) | ((uint64_t)r << 32) | ((uint64_t)g << 16) | ((uint64_t)b << 0);
 }
 
-void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride,
+      uint64_t *output, int lines)
 {
    int h, w, x;
    const uint32_t *input = (uint32_t*)input_;
-   uint64_t *output      = ctx->scaled.frame;
 
-   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   for (h = 0; h < lines; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
    {
       const int16_t *filter_horiz = ctx->horiz.filter;
 
@@ -248,6 +253,160 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
 }
 #endif
 
+#ifdef SCALER_HAVE_AVX2
+static enum scaler_isa scaler_isa_limit = SCALER_ISA_AVX2;
+
+void scaler_cpu_limit(enum scaler_isa isa)
+{
+   scaler_isa_limit = isa;
+}
+
+bool scaler_cpu_has_avx2(void)
+{
+   if (scaler_isa_limit < SCALER_ISA_AVX2)
+      return false;
+
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("avx2");
+}
+
+bool scaler_cpu_has_ssse3(void)
+{
+   if (scaler_isa_limit < SCALER_ISA_SSSE3)
+      return false;
+
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("ssse3");
+}
+
+/* The AVX2 scalers do the same fixed point steps as the others,
+ * so their output is bit-identical. */
+
+SCALER_AVX2
+void scaler_argb8888_vert_avx2(const struct scaler_ctx *ctx, void *output_, int stride,
+      const uint64_t *input, int first, int line, int lines)
+{
+   int h, w, y;
+   uint32_t *output           = (uint32_t*)output_;
+   const int pitch            = ctx->scaled.stride >> 3;
+   const int16_t *filter_vert = ctx->vert.filter + line * ctx->vert.filter_stride;
+
+   for (h = line; h < line + lines; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   {
+      const uint64_t *input_base = input + (ctx->vert.filter_pos[h] - first) * pitch;
+
+      /* Scaled lines are contiguous, so do four pixels at a time. */
+      for (w = 0; w + 4 <= ctx->out_width; w += 4)
+      {
+         __m256i res = _mm256_setzero_si256();
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += pitch)
+         {
+            __m256i coeff = _mm256_set1_epi16(filter_vert[y]);
+            __m256i col   = _mm256_loadu_si256((const __m256i*)input_base_y);
+
+            res = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res);
+         }
+
+         res = _mm256_srai_epi16(res, (7 - 2 - 2));
+         res = _mm256_packus_epi16(res, res);
+         res = _mm256_permute4x64_epi64(res, _MM_SHUFFLE(3, 1, 2, 0));
+
+         _mm_storeu_si128((__m128i*)(output + w), _mm256_castsi256_si128(res));
+      }
+
+      for (; w < ctx->out_width; w++)
+      {
+         __m128i res = _mm_setzero_si128();
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += pitch)
+         {
+            __m128i coeff = _mm_set1_epi16(filter_vert[y]);
+            __m128i col   = _mm_loadl_epi64((const __m128i*)input_base_y);
+
+            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+         }
+
+         res       = _mm_srai_epi16(res, (7 - 2 - 2));
+         output[w] = _mm_cvtsi128_si32(_mm_packus_epi16(res, res));
+      }
+   }
+}
+
+/* Coefficients for two taps of two output pixels. */
+static INLINE SCALER_AVX2 __m256i scaler_avx2_coeff(
+      const int16_t *filter0, const int16_t *filter1, int x, bool pair)
+{
+   __m128i lo = _mm_cvtsi32_si128((uint16_t)filter0[x]
+         | (pair ? (uint32_t)(uint16_t)filter0[x + 1] << 16 : 0));
+   __m128i hi = _mm_cvtsi32_si128((uint16_t)filter1[x]
+         | (pair ? (uint32_t)(uint16_t)filter1[x + 1] << 16 : 0));
+
+   lo = _mm_unpacklo_epi16(lo, lo);
+   lo = _mm_unpacklo_epi32(lo, lo);
+   hi = _mm_unpacklo_epi16(hi, hi);
+   hi = _mm_unpacklo_epi32(hi, hi);
+
+   return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+SCALER_AVX2
+void scaler_argb8888_horiz_avx2(const struct scaler_ctx *ctx, const void *input_, int stride,
+      uint64_t *output, int lines)
+{
+   int h, w, x;
+   const uint32_t *input = (const uint32_t*)input_;
+
+   for (h = 0; h < lines; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   {
+      const int16_t *filter_horiz = ctx->horiz.filter;
+
+      /* Two output pixels at a time, one in each 128-bit lane, which
+       * then works just like the SSE2 version. An odd last pixel is
+       * done twice. */
+      for (w = 0; w < ctx->scaled.width; w += 2, filter_horiz += 2 * ctx->horiz.filter_stride)
+      {
+         __m256i res = _mm256_setzero_si256();
+         bool two    = w + 1 < ctx->scaled.width;
+         const int16_t *filter0 = filter_horiz;
+         const int16_t *filter1 = two ? filter_horiz + ctx->horiz.filter_stride : filter0;
+         const uint32_t *input0 = input + ctx->horiz.filter_pos[w];
+         const uint32_t *input1 = input + ctx->horiz.filter_pos[two ? w + 1 : w];
+
+         for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+         {
+            __m256i coeff = scaler_avx2_coeff(filter0, filter1, x, true);
+            __m256i col   = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(
+                     _mm_loadl_epi64((const __m128i*)(input0 + x)),
+                     _mm_loadl_epi64((const __m128i*)(input1 + x))));
+
+            col = _mm256_slli_epi16(col, 7);
+            res = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res);
+         }
+
+         for (; x < ctx->horiz.filter_len; x++)
+         {
+            __m256i coeff = scaler_avx2_coeff(filter0, filter1, x, false);
+            __m256i col   = _mm256_cvtepu8_epi16(
+                  _mm_set_epi32(0, input1[x], 0, input0[x]));
+
+            col = _mm256_slli_epi16(col, 7);
+            res = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res);
+         }
+
+         res = _mm256_adds_epi16(_mm256_srli_si256(res, 8), res);
+
+         _mm_storel_epi64((__m128i*)(output + w), _mm256_castsi256_si128(res));
+         if (two)
+            _mm_storel_epi64((__m128i*)(output + w + 1),
+                  _mm256_extracti128_si256(res, 1));
+      }
+   }
+}
+#endif
+
 void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
       void *output_, const void *input_,
       int out_width, int out_height,
@@ -0,0 +1,148 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Throughput of every pixel converter: the plain C version, then
+ * the SSE2, SSSE3, AVX2 and NEON versions the runtime dispatch picks
+ * when capped at each of them. A converter without a version for an
+ * ISA gets the best one below it, and ISAs this build or CPU lacks
+ * are shown as "-". The speedup is that of the fastest column over C.
+ *
+ * Usage: bench-pixconv [width height]
+ *
+ * Speed is reported in megapixels per second. The default size is
+ * that of a 640x480 frame, as converted for screenshots and by
+ * video_pixel_frame_scale().
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common.h"
+
+#define BENCH_TIME 0.1
+#define BENCH_RUNS 5
+
+static double bench_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static double bench_run(test_conv_t conv, void *output, const void *input,
+      int width, int height, int out_stride, int in_stride)
+{
+   unsigned run;
+   double best = 0.0;
+
+   /* Warm up the caches. */
+   conv(output, input, width, height, out_stride, in_stride);
+
+   /* Best of a few short runs, to ride out other load on the machine. */
+   for (run = 0; run < BENCH_RUNS; run++)
+   {
+      unsigned frames = 0;
+      double start    = bench_time();
+      double elapsed;
+
+      do
+      {
+         conv(output, input, width, height, out_stride, in_stride);
+         frames++;
+         elapsed = bench_time() - start;
+      } while (elapsed < BENCH_TIME);
+
+      if (frames * (double)width * height / elapsed / 1000000.0 > best)
+         best = frames * (double)width * height / elapsed / 1000000.0;
+   }
+
+   return best;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, k;
+   int width  = 640;
+   int height = 480;
+
+   if (argc == 3)
+   {
+      width  = atoi(argv[1]);
+      height = atoi(argv[2]);
+   }
+
+   if (width <= 0 || height <= 0)
+   {
+      fprintf(stderr, "Usage: %s [width height]\n", argv[0]);
+      return 1;
+   }
+
+   printf("%-20s %9s", "converter", "C");
+   for (k = 0; k < test_num_isas; k++)
+      printf(" %9s", test_isa_names[k]);
+   printf(" %8s\n", "speedup");
+
+   for (i = 0; i < test_num_converters; i++)
+   {
+      const struct test_converter *conv = &test_converters[i];
+      int w           = width - width % conv->align;
+      int in_stride   = w * conv->in_bpp;
+      int out_stride  = w * conv->out_bpp;
+      uint8_t *input  = (uint8_t*)malloc(in_stride * height);
+      uint8_t *output = (uint8_t*)malloc(out_stride * height);
+      double ref, best;
+      int j;
+
+      for (j = 0; j < in_stride * height; j++)
+         input[j] = (uint8_t)(j * 2654435761u >> 24);
+
+      ref  = bench_run(conv->ref, output, input, w, height, out_stride, in_stride);
+      best = ref;
+      printf("%-20s %9.1f", conv->name, ref);
+
+      for (k = 0; k < test_num_isas; k++)
+      {
+         double simd;
+
+         if (!test_use_isa(k))
+         {
+            printf(" %9s", "-");
+            continue;
+         }
+
+         simd = bench_run(conv->conv, output, input, w, height, out_stride, in_stride);
+         if (simd > best)
+            best = simd;
+         printf(" %9.1f", simd);
+      }
+
+      printf(" %7.2fx\n", best / ref);
+
+      free(input);
+      free(output);
+   }
+
+   return 0;
+}
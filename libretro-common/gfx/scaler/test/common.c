@@ -0,0 +1,103 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (common.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gfx/scaler/pixconv.h>
+#include <gfx/scaler/scaler_int.h>
+
+#include "common.h"
+
+#define CONVERTER(name, in_bpp, out_bpp, align) \
+   { #name, conv_##name, ref_conv_##name, in_bpp, out_bpp, align }
+
+#define REF(name) \
+   void ref_conv_##name(void *output, const void *input, \
+         int width, int height, int out_stride, int in_stride)
+
+REF(0rgb1555_argb8888);
+REF(0rgb1555_rgb565);
+REF(rgb565_0rgb1555);
+REF(rgb565_argb8888);
+REF(rgba4444_argb8888);
+REF(rgba4444_rgb565);
+REF(bgr24_argb8888);
+REF(argb8888_0rgb1555);
+REF(argb8888_rgb565);
+REF(argb8888_bgr24);
+REF(argb8888_abgr8888);
+REF(0rgb1555_bgr24);
+REF(rgb565_bgr24);
+REF(yuyv_argb8888);
+REF(copy);
+
+const struct test_converter test_converters[] = {
+   CONVERTER(0rgb1555_argb8888, 2, 4, 1),
+   CONVERTER(0rgb1555_rgb565,   2, 2, 1),
+   CONVERTER(rgb565_0rgb1555,   2, 2, 1),
+   CONVERTER(rgb565_argb8888,   2, 4, 1),
+   CONVERTER(rgba4444_argb8888, 2, 4, 1),
+   CONVERTER(rgba4444_rgb565,   2, 2, 1),
+   CONVERTER(bgr24_argb8888,    3, 4, 1),
+   CONVERTER(argb8888_0rgb1555, 4, 2, 1),
+   CONVERTER(argb8888_rgb565,   4, 2, 1),
+   CONVERTER(argb8888_bgr24,    4, 3, 1),
+   CONVERTER(argb8888_abgr8888, 4, 4, 1),
+   CONVERTER(0rgb1555_bgr24,    2, 3, 1),
+   CONVERTER(rgb565_bgr24,      2, 3, 1),
+   CONVERTER(yuyv_argb8888,     2, 4, 2),
+   CONVERTER(copy,              4, 4, 1),
+};
+
+const unsigned test_num_converters =
+   sizeof(test_converters) / sizeof(test_converters[0]);
+
+const char *const test_isa_names[] = { "SSE2", "SSSE3", "AVX2", "NEON" };
+
+const unsigned test_num_isas =
+   sizeof(test_isa_names) / sizeof(test_isa_names[0]);
+
+bool test_use_isa(unsigned index)
+{
+   switch (index)
+   {
+#ifdef SCALER_HAVE_AVX2
+      case 0:
+         scaler_cpu_limit(SCALER_ISA_SSE2);
+         return true;
+      case 1:
+         scaler_cpu_limit(SCALER_ISA_SSSE3);
+         return scaler_cpu_has_ssse3();
+      case 2:
+         scaler_cpu_limit(SCALER_ISA_AVX2);
+         return scaler_cpu_has_avx2();
+#elif defined(__SSE2__)
+      case 0:
+         return true;
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+      case 3:
+         return true;
+#endif
+      default:
+         break;
+   }
+
+   return false;
+}
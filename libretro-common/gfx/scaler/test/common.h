@@ -0,0 +1,57 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (common.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SCALER_TEST_COMMON_H__
+#define SCALER_TEST_COMMON_H__
+
+#include <boolean.h>
+
+typedef void (*test_conv_t)(void *output, const void *input,
+      int width, int height, int out_stride, int in_stride);
+
+struct test_converter
+{
+   const char *name;
+   /* As built, picking SIMD versions at runtime. */
+   test_conv_t conv;
+   /* The plain C version. */
+   test_conv_t ref;
+   int in_bpp;
+   int out_bpp;
+   /* Width has to be a multiple of this. */
+   int align;
+};
+
+extern const struct test_converter test_converters[];
+extern const unsigned test_num_converters;
+
+/* SIMD versions the converters and scalers can have: SSE2, SSSE3,
+ * AVX2 and NEON. */
+extern const char *const test_isa_names[];
+extern const unsigned test_num_isas;
+
+/* Makes the runtime dispatch pick the versions at @index in
+ * test_isa_names, or the best this CPU has below them. Returns
+ * false if this build or CPU doesn't have them at all. */
+bool test_use_isa(unsigned index);
+
+#endif
@@ -0,0 +1,262 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (main.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Checks that the scaler and the pixel converters give the same
+ * output as their C reference, whatever SIMD kernels they picked and
+ * however many threads the scaler is split across, and when its
+ * filters come out of the bank cache. On x86, everything is run once
+ * for each instruction set the CPU has, so that the SSSE3 and SSE2
+ * versions are checked on AVX2 machines too.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gfx/scaler/scaler.h>
+#include <rthreads/rpool.h>
+
+#include "common.h"
+
+bool ref_scaler_ctx_gen_filter(struct scaler_ctx *ctx);
+void ref_scaler_ctx_gen_reset(struct scaler_ctx *ctx);
+void ref_scaler_ctx_scale(struct scaler_ctx *ctx,
+      void *output, const void *input);
+
+static const unsigned thread_counts[] = { 1, 2, 4, 7 };
+
+static const int sizes[][4] = {
+   { 320,  240, 1920, 1080 },
+   { 640,  480,  320,  240 },
+   { 256,  224,  640,  448 },
+   { 100,   50,   33,   77 },
+   {  61,   17,  183,   51 },
+};
+
+static const enum scaler_pix_fmt in_fmts[] = {
+   SCALER_FMT_ARGB8888,
+   SCALER_FMT_RGB565,
+};
+
+static const enum scaler_pix_fmt out_fmts[] = {
+   SCALER_FMT_ARGB8888,
+   SCALER_FMT_BGR24,
+};
+
+static const int conv_widths[] = { 1, 2, 7, 8, 15, 16, 17, 31, 32, 33, 64, 333 };
+
+static rpool_t *pool;
+static const char *isa_name = "C";
+
+static void fill_random(uint8_t *buf, size_t size, uint32_t state)
+{
+   size_t i;
+
+   for (i = 0; i < size; i++)
+   {
+      state  = state * 1103515245 + 12345;
+      buf[i] = state >> 16;
+   }
+}
+
+/* Every width, with padding between lines that must be left alone. */
+static unsigned check_converter(const struct test_converter *conv,
+      unsigned *run)
+{
+   unsigned i;
+   unsigned failed = 0;
+
+   for (i = 0; i < sizeof(conv_widths) / sizeof(conv_widths[0]); i++)
+   {
+      const int width      = conv_widths[i];
+      const int height     = 3;
+      const int in_stride  = width * conv->in_bpp + 12;
+      const int out_stride = width * conv->out_bpp + 20;
+      uint8_t *input, *expected, *output;
+
+      if (width % conv->align)
+         continue;
+
+      input    = (uint8_t*)malloc(in_stride * height);
+      expected = (uint8_t*)malloc(out_stride * height);
+      output   = (uint8_t*)malloc(out_stride * height);
+
+      fill_random(input, in_stride * height, width);
+      memset(expected, 0xaa, out_stride * height);
+      memset(output, 0xaa, out_stride * height);
+
+      conv->ref(expected, input, width, height, out_stride, in_stride);
+      conv->conv(output, input, width, height, out_stride, in_stride);
+
+      (*run)++;
+      if (memcmp(output, expected, out_stride * height))
+      {
+         fprintf(stderr, "FAIL: conv_%s, width %d, %s.\n",
+               conv->name, width, isa_name);
+         failed++;
+      }
+
+      free(input);
+      free(expected);
+      free(output);
+   }
+
+   return failed;
+}
+
+static int fmt_bpp(enum scaler_pix_fmt fmt)
+{
+   switch (fmt)
+   {
+      case SCALER_FMT_ARGB8888:
+         return 4;
+      case SCALER_FMT_BGR24:
+         return 3;
+      default:
+         break;
+   }
+
+   return 2;
+}
+
+static void setup_ctx(struct scaler_ctx *ctx, const int *size,
+      enum scaler_pix_fmt in_fmt, enum scaler_pix_fmt out_fmt,
+      enum scaler_type type)
+{
+   ctx->in_width    = size[0];
+   ctx->in_height   = size[1];
+   ctx->in_stride   = size[0] * fmt_bpp(in_fmt) + 12;
+   ctx->out_width   = size[2];
+   ctx->out_height  = size[3];
+   ctx->out_stride  = size[2] * fmt_bpp(out_fmt) + 20;
+   ctx->in_fmt      = in_fmt;
+   ctx->out_fmt     = out_fmt;
+   ctx->scaler_type = type;
+}
+
+/* Every size, format pair and type, split over every thread count. */
+static unsigned check_scalers(struct scaler_ctx *ctx, unsigned *run)
+{
+   unsigned s, i, o, t, n;
+   unsigned failed = 0;
+
+   for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+   for (i = 0; i < sizeof(in_fmts) / sizeof(in_fmts[0]); i++)
+   for (o = 0; o < sizeof(out_fmts) / sizeof(out_fmts[0]); o++)
+   for (t = SCALER_TYPE_POINT; t <= SCALER_TYPE_AREA; t++)
+   {
+      struct scaler_ctx ref = {0};
+      size_t in_size, out_size;
+      uint8_t *input, *expected, *output;
+
+      setup_ctx(&ref, sizes[s], in_fmts[i], out_fmts[o], (enum scaler_type)t);
+      if (!ref_scaler_ctx_gen_filter(&ref))
+      {
+         fprintf(stderr, "Failed to create reference scaler.\n");
+         return failed + 1;
+      }
+
+      in_size  = ref.in_stride * ref.in_height;
+      out_size = ref.out_stride * ref.out_height;
+      input    = (uint8_t*)malloc(in_size);
+      expected = (uint8_t*)calloc(1, out_size);
+      output   = (uint8_t*)malloc(out_size);
+
+      fill_random(input, in_size, 1);
+
+      ref_scaler_ctx_scale(&ref, expected, input);
+      ref_scaler_ctx_gen_reset(&ref);
+
+      for (n = 0; n < sizeof(thread_counts) / sizeof(thread_counts[0]); n++)
+      {
+         setup_ctx(ctx, sizes[s], in_fmts[i], out_fmts[o], (enum scaler_type)t);
+         ctx->pool    = pool;
+         ctx->threads = thread_counts[n];
+
+         /* Both leave the padding at the end of each line alone. */
+         memset(output, 0, out_size);
+
+         (*run)++;
+         if (!scaler_ctx_gen_filter(ctx))
+         {
+            fprintf(stderr, "Failed to create scaler.\n");
+            failed++;
+            continue;
+         }
+         scaler_ctx_scale(ctx, output, input);
+
+         if (memcmp(output, expected, out_size))
+         {
+            fprintf(stderr, "FAIL: %dx%d -> %dx%d, format %d -> %d, "
+                  "type %u, %u threads, %s.\n",
+                  ctx->in_width, ctx->in_height,
+                  ctx->out_width, ctx->out_height,
+                  ctx->in_fmt, ctx->out_fmt, t, thread_counts[n],
+                  isa_name);
+            failed++;
+         }
+      }
+
+      free(input);
+      free(expected);
+      free(output);
+   }
+
+   return failed;
+}
+
+int main(void)
+{
+   unsigned i, k;
+   unsigned failed = 0, run = 0, isas = 0;
+   /* Reused throughout, so most filters come from its cache. */
+   struct scaler_ctx ctx;
+
+   memset(&ctx, 0, sizeof(ctx));
+
+   pool = rpool_new(3);
+
+   /* A build without SIMD has no instruction set to pick,
+    * so it goes through once as it is. */
+   for (k = 0; k < test_num_isas || !isas; k++)
+   {
+      if (k < test_num_isas)
+      {
+         if (!test_use_isa(k))
+            continue;
+         isa_name = test_isa_names[k];
+      }
+      isas++;
+
+      for (i = 0; i < test_num_converters; i++)
+         failed += check_converter(&test_converters[i], &run);
+
+      failed += check_scalers(&ctx, &run);
+   }
+
+   scaler_ctx_gen_reset(&ctx);
+
+   printf("%u/%u runs matched the C reference.\n", run - failed, run);
+
+   rpool_free(pool);
+   return failed ? 1 : 0;
+}
@@ -27,6 +27,21 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/* File backends. Can be fleshed out later, but keep it simple for now.
+ * The file is mapped to memory directly (via mmap() or just 
+ * plain zlib_read_file()).
+ */
+
+struct zlib_file_backend
+{
+   void          *(*open)(const char *path);
+   const uint8_t *(*data)(void *handle);
+   size_t         (*size)(void *handle);
+   void           (*free)(void *handle); /* Closes, unmaps and frees. */
+};
+
+const struct zlib_file_backend *zlib_get_default_file_backend(void);
+
 typedef struct zlib_handle
 {
    void     *stream;
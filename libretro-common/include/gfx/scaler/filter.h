@@ -30,8 +30,25 @@ extern "C" {
 #include <boolean.h>
 #include <gfx/scaler/scaler.h>
 
+/**
+ * scaler_gen_filter:
+ * @ctx          : pointer to scaler context object.
+ *
+ * Points the context's filters at banks for its geometry and
+ * scaler type, generating them unless they are already cached.
+ *
+ * Returns: true on success, false if the filters are invalid.
+ **/
 bool scaler_gen_filter(struct scaler_ctx *ctx);
 
+/**
+ * scaler_free_filter_banks:
+ * @ctx          : pointer to scaler context object.
+ *
+ * Frees all the cached filter banks of the context.
+ **/
+void scaler_free_filter_banks(struct scaler_ctx *ctx);
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,6 +34,8 @@ extern "C" {
 
 #define FILTER_UNITY (1 << 14)
 
+struct rpool;
+
 enum scaler_pix_fmt
 {
    SCALER_FMT_ARGB8888 = 0,
@@ -50,7 +52,12 @@ enum scaler_type
    SCALER_TYPE_UNKNOWN = 0,
    SCALER_TYPE_POINT,
    SCALER_TYPE_BILINEAR,
-   SCALER_TYPE_SINC
+   SCALER_TYPE_SINC,
+   SCALER_TYPE_LANCZOS3,
+   SCALER_TYPE_BICUBIC,
+   /* Averages the input pixels each output pixel covers.
+    * Meant for downscaling. */
+   SCALER_TYPE_AREA
 };
 
 struct scaler_filter
@@ -61,6 +68,18 @@ struct scaler_filter
    int *filter_pos;
 };
 
+#define SCALER_FILTER_BANKS 8
+
+/* The filters for one axis, for a given input length,
+ * output length and scaler type. */
+struct scaler_filter_bank
+{
+   enum scaler_type type;
+   int in_len;
+   int out_len;
+   struct scaler_filter filter;
+};
+
 struct scaler_ctx
 {
    int in_width;
@@ -75,10 +94,16 @@ struct scaler_ctx
    enum scaler_pix_fmt out_fmt;
    enum scaler_type scaler_type;
 
+   /* Horizontally scales a number of input lines
+    * into rows of 'scaled.stride' bytes. */
    void (*scaler_horiz)(const struct scaler_ctx*,
-         const void*, int);
+         const void*, int, uint64_t*, int);
+   /* Vertically scales output lines [line, line + lines) from
+    * horizontally scaled lines, the first of which is input
+    * line 'first'. Arguments are output, stride, scaled, first,
+    * line and lines. */
    void (*scaler_vert)(const struct scaler_ctx*,
-         void*, int);
+         void*, int, const uint64_t*, int, int, int);
    void (*scaler_special)(const struct scaler_ctx*,
          void*, const void*, int, int, int, int, int, int);
 
@@ -89,12 +114,32 @@ struct scaler_ctx
    bool unscaled;
    struct scaler_filter horiz, vert;
 
+   /* Filters for the geometries used so far, so that switching
+    * back to one doesn't generate them again. 'horiz' and 'vert'
+    * point into these. */
+   struct scaler_filter_bank banks[SCALER_FILTER_BANKS];
+   unsigned next_bank;
+
+   /* Optional. The filtered paths split the output into this many
+    * slices of bands, and scale them in parallel on 'pool'. Needs
+    * HAVE_THREADS; the slices run one after the other otherwise. */
+   struct rpool *pool;
+   unsigned threads;
+
+   /* Output lines are produced in bands of this many lines, so that
+    * the intermediate buffers below stay in cache. Each slice has
+    * its own set of buffers. */
+   int band_lines;
+   int slices;
+
+   /* One converted input line. */
    struct
    {
       uint32_t *frame;
       int stride;
    } input;
 
+   /* Horizontally scaled input lines, with room for two bands. */
    struct
    {
       uint64_t *frame;
@@ -103,6 +148,7 @@ struct scaler_ctx
       int stride;
    } scaled;
 
+   /* One band of output lines before conversion. */
    struct
    {
       uint32_t *frame;
@@ -26,10 +26,44 @@
 #include <gfx/scaler/scaler.h>
 
 void scaler_argb8888_vert(const struct scaler_ctx *ctx,
-      void *output, int stride);
+      void *output, int stride, const uint64_t *scaled,
+      int first, int line, int lines);
 
 void scaler_argb8888_horiz(const struct scaler_ctx *ctx,
-      const void *input, int stride);
+      const void *input, int stride, uint64_t *scaled, int lines);
+
+#if !defined(SCALER_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) \
+   && (defined(__clang__) || (defined(__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SCALER_HAVE_AVX2 1
+
+/* Only to be used if the CPU supports them, see scaler_cpu_has_avx2().
+ * pixconv.c also has AVX2 and SSSE3 converters. */
+void scaler_argb8888_vert_avx2(const struct scaler_ctx *ctx,
+      void *output, int stride, const uint64_t *scaled,
+      int first, int line, int lines);
+
+void scaler_argb8888_horiz_avx2(const struct scaler_ctx *ctx,
+      const void *input, int stride, uint64_t *scaled, int lines);
+
+bool scaler_cpu_has_avx2(void);
+
+bool scaler_cpu_has_ssse3(void);
+
+/* Runtime dispatched instruction sets, lowest first. SSE2 is
+ * what the build targets anyway. */
+enum scaler_isa
+{
+   SCALER_ISA_SSE2 = 0,
+   SCALER_ISA_SSSE3,
+   SCALER_ISA_AVX2
+};
+
+/* Keeps scaler_cpu_has_*() from reporting anything above @isa, so
+ * that tests and benchmarks can run every version on one CPU. Not
+ * thread-safe, and only takes effect for scalers created after. */
+void scaler_cpu_limit(enum scaler_isa isa);
+#endif
 
 void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
       void *output, const void *input,
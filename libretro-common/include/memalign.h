@@ -0,0 +1,56 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (memalign.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_MEMALIGN_H
+#define __LIBRETRO_SDK_MEMALIGN_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * memalign_alloc:
+ * @boundary                  : alignment in bytes, a power of two.
+ * @size                      : size of the allocation in bytes.
+ *
+ * Allocates @size bytes starting on a @boundary byte boundary.
+ * Must be released with memalign_free().
+ *
+ * Returns: pointer to the allocation, or NULL on failure.
+ **/
+void *memalign_alloc(size_t boundary, size_t size);
+
+/**
+ * memalign_free:
+ * @ptr                       : allocation from memalign_alloc(), or NULL.
+ *
+ * Frees memory allocated by memalign_alloc().
+ **/
+void memalign_free(void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (spsc_ring.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_SPSC_RING_H
+#define __LIBRETRO_SDK_SPSC_RING_H
+
+#include <stddef.h>
+
+#include <retro_atomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lock-free byte ring for exactly one producer and one consumer thread.
+ * The two indices live on their own cache lines, and each side keeps
+ * a cached copy of the other's index, so a batch normally touches no
+ * line the other thread is writing to.
+ *
+ * Only available if HAVE_RETRO_ATOMIC is defined.
+ * Blocking, if wanted, is left to the caller. */
+
+typedef struct spsc_ring spsc_ring_t;
+
+/**
+ * spsc_ring_new:
+ * @size                      : capacity in bytes.
+ *
+ * Creates a ring holding up to @size bytes. Storage is rounded up
+ * to a power of two, but never more than @size bytes are queued.
+ *
+ * Returns: new ring, or NULL on failure.
+ **/
+spsc_ring_t *spsc_ring_new(size_t size);
+
+/**
+ * spsc_ring_free:
+ * @ring                      : ring, or NULL.
+ *
+ * Frees a ring. Neither thread may be using it.
+ **/
+void spsc_ring_free(spsc_ring_t *ring);
+
+/**
+ * spsc_ring_write:
+ * @ring                      : ring.
+ * @data                      : bytes to queue.
+ * @size                      : number of bytes.
+ *
+ * Producer only. Queues as much of @data as fits.
+ *
+ * Returns: number of bytes queued.
+ **/
+size_t spsc_ring_write(spsc_ring_t *ring, const void *data, size_t size);
+
+/**
+ * spsc_ring_read:
+ * @ring                      : ring.
+ * @data                      : buffer to read into.
+ * @size                      : size of @data in bytes.
+ *
+ * Consumer only. Dequeues up to @size bytes.
+ *
+ * Returns: number of bytes read.
+ **/
+size_t spsc_ring_read(spsc_ring_t *ring, void *data, size_t size);
+
+/**
+ * spsc_ring_write_avail:
+ * @ring                      : ring.
+ *
+ * Producer only.
+ *
+ * Returns: number of bytes that can be written right now.
+ **/
+size_t spsc_ring_write_avail(spsc_ring_t *ring);
+
+/**
+ * spsc_ring_read_avail:
+ * @ring                      : ring.
+ *
+ * Consumer only.
+ *
+ * Returns: number of bytes that can be read right now.
+ **/
+size_t spsc_ring_read_avail(spsc_ring_t *ring);
+
+/**
+ * spsc_ring_clear:
+ * @ring                      : ring.
+ *
+ * Consumer only. Drops everything queued so far.
+ **/
+void spsc_ring_clear(spsc_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (retro_atomic.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_ATOMIC_H
+#define __LIBRETRO_SDK_ATOMIC_H
+
+/* Just enough atomics to hand data between two threads without a lock.
+ * retro_atomic_fence() is a full barrier, for the store-then-load
+ * checks that acquire/release alone do not order.
+ * HAVE_RETRO_ATOMIC is only defined if the compiler provides them;
+ * callers need a locked fallback otherwise. */
+
+#if defined(__clang__) || (defined(__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define HAVE_RETRO_ATOMIC 1
+
+typedef long retro_atomic_int_t;
+
+#define retro_atomic_load_acquire(ptr) \
+   __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define retro_atomic_store_release(ptr, val) \
+   __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define retro_atomic_xchg(ptr, val) \
+   __atomic_exchange_n((ptr), (val), __ATOMIC_ACQ_REL)
+#define retro_atomic_fence() \
+   __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#elif defined(__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+#define HAVE_RETRO_ATOMIC 1
+
+/* Older GCC only has the __sync builtins, which are full barriers. */
+typedef volatile long retro_atomic_int_t;
+
+#define retro_atomic_load_acquire(ptr) \
+   __sync_fetch_and_add((ptr), 0)
+#define retro_atomic_store_release(ptr, val) \
+   do { __sync_synchronize(); *(ptr) = (val); __sync_synchronize(); } while (0)
+#define retro_atomic_xchg(ptr, val) \
+   (__sync_synchronize(), __sync_lock_test_and_set((ptr), (val)))
+#define retro_atomic_fence() \
+   __sync_synchronize()
+
+#elif defined(_MSC_VER) && _MSC_VER >= 1400 && !defined(_XBOX)
+#include <intrin.h>
+#define HAVE_RETRO_ATOMIC 1
+
+typedef volatile long retro_atomic_int_t;
+
+/* The interlocked intrinsics are full barriers. */
+#define retro_atomic_load_acquire(ptr) \
+   _InterlockedCompareExchange((ptr), 0, 0)
+#define retro_atomic_store_release(ptr, val) \
+   ((void)_InterlockedExchange((ptr), (val)))
+#define retro_atomic_xchg(ptr, val) \
+   _InterlockedExchange((ptr), (val))
+#define retro_atomic_fence() \
+   do { long retro_fence_ = 0; _InterlockedExchange(&retro_fence_, 1); } while (0)
+
+#endif
+
+#endif
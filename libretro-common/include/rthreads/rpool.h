@@ -0,0 +1,126 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rpool.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_RPOOL_H__
+#define __LIBRETRO_SDK_RPOOL_H__
+
+#include <boolean.h>
+
+#if defined(__cplusplus) && !defined(_MSC_VER)
+extern "C" {
+#endif
+
+typedef struct rpool rpool_t;
+typedef struct rpool_future rpool_future_t;
+
+/* Runs one item of work. @index is the item's index for
+ * rpool_parallel_for(), and 0 for rpool_submit(). */
+typedef void (*rpool_func_t)(void *userdata, unsigned index);
+
+/**
+ * rpool_new:
+ * @workers                 : number of worker threads
+ *
+ * Creates a thread pool. Every worker owns a queue of tasks, and
+ * steals from the other queues once its own runs dry. Threads
+ * waiting on the pool run queued tasks too, so a pool with
+ * @workers set to one less than the number of cores keeps all
+ * of them busy. With zero workers, all tasks are run by the
+ * threads waiting on them.
+ *
+ * Returns: pointer to new pool if successful, otherwise NULL.
+ **/
+rpool_t *rpool_new(unsigned workers);
+
+/**
+ * rpool_free:
+ * @pool                    : pointer to pool object
+ *
+ * Stops the workers and frees the pool. No rpool_parallel_for()
+ * may be running on it, and all submitted work must have been
+ * waited on.
+ **/
+void rpool_free(rpool_t *pool);
+
+/**
+ * rpool_workers:
+ * @pool                    : pointer to pool object
+ *
+ * Returns: number of worker threads in @pool.
+ **/
+unsigned rpool_workers(rpool_t *pool);
+
+/**
+ * rpool_parallel_for:
+ * @pool                    : pointer to pool object, may be NULL
+ * @count                   : number of items
+ * @func                    : function to run for every item
+ * @userdata                : passed to @func
+ *
+ * Calls @func once for every index in [0, @count), spread out over
+ * the pool and the calling thread, and returns when all are done.
+ * Runs everything on the calling thread if @pool is NULL.
+ **/
+void rpool_parallel_for(rpool_t *pool, unsigned count,
+      rpool_func_t func, void *userdata);
+
+/**
+ * rpool_submit:
+ * @pool                    : pointer to pool object, may be NULL
+ * @func                    : function to run
+ * @userdata                : passed to @func
+ *
+ * Queues @func to be run on one of the workers. Submitted tasks
+ * are picked up after any rpool_parallel_for() items, and are
+ * never run by a thread waiting in rpool_parallel_for(), so they
+ * may block. Runs @func on the calling thread before returning
+ * if @pool is NULL or has no workers.
+ *
+ * Returns: a future which must be passed to rpool_future_wait(),
+ * or NULL on failure.
+ **/
+rpool_future_t *rpool_submit(rpool_t *pool,
+      rpool_func_t func, void *userdata);
+
+/**
+ * rpool_future_done:
+ * @future                  : pointer to future object
+ *
+ * Returns: true (1) if the task of @future has finished,
+ * otherwise false (0).
+ **/
+bool rpool_future_done(rpool_future_t *future);
+
+/**
+ * rpool_future_wait:
+ * @future                  : pointer to future object, may be NULL
+ *
+ * Waits for the task of @future to finish, running queued
+ * rpool_parallel_for() items in the meantime, and frees @future.
+ **/
+void rpool_future_wait(rpool_future_t *future);
+
+#if defined(__cplusplus) && !defined(_MSC_VER)
+}
+#endif
+
+#endif
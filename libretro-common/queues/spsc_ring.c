@@ -0,0 +1,176 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (spsc_ring.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <memalign.h>
+#include <queues/spsc_ring.h>
+
+#ifdef HAVE_RETRO_ATOMIC
+
+#define SPSC_RING_CACHE_LINE 64
+
+/* Indices run freely and wrap around; only the difference
+ * between them and their low bits are ever used. */
+struct spsc_ring
+{
+   /* Read-only once created. */
+   uint8_t *buffer;
+   size_t size;
+   size_t mask;
+   uint8_t pad0[SPSC_RING_CACHE_LINE
+      - sizeof(uint8_t*) - 2 * sizeof(size_t)];
+
+   /* Written by the producer. */
+   retro_atomic_int_t write_ptr;
+   unsigned long cached_read;
+   uint8_t pad1[SPSC_RING_CACHE_LINE
+      - sizeof(retro_atomic_int_t) - sizeof(unsigned long)];
+
+   /* Written by the consumer. */
+   retro_atomic_int_t read_ptr;
+   unsigned long cached_write;
+   uint8_t pad2[SPSC_RING_CACHE_LINE
+      - sizeof(retro_atomic_int_t) - sizeof(unsigned long)];
+};
+
+spsc_ring_t *spsc_ring_new(size_t size)
+{
+   size_t storage = 1;
+   spsc_ring_t *ring;
+
+   if (!size)
+      return NULL;
+
+   while (storage < size)
+      storage <<= 1;
+
+   ring = (spsc_ring_t*)memalign_alloc(SPSC_RING_CACHE_LINE, sizeof(*ring));
+   if (!ring)
+      return NULL;
+
+   memset(ring, 0, sizeof(*ring));
+
+   ring->buffer = (uint8_t*)calloc(1, storage);
+   if (!ring->buffer)
+   {
+      memalign_free(ring);
+      return NULL;
+   }
+
+   ring->size = size;
+   ring->mask = storage - 1;
+
+   return ring;
+}
+
+void spsc_ring_free(spsc_ring_t *ring)
+{
+   if (!ring)
+      return;
+
+   free(ring->buffer);
+   memalign_free(ring);
+}
+
+size_t spsc_ring_write_avail(spsc_ring_t *ring)
+{
+   unsigned long write_ptr = (unsigned long)ring->write_ptr;
+
+   ring->cached_read = (unsigned long)
+      retro_atomic_load_acquire(&ring->read_ptr);
+   return ring->size - (size_t)(write_ptr - ring->cached_read);
+}
+
+size_t spsc_ring_read_avail(spsc_ring_t *ring)
+{
+   unsigned long read_ptr = (unsigned long)ring->read_ptr;
+
+   ring->cached_write = (unsigned long)
+      retro_atomic_load_acquire(&ring->write_ptr);
+   return (size_t)(ring->cached_write - read_ptr);
+}
+
+size_t spsc_ring_write(spsc_ring_t *ring, const void *data, size_t size)
+{
+   size_t offset, first;
+   unsigned long write_ptr = (unsigned long)ring->write_ptr;
+   size_t avail = ring->size - (size_t)(write_ptr - ring->cached_read);
+
+   /* Only look at the consumer's index if the cached one
+    * says there is not enough room. */
+   if (avail < size)
+      avail = spsc_ring_write_avail(ring);
+   if (size > avail)
+      size = avail;
+   if (!size)
+      return 0;
+
+   offset = write_ptr & ring->mask;
+   first  = ring->mask + 1 - offset;
+   if (first > size)
+      first = size;
+
+   memcpy(ring->buffer + offset, data, first);
+   memcpy(ring->buffer, (const uint8_t*)data + first, size - first);
+
+   retro_atomic_store_release(&ring->write_ptr,
+         (long)(write_ptr + size));
+   return size;
+}
+
+size_t spsc_ring_read(spsc_ring_t *ring, void *data, size_t size)
+{
+   size_t offset, first;
+   unsigned long read_ptr = (unsigned long)ring->read_ptr;
+   size_t avail = (size_t)(ring->cached_write - read_ptr);
+
+   if (avail < size)
+      avail = spsc_ring_read_avail(ring);
+   if (size > avail)
+      size = avail;
+   if (!size)
+      return 0;
+
+   offset = read_ptr & ring->mask;
+   first  = ring->mask + 1 - offset;
+   if (first > size)
+      first = size;
+
+   memcpy(data, ring->buffer + offset, first);
+   memcpy((uint8_t*)data + first, ring->buffer, size - first);
+
+   retro_atomic_store_release(&ring->read_ptr,
+         (long)(read_ptr + size));
+   return size;
+}
+
+void spsc_ring_clear(spsc_ring_t *ring)
+{
+   ring->cached_write = (unsigned long)
+      retro_atomic_load_acquire(&ring->write_ptr);
+   retro_atomic_store_release(&ring->read_ptr, (long)ring->cached_write);
+}
+
+#endif
@@ -0,0 +1,544 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rpool.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <rthreads/rthreads.h>
+#include <rthreads/rpool.h>
+
+#define RPOOL_QUEUE_MIN 16
+
+struct rpool_future
+{
+   rpool_t *pool;
+   /* Tasks yet to finish, protected by pool->lock. */
+   unsigned remaining;
+};
+
+struct rpool_task
+{
+   rpool_func_t func;
+   void *userdata;
+   unsigned index;
+   rpool_future_t *future;
+};
+
+/* The owning worker takes tasks from the tail, thieves
+ * take them from the head. */
+struct rpool_queue
+{
+   slock_t *lock;
+   struct rpool_task *tasks;
+   unsigned capacity;
+   unsigned head;
+   unsigned tail;
+};
+
+struct rpool_worker
+{
+   rpool_t *pool;
+   sthread_t *thread;
+   unsigned index;
+};
+
+struct rpool
+{
+   struct rpool_queue *queues;
+   unsigned num_queues;
+   struct rpool_worker *workers;
+   unsigned num_workers;
+   /* Tasks from rpool_submit(). Only the workers run these, so
+    * a thread waiting in rpool_parallel_for() never picks up a
+    * long task it didn't ask for. */
+   struct rpool_queue submitted;
+
+   slock_t *lock;
+   /* Idle workers wait on this for new tasks. */
+   scond_t *work_cond;
+   /* Waiters on a future wait on this for tasks to finish. */
+   scond_t *done_cond;
+
+   /* The rest is protected by lock. */
+   unsigned generation;
+   unsigned sleepers;
+   unsigned next_queue;
+   bool quit;
+};
+
+static bool rpool_queue_push(struct rpool_queue *queue,
+      const struct rpool_task *task)
+{
+   bool ret = true;
+
+   slock_lock(queue->lock);
+
+   if (queue->tail - queue->head == queue->capacity)
+   {
+      unsigned i;
+      unsigned capacity        = queue->capacity * 2;
+      struct rpool_task *tasks = (struct rpool_task*)
+         malloc(capacity * sizeof(*tasks));
+
+      if (!tasks)
+      {
+         ret = false;
+         goto end;
+      }
+
+      for (i = queue->head; i != queue->tail; i++)
+         tasks[i & (capacity - 1)] = queue->tasks[i & (queue->capacity - 1)];
+
+      free(queue->tasks);
+      queue->tasks    = tasks;
+      queue->capacity = capacity;
+   }
+
+   queue->tasks[queue->tail++ & (queue->capacity - 1)] = *task;
+
+end:
+   slock_unlock(queue->lock);
+   return ret;
+}
+
+static bool rpool_queue_pop(struct rpool_queue *queue,
+      struct rpool_task *task, bool steal)
+{
+   bool ret = false;
+
+   slock_lock(queue->lock);
+
+   if (queue->head != queue->tail)
+   {
+      if (steal)
+         *task = queue->tasks[queue->head++ & (queue->capacity - 1)];
+      else
+         *task = queue->tasks[--queue->tail & (queue->capacity - 1)];
+      ret = true;
+   }
+
+   slock_unlock(queue->lock);
+   return ret;
+}
+
+static void rpool_run_task(rpool_t *pool, const struct rpool_task *task)
+{
+   task->func(task->userdata, task->index);
+
+   slock_lock(pool->lock);
+   if (--task->future->remaining == 0)
+      scond_broadcast(pool->done_cond);
+   slock_unlock(pool->lock);
+}
+
+/* Runs one queued task, preferring the queue at @self. Only
+ * workers (@owner) take tasks from rpool_submit(), and only once
+ * the rpool_parallel_for() items have run dry. */
+static bool rpool_run_one(rpool_t *pool, unsigned self, bool owner)
+{
+   unsigned i;
+   struct rpool_task task;
+
+   for (i = 0; i < pool->num_queues; i++)
+   {
+      unsigned q = (self + i) % pool->num_queues;
+
+      if (!rpool_queue_pop(&pool->queues[q], &task, !owner || i != 0))
+         continue;
+
+      rpool_run_task(pool, &task);
+      return true;
+   }
+
+   if (owner && rpool_queue_pop(&pool->submitted, &task, true))
+   {
+      rpool_run_task(pool, &task);
+      return true;
+   }
+
+   return false;
+}
+
+static void rpool_worker_loop(void *data)
+{
+   struct rpool_worker *worker = (struct rpool_worker*)data;
+   rpool_t *pool               = worker->pool;
+
+   for (;;)
+   {
+      unsigned generation;
+
+      slock_lock(pool->lock);
+      if (pool->quit)
+      {
+         slock_unlock(pool->lock);
+         break;
+      }
+      generation = pool->generation;
+      slock_unlock(pool->lock);
+
+      while (rpool_run_one(pool, worker->index, true));
+
+      /* Anything queued after we read the generation bumps it,
+       * so there's no sleeping through new work. */
+      slock_lock(pool->lock);
+      while (!pool->quit && pool->generation == generation)
+      {
+         pool->sleepers++;
+         scond_wait(pool->work_cond, pool->lock);
+         pool->sleepers--;
+      }
+      slock_unlock(pool->lock);
+   }
+}
+
+static void rpool_wake(rpool_t *pool, unsigned count)
+{
+   pool->generation++;
+
+   if (pool->sleepers)
+   {
+      if (count == 1)
+         scond_signal(pool->work_cond);
+      else
+         scond_broadcast(pool->work_cond);
+   }
+}
+
+static void rpool_enqueue(rpool_t *pool, rpool_future_t *future,
+      rpool_func_t func, void *userdata, unsigned first, unsigned count)
+{
+   unsigned i;
+
+   slock_lock(pool->lock);
+
+   for (i = 0; i < count; i++)
+   {
+      struct rpool_task task;
+      unsigned q     = (pool->next_queue + i) % pool->num_queues;
+
+      task.func      = func;
+      task.userdata  = userdata;
+      task.index     = first + i;
+      task.future    = future;
+
+      if (!rpool_queue_push(&pool->queues[q], &task))
+      {
+         /* Run what doesn't fit in place. */
+         slock_unlock(pool->lock);
+         func(userdata, first + i);
+         slock_lock(pool->lock);
+         future->remaining--;
+      }
+   }
+
+   pool->next_queue = (pool->next_queue + count) % pool->num_queues;
+   rpool_wake(pool, count);
+
+   slock_unlock(pool->lock);
+}
+
+static void rpool_wait(rpool_t *pool, rpool_future_t *future)
+{
+   for (;;)
+   {
+      bool done;
+
+      slock_lock(pool->lock);
+      done = !future->remaining;
+      slock_unlock(pool->lock);
+
+      if (done)
+         break;
+
+      if (rpool_run_one(pool, 0, false))
+         continue;
+
+      /* The rest is already running on the workers. */
+      slock_lock(pool->lock);
+      while (future->remaining)
+         scond_wait(pool->done_cond, pool->lock);
+      slock_unlock(pool->lock);
+      break;
+   }
+}
+
+/**
+ * rpool_new:
+ * @workers                 : number of worker threads
+ *
+ * Creates a thread pool. Every worker owns a queue of tasks, and
+ * steals from the other queues once its own runs dry. Threads
+ * waiting on the pool run queued tasks too, so a pool with
+ * @workers set to one less than the number of cores keeps all
+ * of them busy. With zero workers, all tasks are run by the
+ * threads waiting on them.
+ *
+ * Returns: pointer to new pool if successful, otherwise NULL.
+ **/
+rpool_t *rpool_new(unsigned workers)
+{
+   unsigned i;
+   rpool_t *pool = (rpool_t*)calloc(1, sizeof(*pool));
+
+   if (!pool)
+      return NULL;
+
+   pool->num_queues = workers ? workers : 1;
+   pool->queues     = (struct rpool_queue*)
+      calloc(pool->num_queues, sizeof(*pool->queues));
+   pool->workers    = (struct rpool_worker*)
+      calloc(workers ? workers : 1, sizeof(*pool->workers));
+   pool->lock       = slock_new();
+   pool->work_cond  = scond_new();
+   pool->done_cond  = scond_new();
+
+   pool->submitted.capacity = RPOOL_QUEUE_MIN;
+   pool->submitted.tasks    = (struct rpool_task*)
+      malloc(pool->submitted.capacity * sizeof(*pool->submitted.tasks));
+   pool->submitted.lock     = slock_new();
+
+   if (!pool->queues || !pool->workers || !pool->lock
+         || !pool->work_cond || !pool->done_cond
+         || !pool->submitted.tasks || !pool->submitted.lock)
+      goto error;
+
+   for (i = 0; i < pool->num_queues; i++)
+   {
+      struct rpool_queue *queue = &pool->queues[i];
+
+      queue->capacity = RPOOL_QUEUE_MIN;
+      queue->tasks    = (struct rpool_task*)
+         malloc(queue->capacity * sizeof(*queue->tasks));
+      queue->lock     = slock_new();
+
+      if (!queue->tasks || !queue->lock)
+         goto error;
+   }
+
+   for (i = 0; i < workers; i++)
+   {
+      pool->workers[i].pool   = pool;
+      pool->workers[i].index  = i;
+      pool->workers[i].thread = sthread_create(rpool_worker_loop,
+            &pool->workers[i]);
+
+      if (!pool->workers[i].thread)
+         goto error;
+
+      pool->num_workers++;
+   }
+
+   return pool;
+
+error:
+   rpool_free(pool);
+   return NULL;
+}
+
+/**
+ * rpool_free:
+ * @pool                    : pointer to pool object
+ *
+ * Stops the workers and frees the pool. No rpool_parallel_for()
+ * may be running on it, and all submitted work must have been
+ * waited on.
+ **/
+void rpool_free(rpool_t *pool)
+{
+   unsigned i;
+
+   if (!pool)
+      return;
+
+   if (pool->lock)
+   {
+      slock_lock(pool->lock);
+      pool->quit = true;
+      if (pool->work_cond)
+         scond_broadcast(pool->work_cond);
+      slock_unlock(pool->lock);
+   }
+
+   for (i = 0; i < pool->num_workers; i++)
+      sthread_join(pool->workers[i].thread);
+
+   for (i = 0; pool->queues && i < pool->num_queues; i++)
+   {
+      free(pool->queues[i].tasks);
+      if (pool->queues[i].lock)
+         slock_free(pool->queues[i].lock);
+   }
+
+   free(pool->submitted.tasks);
+   if (pool->submitted.lock)
+      slock_free(pool->submitted.lock);
+
+   if (pool->done_cond)
+      scond_free(pool->done_cond);
+   if (pool->work_cond)
+      scond_free(pool->work_cond);
+   if (pool->lock)
+      slock_free(pool->lock);
+
+   free(pool->workers);
+   free(pool->queues);
+   free(pool);
+}
+
+/**
+ * rpool_workers:
+ * @pool                    : pointer to pool object
+ *
+ * Returns: number of worker threads in @pool.
+ **/
+unsigned rpool_workers(rpool_t *pool)
+{
+   return pool ? pool->num_workers : 0;
+}
+
+/**
+ * rpool_parallel_for:
+ * @pool                    : pointer to pool object, may be NULL
+ * @count                   : number of items
+ * @func                    : function to run for every item
+ * @userdata                : passed to @func
+ *
+ * Calls @func once for every index in [0, @count), spread out over
+ * the pool and the calling thread, and returns when all are done.
+ * Runs everything on the calling thread if @pool is NULL.
+ **/
+void rpool_parallel_for(rpool_t *pool, unsigned count,
+      rpool_func_t func, void *userdata)
+{
+   rpool_future_t future;
+
+   if (!count)
+      return;
+
+   if (!pool || !pool->num_workers || count == 1)
+   {
+      unsigned i;
+      for (i = 0; i < count; i++)
+         func(userdata, i);
+      return;
+   }
+
+   /* The calling thread takes the first item itself. */
+   future.pool      = pool;
+   future.remaining = count - 1;
+
+   rpool_enqueue(pool, &future, func, userdata, 1, count - 1);
+   func(userdata, 0);
+   rpool_wait(pool, &future);
+}
+
+/**
+ * rpool_submit:
+ * @pool                    : pointer to pool object, may be NULL
+ * @func                    : function to run
+ * @userdata                : passed to @func
+ *
+ * Queues @func to be run on one of the workers. Submitted tasks
+ * are picked up after any rpool_parallel_for() items, and are
+ * never run by a thread waiting in rpool_parallel_for(), so they
+ * may block. Runs @func on the calling thread before returning
+ * if @pool is NULL or has no workers.
+ *
+ * Returns: a future which must be passed to rpool_future_wait(),
+ * or NULL on failure.
+ **/
+rpool_future_t *rpool_submit(rpool_t *pool,
+      rpool_func_t func, void *userdata)
+{
+   struct rpool_task task;
+   rpool_future_t *future = (rpool_future_t*)calloc(1, sizeof(*future));
+
+   if (!future)
+      return NULL;
+
+   future->pool = pool;
+
+   if (!pool || !pool->num_workers)
+   {
+      func(userdata, 0);
+      return future;
+   }
+
+   task.func         = func;
+   task.userdata     = userdata;
+   task.index        = 0;
+   task.future       = future;
+   future->remaining = 1;
+
+   slock_lock(pool->lock);
+
+   if (!rpool_queue_push(&pool->submitted, &task))
+   {
+      slock_unlock(pool->lock);
+      free(future);
+      return NULL;
+   }
+
+   rpool_wake(pool, 1);
+   slock_unlock(pool->lock);
+
+   return future;
+}
+
+/**
+ * rpool_future_done:
+ * @future                  : pointer to future object
+ *
+ * Returns: true (1) if the task of @future has finished,
+ * otherwise false (0).
+ **/
+bool rpool_future_done(rpool_future_t *future)
+{
+   bool done;
+
+   if (!future->pool)
+      return true;
+
+   slock_lock(future->pool->lock);
+   done = !future->remaining;
+   slock_unlock(future->pool->lock);
+
+   return done;
+}
+
+/**
+ * rpool_future_wait:
+ * @future                  : pointer to future object, may be NULL
+ *
+ * Waits for the task of @future to finish, running queued
+ * rpool_parallel_for() items in the meantime, and frees @future.
+ **/
+void rpool_future_wait(rpool_future_t *future)
+{
+   if (!future)
+      return;
+
+   if (future->pool)
+      rpool_wait(future->pool, future);
+   free(future);
+}
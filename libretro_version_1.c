@@ -39,6 +39,7 @@
 #include "audio/audio_utils.h"
 #include "record/record_driver.h"
 #include "gfx/video_pixel_converter.h"
+#include "gfx/video_frame_pool.h"
 
 #ifdef HAVE_NETPLAY
 #include "netplay.h"
@@ -69,7 +70,7 @@ static void video_frame(const void *data, unsigned width,
    {
       video_pixel_scaler_t *scaler = scaler_get_ptr();
 
-      data                        = scaler->scaler_out;
+      data                        = scaler->out->data;
       pitch                       = scaler->scaler->out_stride;
    }
 
@@ -459,6 +460,48 @@ void retro_init_libretro_cbs(void *data)
 #endif
 }
 
+static void video_frame_runahead(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+   (void)data;
+   (void)width;
+   (void)height;
+   (void)pitch;
+}
+
+static void audio_sample_runahead(int16_t left, int16_t right)
+{
+   (void)left;
+   (void)right;
+}
+
+static size_t audio_sample_batch_runahead(const int16_t *data, size_t frames)
+{
+   (void)data;
+   return frames;
+}
+
+/**
+ * retro_set_runahead_callbacks:
+ * @hide_video           : drop the frames the core renders.
+ * @hide_audio           : drop the samples the core renders.
+ *
+ * Sets the video and audio callbacks for frames which are
+ * run ahead and later rolled back.
+ **/
+void retro_set_runahead_callbacks(bool hide_video, bool hide_audio)
+{
+   pretro_set_video_refresh(hide_video ? video_frame_runahead : video_frame);
+
+   if (hide_audio)
+   {
+      pretro_set_audio_sample(audio_sample_runahead);
+      pretro_set_audio_sample_batch(audio_sample_batch_runahead);
+   }
+   else
+      retro_set_rewind_callbacks();
+}
+
 /**
  * retro_set_rewind_callbacks:
  *
@@ -22,6 +22,7 @@
 extern "C" {
 #endif
 
+#include <boolean.h>
 #include "libretro.h"
 
 typedef struct retro_callbacks
@@ -58,6 +59,16 @@ void retro_set_default_callbacks(void *data);
  **/
 void retro_set_rewind_callbacks(void);
 
+/**
+ * retro_set_runahead_callbacks:
+ * @hide_video           : drop the frames the core renders.
+ * @hide_audio           : drop the samples the core renders.
+ *
+ * Sets the video and audio callbacks for frames which are
+ * run ahead and later rolled back.
+ **/
+void retro_set_runahead_callbacks(bool hide_video, bool hide_audio);
+
 /**
  * retro_flush_audio:
  * @data                 : pointer to audio buffer.
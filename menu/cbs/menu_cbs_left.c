@@ -109,6 +109,8 @@ static int action_left_save_state(unsigned type, const char *label,
    if (settings->state_slot >= 0)
       settings->state_slot--;
 
+   rarch_main_state_slot_msg();
+
    return 0;
 }
 
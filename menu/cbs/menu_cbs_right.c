@@ -114,6 +114,8 @@ static int action_right_save_state(unsigned type, const char *label,
 
    settings->state_slot++;
 
+   rarch_main_state_slot_msg();
+
    return 0;
 }
 
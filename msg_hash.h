@@ -88,6 +88,7 @@
 #define MSG_FAILED_TO_START_MOVIE_RECORD              0x61221776U
 
 #define MSG_STATE_SLOT                                0x27b67f67U
+#define MSG_STATE_SLOT_EMPTY                          0x9a03a075U
 #define MSG_STARTING_MOVIE_RECORD_TO                  0x6a7e0d50U
 #define MSG_FAILED_TO_START_MOVIE_RECORD              0x61221776U
 
@@ -120,6 +121,7 @@
 #define MSG_CONFIG_DIRECTORY_NOT_SET                  0xcd45252aU
 
 #define MSG_SAVED_STATE_TO_SLOT                       0xe1e3dc3bU
+#define MSG_SAVED_STATE_TO                            0xa6f8525aU
 
 #define MSG_CORE_DOES_NOT_SUPPORT_SAVESTATES          0xd50adf46U
 #define MSG_FAILED_TO_LOAD_STATE                      0x91f348ebU
@@ -396,6 +396,49 @@ unsigned rarch_get_cpu_cores(void)
 #endif
 }
 
+#ifdef HAVE_THREADS
+static rpool_t *rarch_thread_pool;
+
+/**
+ * rarch_get_thread_pool:
+ *
+ * Gets the thread pool shared by data-parallel work such as
+ * softfilters and the scaler, and by the autosave passes, creating
+ * it on first use. It has a worker for every CPU core but the one
+ * of the calling thread. Must only be called from the main thread.
+ * Audio DSP doesn't use it, as a DSP chain is serial and too short
+ * to be worth splitting.
+ *
+ * Returns: the shared thread pool, or NULL if it can't be created.
+ **/
+rpool_t *rarch_get_thread_pool(void)
+{
+   unsigned cores;
+
+   if (rarch_thread_pool)
+      return rarch_thread_pool;
+
+   cores             = rarch_get_cpu_cores();
+   rarch_thread_pool = rpool_new(cores > 1 ? cores - 1 : 0);
+
+   if (rarch_thread_pool)
+      RARCH_LOG("Started thread pool with %u workers.\n",
+            rpool_workers(rarch_thread_pool));
+   return rarch_thread_pool;
+}
+
+/**
+ * rarch_thread_pool_free:
+ *
+ * Frees the shared thread pool.
+ **/
+void rarch_thread_pool_free(void)
+{
+   rpool_free(rarch_thread_pool);
+   rarch_thread_pool = NULL;
+}
+#endif
+
 /**
  * rarch_get_cpu_features:
  *
@@ -23,6 +23,10 @@
 
 #include "libretro.h"
 
+#ifdef HAVE_THREADS
+#include <rthreads/rpool.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -116,6 +120,27 @@ uint64_t rarch_get_cpu_features(void);
  **/
 unsigned rarch_get_cpu_cores(void);
 
+#ifdef HAVE_THREADS
+/**
+ * rarch_get_thread_pool:
+ *
+ * Gets the thread pool shared by data-parallel work such as
+ * softfilters and by the autosave passes, creating it on first
+ * use. It has a worker for every CPU core but the one of the
+ * calling thread. Must only be called from the main thread.
+ *
+ * Returns: the shared thread pool, or NULL if it can't be created.
+ **/
+rpool_t *rarch_get_thread_pool(void);
+
+/**
+ * rarch_thread_pool_free:
+ *
+ * Frees the shared thread pool.
+ **/
+void rarch_thread_pool_free(void);
+#endif
+
 
 #ifdef __cplusplus
 }
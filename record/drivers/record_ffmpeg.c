@@ -47,6 +47,7 @@ extern "C" {
 #include <queues/fifo_buffer.h>
 #include <rthreads/rthreads.h>
 #include "../../general.h"
+#include "../../performance.h"
 #include <gfx/scaler/scaler.h>
 #include <file/config_file.h>
 #include "../../audio/audio_utils.h"
@@ -306,7 +307,8 @@ static bool ffmpeg_init_audio(ffmpeg_t *handle)
       rarch_resampler_realloc(&audio->resampler_data,
             &audio->resampler,
             settings->audio.resampler,
-            audio->ratio);
+            audio->ratio,
+            (enum resampler_quality)settings->audio.resampler_quality);
    }
    else
    {
@@ -438,6 +440,13 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
          return false;
    }
 
+#ifdef HAVE_THREADS
+   /* The in-house scaler runs on the encoding thread, but the pool
+    * has to be created here, on the main thread. */
+   video->scaler.pool    = rarch_get_thread_pool();
+   video->scaler.threads = rarch_get_cpu_cores();
+#endif
+
    video->codec = avcodec_alloc_context3(codec);
 
    /* Useful to set scale_factor to 2 for chroma subsampled formats to
@@ -935,7 +944,7 @@ static void ffmpeg_scale_input(ffmpeg_t *handle,
             data->width, data->height, handle->video.in_pix_fmt,
             handle->params.out_width, handle->params.out_height,
             handle->video.pix_fmt,
-            shrunk ? SWS_BILINEAR : SWS_POINT, NULL, NULL, NULL);
+            shrunk ? SWS_AREA : SWS_POINT, NULL, NULL, NULL);
 
       sws_scale(handle->video.sws, (const uint8_t* const*)&data->data,
             &linesize, 0, data->height, handle->video.conv_frame->data,
@@ -951,7 +960,7 @@ static void ffmpeg_scale_input(ffmpeg_t *handle,
          handle->video.scaler.in_stride = data->pitch;
 
          handle->video.scaler.scaler_type = shrunk ?
-            SCALER_TYPE_BILINEAR : SCALER_TYPE_POINT;
+            SCALER_TYPE_AREA : SCALER_TYPE_POINT;
 
          handle->video.scaler.out_width  = handle->params.out_width;
          handle->video.scaler.out_height = handle->params.out_height;
@@ -1153,6 +1162,7 @@ static void ffmpeg_audio_resample(ffmpeg_t *handle,
       info.data_out     = handle->audio.resample_out;
       info.input_frames = data->frames;
       info.ratio        = handle->audio.ratio;
+      info.gain         = 1.0f;
 
       rarch_resampler_process(handle->audio.resampler,
             handle->audio.resampler_data, &info);
@@ -1096,6 +1096,10 @@ void rarch_main_free(void)
    rarch_main_state_free();
    rarch_main_global_free();
    config_free();
+
+#ifdef HAVE_THREADS
+   rarch_thread_pool_free();
+#endif
 }
 
 /*
@@ -25,6 +25,15 @@
 #include "general.h"
 #include "msg_hash.h"
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#if defined(HAVE_ZLIB) && defined(HAVE_ZLIB_DEFLATE)
+#define HAVE_REWIND_DEFLATE
+#include <file/file_extract.h>
+#endif
+
 #ifndef UINT16_MAX
 #define UINT16_MAX 0xffff
 #endif
@@ -43,6 +52,19 @@
 #define NO_UNALIGNED_MEM
 #endif
 
+/* Wider scan kernels are picked at runtime, 
+ * see state_manager_raw_init_simd(). */
+#if defined(CPU_X86) && (defined(__clang__) || (defined(__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define HAVE_REWIND_AVX2
+#include <immintrin.h>
+#endif
+
+#if (defined(__ARM_NEON__) || defined(__ARM_NEON)) && defined(__GNUC__)
+#define HAVE_REWIND_NEON
+#include <arm_neon.h>
+#endif
+
 /* Format per frame (pseudocode): */
 #if 0
 size nextstart;
@@ -68,7 +90,7 @@ size_t state_manager_raw_maxsize(size_t uncomp)
    /* bytes covered by a compressed block */
    const int maxcblkcover = UINT16_MAX * sizeof(uint16_t);
    /* uncompressed size, rounded to 16 bits */
-   size_t uncomp16        = (uncomp + sizeof(uint16_t) - 1) & ~sizeof(uint16_t);
+   size_t uncomp16        = (uncomp + sizeof(uint16_t) - 1) & ~(sizeof(uint16_t) - 1);
    /* number of blocks */
    size_t maxcblks        = (uncomp + maxcblkcover - 1) / maxcblkcover;
    return uncomp16 + maxcblks * sizeof(uint16_t) * 2 /* two u16 overhead per block */ + sizeof(uint16_t) *
@@ -77,9 +99,9 @@ size_t state_manager_raw_maxsize(size_t uncomp)
 
 void *state_manager_raw_alloc(size_t len, uint16_t uniq)
 {
-   size_t  len16 = (len + sizeof(uint16_t) - 1) & ~sizeof(uint16_t);
+   size_t  len16 = (len + sizeof(uint16_t) - 1) & ~(sizeof(uint16_t) - 1);
 
-   uint16_t *ret = (uint16_t*)calloc(len16 + sizeof(uint16_t) * 4 + 16, 1);
+   uint16_t *ret = (uint16_t*)calloc(len16 + sizeof(uint16_t) * 4 + 32, 1);
 
    /* Force in a different byte at the end, so we don't need to check 
     * bounds in the innermost loop (it's expensive).
@@ -89,8 +111,9 @@ void *state_manager_raw_alloc(size_t len, uint16_t uniq)
     *
     * There is also some padding at the end. This is so we don't 
     * read outside the buffer end if we're reading in large blocks;
+    * the AVX2 kernels read 32 bytes at a time.
     *
-    * It doesn't make any difference to us, but sacrificing 16 bytes to get 
+    * It doesn't make any difference to us, but sacrificing 32 bytes to get 
     * Valgrind happy is worth it. */
    ret[len16/sizeof(uint16_t) + 3] = uniq;
 
@@ -223,8 +246,116 @@ static INLINE size_t find_same(const uint16_t *a, const uint16_t *b)
    return a - a_org;
 }
 
-size_t state_manager_raw_compress(const void *src,
-      const void *dst, size_t len, void *patch)
+#ifdef HAVE_REWIND_AVX2
+/* Same as the SSE2 version, 32 bytes at a time. */
+static INLINE __attribute__((target("avx2")))
+size_t find_change_avx2(const uint16_t *a, const uint16_t *b)
+{
+   const __m256i *a256 = (const __m256i*)a;
+   const __m256i *b256 = (const __m256i*)b;
+
+   for (;;)
+   {
+      __m256i v0    = _mm256_loadu_si256(a256);
+      __m256i v1    = _mm256_loadu_si256(b256);
+      __m256i c     = _mm256_cmpeq_epi32(v0, v1);
+      uint32_t mask = (uint32_t)_mm256_movemask_epi8(c);
+
+      if (mask != 0xffffffffu)
+      {
+         size_t ret = (((uint8_t*)a256 - (uint8_t*)a) |
+               (__builtin_ctz(~mask))) >> 1;
+         return ret | (a[ret] == b[ret]);
+      }
+
+      a256++;
+      b256++;
+   }
+}
+
+/* Finds the first identical 32-bit word, like the scalar version. 
+ * The caller guarantees that a[0] != b[0]. */
+static INLINE __attribute__((target("avx2")))
+size_t find_same_avx2(const uint16_t *a, const uint16_t *b)
+{
+   const __m256i *a256 = (const __m256i*)a;
+   const __m256i *b256 = (const __m256i*)b;
+
+   for (;;)
+   {
+      __m256i v0    = _mm256_loadu_si256(a256);
+      __m256i v1    = _mm256_loadu_si256(b256);
+      __m256i c     = _mm256_cmpeq_epi32(v0, v1);
+      uint32_t mask = (uint32_t)_mm256_movemask_epi8(c);
+
+      if (mask)
+      {
+         size_t ret = (((uint8_t*)a256 - (uint8_t*)a) |
+               (__builtin_ctz(mask))) >> 1;
+         return ret - (a[ret - 1] == b[ret - 1]);
+      }
+
+      a256++;
+      b256++;
+   }
+}
+#endif
+
+#ifdef HAVE_REWIND_NEON
+static INLINE size_t find_change_neon(const uint16_t *a, const uint16_t *b)
+{
+   const uint16_t *a_org = a;
+
+   for (;;)
+   {
+      uint16x8_t c  = vceqq_u16(vld1q_u16(a), vld1q_u16(b));
+      uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vmovn_u16(c)), 0);
+
+      /* One byte per 16-bit element, in memory order. */
+      if (mask != UINT64_C(0xffffffffffffffff))
+         return (a - a_org) + (__builtin_ctzll(~mask) >> 3);
+
+      a += 8;
+      b += 8;
+   }
+}
+
+/* Works on 32-bit words to match the other find_same versions. 
+ * The caller guarantees that a[0] != b[0]. */
+static INLINE size_t find_same_neon(const uint16_t *a, const uint16_t *b)
+{
+   const uint16_t *a_org = a;
+   const uint16_t *b_org = b;
+
+   for (;;)
+   {
+      uint32x4_t c  = vceqq_u32(
+            vreinterpretq_u32_u16(vld1q_u16(a)),
+            vreinterpretq_u32_u16(vld1q_u16(b)));
+      uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u16(vmovn_u32(c)), 0);
+
+      /* One 16-bit element per 32-bit word, in memory order. */
+      if (mask)
+      {
+         size_t ret = (a - a_org) + (__builtin_ctzll(mask) >> 3);
+         return ret - (a_org[ret - 1] == b_org[ret - 1]);
+      }
+
+      a += 8;
+      b += 8;
+   }
+}
+#endif
+
+typedef size_t (*find_func_t)(const uint16_t *a, const uint16_t *b);
+
+/* The scan kernels are passed as constants from the wrappers below 
+ * so they get inlined into each specialized copy of this loop. */
+static INLINE size_t raw_compress(const void *src,
+      const void *dst, size_t len, void *patch,
+      find_func_t find_change, find_func_t find_same)
 {
    const uint16_t  *old16 = (const uint16_t*)src;
    const uint16_t  *new16 = (const uint16_t*)dst;
@@ -283,6 +414,69 @@ size_t state_manager_raw_compress(const void *src,
    return (uint8_t*)(compressed16+3) - (uint8_t*)patch;
 }
 
+static size_t raw_compress_generic(const void *src,
+      const void *dst, size_t len, void *patch)
+{
+   return raw_compress(src, dst, len, patch, find_change, find_same);
+}
+
+#ifdef HAVE_REWIND_AVX2
+static __attribute__((target("avx2")))
+size_t raw_compress_avx2(const void *src,
+      const void *dst, size_t len, void *patch)
+{
+   return raw_compress(src, dst, len, patch,
+         find_change_avx2, find_same_avx2);
+}
+#endif
+
+#ifdef HAVE_REWIND_NEON
+static size_t raw_compress_neon(const void *src,
+      const void *dst, size_t len, void *patch)
+{
+   return raw_compress(src, dst, len, patch,
+         find_change_neon, find_same_neon);
+}
+#endif
+
+static size_t (*raw_compress_cb)(const void *src,
+      const void *dst, size_t len, void *patch) = raw_compress_generic;
+
+const char *state_manager_raw_init_simd(uint64_t cpu)
+{
+   (void)cpu;
+
+   raw_compress_cb = raw_compress_generic;
+
+#ifdef HAVE_REWIND_AVX2
+   if ((cpu & (RETRO_SIMD_AVX | RETRO_SIMD_AVX2)) ==
+         (RETRO_SIMD_AVX | RETRO_SIMD_AVX2))
+   {
+      raw_compress_cb = raw_compress_avx2;
+      return "AVX2";
+   }
+#endif
+#ifdef HAVE_REWIND_NEON
+   if (cpu & RETRO_SIMD_NEON)
+   {
+      raw_compress_cb = raw_compress_neon;
+      return "NEON";
+   }
+#endif
+
+#if __SSE2__
+   return "SSE2";
+#else
+   return "C";
+#endif
+}
+
+size_t state_manager_raw_compress(const void *src,
+      const void *dst, size_t len, void *patch)
+{
+   return raw_compress_cb(src, dst, len, patch);
+}
+
 void state_manager_raw_decompress(const void *patch,
       size_t patchlen, void *data, size_t datalen)
 {
@@ -360,6 +554,21 @@ static INLINE size_t read_size_t(const void *ptr)
    return ret;
 }
 
+/* In threaded mode these run on the worker, but rarch_perf_register()
+ * isn't thread-safe, so they are registered in state_manager_new(). */
+static struct retro_perf_counter gen_deltas = { "gen_deltas" };
+#ifdef HAVE_REWIND_DEFLATE
+static struct retro_perf_counter deflate_deltas = { "deflate_deltas" };
+#endif
+
+struct state_manager_keyframe
+{
+   uint64_t serial;
+   /* Offset of the entry in the ring, i.e. where 'head' points 
+    * after it's been popped. */
+   size_t start;
+};
+
 struct state_manager
 {
    uint8_t *data;
@@ -382,18 +591,446 @@ struct state_manager
 
    unsigned entries;
    bool thisblock_valid;
+
+   /* Serial number of the state in thisblock. The entry at the head 
+    * of the ring has the same number, and turns that state into the 
+    * previous one. */
+   uint64_t serial;
+
+   /* Every keyframe_interval-th entry stores a full copy of the 
+    * previous state instead of a patch. They are indexed in a 
+    * circular array, oldest first, so we can seek straight to them. */
+   unsigned keyframe_interval;
+   struct state_manager_keyframe *keyframes;
+   size_t keyframes_size;
+   size_t keyframes_first;
+   size_t keyframes_count;
+
+#ifdef HAVE_THREADS
+   /* Threaded mode: the delta between thisblock and nextblock is 
+    * generated on a worker thread. The worker reads 'job_old' and 
+    * 'job_new' while it's busy, so a third block is kept around 
+    * to serialize the next state into. */
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   uint8_t *spareblock;
+   const uint8_t *job_old;
+   const uint8_t *job_new;
+   bool busy;
+   bool quit;
+#endif
+
+#ifdef HAVE_REWIND_DEFLATE
+   /* Second tier: entries that are older than deflate_age, or that 
+    * are pushed out of the main ring, are deflated and moved to a 
+    * separate ring with the same layout. Its head is always the 
+    * entry right before the tail of the main ring. */
+   unsigned deflate_age;
+   /* Serial number of the entry at the tail of the main ring. */
+   uint64_t tail_serial;
+
+   uint8_t *cold_data;
+   size_t cold_capacity;
+   uint8_t *cold_head;
+   uint8_t *cold_tail;
+   size_t cold_maxsize;
+   unsigned cold_entries;
+
+   /* Inflated patches go here before they're applied. */
+   uint8_t *scratch;
+#endif
+};
+
+#ifdef HAVE_REWIND_DEFLATE
+/* Each entry in the deflated ring starts with this. */
+struct state_manager_cold_header
+{
+   uint32_t size;
+   uint32_t stored_size;
+   uint32_t flags;
 };
 
-state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
+#define COLD_KEYFRAME (1 << 0)
+#define COLD_DEFLATED (1 << 1)
+#endif
+
+static size_t state_manager_remaining(const uint8_t *data,
+      size_t capacity, const uint8_t *head, const uint8_t *tail)
+{
+   size_t headpos = head - data;
+   size_t tailpos = tail - data;
+
+   return (tailpos + capacity - sizeof(size_t) - headpos - 1)
+      % capacity + 1;
+}
+
+static struct state_manager_keyframe *state_manager_keyframe(
+      state_manager_t *state, size_t idx)
+{
+   return &state->keyframes[(state->keyframes_first + idx)
+      % state->keyframes_size];
+}
+
+static bool state_manager_tail_is_keyframe(state_manager_t *state)
+{
+   return state->keyframes_count &&
+      state_manager_keyframe(state, 0)->start ==
+      (size_t)(state->tail - state->data);
+}
+
+/* Removes the oldest entry from the main ring. */
+static void state_manager_advance_tail(state_manager_t *state)
+{
+   if (state_manager_tail_is_keyframe(state))
+   {
+      state->keyframes_first = (state->keyframes_first + 1)
+         % state->keyframes_size;
+      state->keyframes_count--;
+   }
+
+   state->tail = state->data + read_size_t(state->tail);
+
+#ifdef HAVE_REWIND_DEFLATE
+   state->tail_serial++;
+#endif
+}
+
+#ifdef HAVE_REWIND_DEFLATE
+/* Returns the size of a patch from state_manager_raw_compress(). */
+static size_t state_manager_patch_size(const uint8_t *patch)
+{
+   const uint16_t *patch16 = (const uint16_t*)patch;
+
+   for (;;)
+   {
+      uint16_t numchanged = *(patch16++);
+
+      if (numchanged)
+         patch16 += numchanged + 1;
+      else
+      {
+         uint32_t numunchanged = patch16[0] | (patch16[1] << 16);
+
+         patch16 += 2;
+         if (!numunchanged)
+            break;
+      }
+   }
+
+   return (const uint8_t*)patch16 - patch;
+}
+
+static void state_manager_cold_push(state_manager_t *state,
+      const uint8_t *src, size_t len, bool keyframe)
+{
+   struct state_manager_cold_header header;
+   uint8_t *out;
+   void *stream = NULL;
+
+   while (state_manager_remaining(state->cold_data, state->cold_capacity,
+            state->cold_head, state->cold_tail) <= state->cold_maxsize)
+   {
+      state->cold_tail = state->cold_data + read_size_t(state->cold_tail);
+      state->cold_entries--;
+      state->entries--;
+   }
+
+   RARCH_PERFORMANCE_START(deflate_deltas);
+
+   out                = state->cold_head + sizeof(size_t);
+   header.size        = len;
+   header.stored_size = len;
+   header.flags       = keyframe ? COLD_KEYFRAME : 0;
+
+   /* Only keep the deflated version if it's actually smaller. */
+   if ((stream = zlib_stream_new()))
+   {
+      zlib_set_stream(stream, len, len, src, out + sizeof(header));
+      zlib_deflate_init(stream, 1);
+
+      if (zlib_deflate_data_to_file(stream) == 1)
+      {
+         header.stored_size = zlib_stream_get_total_out(stream);
+         header.flags      |= COLD_DEFLATED;
+      }
+
+      zlib_stream_deflate_free(stream);
+      free(stream);
+   }
+
+   if (!(header.flags & COLD_DEFLATED))
+      memcpy(out + sizeof(header), src, len);
+
+   memcpy(out, &header, sizeof(header));
+   out += sizeof(header) + header.stored_size;
+
+   if (out - state->cold_data + state->cold_maxsize > state->cold_capacity)
+   {
+      out = state->cold_data;
+      if (state->cold_tail == state->cold_data + sizeof(size_t))
+      {
+         state->cold_tail = state->cold_data + read_size_t(state->cold_tail);
+         state->cold_entries--;
+         state->entries--;
+      }
+   }
+   write_size_t(out, state->cold_head - state->cold_data);
+   out += sizeof(size_t);
+   write_size_t(state->cold_head, out - state->cold_data);
+   state->cold_head = out;
+
+   state->cold_entries++;
+
+   RARCH_PERFORMANCE_STOP(deflate_deltas);
+}
+
+static bool state_manager_cold_pop(state_manager_t *state)
+{
+   size_t start;
+   struct state_manager_cold_header header;
+   const uint8_t *entry = NULL;
+   uint8_t *out         = NULL;
+
+   if (state->cold_head == state->cold_tail)
+      return false;
+
+   start            = read_size_t(state->cold_head - sizeof(size_t));
+   state->cold_head = state->cold_data + start;
+
+   entry = state->cold_data + start + sizeof(size_t);
+   memcpy(&header, entry, sizeof(header));
+   entry += sizeof(header);
+
+   out = (header.flags & COLD_KEYFRAME) ? state->thisblock : state->scratch;
+
+   if (header.flags & COLD_DEFLATED)
+   {
+      int ret      = -1;
+      void *stream = zlib_stream_new();
+
+      if (stream && zlib_inflate_init(stream))
+      {
+         zlib_set_stream(stream, header.stored_size, header.size,
+               entry, out);
+
+         do
+         {
+            ret = zlib_inflate_data_to_file_iterate(stream);
+         } while (ret == 0);
+
+         zlib_stream_free(stream);
+      }
+      free(stream);
+
+      if (ret != 1)
+      {
+         /* Nothing sane to do with the rest of the history. */
+         state->cold_tail = state->cold_head;
+         state->entries  -= state->cold_entries;
+         state->cold_entries = 0;
+         return false;
+      }
+   }
+   else
+      memcpy(out, entry, header.size);
+
+   if (!(header.flags & COLD_KEYFRAME))
+      state_manager_raw_decompress(state->scratch, header.size,
+            state->thisblock, state->blocksize);
+
+   state->cold_entries--;
+   state->serial--;
+   state->entries--;
+   return true;
+}
+
+/* Moves the oldest entry of the main ring to the deflated ring. */
+static void state_manager_migrate_tail(state_manager_t *state)
+{
+   const uint8_t *entry = state->tail + sizeof(size_t);
+   bool keyframe        = state_manager_tail_is_keyframe(state);
+
+   state_manager_cold_push(state, entry, keyframe ?
+         state->blocksize : state_manager_patch_size(entry), keyframe);
+   state_manager_advance_tail(state);
+}
+#endif
+
+/* Makes room in the main ring by deflating or discarding 
+ * the oldest entry. */
+static void state_manager_drop_tail(state_manager_t *state)
+{
+#ifdef HAVE_REWIND_DEFLATE
+   if (state->cold_data)
+   {
+      state_manager_migrate_tail(state);
+      return;
+   }
+#endif
+
+   state_manager_advance_tail(state);
+   state->entries--;
+}
+
+/* Appends the delta from 'oldb' to 'newb' to the ring, discarding 
+ * the oldest entries if it doesn't fit. The new entry gets the 
+ * current serial number. In threaded mode this runs on the 
+ * worker thread. */
+static void state_manager_push_delta(state_manager_t *state,
+      const uint8_t *oldb, const uint8_t *newb)
+{
+   uint8_t *compressed;
+   size_t headpos, tailpos, remaining;
+
+recheckcapacity:;
+
+   headpos = state->head - state->data;
+   tailpos = state->tail - state->data;
+   remaining = (tailpos + state->capacity -
+         sizeof(size_t) - headpos - 1) % state->capacity + 1;
+
+   if (remaining <= state->maxcompsize)
+   {
+      state_manager_drop_tail(state);
+      goto recheckcapacity;
+   }
+
+#ifdef HAVE_REWIND_DEFLATE
+   if (state->head == state->tail)
+      state->tail_serial = state->serial;
+#endif
+
+   RARCH_PERFORMANCE_START(gen_deltas);
+
+   compressed = state->head + sizeof(size_t);
+
+   if (state->keyframe_interval &&
+         state->serial % state->keyframe_interval == 0)
+   {
+      struct state_manager_keyframe *key = state_manager_keyframe(state,
+            state->keyframes_count++);
+
+      key->serial = state->serial;
+      key->start  = headpos;
+
+      memcpy(compressed, oldb, state->blocksize);
+      compressed += state->blocksize;
+   }
+   else
+      compressed += state_manager_raw_compress(oldb, newb,
+            state->blocksize, compressed);
+
+   if (compressed - state->data + state->maxcompsize > state->capacity)
+   {
+      compressed = state->data;
+      if (state->tail == state->data + sizeof(size_t))
+         state_manager_drop_tail(state);
+   }
+   write_size_t(compressed, state->head-state->data);
+   compressed += sizeof(size_t);
+   write_size_t(state->head, compressed-state->data);
+   state->head = compressed;
+
+   RARCH_PERFORMANCE_STOP(gen_deltas);
+
+#ifdef HAVE_REWIND_DEFLATE
+   if (state->cold_data)
+   {
+      while (state->tail != state->head &&
+            state->serial - state->tail_serial >= state->deflate_age)
+         state_manager_migrate_tail(state);
+   }
+#endif
+}
+
+#ifdef HAVE_THREADS
+static void state_manager_thread(void *data)
+{
+   state_manager_t *state = (state_manager_t*)data;
+
+   slock_lock(state->lock);
+
+   for (;;)
+   {
+      while (!state->busy && !state->quit)
+         scond_wait(state->cond, state->lock);
+
+      if (state->quit)
+         break;
+
+      slock_unlock(state->lock);
+      state_manager_push_delta(state, state->job_old, state->job_new);
+      slock_lock(state->lock);
+
+      state->busy = false;
+      scond_signal(state->cond);
+   }
+
+   slock_unlock(state->lock);
+}
+
+/**
+ * state_manager_wait:
+ * @state              : pointer to state manager
+ *
+ * Blocks until the worker thread (if any) has finished writing 
+ * the last delta into the ring. Must be called before touching 
+ * the ring from the main thread.
+ **/
+static void state_manager_wait(state_manager_t *state)
+{
+   if (!state->thread)
+      return;
+
+   slock_lock(state->lock);
+   while (state->busy)
+      scond_wait(state->cond, state->lock);
+   slock_unlock(state->lock);
+}
+#endif
+
+state_manager_t *state_manager_new(size_t state_size, size_t buffer_size,
+      bool threaded, unsigned keyframe_interval, unsigned deflate_age)
 {
    state_manager_t *state = (state_manager_t*)calloc(1, sizeof(*state));
 
    if (!state)
       return NULL;
 
-   state->blocksize   = (state_size + sizeof(uint16_t) - 1) & ~sizeof(uint16_t);
+   rarch_perf_register(&gen_deltas);
+
+   state->blocksize   = (state_size + sizeof(uint16_t) - 1) & ~(sizeof(uint16_t) - 1);
    /* the compressed data is surrounded by pointers to the other side */
    state->maxcompsize = state_manager_raw_maxsize(state_size) + sizeof(size_t) * 2;
+
+#ifdef HAVE_REWIND_DEFLATE
+   /* The deflated ring gets most of the budget, since that's where 
+    * the bulk of the history ends up. */
+   if (deflate_age && buffer_size / 4 >= state->maxcompsize * 4)
+   {
+      state->deflate_age   = deflate_age;
+      state->cold_capacity = buffer_size - buffer_size / 4;
+      state->cold_maxsize  = state->maxcompsize +
+         sizeof(struct state_manager_cold_header);
+      state->cold_data     = (uint8_t*)malloc(state->cold_capacity);
+      state->scratch       = (uint8_t*)malloc(state->maxcompsize);
+      if (!state->cold_data || !state->scratch)
+         goto error;
+
+      state->cold_head     = state->cold_data + sizeof(size_t);
+      state->cold_tail     = state->cold_data + sizeof(size_t);
+      buffer_size         /= 4;
+
+      rarch_perf_register(&deflate_deltas);
+
+      /* Deflating is far too slow for the main thread. */
+      threaded             = true;
+   }
+#else
+   (void)deflate_age;
+#endif
+
    state->data        = (uint8_t*)malloc(buffer_size);
 
    state->thisblock   = (uint8_t*)state_manager_raw_alloc(state_size, 0);
@@ -406,6 +1043,35 @@ state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
    state->head = state->data + sizeof(size_t);
    state->tail = state->data + sizeof(size_t);
 
+   if (keyframe_interval)
+   {
+      /* Every keyframe takes up at least a full block in the ring. */
+      state->keyframe_interval = keyframe_interval;
+      state->keyframes_size    = buffer_size /
+         (state->blocksize + sizeof(size_t) * 2) + 1;
+      state->keyframes         = (struct state_manager_keyframe*)
+         calloc(state->keyframes_size, sizeof(*state->keyframes));
+      if (!state->keyframes)
+         goto error;
+   }
+
+#ifdef HAVE_THREADS
+   if (threaded)
+   {
+      state->spareblock = (uint8_t*)state_manager_raw_alloc(state_size, 2);
+      state->lock       = slock_new();
+      state->cond       = scond_new();
+      if (!state->spareblock || !state->lock || !state->cond)
+         goto error;
+
+      state->thread     = sthread_create(state_manager_thread, state);
+      if (!state->thread)
+         goto error;
+   }
+#else
+   (void)threaded;
+#endif
+
    return state;
 
 error:
@@ -418,20 +1084,79 @@ void state_manager_free(state_manager_t *state)
    if (!state)
       return;
 
+#ifdef HAVE_THREADS
+   if (state->thread)
+   {
+      slock_lock(state->lock);
+      state->quit = true;
+      scond_signal(state->cond);
+      slock_unlock(state->lock);
+      sthread_join(state->thread);
+   }
+
+   if (state->lock)
+      slock_free(state->lock);
+   if (state->cond)
+      scond_free(state->cond);
+   free(state->spareblock);
+#endif
+
+#ifdef HAVE_REWIND_DEFLATE
+   free(state->cold_data);
+   free(state->scratch);
+#endif
+
+   free(state->keyframes);
    free(state->data);
    free(state->thisblock);
    free(state->nextblock);
    free(state);
 }
 
-bool state_manager_pop(state_manager_t *state, const void **data)
+/* Applies the entry at the head of the ring to thisblock. */
+static bool state_manager_pop_entry(state_manager_t *state)
 {
    size_t start;
-   uint8_t *out                 = NULL;
    const uint8_t *compressed    = NULL;
 
+   if (state->head == state->tail)
+   {
+#ifdef HAVE_REWIND_DEFLATE
+      if (state->cold_data)
+         return state_manager_cold_pop(state);
+#endif
+      return false;
+   }
+
+   start = read_size_t(state->head - sizeof(size_t));
+   state->head = state->data + start;
+
+   compressed = state->data + start + sizeof(size_t);
+
+   if (state->keyframes_count &&
+         state_manager_keyframe(state,
+            state->keyframes_count - 1)->serial == state->serial)
+   {
+      memcpy(state->thisblock, compressed, state->blocksize);
+      state->keyframes_count--;
+   }
+   else
+      state_manager_raw_decompress(compressed, state->maxcompsize,
+            state->thisblock, state->blocksize);
+
+   state->serial--;
+   state->entries--;
+   return true;
+}
+
+bool state_manager_pop(state_manager_t *state, const void **data)
+{
    *data = NULL;
 
+#ifdef HAVE_THREADS
+   state_manager_wait(state);
+#endif
+
    if (state->thisblock_valid)
    {
       state->thisblock_valid = false;
@@ -440,20 +1165,72 @@ bool state_manager_pop(state_manager_t *state, const void **data)
       return true;
    }
 
-   if (state->head == state->tail)
+   if (!state_manager_pop_entry(state))
       return false;
 
-   start = read_size_t(state->head - sizeof(size_t));
-   state->head = state->data + start;
+   *data = state->thisblock;
+   return true;
+}
 
-   compressed = state->data + start + sizeof(size_t);
-   out = state->thisblock;
+bool state_manager_seek(state_manager_t *state, unsigned count,
+      const void **data)
+{
+   uint64_t target;
 
-   state_manager_raw_decompress(compressed, state->maxcompsize, out, state->blocksize);
+   *data = NULL;
 
-   state->entries--;
-   *data = state->thisblock;
-   return true;
+   if (!count)
+      return false;
+
+#ifdef HAVE_THREADS
+   state_manager_wait(state);
+#endif
+
+   if (state->thisblock_valid)
+   {
+      state->thisblock_valid = false;
+      state->entries--;
+      *data = state->thisblock;
+      count--;
+   }
+
+   target = state->serial > count ? state->serial - count : 0;
+
+   /* Keyframe serials are consecutive multiples of the interval, 
+    * so the oldest one that is still newer than the target can be 
+    * looked up directly. */
+   if (state->keyframes_count)
+   {
+      const struct state_manager_keyframe *key = NULL;
+      uint64_t first = state_manager_keyframe(state, 0)->serial;
+      uint64_t want  = (target / state->keyframe_interval + 1)
+         * state->keyframe_interval;
+      size_t idx     = want > first ?
+         (size_t)((want - first) / state->keyframe_interval) : 0;
+
+      if (idx < state->keyframes_count)
+      {
+         key = state_manager_keyframe(state, idx);
+
+         state->head = state->data + key->start;
+         memcpy(state->thisblock, state->data + key->start + sizeof(size_t),
+               state->blocksize);
+
+         state->entries        -= (unsigned)(state->serial - key->serial + 1);
+         count                 -= (unsigned)(state->serial - key->serial + 1);
+         state->serial          = key->serial - 1;
+         state->keyframes_count = idx;
+         *data                  = state->thisblock;
+      }
+   }
+
+   while (count && state_manager_pop_entry(state))
+   {
+      *data = state->thisblock;
+      count--;
+   }
+
+   return *data != NULL;
 }
 
 void state_manager_push_where(state_manager_t *state, void **data)
@@ -481,47 +1258,36 @@ void state_manager_push_do(state_manager_t *state)
 
    if (state->thisblock_valid)
    {
-      const uint8_t *oldb, *newb;
-      uint8_t *compressed;
-      size_t headpos, tailpos, remaining;
       if (state->capacity < sizeof(size_t) + state->maxcompsize)
          return;
 
-recheckcapacity:;
-
-      headpos = state->head - state->data;
-      tailpos = state->tail - state->data;
-      remaining = (tailpos + state->capacity -
-            sizeof(size_t) - headpos - 1) % state->capacity + 1;
-
-      if (remaining <= state->maxcompsize)
-      {
-         state->tail = state->data + read_size_t(state->tail);
-         state->entries--;
-         goto recheckcapacity;
-      }
-
-      RARCH_PERFORMANCE_INIT(gen_deltas);
-      RARCH_PERFORMANCE_START(gen_deltas);
-
-      oldb = state->thisblock;
-      newb = state->nextblock;
-      compressed = state->head + sizeof(size_t);
-
-      compressed += state_manager_raw_compress(oldb, newb, state->blocksize, compressed);
-
-      if (compressed - state->data + state->maxcompsize > state->capacity)
+#ifdef HAVE_THREADS
+      if (state->thread)
       {
-         compressed = state->data;
-         if (state->tail == state->data + sizeof(size_t))
-            state->tail = state->data + read_size_t(state->tail);
+         slock_lock(state->lock);
+         while (state->busy)
+            scond_wait(state->cond, state->lock);
+
+         state->job_old = state->thisblock;
+         state->job_new = state->nextblock;
+         state->busy    = true;
+         state->serial++;
+         state->entries++;
+         scond_signal(state->cond);
+         slock_unlock(state->lock);
+
+         /* The worker now owns the old block until it's done;
+          * serialize the next state into the spare one. */
+         swap              = state->thisblock;
+         state->thisblock  = state->nextblock;
+         state->nextblock  = state->spareblock;
+         state->spareblock = swap;
+         return;
       }
-      write_size_t(compressed, state->head-state->data);
-      compressed += sizeof(size_t);
-      write_size_t(state->head, compressed-state->data);
-      state->head = compressed;
+#endif
 
-      RARCH_PERFORMANCE_STOP(gen_deltas);
+      state->serial++;
+      state_manager_push_delta(state, state->thisblock, state->nextblock);
    }
    else
       state->thisblock_valid = true;
@@ -533,22 +1299,64 @@ recheckcapacity:;
    state->entries++;
 }
 
+void *state_manager_scratch(state_manager_t *state)
+{
+   /* Between push_do() and push_where(), nextblock holds nothing
+    * we care about, and the worker thread never touches it. */
+   return state->nextblock;
+}
+
 void state_manager_capacity(state_manager_t *state,
+      enum state_manager_tier tier,
       unsigned *entries, size_t *bytes, bool *full)
 {
-   size_t headpos   = state->head - state->data;
-   size_t tailpos   = state->tail - state->data;
-   size_t remaining = (tailpos + state->capacity -
-         sizeof(size_t) - headpos - 1) % state->capacity + 1;
+   size_t remaining;
+   unsigned tier_entries = 0;
+   size_t tier_bytes     = 0;
+   bool tier_full        = false;
+
+#ifdef HAVE_THREADS
+   state_manager_wait(state);
+#endif
+
+   if (tier != STATE_MANAGER_TIER_DEFLATE)
+   {
+      remaining    = state_manager_remaining(state->data,
+            state->capacity, state->head, state->tail);
+      tier_entries = state->entries;
+      tier_bytes   = state->capacity - remaining;
+      tier_full    = remaining <= state->maxcompsize * 2;
+   }
+
+#ifdef HAVE_REWIND_DEFLATE
+   if (state->cold_data)
+   {
+      if (tier == STATE_MANAGER_TIER_DELTA)
+         tier_entries -= state->cold_entries;
+      else
+      {
+         remaining   = state_manager_remaining(state->cold_data,
+               state->cold_capacity, state->cold_head, state->cold_tail);
+         tier_bytes += state->cold_capacity - remaining;
+
+         /* Only running out of the last tier loses history. */
+         tier_full   = remaining <= state->cold_maxsize * 2;
+
+         if (tier == STATE_MANAGER_TIER_DEFLATE)
+            tier_entries = state->cold_entries;
+      }
+   }
+#endif
 
    if (entries)
-      *entries = state->entries;
+      *entries = tier_entries;
    if (bytes)
-      *bytes = state->capacity-remaining;
+      *bytes = tier_bytes;
    if (full)
-      *full = remaining <= state->maxcompsize * 2;
+      *full = tier_full;
 }
 
+#ifndef REWIND_TEST
 void init_rewind(void)
 {
    void *state          = NULL;
@@ -585,13 +1393,22 @@ void init_rewind(void)
          msg_hash_to_str(MSG_REWIND_INIT),
          (unsigned)(settings->rewind_buffer_size / 1000000));
 
+   RARCH_LOG("Rewind: using %s delta kernels.\n",
+         state_manager_raw_init_simd(rarch_get_cpu_features()));
+
    global->rewind.state = state_manager_new(global->rewind.size,
-         settings->rewind_buffer_size);
+         settings->rewind_buffer_size, settings->rewind_threaded,
+         settings->rewind_keyframe_interval,
+         settings->rewind_deflate_age);
 
    if (!global->rewind.state)
+   {
       RARCH_WARN("%s.\n", msg_hash_to_str(MSG_REWIND_INIT_FAILED));
+      return;
+   }
 
    state_manager_push_where(global->rewind.state, &state);
    pretro_serialize(state, global->rewind.size);
    state_manager_push_do(global->rewind.state);
 }
+#endif
@@ -28,17 +28,40 @@ extern "C" {
 
 typedef struct state_manager state_manager_t;
 
-state_manager_t *state_manager_new(size_t state_size, size_t buffer_size);
+enum state_manager_tier
+{
+   STATE_MANAGER_TIER_ALL = 0,
+   /* Patches from state_manager_raw_compress(). */
+   STATE_MANAGER_TIER_DELTA,
+   /* Older patches that have been deflated on top of that. */
+   STATE_MANAGER_TIER_DEFLATE
+};
+
+state_manager_t *state_manager_new(size_t state_size, size_t buffer_size,
+      bool threaded, unsigned keyframe_interval, unsigned deflate_age);
 
 void state_manager_free(state_manager_t *state);
 
 bool state_manager_pop(state_manager_t *state, const void **data);
 
+/*
+ * Same as calling state_manager_pop() 'count' times, but jumps straight to the nearest keyframe,
+ * so the cost doesn't grow with 'count'. Stops early at the oldest stored state.
+ */
+bool state_manager_seek(state_manager_t *state, unsigned count, const void **data);
+
 void state_manager_push_where(state_manager_t *state, void **data);
 
 void state_manager_push_do(state_manager_t *state);
 
+/*
+ * Returns a state-sized buffer which goes unused until the next call to state_manager_push_where().
+ * Lets other per-frame users of savestates borrow the rewind buffers instead of allocating their own.
+ */
+void *state_manager_scratch(state_manager_t *state);
+
 void state_manager_capacity(state_manager_t *state,
+      enum state_manager_tier tier,
       unsigned int *entries, size_t *bytes, bool *full);
 
 void init_rewind(void);
@@ -61,6 +84,13 @@ void *state_manager_raw_alloc(size_t len, uint16_t uniq);
  */
 size_t state_manager_raw_compress(const void *src, const void *dst, size_t len, void *patch);
 
+/*
+ * Selects the scan kernels used by state_manager_raw_compress() from a RETRO_SIMD_* mask.
+ * Without this, the baseline (SSE2 or C) kernels are used.
+ * Returns the name of the selected kernel set.
+ */
+const char *state_manager_raw_init_simd(uint64_t cpu);
+
 /*
  * Takes 'patch' from a previous call to 'state_manager_raw_compress' and applies it to 'data' ('src' from that call),
  * yielding 'dst' in that call.
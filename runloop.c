@@ -23,6 +23,7 @@
 #include <compat/strl.h>
 
 #include "configuration.h"
+#include "content.h"
 #include "dynamic.h"
 #include "performance.h"
 #include "retroarch.h"
@@ -34,6 +35,15 @@
 #include "input/keyboard_line.h"
 #include "input/input_common.h"
 
+#if !defined(_WIN32) && !defined(RARCH_CONSOLE)
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(_POSIX_MONOTONIC_CLOCK) && defined(TIMER_ABSTIME) && !defined(__MACH__)
+#define HAVE_CLOCK_NANOSLEEP
+#endif
+#endif
+
 #ifdef HAVE_MENU
 #include "menu/menu.h"
 #endif
@@ -116,6 +126,41 @@ static void check_fast_forward_button(bool fastforward_pressed,
    driver_set_nonblock_state(driver->nonblock_state);
 }
 
+/**
+ * rarch_main_state_slot_msg:
+ *
+ * Shows the current state slot, along with the core that saved
+ * the state in it. Only the header of the state is read.
+ **/
+void rarch_main_state_slot_msg(void)
+{
+   state_info_t info;
+   char path[PATH_MAX_LENGTH] = {0};
+   char msg[PATH_MAX_LENGTH]  = {0};
+   const char *detail         = NULL;
+   settings_t *settings       = config_get_ptr();
+
+   fill_pathname_state_slot(path, settings->state_slot, sizeof(path));
+
+   if (!path_file_exists(path))
+      detail = msg_hash_to_str(MSG_STATE_SLOT_EMPTY);
+   else if (load_state_info(path, &info) && info.core_name[0])
+      detail = info.core_name;
+
+   if (detail)
+      snprintf(msg, sizeof(msg), "%s: %d (%s)",
+            msg_hash_to_str(MSG_STATE_SLOT),
+            settings->state_slot, detail);
+   else
+      snprintf(msg, sizeof(msg), "%s: %d",
+            msg_hash_to_str(MSG_STATE_SLOT),
+            settings->state_slot);
+
+   rarch_main_msg_queue_push(msg, 1, 180, true);
+
+   RARCH_LOG("%s\n", msg);
+}
+
 /**
  * check_stateslots:
  * @pressed_increase     : is state slot increase key pressed?
@@ -126,7 +171,6 @@ static void check_fast_forward_button(bool fastforward_pressed,
  **/
 static void check_stateslots(bool pressed_increase, bool pressed_decrease)
 {
-   char msg[PATH_MAX_LENGTH] = {0};
    settings_t *settings      = config_get_ptr();
 
    /* Save state slots */
@@ -140,22 +184,40 @@ static void check_stateslots(bool pressed_increase, bool pressed_decrease)
    else
       return;
 
-   snprintf(msg, sizeof(msg), "%s: %d",
-         msg_hash_to_str(MSG_STATE_SLOT),
-         settings->state_slot);
+   rarch_main_state_slot_msg();
+}
 
-   rarch_main_msg_queue_push(msg, 1, 180, true);
+/**
+ * rewind_seek_count:
+ *
+ * Number of rewind entries that cover rewind_seek_seconds
+ * of gameplay, given one entry per rewind_granularity frames.
+ *
+ * Returns: number of entries to seek back by, at least 1.
+ **/
+static unsigned rewind_seek_count(void)
+{
+   settings_t *settings                 = config_get_ptr();
+   struct retro_system_av_info *av_info =
+      video_viewport_get_system_av_info();
+   unsigned granularity                 = settings->rewind_granularity ?
+      settings->rewind_granularity : 1;
+   double frames                        =
+      settings->rewind_seek_seconds * av_info->timing.fps;
+   unsigned count                       = (unsigned)(frames / granularity);
 
-   RARCH_LOG("%s\n", msg);
+   return count ? count : 1;
 }
 
 /**
  * check_rewind:
  * @pressed              : was rewind key pressed or held?
+ * @seek_pressed         : was rewind seek key pressed?
  *
  * Checks if rewind toggle/hold was being pressed and/or held.
+ * A rewind seek jumps back rewind_seek_seconds in one step.
  **/
-static void check_rewind(bool pressed)
+static void check_rewind(bool pressed, bool seek_pressed)
 {
    static bool first = true;
    global_t *global  = global_get_ptr();
@@ -175,7 +237,28 @@ static void check_rewind(bool pressed)
    if (!global->rewind.state)
       return;
 
-   if (pressed)
+   /* A movie can only be rewound one frame at a time,
+    * so seeking is left out while one is playing or recording. */
+   if (seek_pressed && !global->bsv.movie)
+   {
+      const void *buf    = NULL;
+      runloop_t *runloop = rarch_main_get_ptr();
+
+      if (state_manager_seek(global->rewind.state,
+               rewind_seek_count(), &buf))
+      {
+         global->rewind.frame_is_reverse = true;
+         audio_driver_setup_rewind();
+
+         rarch_main_msg_queue_push_new(MSG_REWINDING, 0,
+               runloop->is_paused ? 1 : 30, true);
+         pretro_unserialize(buf, global->rewind.size);
+      }
+      else
+         rarch_main_msg_queue_push_new(MSG_REWIND_REACHED_END,
+               0, 30, true);
+   }
+   else if (pressed)
    {
       const void *buf    = NULL;
       runloop_t *runloop = rarch_main_get_ptr();
@@ -564,7 +647,7 @@ static int do_state_checks(event_cmd_state_t *cmd)
             cmd->pause_pressed,
             cmd->frameadvance_pressed,
             cmd->fullscreen_toggle,
-            cmd->rewind_pressed))
+            cmd->rewind_pressed || cmd->rewind_seek_pressed))
       return 1;
 
    check_fast_forward_button(cmd->fastforward_pressed,
@@ -577,7 +660,7 @@ static int do_state_checks(event_cmd_state_t *cmd)
    else if (cmd->load_state_pressed)
       event_command(EVENT_CMD_LOAD_STATE);
 
-   check_rewind(cmd->rewind_pressed);
+   check_rewind(cmd->rewind_pressed, cmd->rewind_seek_pressed);
    check_slowmotion(cmd->slowmotion_pressed);
 
    if (cmd->movie_record)
@@ -673,6 +756,53 @@ static void rarch_update_frame_time(void)
    system->frame_time.callback(delta);
 }
 
+/* Upper bounds (usec late) of the frame time histogram buckets.
+ * Bucket 0 holds wake-ups before the deadline, where the spin made
+ * up the difference, the last one everything later. */
+static const int64_t frame_time_buckets[FRAME_TIME_HISTOGRAM_SIZE - 2] = {
+   50, 100, 250, 500, 1000, 2000
+};
+
+/**
+ * rarch_sleep_until:
+ * @deadline             : rarch_get_time_usec() time to wake up at.
+ * @spin                 : how many usec before @deadline to stop
+ *                         sleeping and busy-wait instead.
+ *
+ * Sleeps until @deadline. The OS scheduler tends to wake us up late,
+ * so the last stretch is spent spinning.
+ *
+ * Returns: the time the sleep woke up, before spinning.
+ **/
+static retro_time_t rarch_sleep_until(retro_time_t deadline,
+      retro_time_t spin)
+{
+   retro_time_t woke;
+   retro_time_t wake = deadline - spin;
+   retro_time_t now  = rarch_get_time_usec();
+
+   if (wake > now)
+   {
+#ifdef HAVE_CLOCK_NANOSLEEP
+      /* Same clock as rarch_get_time_usec(). An absolute deadline
+       * doesn't drift when we get interrupted. */
+      struct timespec tv;
+      tv.tv_sec  = wake / 1000000;
+      tv.tv_nsec = (wake % 1000000) * 1000;
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tv, NULL) == EINTR);
+#else
+      /* Whole milliseconds only, the spin below covers the rest. */
+      rarch_sleep((unsigned)((wake - now) / 1000));
+#endif
+   }
+
+   woke = rarch_get_time_usec();
+
+   while (rarch_get_time_usec() < deadline);
+
+   return woke;
+}
+
 /**
  * rarch_limit_frame_time:
  *
@@ -680,8 +810,9 @@ static void rarch_update_frame_time(void)
  **/
 static void rarch_limit_frame_time(void)
 {
+   unsigned i;
    retro_time_t target      = 0;
-   retro_time_t to_sleep_ms = 0;
+   retro_time_t error       = 0;
    runloop_t *runloop       = rarch_main_get_ptr();
    settings_t *settings     = config_get_ptr();
    retro_time_t current     = rarch_get_time_usec();
@@ -694,19 +825,87 @@ static void rarch_limit_frame_time(void)
 
    target        = runloop->frames.limit.last_time + 
                    runloop->frames.limit.minimum_time;
-   to_sleep_ms   = (target - current) / 1000;
 
-   if (to_sleep_ms <= 0)
+   if (current >= target)
    {
-      runloop->frames.limit.last_time = rarch_get_time_usec();
-      return;
+      /* Running behind, don't try to catch up. */
+      runloop->frames.limit.last_time = current;
+      error                           = current - target;
+   }
+   else
+   {
+      /* Measured before the spin, which always ends on time. Early
+       * means the spin covered the rest, late that the scheduler
+       * overshot even the spin margin. */
+      error = rarch_sleep_until(target,
+            settings->frame_limiter_spin_usec) - target;
+
+      /* Combat jitter a bit. */
+      runloop->frames.limit.last_time += 
+         runloop->frames.limit.minimum_time;
+   }
+
+   /* Frames that are a whole frame or more late land in the
+    * last bucket along with everything else past its bound. */
+   for (i = 0; i < ARRAY_SIZE(frame_time_buckets); i++)
+      if (error < frame_time_buckets[i])
+         break;
+
+   runloop->frames.limit.error_histogram[error < 0 ? 0 : i + 1]++;
+   runloop->frames.limit.error_sum += error;
+   runloop->frames.limit.error_count++;
+}
+
+/**
+ * rarch_main_frame_time_log:
+ *
+ * Logs how accurately the frame limiter has hit its deadlines,
+ * and how much of the frame time run-ahead takes.
+ **/
+void rarch_main_frame_time_log(void)
+{
+   unsigned i;
+   runloop_t *runloop = rarch_main_get_ptr();
+   global_t *global   = global_get_ptr();
+   uint64_t count     = runloop->frames.limit.error_count;
+
+   if (global->runahead.frames)
+   {
+      struct retro_system_av_info *av_info = 
+         video_viewport_get_system_av_info();
+      double average = (double)global->runahead.time_sum
+         / global->runahead.frames;
+
+      RARCH_LOG("[Run-ahead]: %llu frames, average %d usec, "
+            "%.1f%% of the frame time.\n",
+            (unsigned long long)global->runahead.frames, (int)average,
+            100.0 * average * av_info->timing.fps / 1000000.0);
    }
 
-   rarch_sleep((unsigned int)to_sleep_ms);
+   if (!count)
+      return;
+
+   RARCH_LOG("[Frame limiter]: %llu frames, average error %d usec.\n",
+         (unsigned long long)count,
+         (int)(runloop->frames.limit.error_sum / (int64_t)count));
+
+   for (i = 0; i < FRAME_TIME_HISTOGRAM_SIZE; i++)
+   {
+      char bucket[32]   = {0};
+      uint64_t frames   = runloop->frames.limit.error_histogram[i];
+
+      if (i == 0)
+         strlcpy(bucket, "early, spun", sizeof(bucket));
+      else if (i == FRAME_TIME_HISTOGRAM_SIZE - 1)
+         snprintf(bucket, sizeof(bucket), ">= %d usec late",
+               (int)frame_time_buckets[i - 2]);
+      else
+         snprintf(bucket, sizeof(bucket), "< %d usec late",
+               (int)frame_time_buckets[i - 1]);
 
-   /* Combat jitter a bit. */
-   runloop->frames.limit.last_time += 
-      runloop->frames.limit.minimum_time;
+      RARCH_LOG("[Frame limiter]: %16s: %llu (%.1f%%)\n", bucket,
+            (unsigned long long)frames, 100.0 * frames / count);
+   }
 }
 
 /**
@@ -1013,6 +1212,7 @@ static void rarch_main_cmd_get_state(event_cmd_state_t *cmd,
    cmd->pause_pressed               = BIT64_GET(trigger_input, RARCH_PAUSE_TOGGLE);
    cmd->frameadvance_pressed        = BIT64_GET(trigger_input, RARCH_FRAMEADVANCE);
    cmd->rewind_pressed              = BIT64_GET(input,         RARCH_REWIND);
+   cmd->rewind_seek_pressed         = BIT64_GET(trigger_input, RARCH_REWIND_SEEK);
    cmd->netplay_flip_pressed        = BIT64_GET(trigger_input, RARCH_NETPLAY_FLIP);
    cmd->fullscreen_toggle           = BIT64_GET(trigger_input, RARCH_FULLSCREEN_TOGGLE_KEY);
    cmd->cheat_index_plus_pressed    = BIT64_GET(trigger_input,
@@ -1023,6 +1223,87 @@ static void rarch_main_cmd_get_state(event_cmd_state_t *cmd,
          RARCH_CHEAT_TOGGLE);
 }
 
+/**
+ * rarch_main_run_ahead:
+ * @frames               : number of frames to run ahead.
+ *
+ * Runs one frame for real with its video hidden, snapshots the
+ * core, runs @frames more frames with their audio hidden while
+ * showing only the last one, then rolls back to the snapshot.
+ * What's shown is @frames frames ahead of what's heard and
+ * of the actual core state.
+ *
+ * Returns: true if the frame has been run, false if run-ahead
+ * can't be used right now.
+ **/
+static bool rarch_main_run_ahead(unsigned frames)
+{
+   unsigned i;
+   retro_time_t start;
+   void *state      = NULL;
+   size_t size      = pretro_serialize_size();
+   driver_t *driver = driver_get_ptr();
+   global_t *global = global_get_ptr();
+
+   (void)driver;
+
+   /* Hidden frames would end up in the movie or on the wire. */
+   if (!size || global->runahead.failed || global->bsv.movie
+         || global->rewind.frame_is_reverse)
+      return false;
+#ifdef HAVE_NETPLAY
+   if (driver->netplay_data)
+      return false;
+#endif
+
+   if (global->rewind.state && global->rewind.size >= size)
+      state = state_manager_scratch(global->rewind.state);
+   else
+   {
+      if (global->runahead.size < size)
+      {
+         free(global->runahead.buffer);
+         global->runahead.buffer = malloc(size);
+         global->runahead.size   = global->runahead.buffer ? size : 0;
+      }
+      state = global->runahead.buffer;
+   }
+
+   if (!state)
+      return false;
+
+   RARCH_PERFORMANCE_INIT(run_ahead);
+   RARCH_PERFORMANCE_START(run_ahead);
+   start = rarch_get_time_usec();
+
+   retro_set_runahead_callbacks(true, false);
+   pretro_run();
+
+   if (!pretro_serialize(state, size))
+   {
+      RARCH_WARN("Core failed to serialize, disabling run-ahead.\n");
+      global->runahead.failed = true;
+      retro_set_runahead_callbacks(false, false);
+      RARCH_PERFORMANCE_STOP(run_ahead);
+      return true;
+   }
+
+   for (i = 1; i <= frames; i++)
+   {
+      retro_set_runahead_callbacks(i < frames, true);
+      pretro_run();
+   }
+
+   retro_set_runahead_callbacks(false, false);
+   pretro_unserialize(state, size);
+
+   RARCH_PERFORMANCE_STOP(run_ahead);
+   global->runahead.time_sum += rarch_get_time_usec() - start;
+   global->runahead.frames++;
+
+   return true;
+}
+
 /**
  * rarch_main_iterate:
  *
@@ -1127,7 +1408,9 @@ int rarch_main_iterate(void)
 
 
    /* Run libretro for one frame. */
-   pretro_run();
+   if (!settings->run_ahead_enabled || !settings->run_ahead_frames
+         || !rarch_main_run_ahead(settings->run_ahead_frames))
+      pretro_run();
 
    for (i = 0; i < settings->input.max_users; i++)
    {
@@ -1148,6 +1431,7 @@ int rarch_main_iterate(void)
 
 #if defined(HAVE_THREADS)
    unlock_autosave();
+   autosave_iterate();
 #endif
 
 success:
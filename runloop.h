@@ -34,6 +34,10 @@ extern "C" {
 
 /* All libretro runloop-related globals go here. */
 
+/* Buckets of how late the frame limiter woke up, see
+ * rarch_main_frame_time_log(). */
+#define FRAME_TIME_HISTOGRAM_SIZE 8
+
 typedef struct runloop
 {
    /* Lifecycle state checks. */
@@ -53,6 +57,12 @@ typedef struct runloop
       {
          retro_time_t minimum_time;
          retro_time_t last_time;
+
+         /* Wake-up error against the deadline, in usec,
+          * before the limiter spins the rest of the way. */
+         uint64_t error_histogram[FRAME_TIME_HISTOGRAM_SIZE];
+         int64_t error_sum;
+         uint64_t error_count;
       } limit;
    } frames;
 } runloop_t;
@@ -165,6 +175,19 @@ typedef struct global
       bool frame_is_reverse;
    } rewind;
 
+   struct
+   {
+      /* Run-ahead snapshot, when it can't borrow the rewind buffers. */
+      void *buffer;
+      size_t size;
+      bool failed;
+
+      /* Time spent on run-ahead frames, all core runs included,
+       * see rarch_main_frame_time_log(). */
+      retro_time_t time_sum;
+      uint64_t frames;
+   } runahead;
+
    struct
    {
       /* Movie playback/recording support. */
@@ -306,6 +329,22 @@ global_t *global_get_ptr(void);
  **/
 int rarch_main_iterate(void);
 
+/**
+ * rarch_main_frame_time_log:
+ *
+ * Logs how accurately the frame limiter has hit its deadlines,
+ * and how much of the frame time run-ahead takes.
+ **/
+void rarch_main_frame_time_log(void);
+
+/**
+ * rarch_main_state_slot_msg:
+ *
+ * Shows the current state slot, along with the core that saved
+ * the state in it. Only the header of the state is read.
+ **/
+void rarch_main_state_slot_msg(void);
+
 void rarch_main_msg_queue_push(const char *msg, unsigned prio,
       unsigned duration, bool flush);
 
@@ -0,0 +1,205 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2014-2015 - Alfred Agrell
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Microbenchmark for the rewind differ.
+ *
+ * Usage: rewind-bench [old.state new.state]
+ *
+ * Without arguments, synthetic state pairs of typical sizes are used, 
+ * with a small fraction of the data changed in short runs (which is 
+ * what most cores look like from one frame to the next).
+ * Every kernel set is checked against the others and must round-trip.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rewind.h"
+#include "libretro.h"
+
+/* rewind.c uses the performance counters. */
+void rarch_perf_register(struct retro_perf_counter *perf) { (void)perf; }
+void rarch_perf_start(struct retro_perf_counter *perf) { (void)perf; }
+void rarch_perf_stop(struct retro_perf_counter *perf) { (void)perf; }
+
+static const uint64_t kernels[] = {
+   0,
+   RETRO_SIMD_AVX | RETRO_SIMD_AVX2,
+   RETRO_SIMD_NEON,
+};
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void *read_state(const char *path, size_t *len, uint16_t uniq)
+{
+   long size;
+   void *ret = NULL;
+   FILE *file = fopen(path, "rb");
+
+   if (!file)
+      return NULL;
+
+   fseek(file, 0, SEEK_END);
+   size = ftell(file);
+   rewind(file);
+
+   if (size > 0 && (ret = state_manager_raw_alloc(size, uniq)))
+   {
+      if (fread(ret, 1, size, file) != (size_t)size)
+      {
+         free(ret);
+         ret = NULL;
+      }
+      *len = size;
+   }
+
+   fclose(file);
+   return ret;
+}
+
+static void gen_pair(uint8_t *old_state, uint8_t *new_state, size_t len)
+{
+   size_t i;
+
+   for (i = 0; i < len; i++)
+      old_state[i] = rand();
+   memcpy(new_state, old_state, len);
+
+   /* Roughly 0.2% changed, in runs of up to 32 bytes. */
+   for (i = 0; i < len / 8192; i++)
+   {
+      size_t j;
+      size_t pos = rand() % len;
+      size_t run = 1 + rand() % 32;
+
+      for (j = pos; j < pos + run && j < len; j++)
+         new_state[j] ^= 1 + rand() % 255;
+   }
+}
+
+static int bench_pair(const uint8_t *old_state, const uint8_t *new_state,
+      size_t len)
+{
+   unsigned i, k;
+   int ret            = 0;
+   size_t ref_size    = 0;
+   size_t maxsize     = state_manager_raw_maxsize(len);
+   uint8_t *patch     = (uint8_t*)malloc(maxsize);
+   uint8_t *ref       = (uint8_t*)malloc(maxsize);
+   uint8_t *check     = (uint8_t*)state_manager_raw_alloc(len, 2);
+   const char *base   = NULL;
+
+   for (k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+   {
+      double start, elapsed;
+      size_t size       = 0;
+      unsigned iters    = 0;
+      const char *name  = state_manager_raw_init_simd(kernels[k]);
+
+      /* Not available on this host/build. */
+      if (!k)
+         base = name;
+      else if (!strcmp(name, base))
+         continue;
+
+      start = get_time();
+      do
+      {
+         for (i = 0; i < 16; i++)
+            size = state_manager_raw_compress(old_state, new_state, len, patch);
+         iters  += 16;
+         elapsed = get_time() - start;
+      } while (elapsed < 0.5);
+
+      memcpy(check, new_state, len);
+      state_manager_raw_decompress(patch, size, check, len);
+
+      if (memcmp(check, old_state, len))
+      {
+         fprintf(stderr, "%s: patch doesn't round-trip!\n", name);
+         ret = 1;
+      }
+
+      if (!k)
+      {
+         memcpy(ref, patch, size);
+         ref_size = size;
+      }
+      else if (size != ref_size || memcmp(ref, patch, size))
+         printf("  (%s: patch differs from %s, %u vs. %u bytes)\n",
+               name, base,
+               (unsigned)size, (unsigned)ref_size);
+
+      printf("  %-5s %8.2f GB/s, %10u bytes patch\n", name,
+            (double)len * iters / elapsed / 1e9, (unsigned)size);
+   }
+
+   free(patch);
+   free(ref);
+   free(check);
+   return ret;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   int ret = 0;
+   static const size_t sizes[] = {
+      64 * 1024, 512 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024,
+   };
+
+   if (argc == 3)
+   {
+      size_t old_len = 0, new_len = 0;
+      uint8_t *old_state = (uint8_t*)read_state(argv[1], &old_len, 0);
+      uint8_t *new_state = (uint8_t*)read_state(argv[2], &new_len, 1);
+
+      if (!old_state || !new_state || old_len != new_len)
+      {
+         fprintf(stderr, "Failed to read states of equal size.\n");
+         return 1;
+      }
+
+      printf("%s vs. %s (%u bytes):\n", argv[1], argv[2], (unsigned)old_len);
+      ret = bench_pair(old_state, new_state, old_len);
+
+      free(old_state);
+      free(new_state);
+      return ret;
+   }
+
+   for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+   {
+      uint8_t *old_state = (uint8_t*)state_manager_raw_alloc(sizes[i], 0);
+      uint8_t *new_state = (uint8_t*)state_manager_raw_alloc(sizes[i], 1);
+
+      gen_pair(old_state, new_state, sizes[i]);
+
+      printf("%u KiB state:\n", (unsigned)(sizes[i] / 1024));
+      ret |= bench_pair(old_state, new_state, sizes[i]);
+
+      free(old_state);
+      free(new_state);
+   }
+
+   return ret;
+}
@@ -0,0 +1,262 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2014-2015 - Alfred Agrell
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Round-trip test for state_manager_seek().
+ *
+ * Usage: rewind-seek
+ *
+ * Synthetic states are pushed into a state manager, and then rewound
+ * with a random mix of state_manager_pop() and state_manager_seek().
+ * Every state that comes back must be the one pushed at that point
+ * of the history, and a seek past the oldest entry must stop there.
+ * This is done with and without keyframes, on the worker thread, and
+ * with a deflated tier small enough that both the seeks and the ring
+ * wrapping cross into it. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rewind.h"
+#include "libretro.h"
+
+/* rewind.c uses the performance counters. */
+void rarch_perf_register(struct retro_perf_counter *perf) { (void)perf; }
+void rarch_perf_start(struct retro_perf_counter *perf) { (void)perf; }
+void rarch_perf_stop(struct retro_perf_counter *perf) { (void)perf; }
+
+/* Not a multiple of anything in particular. */
+#define STATE_SIZE  4102
+#define BUFFER_SIZE (128 * 1024)
+#define ROUNDS      24
+#define MAX_STATES  (ROUNDS * 400)
+
+struct seek_config
+{
+   const char *name;
+   bool threaded;
+   unsigned keyframe_interval;
+   unsigned deflate_age;
+};
+
+static const struct seek_config configs[] = {
+   { "deltas only",                 false,  0,  0 },
+   { "keyframes every 16",          false, 16,  0 },
+   { "keyframes every 5",           false,  5,  0 },
+   { "keyframes, threaded",         true,  16,  0 },
+   { "deflate",                     true,   0, 40 },
+   { "keyframes every 7, deflate",  true,   7, 40 },
+   { "keyframes every 16, deflate", true,  16,  3 },
+};
+
+/* Every state ever pushed, by the order it was made in. */
+static uint8_t *states;
+static unsigned num_states;
+
+/* What the history should look like, oldest first. */
+static unsigned history[MAX_STATES];
+static unsigned history_size;
+
+static const uint8_t *make_state(void)
+{
+   unsigned i;
+   uint8_t *state = states + num_states * STATE_SIZE;
+
+   if (!num_states)
+   {
+      for (i = 0; i < STATE_SIZE; i++)
+         state[i] = rand();
+   }
+   else
+   {
+      memcpy(state, state - STATE_SIZE, STATE_SIZE);
+
+      /* A few short runs, and now and then a larger change
+       * so some patches don't deflate well. */
+      for (i = 0; i < 1 + rand() % 8; i++)
+      {
+         unsigned j;
+         unsigned pos = rand() % STATE_SIZE;
+         unsigned run = rand() % 16 ? 1 + rand() % 16 : 1 + rand() % 1024;
+
+         for (j = pos; j < pos + run && j < STATE_SIZE; j++)
+            state[j] ^= 1 + rand() % 255;
+      }
+   }
+
+   history[history_size++] = num_states;
+   return states + num_states++ * STATE_SIZE;
+}
+
+static void push(state_manager_t *manager)
+{
+   void *data;
+
+   state_manager_push_where(manager, &data);
+   memcpy(data, make_state(), STATE_SIZE);
+   state_manager_push_do(manager);
+}
+
+/* Rewinds by @count states, with a seek or that many pops,
+ * and checks what comes out against the model. */
+static bool rewind_by(state_manager_t *manager, unsigned count, bool seek)
+{
+   unsigned i, entries, left;
+   unsigned expect       = 0;
+   bool ret              = false;
+   const void *data      = NULL;
+
+   state_manager_capacity(manager, STATE_MANAGER_TIER_ALL,
+         &entries, NULL, NULL);
+
+   if (entries > history_size)
+   {
+      fprintf(stderr, "  %u entries, but only %u states pushed\n",
+            entries, history_size);
+      return false;
+   }
+
+   if (seek)
+      ret = state_manager_seek(manager, count, &data);
+   else
+   {
+      /* A failed pop clears the pointer. */
+      const void *popped = NULL;
+
+      for (i = 0; i < count && state_manager_pop(manager, &popped); i++)
+      {
+         data = popped;
+         ret  = true;
+      }
+   }
+
+   /* Whatever the manager has let go of is gone from the model too. */
+   expect = count < entries ? count : entries;
+
+   if (ret != (expect > 0) || (!ret && data))
+   {
+      fprintf(stderr, "  %s %u of %u: returned %s\n", seek ? "seek" : "pop",
+            count, entries, ret ? "a state" : "nothing");
+      return false;
+   }
+
+   if (ret && memcmp(data,
+            states + history[history_size - expect] * STATE_SIZE,
+            STATE_SIZE))
+   {
+      fprintf(stderr, "  %s %u of %u: wrong state\n", seek ? "seek" : "pop",
+            count, entries);
+      return false;
+   }
+
+   state_manager_capacity(manager, STATE_MANAGER_TIER_ALL,
+         &left, NULL, NULL);
+
+   if (left != entries - expect)
+   {
+      fprintf(stderr, "  %s %u of %u: %u entries left\n",
+            seek ? "seek" : "pop", count, entries, left);
+      return false;
+   }
+
+   history_size -= expect;
+   return true;
+}
+
+static bool run_config(const struct seek_config *config)
+{
+   unsigned round, i;
+   unsigned cold_max = 0;
+   bool ok           = true;
+   state_manager_t *manager = state_manager_new(STATE_SIZE, BUFFER_SIZE,
+         config->threaded, config->keyframe_interval, config->deflate_age);
+
+   if (!manager)
+      return false;
+
+   srand(1);
+   num_states   = 0;
+   history_size = 0;
+
+   for (round = 0; round < ROUNDS && ok; round++)
+   {
+      unsigned pushes = 50 + rand() % 300;
+      unsigned rewind = rand() % (pushes * 2);
+
+      for (i = 0; i < pushes; i++)
+         push(manager);
+
+      if (config->deflate_age)
+      {
+         unsigned cold = 0;
+         state_manager_capacity(manager, STATE_MANAGER_TIER_DEFLATE,
+               &cold, NULL, NULL);
+         if (cold > cold_max)
+            cold_max = cold;
+      }
+
+      /* Every few rounds, go all the way back to the oldest state. */
+      if (round % 6 == 5)
+         rewind = MAX_STATES;
+
+      while (rewind && ok)
+      {
+         unsigned count = 1 + rand() % (rand() % 4 ? 40 : 200);
+
+         if (count > rewind)
+            count = rewind;
+         rewind -= count;
+
+         ok = rewind_by(manager, count, rand() % 4 != 0);
+      }
+
+      if (ok && round % 6 == 5)
+         ok = rewind_by(manager, 1, true) && rewind_by(manager, 1, false);
+   }
+
+   /* Make sure the deflated tier was actually exercised. */
+   if (ok && config->deflate_age && !cold_max)
+   {
+      fprintf(stderr, "  nothing was deflated\n");
+      ok = false;
+   }
+
+   state_manager_free(manager);
+   return ok;
+}
+
+int main(void)
+{
+   unsigned i;
+   unsigned failed = 0;
+
+   states = (uint8_t*)malloc((size_t)MAX_STATES * STATE_SIZE);
+   if (!states)
+      return 1;
+
+   for (i = 0; i < sizeof(configs) / sizeof(configs[0]); i++)
+   {
+      bool ok = run_config(&configs[i]);
+
+      printf("%-32s %s\n", configs[i].name, ok ? "ok" : "FAIL");
+      if (!ok)
+         failed++;
+   }
+
+   free(states);
+
+   printf("%u failed.\n", failed);
+   return failed ? 1 : 0;
+}
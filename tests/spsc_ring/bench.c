@@ -0,0 +1,211 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares spsc_ring with the locked fifo_buffer hand-off it replaces
+ * in the threaded audio drivers: throughput in audio-sized batches,
+ * and the delay between a write and the reader seeing it. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+
+#include <boolean.h>
+#include <queues/fifo_buffer.h>
+#include <queues/spsc_ring.h>
+#include <rthreads/rthreads.h>
+
+/* 512 stereo s16 frames, a typical batch from audio_driver_flush(). */
+#define BATCH        2048
+#define RING_SIZE    (64 * 1024)
+#define STREAM_BYTES (512 * 1024 * 1024)
+#define MESSAGES     200000
+
+struct queue
+{
+   spsc_ring_t *ring;
+   fifo_buffer_t *fifo;
+   slock_t *lock;
+};
+
+static uint64_t now_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static size_t queue_write(struct queue *q, const void *data, size_t size)
+{
+   size_t avail;
+
+   if (q->ring)
+      return spsc_ring_write(q->ring, data, size);
+
+   slock_lock(q->lock);
+   avail = fifo_write_avail(q->fifo);
+   if (size > avail)
+      size = avail;
+   fifo_write(q->fifo, data, size);
+   slock_unlock(q->lock);
+   return size;
+}
+
+static size_t queue_read(struct queue *q, void *data, size_t size)
+{
+   size_t avail;
+
+   if (q->ring)
+      return spsc_ring_read(q->ring, data, size);
+
+   slock_lock(q->lock);
+   avail = fifo_read_avail(q->fifo);
+   if (size > avail)
+      size = avail;
+   fifo_read(q->fifo, data, size);
+   slock_unlock(q->lock);
+   return size;
+}
+
+/* Producer side. */
+static bool queue_empty(struct queue *q)
+{
+   bool empty;
+
+   if (q->ring)
+      return spsc_ring_write_avail(q->ring) == RING_SIZE;
+
+   slock_lock(q->lock);
+   empty = !fifo_read_avail(q->fifo);
+   slock_unlock(q->lock);
+   return empty;
+}
+
+static void write_all(struct queue *q, const void *data, size_t size)
+{
+   size_t written = 0;
+
+   while (written < size)
+   {
+      size_t ret = queue_write(q, (const uint8_t*)data + written,
+            size - written);
+      written += ret;
+      if (!ret)
+         sched_yield();
+   }
+}
+
+static void throughput_producer(void *data)
+{
+   static uint8_t batch[BATCH];
+   struct queue *q = (struct queue*)data;
+   size_t pos;
+
+   for (pos = 0; pos < STREAM_BYTES; pos += BATCH)
+      write_all(q, batch, BATCH);
+}
+
+/* Sends timestamps, waiting for each to be picked up. */
+static void latency_producer(void *data)
+{
+   struct queue *q = (struct queue*)data;
+   unsigned i;
+
+   for (i = 0; i < MESSAGES; i++)
+   {
+      uint64_t stamp = now_ns();
+      write_all(q, &stamp, sizeof(stamp));
+
+      while (!queue_empty(q))
+         sched_yield();
+   }
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+   uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+   return x < y ? -1 : x > y;
+}
+
+static void run(const char *name, struct queue *q)
+{
+   static uint8_t batch[BATCH];
+   static uint64_t delays[MESSAGES];
+   sthread_t *thread;
+   size_t pos = 0;
+   unsigned n = 0;
+   uint64_t start;
+   double secs;
+
+   start  = now_ns();
+   thread = sthread_create(throughput_producer, q);
+   while (pos < STREAM_BYTES)
+   {
+      size_t ret = queue_read(q, batch, BATCH);
+      pos += ret;
+      if (!ret)
+         sched_yield();
+   }
+   sthread_join(thread);
+   secs = (now_ns() - start) / 1e9;
+
+   thread = sthread_create(latency_producer, q);
+   while (n < MESSAGES)
+   {
+      uint64_t stamp;
+
+      if (queue_read(q, &stamp, sizeof(stamp)) != sizeof(stamp))
+      {
+         sched_yield();
+         continue;
+      }
+      delays[n++] = now_ns() - stamp;
+   }
+   sthread_join(thread);
+
+   qsort(delays, MESSAGES, sizeof(delays[0]), cmp_u64);
+
+   printf("%-12s %10.0f MiB/s %10u ns %10u ns %10u ns\n", name,
+         STREAM_BYTES / secs / (1024 * 1024),
+         (unsigned)delays[MESSAGES / 2],
+         (unsigned)delays[MESSAGES * 99 / 100],
+         (unsigned)delays[MESSAGES - 1]);
+}
+
+int main(void)
+{
+   struct queue ring, fifo;
+
+   memset(&ring, 0, sizeof(ring));
+   memset(&fifo, 0, sizeof(fifo));
+
+   ring.ring = spsc_ring_new(RING_SIZE);
+   fifo.fifo = fifo_new(RING_SIZE);
+   fifo.lock = slock_new();
+
+   printf("%u byte batches through a %u byte queue, %u timestamps.\n",
+         BATCH, RING_SIZE, MESSAGES);
+   printf("%-12s %16s %13s %13s %13s\n",
+         "queue", "throughput", "median", "p99", "max");
+
+   run("spsc_ring", &ring);
+   run("fifo+slock", &fifo);
+
+   spsc_ring_free(ring.ring);
+   fifo_free(fifo.fifo);
+   slock_free(fifo.lock);
+   return 0;
+}
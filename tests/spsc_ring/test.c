@@ -0,0 +1,188 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Streams a byte pattern through spsc_ring from a second thread,
+ * with odd-sized batches on both ends, and checks that it arrives
+ * intact for a range of ring sizes. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#include <boolean.h>
+#include <queues/spsc_ring.h>
+#include <rthreads/rthreads.h>
+
+#define STREAM_BYTES (4 * 1024 * 1024)
+#define MAX_BATCH    3001
+
+struct stress
+{
+   spsc_ring_t *ring;
+   size_t total;
+   unsigned seed;
+};
+
+static const size_t ring_sizes[] = { 1, 7, 64, 1000, 4096, 65536 };
+
+static uint8_t pattern(size_t pos)
+{
+   return (uint8_t)((pos * 2654435761u) >> 13);
+}
+
+static size_t batch_size(unsigned *seed)
+{
+   *seed = *seed * 1103515245u + 12345u;
+   return (*seed >> 16) % MAX_BATCH + 1;
+}
+
+static void producer(void *data)
+{
+   uint8_t batch[MAX_BATCH];
+   struct stress *s = (struct stress*)data;
+   size_t pos       = 0;
+
+   while (pos < s->total)
+   {
+      size_t i, written;
+      size_t size = batch_size(&s->seed);
+
+      if (size > s->total - pos)
+         size = s->total - pos;
+
+      for (i = 0; i < size; i++)
+         batch[i] = pattern(pos + i);
+
+      for (written = 0; written < size; )
+      {
+         size_t ret = spsc_ring_write(s->ring, batch + written, size - written);
+         written   += ret;
+         if (!ret)
+            sched_yield();
+      }
+
+      pos += size;
+   }
+}
+
+static bool check_basics(void)
+{
+   uint8_t in[1500], out[1500];
+   unsigned i;
+   spsc_ring_t *ring = spsc_ring_new(1000);
+
+   for (i = 0; i < sizeof(in); i++)
+      in[i] = pattern(i);
+
+   if (!ring
+         || spsc_ring_write_avail(ring) != 1000
+         || spsc_ring_write(ring, in, 1500) != 1000
+         || spsc_ring_read_avail(ring) != 1000
+         || spsc_ring_write(ring, in, 1) != 0
+         || spsc_ring_read(ring, out, 300) != 300
+         || memcmp(in, out, 300)
+         || spsc_ring_write(ring, in + 1000, 500) != 300
+         || spsc_ring_read(ring, out, 1500) != 1000
+         || memcmp(in + 300, out, 1000))
+      goto fail;
+
+   /* Wrapped around the 1024 byte storage. Clear must leave it empty. */
+   spsc_ring_write(ring, in, 700);
+   spsc_ring_clear(ring);
+   if (spsc_ring_read_avail(ring) != 0
+         || spsc_ring_write_avail(ring) != 1000
+         || spsc_ring_read(ring, out, 1) != 0)
+      goto fail;
+
+   spsc_ring_free(ring);
+   return true;
+
+fail:
+   fprintf(stderr, "FAIL: single-threaded checks.\n");
+   spsc_ring_free(ring);
+   return false;
+}
+
+static bool check_stress(size_t ring_size)
+{
+   uint8_t batch[MAX_BATCH];
+   struct stress s;
+   sthread_t *thread;
+   unsigned seed = 4321;
+   size_t pos    = 0;
+   bool ok       = true;
+
+   s.ring  = spsc_ring_new(ring_size);
+   s.total = STREAM_BYTES;
+   s.seed  = 1234;
+
+   if (!s.ring || !(thread = sthread_create(producer, &s)))
+   {
+      fprintf(stderr, "Failed to set up %u byte ring.\n", (unsigned)ring_size);
+      return false;
+   }
+
+   while (pos < s.total)
+   {
+      size_t i;
+      size_t size = spsc_ring_read(s.ring, batch, batch_size(&seed));
+
+      if (!size)
+         sched_yield();
+
+      for (i = 0; ok && i < size; i++)
+      {
+         if (batch[i] != pattern(pos + i))
+         {
+            fprintf(stderr, "FAIL: %u byte ring, byte %u is wrong.\n",
+                  (unsigned)ring_size, (unsigned)(pos + i));
+            ok = false;
+         }
+      }
+
+      /* Keep draining after a failure so the producer can finish. */
+      pos += size;
+   }
+
+   sthread_join(thread);
+
+   if (ok && spsc_ring_read_avail(s.ring))
+   {
+      fprintf(stderr, "FAIL: %u byte ring has bytes left over.\n",
+            (unsigned)ring_size);
+      ok = false;
+   }
+
+   spsc_ring_free(s.ring);
+   return ok;
+}
+
+int main(void)
+{
+   unsigned i;
+   unsigned failed = check_basics() ? 0 : 1;
+
+   for (i = 0; i < sizeof(ring_sizes) / sizeof(ring_sizes[0]); i++)
+      if (!check_stress(ring_sizes[i]))
+         failed++;
+
+   printf("Streamed %u MiB through %u ring sizes, %u failures.\n",
+         STREAM_BYTES * (unsigned)(sizeof(ring_sizes) / sizeof(ring_sizes[0]))
+         >> 20, (unsigned)(sizeof(ring_sizes) / sizeof(ring_sizes[0])),
+         failed);
+
+   return failed ? 1 : 0;
+}